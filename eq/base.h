@@ -82,6 +82,7 @@
 #include <eq/canvas.h>
 #include <eq/channelStatistics.h>
 #include <eq/channel.h>
+#include <eq/chunkedObject.h>
 #include <eq/client.h>
 #include <eq/compositor.h>
 #include <eq/config.h>
@@ -90,6 +91,7 @@
 #include <eq/exception.h>
 #include <eq/frame.h>
 #include <eq/frameData.h>
+#include <eq/frameReplay.h>
 #include <eq/global.h>
 #include <eq/glException.h>
 #include <eq/image.h>
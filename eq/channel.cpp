@@ -33,6 +33,9 @@
 #  include "configEvent.h"
 #endif
 #include "detail/fileFrameWriter.h"
+#include "detail/frameCapture.h"
+#include "detail/referenceImage.h"
+#include "detail/sharedImageRing.h"
 #include "error.h"
 #include "frame.h"
 #include "frameData.h"
@@ -64,6 +67,7 @@
 #include <co/sendToken.h>
 #include <lunchbox/rng.h>
 #include <lunchbox/scopedMutex.h>
+#include <lunchbox/thread.h>
 #include <pression/plugins/compressor.h>
 
 #ifdef EQUALIZER_USE_GLSTATS
@@ -72,6 +76,7 @@
 #endif
 
 #include <bitset>
+#include <cstring>
 #include <set>
 
 #include "detail/channel.ipp"
@@ -91,6 +96,53 @@ using detail::STATE_RUNNING;
 using detail::STATE_FAILED;
 /** @endcond */
 
+namespace
+{
+/** Images are split into blocks of this size to skip empty space. */
+const uint32_t _transmitBlockSize = 32;
+
+/** Send only the occupied blocks if no more than this fraction is used. */
+const float _maxBlockOccupancy = .5f;
+
+/** The keyframe rate of delta frames for IATTR_HINT_DELTA ON. */
+const uint32_t _keyframeRate = 60;
+
+/** Move the calling worker thread, if needed, to the given affinity. */
+void _followAffinity( const int32_t affinity )
+{
+    static thread_local int32_t current = lunchbox::Thread::NONE;
+    if( affinity == lunchbox::Thread::NONE || affinity == current )
+        return;
+
+    lunchbox::Thread::setAffinity( affinity );
+    current = affinity;
+}
+
+/** @return true if both nodes listen on the same, named host. */
+bool _isSameHost( const co::Node& node, const co::Node& other )
+{
+    const co::ConnectionDescriptions& descs = node.getConnectionDescriptions();
+    const co::ConnectionDescriptions& others =
+        other.getConnectionDescriptions();
+
+    for( co::ConnectionDescriptionsCIter i = descs.begin();
+         i != descs.end(); ++i )
+    {
+        const std::string& hostname = (*i)->getHostname();
+        if( hostname.empty( ))
+            continue;
+
+        for( co::ConnectionDescriptionsCIter j = others.begin();
+             j != others.end(); ++j )
+        {
+            if( (*j)->getHostname() == hostname )
+                return true;
+        }
+    }
+    return false;
+}
+}
+
 Channel::Channel( Window* parent )
         : Super( parent )
         , _impl( new detail::Channel )
@@ -1202,6 +1254,12 @@ void Channel::_frameReadback( const uint128_t& frameID,
 
     frameReadback( frameID, frames );
     LBASSERT( stat->event.event.data.statistic.frameNumber > 0 );
+
+    // compress and transmit only the regions of interest of the new images
+    if( getIAttribute( IATTR_HINT_ROI ) == ON )
+        for( size_t i = 0; i < frames.size(); ++i )
+            frames[i]->getFrameData()->cropImages( nImages[i], frameID );
+
     const bool async = _asyncFinishReadback( nImages, frames );
     _setReady( async, stat.get(), frames );
 }
@@ -1289,18 +1347,75 @@ void Channel::_asyncTransmit( FrameDataPtr frame, const uint32_t frameNumber,
                               const uint32_t taskID )
 {
     LBASSERT( nodes.size() == netNodes.size( ));
+    if( nodes.empty( ))
+        return;
+
+    // One task per image, the transmit threads compress and send the images
+    // of all channels concurrently. The ready signal of the frame waits for
+    // all of them in _cmdFrameSetReadyNode.
+    _refFrame( frameNumber );
+    {
+        lunchbox::ScopedWrite mutex( _impl->transmits );
+        ++_impl->transmits.data[ frameNumber ].pending;
+    }
+
+    LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Start transmit frame data " << frame
+                                    << " image " << image << " to "
+                                    << nodes.size() << " receivers"
+                                    << std::endl;
+    send( getLocalNode(), fabric::CMD_CHANNEL_FRAME_TRANSMIT_IMAGE )
+            << co::ObjectVersion( frame ) << nodes << netNodes << image
+            << frameNumber << taskID;
+}
+
+void Channel::_transmitDone( const uint32_t frameNumber )
+{
+    detail::Channel::ReadyNodes readyNodes;
+    {
+        lunchbox::ScopedWrite mutex( _impl->transmits );
+        detail::Channel::TransmitsMap::iterator i =
+            _impl->transmits->find( frameNumber );
+        LBASSERT( i != _impl->transmits->end( ));
+        LBASSERT( i->second.pending > 0 );
+        if( --i->second.pending > 0 )
+            return;
+
+        readyNodes.swap( i->second.readyNodes );
+        _impl->transmits->erase( i );
+    }
+
+    BOOST_FOREACH( const detail::Channel::ReadyNode& ready, readyNodes )
+    {
+        _sendReadyNode( ready.frameData, ready.nodes, ready.netNodes,
+                        frameNumber );
+        _unrefFrame( frameNumber );
+    }
+}
+
+void Channel::_sendReadyNode( const co::ObjectVersion& frameDataVersion,
+                              const std::vector< uint128_t >& nodes,
+                              const co::NodeIDs& netNodes,
+                              const uint32_t frameNumber )
+{
+    co::LocalNodePtr localNode = getLocalNode();
+    const FrameDataPtr frameData = getNode()->getFrameData( frameDataVersion );
+
     co::NodeIDs::const_iterator j = netNodes.begin();
     for( std::vector< uint128_t >::const_iterator i = nodes.begin();
          i != nodes.end(); ++i, ++j )
     {
-        _refFrame( frameNumber );
-
-        LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Start transmit frame data " << frame
-                                        << " receiver " << *i << " on " << *j
-                                        << std::endl;
-        send( getLocalNode(), fabric::CMD_CHANNEL_FRAME_TRANSMIT_IMAGE )
-                << co::ObjectVersion( frame ) << *i << *j << image
-                << frameNumber << taskID;
+        co::NodePtr toNode = localNode->connect( *j );
+        if( !toNode )
+        {
+            LBERROR << "Can't connect to " << *j << " to signal ready of frame "
+                    << frameNumber << std::endl;
+            continue;
+        }
+        co::ObjectOCommand os( co::Connections( 1, toNode->getConnection( )),
+                            fabric::CMD_NODE_FRAMEDATA_READY,
+                               co::COMMANDTYPE_OBJECT, *i, CO_INSTANCE_ALL );
+        os << frameDataVersion;
+        frameData->serialize( os );
     }
 }
 
@@ -1321,6 +1436,13 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
         return;
     }
 
+    // Compress where the image was read back, unless the node pins its
+    // transmit threads explicitly
+    const int32_t nodeAffinity =
+        getNode()->getIAttribute( Node::IATTR_HINT_AFFINITY );
+    if( nodeAffinity == AUTO || nodeAffinity == OFF )
+        _followAffinity( getPipe()->getAffinity( ));
+
     ChannelStatistics transmitEvent( Statistic::CHANNEL_FRAME_TRANSMIT, this,
                                      frameNumber );
     transmitEvent.event.data.statistic.task = taskID;
@@ -1348,10 +1470,43 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
     co::ConnectionPtr connection = toNode->getConnection();
     co::ConstConnectionDescriptionPtr description =connection->getDescription();
 
+    // hand raw pixels through shared memory to nodes on the same host
+    detail::SharedImageRing* ring = _isSameHost( *localNode, *toNode ) ?
+        getNode()->getSharedImageRing( toNode, nodeID ) : 0;
+
     // use compression on links up to 2 GBit/s
-    const bool useCompression = ( description->bandwidth <= 262144 );
+    const bool useCompression = !ring && ( description->bandwidth <= 262144 );
+
+    // send only the blocks changed since the last frame sent to the node, or
+    // periodically a keyframe
+    const int32_t deltaHint = getIAttribute( IATTR_HINT_DELTA );
+    detail::ReferenceImage* reference = 0;
+    if( deltaHint != OFF && deltaHint != UNDEFINED )
+        reference = _impl->getReferenceImage(
+            detail::Channel::ReferenceKey( nodeID, image->getContext().eye,
+                                           imageIndex ), frameNumber );
+    // consecutive frames of one stream may be transmitted concurrently
+    lunchbox::ScopedMutex<> referenceMutex( reference ? &reference->lock : 0 );
+    const uint32_t keyframeRate = deltaHint > ON ? uint32_t( deltaHint ) :
+                                                   _keyframeRate;
+    // a receiver which lost the stream after the last keyframe needs a new one
+    const uint32_t lost = reference ?
+        getNode()->takeKeyframeRequest( reference->stream ) : 0;
+    const bool delta = reference && reference->sequence > 0 &&
+        lost < reference->keyframe &&
+        reference->sequence - reference->keyframe + 1 < keyframeRate &&
+        image->findChangedBlocks( reference->image, _transmitBlockSize ) <=
+            _maxBlockOccupancy;
+    const uint128_t stream = reference ? reference->stream : uint128_t();
+    const uint32_t sequence = reference ? reference->sequence + 1 : 0;
+
+    // send only the occupied blocks of sparse images, e.g., of DB sources
+    const bool sparse = delta ||
+        image->findBlocks( _transmitBlockSize ) <= _maxBlockOccupancy;
+    const uint32_t blockSize = sparse ? _transmitBlockSize : 0;
 
     std::vector< const PixelData* > pixelDatas;
+    std::vector< Frame::Buffer > dataBuffers;
     std::vector< float > qualities;
 
     uint32_t commandBuffers = Frame::BUFFER_NONE;
@@ -1378,12 +1533,19 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
                 // format, type, nChunks, compressor name
                 imageDataSize += sizeof( FrameData::ImageHeader );
 
-                const PixelData& data = useCompression ?
-                    image->compressPixelData( buffer ) :
-                    image->getPixelData( buffer );
+                const PixelData& data =
+                    sparse ? image->getBlockData( buffer, useCompression ) :
+                    useCompression ? image->compressPixelData( buffer ) :
+                                     image->getPixelData( buffer );
                 pixelDatas.push_back( &data );
+                dataBuffers.push_back( buffer );
                 qualities.push_back( image->getQuality( buffer ));
 
+                // occupancy mask and background pixel
+                if( sparse )
+                    imageDataSize += image->getBlockMaskSize() +
+                                     data.pixelSize;
+
                 if( data.compressedData.isCompressed( ))
                 {
                     imageDataSize += data.compressedData.getSize() +
@@ -1393,7 +1555,7 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
                 }
                 else
                     imageDataSize += sizeof( uint64_t ) +
-                                     image->getPixelDataSize( buffer );
+                                     data.pvp.getArea() * data.pixelSize;
 
                 commandBuffers |= buffer;
                 rawSize += image->getPixelDataSize( buffer );
@@ -1408,6 +1570,60 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
     if( pixelDatas.empty( ))
         return;
 
+    if( reference )
+        reference->update( *image, sequence, !delta );
+
+    if( ring )
+    {
+        uint64_t offset = 0;
+        uint8_t* data = ring->allocate( imageDataSize, offset );
+        if( data ) // else full, use the connection
+        {
+            for( uint32_t j=0; j < pixelDatas.size(); ++j )
+            {
+                const PixelData* pixels = pixelDatas[j];
+                LBASSERT( !pixels->compressedData.isCompressed( ));
+
+                const FrameData::ImageHeader header =
+                    { pixels->internalFormat, pixels->externalFormat,
+                      pixels->pixelSize, pixels->pvp, EQ_COMPRESSOR_NONE,
+                      pixels->compressorFlags, 1, qualities[ j ], blockSize,
+                      delta };
+                const uint64_t dataSize = pixels->pvp.getArea() *
+                                          pixels->pixelSize;
+
+                ::memcpy( data, &header, sizeof( header ));
+                data += sizeof( header );
+                if( sparse )
+                {
+                    ::memcpy( data, image->getBlockMask(),
+                              image->getBlockMaskSize( ));
+                    data += image->getBlockMaskSize();
+                    ::memcpy( data, image->getBlockBackground( dataBuffers[j] ),
+                              pixels->pixelSize );
+                    data += pixels->pixelSize;
+                }
+                ::memcpy( data, &dataSize, sizeof( dataSize ));
+                data += sizeof( dataSize );
+                if( dataSize > 0 )
+                    ::memcpy( data, pixels->pixels, dataSize );
+                data += dataSize;
+            }
+
+            LBASSERT( image->getPixelViewport().isValid( ));
+            co::ObjectOCommand command( co::Connections( 1, connection ),
+                                      fabric::CMD_NODE_FRAMEDATA_TRANSMIT_SHARED,
+                                        co::COMMANDTYPE_OBJECT, nodeID,
+                                        CO_INSTANCE_ALL );
+            command << frameDataVersion << image->getPixelViewport()
+                    << image->getZoom() << image->getContext()
+                    << commandBuffers << frameNumber << image->getAlphaUsage()
+                    << offset << imageDataSize << stream << sequence
+                    << getNode()->getID();
+            return;
+        }
+    }
+
     // send image pixel data command
     co::LocalNode::SendToken token;
     if( getIAttribute( IATTR_HINT_SENDTOKEN ) == ON )
@@ -1425,7 +1641,8 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
                                 CO_INSTANCE_ALL );
     command << frameDataVersion << image->getPixelViewport() << image->getZoom()
             << image->getContext() << commandBuffers << frameNumber
-            << image->getAlphaUsage();
+            << image->getAlphaUsage() << stream << sequence
+            << getNode()->getID();
     command.sendHeader( imageDataSize );
 
 #ifndef NDEBUG
@@ -1447,9 +1664,20 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
                 data->pixelSize, data->pvp,
                 isCompressed ? data->compressedData.compressor :
                                EQ_COMPRESSOR_NONE,
-                data->compressorFlags, nChunks, qualities[ j ] };
+                data->compressorFlags, nChunks, qualities[ j ], blockSize,
+                delta };
 
         connection->send( &header, sizeof( header ), true );
+        if( sparse )
+        {
+            connection->send( image->getBlockMask(), image->getBlockMaskSize(),
+                              true );
+            connection->send( image->getBlockBackground( dataBuffers[j] ),
+                              data->pixelSize, true );
+#ifndef NDEBUG
+            sentBytes += image->getBlockMaskSize() + data->pixelSize;
+#endif
+        }
 
         if( isCompressed )
         {
@@ -1470,7 +1698,8 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
         {
             const uint64_t dataSize = data->pvp.getArea() * data->pixelSize;
             connection->send( &dataSize, sizeof( dataSize ), true );
-            connection->send( data->pixels, dataSize, true );
+            if( dataSize > 0 )
+                connection->send( data->pixels, dataSize, true );
 #ifndef NDEBUG
             sentBytes += sizeof( dataSize ) + dataSize;
 #endif
@@ -1641,6 +1870,7 @@ bool Channel::_cmdConfigExit( co::ICommand& cmd )
     if( _impl->state != STATE_STOPPED )
         _impl->state = configExit() ? STATE_STOPPED : STATE_FAILED;
 
+    _impl->frameWriter.stop(); // write all dumped images before exit returns
     _deleteTransferWindow();
     getWindow()->send( getLocalNode(),
                        fabric::CMD_WINDOW_DESTROY_CHANNEL ) << getID();
@@ -1774,6 +2004,15 @@ bool Channel::_cmdFrameAssemble( co::ICommand& cmd )
     const Frames& frames = _getFrames( frameIDs, false );
     frameAssemble( context.frameID, frames );
 
+    const std::string& capture = getSAttribute( SATTR_CAPTURE_FRAMES );
+    if( !capture.empty( ))
+    {
+        detail::FrameCapture* frameCapture =
+            getNode()->getFrameCapture( capture );
+        if( frameCapture->isGood( ))
+            frameCapture->writeAssembly( getCurrentFrame(), frames );
+    }
+
     resetContext();
     return true;
 }
@@ -1840,18 +2079,27 @@ bool Channel::_cmdFrameTransmitImage( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
     const co::ObjectVersion& frameData = command.read< co::ObjectVersion >();
-    const uint128_t& nodeID = command.read< uint128_t >();
-    const co::NodeID& netNodeID = command.read< co::NodeID >();
+    const std::vector< uint128_t >& nodes =
+            command.read< std::vector< uint128_t > >();
+    const co::NodeIDs& netNodes = command.read< co::NodeIDs >();
     const uint64_t imageIndex = command.read< uint64_t >();
     const uint32_t frameNumber = command.read< uint32_t >();
     const uint32_t taskID = command.read< uint32_t >();
 
-    LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Transmit " << command << " frame data "
-                                    << frameData << " receiver " << nodeID
-                                    << " on " << netNodeID << std::endl;
+    // the receivers of one image are served in order, since compression and
+    // block state are kept in the image
+    co::NodeIDs::const_iterator j = netNodes.begin();
+    for( std::vector< uint128_t >::const_iterator i = nodes.begin();
+         i != nodes.end(); ++i, ++j )
+    {
+        LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Transmit " << command
+                                        << " frame data " << frameData
+                                        << " receiver " << *i << " on " << *j
+                                        << std::endl;
+        _transmitImage( frameData, *i, *j, imageIndex, frameNumber, taskID );
+    }
 
-    _transmitImage( frameData, nodeID, netNodeID, imageIndex, frameNumber,
-                    taskID );
+    _transmitDone( frameNumber );
     _unrefFrame( frameNumber );
     return true;
 }
@@ -1867,27 +2115,22 @@ bool Channel::_cmdFrameSetReadyNode( co::ICommand& cmd )
     const co::NodeIDs& netNodes = command.read< co::NodeIDs >();
     const uint32_t frameNumber = command.read< uint32_t >();
 
-    co::LocalNodePtr localNode = getLocalNode();
-    const FrameDataPtr frameData = getNode()->getFrameData( frameDataVersion );
-
-    co::NodeIDs::const_iterator j = netNodes.begin();
-    for( std::vector< uint128_t >::const_iterator i = nodes.begin();
-         i != nodes.end(); ++i, ++j )
     {
-        co::NodePtr toNode = localNode->connect( *j );
-        if( !toNode )
+        // All images of the frame were queued before this signal, but may
+        // still be sent by other transmit threads: defer to the last one.
+        lunchbox::ScopedWrite mutex( _impl->transmits );
+        detail::Channel::TransmitsMap::iterator i =
+            _impl->transmits->find( frameNumber );
+        if( i != _impl->transmits->end( ))
         {
-            LBERROR << "Can't connect to " << *j << " to signal ready of frame "
-                    << frameNumber << std::endl;
-            continue;
+            const detail::Channel::ReadyNode ready = { frameDataVersion, nodes,
+                                                       netNodes };
+            i->second.readyNodes.push_back( ready );
+            return true;
         }
-        co::ObjectOCommand os( co::Connections( 1, toNode->getConnection( )),
-                            fabric::CMD_NODE_FRAMEDATA_READY,
-                               co::COMMANDTYPE_OBJECT, *i, CO_INSTANCE_ALL );
-        os << frameDataVersion;
-        frameData->serialize( os );
     }
 
+    _sendReadyNode( frameDataVersion, nodes, netNodes, frameNumber );
     _unrefFrame( frameNumber );
     return true;
 }
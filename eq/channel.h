@@ -662,6 +662,15 @@ private:
                          const co::NodeIDs& netNodes,
                          const uint32_t taskID );
 
+    /** Finish one image transmission, sending the deferred ready signals. */
+    void _transmitDone( const uint32_t frameNumber );
+
+    /** Signal the readiness of a frame data to the given nodes. */
+    void _sendReadyNode( const co::ObjectVersion& frameDataVersion,
+                         const std::vector< uint128_t >& nodes,
+                         const co::NodeIDs& netNodes,
+                         const uint32_t frameNumber );
+
     void _setReady( const bool async, detail::RBStat* stat,
                     const Frames& frames );
     void _asyncSetReady( const FrameDataPtr frame, detail::RBStat* stat,
@@ -58,7 +58,9 @@ ChannelStatistics::ChannelStatistics( const Statistic::Type type,
         type != Statistic::CHANNEL_ASYNC_READBACK &&
         type != Statistic::CHANNEL_FRAME_TRANSMIT &&
         type != Statistic::CHANNEL_FRAME_COMPRESS &&
-        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN )
+        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN &&
+        type != Statistic::CHANNEL_EMPTY_SPACE &&
+        type != Statistic::CHANNEL_FRAME_WAIT_DUMP )
     {
         channel->getWindow()->finish();
     }
@@ -77,7 +79,9 @@ ChannelStatistics::~ChannelStatistics()
         type != Statistic::CHANNEL_ASYNC_READBACK &&
         type != Statistic::CHANNEL_FRAME_TRANSMIT &&
         type != Statistic::CHANNEL_FRAME_COMPRESS &&
-        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN )
+        type != Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN &&
+        type != Statistic::CHANNEL_EMPTY_SPACE &&
+        type != Statistic::CHANNEL_FRAME_WAIT_DUMP )
     {
         _owner->getWindow()->finish();
     }
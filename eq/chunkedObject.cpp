@@ -0,0 +1,370 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "chunkedObject.h"
+
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/localNode.h>
+#include <co/objectVersion.h>
+#include <lunchbox/thread.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace eq
+{
+namespace detail
+{
+class ChunkedObject
+{
+public:
+    /** One chunk, distributed as a separate object. */
+    class Chunk : public co::Object
+    {
+    public:
+        Chunk( eq::ChunkedObject& parent, const size_t index )
+            : dirty( true )
+            , pending( false )
+            , _parent( parent )
+            , _index( index )
+        {}
+
+        ChangeType getChangeType() const override { return INSTANCE; }
+
+        bool dirty; //!< changed since the last scheduled commit
+        bool pending; //!< a commit is scheduled, protected by the mutex
+        uint128_t version; //!< the version after the scheduled commit
+
+    protected:
+        void getInstanceData( co::DataOStream& os ) override
+            { _parent.serializeChunk( os, _index ); }
+
+        void applyInstanceData( co::DataIStream& is ) override
+            { _parent.deserializeChunk( is, _index ); }
+
+    private:
+        eq::ChunkedObject& _parent;
+        const size_t _index;
+    };
+
+    class Worker : public lunchbox::Thread
+    {
+    public:
+        explicit Worker( ChunkedObject& impl ) : _impl( impl ) {}
+
+    protected:
+        bool init() override { setName( "Chunks" ); return true; }
+
+        void run() override
+        {
+            std::function< void() > task;
+            while( _impl._pop( task ))
+            {
+                task();
+                _impl._done();
+            }
+        }
+
+    private:
+        ChunkedObject& _impl;
+    };
+
+    ChunkedObject( eq::ChunkedObject& parent, const size_t nChunks,
+                   const size_t nThreads_ )
+        : nThreads( nThreads_ )
+        , registered( false )
+        , _nPending( 0 )
+        , _running( false )
+    {
+        if( nThreads == 0 )
+            nThreads = std::max( std::thread::hardware_concurrency(), 1u );
+        nThreads = std::min( nThreads, nChunks );
+
+        chunks.reserve( nChunks );
+        for( size_t i = 0; i < nChunks; ++i )
+            chunks.push_back( new Chunk( parent, i ));
+    }
+
+    ~ChunkedObject()
+    {
+        {
+            std::unique_lock< std::mutex > lock( _mutex );
+            _condition.wait( lock, [this] { return _nPending == 0; } );
+            _running = false;
+        }
+        _condition.notify_all();
+
+        for( Worker* worker : _workers )
+        {
+            worker->join();
+            delete worker;
+        }
+
+        for( Chunk* chunk : chunks )
+        {
+            LBASSERTINFO( !chunk->isAttached(), "Chunk " << chunk->getID()
+                          << " is still attached" );
+            delete chunk;
+        }
+    }
+
+    /** Run the task on a worker thread. */
+    void push( const std::function< void() >& task )
+    {
+        {
+            std::lock_guard< std::mutex > lock( _mutex );
+            if( !_running )
+            {
+                _running = true;
+                for( size_t i = 0; i < nThreads; ++i )
+                {
+                    _workers.push_back( new Worker( *this ));
+                    _workers.back()->start();
+                }
+            }
+            ++_nPending;
+            _tasks.push_back( task );
+        }
+        _condition.notify_all();
+    }
+
+    /** Commit the chunk from a worker thread. */
+    void commit( Chunk* chunk, const uint32_t incarnation )
+    {
+        {
+            std::lock_guard< std::mutex > lock( _mutex );
+            LBASSERT( !chunk->pending );
+            chunk->pending = true;
+        }
+        push( [this, chunk, incarnation]
+        {
+            const uint128_t& version = chunk->commit( incarnation );
+            LBASSERTINFO( version == chunk->version,
+                          version << " != " << chunk->version );
+            std::lock_guard< std::mutex > lock( _mutex );
+            chunk->pending = false;
+        });
+    }
+
+    void waitCommitted( const Chunk* chunk )
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        _condition.wait( lock, [chunk] { return !chunk->pending; } );
+    }
+
+    void waitAll()
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        _condition.wait( lock, [this] { return _nPending == 0; } );
+    }
+
+    /** Register the chunks with the master's node on its first commit. */
+    void register_( co::LocalNodePtr node, const uint32_t autoObsolete )
+    {
+        for( Chunk* chunk : chunks )
+        {
+            LBCHECK( node->registerObject( chunk ));
+            chunk->setAutoObsolete( autoObsolete );
+            chunk->version = chunk->getVersion();
+            chunk->dirty = false; // sent with the instance data
+        }
+        registered = true;
+    }
+
+    /** Map and sync the chunks to the given versions on a slave. */
+    void sync( co::LocalNodePtr node, const co::ObjectVersions& versions )
+    {
+        LBASSERTINFO( versions.size() == chunks.size(),
+                      versions.size() << " != " << chunks.size( ));
+        const size_t nChunks = std::min( versions.size(), chunks.size( ));
+
+        // The published chunk versions may still be committed by the
+        // master's threads. Map the oldest version the master has, which is
+        // committed, and sync to the published version afterwards.
+        std::vector< uint32_t > requests;
+        for( size_t i = 0; i < nChunks; ++i )
+        {
+            Chunk* chunk = chunks[i];
+            if( !chunk->isAttached( ))
+                requests.push_back( node->mapObjectNB( chunk,
+                                                      versions[i].identifier,
+                                                      co::VERSION_OLDEST ));
+        }
+        for( const uint32_t request : requests )
+            LBCHECK( node->mapObjectSync( request ));
+
+        for( size_t i = 0; i < nChunks; ++i )
+        {
+            Chunk* chunk = chunks[i];
+            const uint128_t& version = versions[i].version;
+            if( chunk->getVersion() != version )
+                push( [chunk, version] { chunk->sync( version ); });
+        }
+        waitAll();
+    }
+
+    std::vector< Chunk* > chunks;
+    size_t nThreads;
+    bool registered;
+
+private:
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque< std::function< void() > > _tasks;
+    std::vector< Worker* > _workers;
+    size_t _nPending;
+    bool _running;
+
+    bool _pop( std::function< void() >& task )
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        _condition.wait( lock, [this] { return !_tasks.empty() || !_running; });
+        if( _tasks.empty( ))
+            return false; // stopped
+
+        task = _tasks.front();
+        _tasks.pop_front();
+        return true;
+    }
+
+    void _done()
+    {
+        {
+            std::lock_guard< std::mutex > lock( _mutex );
+            --_nPending;
+        }
+        _condition.notify_all();
+    }
+};
+}
+
+ChunkedObject::ChunkedObject( const size_t nChunks, const size_t nThreads )
+    : _impl( new detail::ChunkedObject( *this, nChunks, nThreads ))
+{}
+
+ChunkedObject::~ChunkedObject()
+{
+    delete _impl;
+}
+
+size_t ChunkedObject::getNumChunks() const
+{
+    return _impl->chunks.size();
+}
+
+void ChunkedObject::setChunkDirty( const size_t index )
+{
+    LBASSERT( !isAttached() || isMaster( ));
+    LBASSERT( index < _impl->chunks.size( ));
+
+    detail::ChunkedObject::Chunk* chunk = _impl->chunks[ index ];
+    _impl->waitCommitted( chunk );
+    chunk->dirty = true;
+    setDirty( DIRTY_CHUNKS );
+}
+
+void ChunkedObject::waitCommitted() const
+{
+    _impl->waitAll();
+}
+
+uint128_t ChunkedObject::commit( const uint32_t incarnation )
+{
+    LBASSERT( isMaster( ));
+    if( !_impl->registered )
+    {
+        _impl->register_( getLocalNode(), getAutoObsolete( ));
+        setDirty( DIRTY_CHUNKS );
+    }
+
+    std::vector< detail::ChunkedObject::Chunk* > dirty;
+    for( detail::ChunkedObject::Chunk* chunk : _impl->chunks )
+    {
+        if( !chunk->dirty )
+            continue;
+
+        // versioned objects increment their version on each commit
+        ++chunk->version;
+        chunk->dirty = false;
+        dirty.push_back( chunk );
+    }
+
+    // sends the new chunk versions, the slaves wait for the chunk data
+    const uint128_t version = co::Serializable::commit( incarnation );
+
+    for( detail::ChunkedObject::Chunk* chunk : dirty )
+        _impl->commit( chunk, incarnation );
+    return version;
+}
+
+void ChunkedObject::serialize( co::DataOStream& os, const uint64_t dirtyBits )
+{
+    if( !( dirtyBits & DIRTY_CHUNKS ))
+        return;
+
+    co::ObjectVersions versions;
+    if( _impl->registered )
+    {
+        versions.reserve( _impl->chunks.size( ));
+        for( const detail::ChunkedObject::Chunk* chunk : _impl->chunks )
+            versions.push_back( co::ObjectVersion( chunk->getID(),
+                                                   chunk->version ));
+    }
+    os << versions;
+}
+
+void ChunkedObject::deserialize( co::DataIStream& is,
+                                 const uint64_t dirtyBits )
+{
+    if( !( dirtyBits & DIRTY_CHUNKS ))
+        return;
+
+    co::ObjectVersions versions;
+    is >> versions;
+    if( !versions.empty() && !isMaster( ))
+        _impl->sync( getLocalNode(), versions );
+}
+
+void ChunkedObject::notifyDetach()
+{
+    co::Serializable::notifyDetach();
+
+    co::LocalNodePtr node = getLocalNode();
+    if( isMaster( ))
+    {
+        _impl->waitAll();
+        _impl->registered = false;
+        for( detail::ChunkedObject::Chunk* chunk : _impl->chunks )
+        {
+            if( chunk->isAttached( ))
+                node->deregisterObject( chunk );
+            chunk->dirty = true;
+        }
+        return;
+    }
+
+    for( detail::ChunkedObject::Chunk* chunk : _impl->chunks )
+        if( chunk->isAttached( ))
+            node->unmapObject( chunk );
+}
+
+}
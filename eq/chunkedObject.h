@@ -0,0 +1,120 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_CHUNKEDOBJECT_H
+#define EQ_CHUNKEDOBJECT_H
+
+#include <eq/api.h>
+#include <eq/types.h>
+#include <co/serializable.h> // base class
+
+namespace eq
+{
+namespace detail { class ChunkedObject; }
+
+/**
+ * A distributed object for large per-frame application data, committed in
+ * chunks by a pool of threads.
+ *
+ * The data of the object is partitioned into a fixed number of chunks, which
+ * the subclass serializes in serializeChunk() and deserializes in
+ * deserializeChunk(). Each chunk is distributed as a separate object. The
+ * master commit() only sends the versions of the chunks and returns the new
+ * version right away. The dirty chunks are serialized, compressed and sent
+ * concurrently by the commit threads, so Config::startFrame() is not blocked by
+ * a large delta. Slaves sync all chunks in parallel when syncing the object,
+ * waiting for the chunks still being transmitted. Chunks are mapped at the
+ * oldest committed version and synced forward, since a published chunk version
+ * may not exist yet when a slave maps the object.
+ *
+ * On the master, call setChunkDirty() before changing the data of a chunk. It
+ * waits until a pending commit of the chunk has serialized it.
+ *
+ * The object is registered and mapped like any other co::Object, e.g., as the
+ * frame data of a seq::Application. Master and slave instances need the same
+ * number of chunks. Further data is distributed by overriding serialize() and
+ * deserialize(), calling the ChunkedObject implementation, with dirty bits
+ * starting at DIRTY_CUSTOM.
+ */
+class ChunkedObject : public co::Serializable
+{
+public:
+    /** @return the number of chunks. @version 1.12 */
+    EQ_API size_t getNumChunks() const;
+
+    /**
+     * Mark the given chunk to be sent with the next commit.
+     *
+     * Has to be called on the master before the data of the chunk is changed.
+     * @version 1.12
+     */
+    EQ_API void setChunkDirty( size_t chunk );
+
+    /** Wait until all chunks of the last commit are sent. @version 1.12 */
+    EQ_API void waitCommitted() const;
+
+    /** @internal Start the commit of the dirty chunks. */
+    EQ_API uint128_t commit( uint32_t incarnation = CO_COMMIT_NEXT ) override;
+
+    /** The changed parts of the object since the last serialize(). */
+    enum DirtyBits
+    {
+        DIRTY_CHUNKS = co::Serializable::DIRTY_CUSTOM << 0,
+        DIRTY_CUSTOM = co::Serializable::DIRTY_CUSTOM << 1
+    };
+
+protected:
+    /**
+     * Construct a new chunked object.
+     *
+     * @param nChunks the number of chunks.
+     * @param nThreads the number of commit threads, 0 for one per core.
+     * @version 1.12
+     */
+    EQ_API explicit ChunkedObject( size_t nChunks, size_t nThreads = 0 );
+
+    /** Destruct this object. @version 1.12 */
+    EQ_API virtual ~ChunkedObject();
+
+    /**
+     * Serialize the data of a chunk, called concurrently from commit threads.
+     * @version 1.12
+     */
+    virtual void serializeChunk( co::DataOStream& os, size_t chunk ) = 0;
+
+    /**
+     * Deserialize the data of a chunk, called concurrently when syncing.
+     * @version 1.12
+     */
+    virtual void deserializeChunk( co::DataIStream& is, size_t chunk ) = 0;
+
+    EQ_API void serialize( co::DataOStream& os,
+                           uint64_t dirtyBits ) override; //!< @internal
+    EQ_API void deserialize( co::DataIStream& is,
+                             uint64_t dirtyBits ) override; //!< @internal
+    EQ_API void notifyDetach() override; //!< @internal
+
+private:
+    detail::ChunkedObject* const _impl;
+    friend class detail::ChunkedObject;
+
+    ChunkedObject( const ChunkedObject& ) = delete;
+    ChunkedObject& operator=( const ChunkedObject& ) = delete;
+};
+}
+
+#endif // EQ_CHUNKEDOBJECT_H
@@ -19,6 +19,7 @@
 #include "commandQueue.h"
 
 #include "messagePump.h"
+#include "detail/queueStatistics.h"
 
 #include <co/iCommand.h>
 #include <lunchbox/clock.h>
@@ -34,6 +35,8 @@ CommandQueue::CommandQueue( const size_t maxSize )
     : co::CommandQueue( maxSize )
     , _messagePump( 0 )
     , _waitTime( 0 )
+    , _statistics( new detail::QueueStatistics )
+    , _statisticsEnabled( 0 )
 {}
 
 CommandQueue::~CommandQueue()
@@ -41,10 +44,13 @@ CommandQueue::~CommandQueue()
     LBASSERT( !_messagePump );
     delete _messagePump;
     _messagePump = 0;
+    delete _statistics;
 }
 
 void CommandQueue::push( const co::ICommand& command )
 {
+    if( _statisticsEnabled )
+        _statistics->notifyPush( false );
     co::CommandQueue::push( command );
     if( _messagePump )
         _messagePump->postWakeup();
@@ -52,6 +58,8 @@ void CommandQueue::push( const co::ICommand& command )
 
 void CommandQueue::pushFront( const co::ICommand& command )
 {
+    if( _statisticsEnabled )
+        _statistics->notifyPush( true );
     co::CommandQueue::pushFront( command );
     if( _messagePump )
         _messagePump->postWakeup();
@@ -59,6 +67,9 @@ void CommandQueue::pushFront( const co::ICommand& command )
 
 co::ICommand CommandQueue::pop( const uint32_t timeout )
 {
+    if( _statisticsEnabled )
+        _statistics->notifyDispatchDone();
+
     const int64_t start = _clock.getTime64();
     int64_t waitBegin = -1;
     while( true )
@@ -71,7 +82,7 @@ co::ICommand CommandQueue::pop( const uint32_t timeout )
         {
             if( waitBegin > -1 )
                 _waitTime += ( _clock.getTime64() - waitBegin );
-            return co::CommandQueue::pop( 0 );
+            return _popped( co::CommandQueue::pop( 0 ));
         }
 
         if( _messagePump )
@@ -86,7 +97,7 @@ co::ICommand CommandQueue::pop( const uint32_t timeout )
             // blocking
             const co::ICommand& command = co::CommandQueue::pop( timeout );
             _waitTime += ( _clock.getTime64() - waitBegin );
-            return command;
+            return _popped( command );
         }
 
         if( _clock.getTime64() - start > timeout )
@@ -96,6 +107,9 @@ co::ICommand CommandQueue::pop( const uint32_t timeout )
 
 co::ICommands CommandQueue::popAll( const uint32_t timeout )
 {
+    if( _statisticsEnabled )
+        _statistics->notifyDispatchDone();
+
     const int64_t start = _clock.getTime64();
     int64_t waitBegin = -1;
     while( true )
@@ -108,7 +122,7 @@ co::ICommands CommandQueue::popAll( const uint32_t timeout )
         {
             if( waitBegin > -1 )
                 _waitTime += ( _clock.getTime64() - waitBegin );
-            return co::CommandQueue::popAll( 0 );
+            return _popped( co::CommandQueue::popAll( 0 ));
         }
 
         if( _messagePump )
@@ -123,7 +137,7 @@ co::ICommands CommandQueue::popAll( const uint32_t timeout )
             // blocking
             const co::ICommands& commands = co::CommandQueue::popAll( timeout );
             _waitTime += ( _clock.getTime64() - waitBegin );
-            return commands;
+            return _popped( commands );
         }
 
         if( _clock.getTime64() - start > timeout )
@@ -133,10 +147,26 @@ co::ICommands CommandQueue::popAll( const uint32_t timeout )
 
 co::ICommand CommandQueue::tryPop()
 {
+    if( _statisticsEnabled )
+        _statistics->notifyDispatchDone();
     if( _messagePump )
         _messagePump->dispatchAll(); // non-blocking
 
-    return co::CommandQueue::tryPop();
+    return _popped( co::CommandQueue::tryPop( ));
+}
+
+co::ICommand CommandQueue::_popped( const co::ICommand& command )
+{
+    if( _statisticsEnabled && command.isValid( ))
+        _statistics->notifyPop( co::ICommands( 1, command ), isEmpty( ));
+    return command;
+}
+
+co::ICommands CommandQueue::_popped( const co::ICommands& commands )
+{
+    if( _statisticsEnabled && !commands.empty( ))
+        _statistics->notifyPop( commands, isEmpty( ));
+    return commands;
 }
 
 void CommandQueue::pump()
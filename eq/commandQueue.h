@@ -25,6 +25,8 @@
 
 namespace eq
 {
+namespace detail { class QueueStatistics; }
+
 /**
  * @internal
  * Augments an co::CommandQueue to pump system-specific events where
@@ -57,6 +59,19 @@ public:
     int64_t resetWaitTime()
     { const int64_t time = _waitTime; _waitTime = 0; return time; }
 
+    /**
+     * Start recording the latency and handler time of all commands.
+     *
+     * The instrumentation is allocated with the queue, so that producer threads
+     * may enable or observe it at any time. Statistics can't be disabled once
+     * enabled.
+     */
+    void enableStatistics() { _statisticsEnabled = 1; }
+
+    /** @return the recorded command statistics, or 0 if disabled. */
+    detail::QueueStatistics* getStatistics()
+        { return _statisticsEnabled ? _statistics : 0; }
+
     void setMessagePump( MessagePump* p ) { _messagePump = p; }
     MessagePump* getMessagePump() { return _messagePump; }
     virtual void pump(); //!< @sa co::CommandQueue::pump()
@@ -66,6 +81,13 @@ private:
 
     /** The time spent waiting in pop(). */
     int64_t _waitTime;
+
+    /** The per-command instrumentation, used once enabled. */
+    detail::QueueStatistics* const _statistics;
+    a_int32_t _statisticsEnabled;
+
+    co::ICommand _popped( const co::ICommand& command );
+    co::ICommands _popped( const co::ICommands& commands );
 };
 }
 
@@ -18,6 +18,7 @@
  */
 
 #include "compressorReadDrawPixels.h"
+#include "readbackBuffer.h"
 
 #include <eq/fabric/pixelViewport.h>
 #include <eq/util/texture.h>
@@ -113,12 +114,14 @@ CompressorReadDrawPixels::CompressorReadDrawPixels( const unsigned name )
         : Compressor()
         , _texture( 0 )
         , _pbo( 0 )
+        , _readbackIndex( 0 )
         , _internalFormat( 0 )
         , _format( 0 )
         , _type( 0 )
         , _depth( _depths[ name ] )
 {
     LBASSERT( _depth > 0 );
+    _readback[0] = _readback[1] = 0;
     switch( name )
     {
         case EQ_COMPRESSOR_TRANSFER_RGBA_TO_RGBA:
@@ -283,6 +286,10 @@ CompressorReadDrawPixels::~CompressorReadDrawPixels( )
         delete _pbo;
         _pbo = 0;
     }
+    // no context here, buffers not flushed before are freed with the context
+    delete _readback[0];
+    delete _readback[1];
+    _readback[0] = _readback[1] = 0;
 }
 
 bool CompressorReadDrawPixels::isCompatible( const GLEWContext* )
@@ -484,6 +491,20 @@ void CompressorReadDrawPixels::startDownload( const GLEWContext* glewContext,
             return;
         }
 
+        // zero-copy async RB through persistently mapped PBOs, alternating
+        // buffers keeps the pixels of the last readback mapped while the
+        // next one runs
+        if( ReadbackBuffer::isSupported( glewContext ))
+        {
+            _readbackIndex = ( _readbackIndex + 1 ) % 2;
+            ReadbackBuffer*& readback = _readback[ _readbackIndex ];
+            if( !readback )
+                readback = new ReadbackBuffer;
+            if( readback->start( glewContext, dims, _format, _type, size ))
+                return;
+            _flushReadbacks( glewContext );
+        }
+
         if( _initPBO( glewContext, size ))
         {
             EQ_GL_CALL( glReadPixels( dims[0], dims[2], dims[1], dims[3],
@@ -507,6 +528,19 @@ void CompressorReadDrawPixels::startDownload( const GLEWContext* glewContext,
     }
 }
 
+void CompressorReadDrawPixels::_flushReadbacks(
+    const GLEWContext* glewContext )
+{
+    for( size_t i = 0; i < 2; ++i )
+    {
+        if( !_readback[i] )
+            continue;
+        _readback[i]->flush( glewContext );
+        delete _readback[i];
+        _readback[i] = 0;
+    }
+}
+
 void* CompressorReadDrawPixels::_downloadTexture(
     const GLEWContext* glewContext, const FlushMode mode )
 {
@@ -541,6 +575,19 @@ void CompressorReadDrawPixels::finishDownload(
         return;
     }
 
+    ReadbackBuffer* readback = _readback[ _readbackIndex ];
+    if( readback && readback->isPending( ))
+    {
+        *out = readback->finish( glewContext );
+        if( *out )
+            return;
+
+        LBERROR << "Can't finish persistent PBO readback" << std::endl;
+        _resizeBuffer( inDims[1] * inDims[3] * _depth );
+        *out = _buffer.getData();
+        return;
+    }
+
     if( _pbo && _pbo->isInitialized( ))
     {
         const eq_uint64_t size = inDims[1] * inDims[3] * _depth;
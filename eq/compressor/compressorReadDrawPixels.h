@@ -27,6 +27,7 @@ namespace eq
 {
 namespace plugin
 {
+class ReadbackBuffer;
 
 enum FlushMode
 {
@@ -68,12 +69,16 @@ protected:
     lunchbox::Bufferb _buffer;
     util::Texture*    _texture;
     util::PixelBufferObject* _pbo;
+    /** Persistently mapped PBOs, if supported, used in turns. */
+    ReadbackBuffer*   _readback[ 2 ];
+    unsigned    _readbackIndex;  //!< the buffer of the last readback
     unsigned    _internalFormat; //!< the GL format
     unsigned    _format;         //!< the GL format
     unsigned    _type;           //!< the GL type
     const unsigned _depth;       //!< the size of one output token
 
     void _resizeBuffer( const eq_uint64_t );
+    void _flushReadbacks( const GLEWContext* );
     void _initTexture( const GLEWContext*, const eq_uint64_t );
     void _initAsyncTexture( const GLEWContext*, const eq_uint64_t,
                             const eq_uint64_t );
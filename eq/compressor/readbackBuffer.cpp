@@ -0,0 +1,159 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "readbackBuffer.h"
+
+#include <lunchbox/debug.h>
+
+#define glewGetContext() glewContext
+
+namespace eq
+{
+namespace plugin
+{
+namespace
+{
+#ifdef GL_ARB_buffer_storage
+const GLbitfield _mapFlags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                             GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+#endif
+
+/** The time to wait for a fence before warning about a stalled readback. */
+const GLuint64 _timeout = 1000000000ull; // ns
+}
+
+ReadbackBuffer::ReadbackBuffer()
+    : _id( 0 )
+    , _size( 0 )
+    , _data( 0 )
+    , _fence( 0 )
+{}
+
+ReadbackBuffer::~ReadbackBuffer()
+{
+    if( _id != 0 )
+        LBWARN << "OpenGL buffer " << _id << " not freed" << std::endl;
+}
+
+bool ReadbackBuffer::isSupported( const GLEWContext* glewContext )
+{
+#ifdef GL_ARB_buffer_storage
+    return glewContext && GLEW_ARB_buffer_storage && GLEW_ARB_sync;
+#else
+    (void)glewContext;
+    return false;
+#endif
+}
+
+bool ReadbackBuffer::start( const GLEWContext* glewContext,
+                            const eq_uint64_t dims[4], const unsigned format,
+                            const unsigned type, const eq_uint64_t size )
+{
+    if( !_resize( glewContext, size ))
+        return false;
+
+    if( _fence ) // previous readback was never finished
+    {
+        EQ_GL_CALL( glDeleteSync( _fence ));
+        _fence = 0;
+    }
+
+    EQ_GL_CALL( glBindBuffer( GL_PIXEL_PACK_BUFFER, _id ));
+    EQ_GL_CALL( glReadPixels( dims[0], dims[2], dims[1], dims[3], format, type,
+                              0 ));
+    _fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    EQ_GL_CALL( glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 ));
+
+    // the fence is waited for by the transfer thread in a shared context
+    glFlush();
+    return _fence != 0;
+}
+
+void* ReadbackBuffer::finish( const GLEWContext* glewContext )
+{
+    if( !_fence )
+        return 0;
+
+    for( ;; )
+    {
+        const GLenum result = glClientWaitSync( _fence,
+                                                GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                _timeout );
+        if( result == GL_ALREADY_SIGNALED ||
+            result == GL_CONDITION_SATISFIED )
+        {
+            break;
+        }
+        if( result == GL_WAIT_FAILED )
+        {
+            EQ_GL_ERROR( "glClientWaitSync" );
+            EQ_GL_CALL( glDeleteSync( _fence ));
+            _fence = 0;
+            return 0;
+        }
+        LBWARN << "Readback of " << _size << " bytes not finished after "
+               << _timeout / 1000000 << " ms" << std::endl;
+    }
+
+    EQ_GL_CALL( glDeleteSync( _fence ));
+    _fence = 0;
+    return _data;
+}
+
+bool ReadbackBuffer::_resize( const GLEWContext* glewContext,
+                              const eq_uint64_t size )
+{
+    if( _data && _size >= size )
+        return true;
+
+    // the storage is immutable, allocate a new buffer to grow
+    flush( glewContext );
+#ifdef GL_ARB_buffer_storage
+    EQ_GL_CALL( glGenBuffers( 1, &_id ));
+    EQ_GL_CALL( glBindBuffer( GL_PIXEL_PACK_BUFFER, _id ));
+    EQ_GL_CALL( glBufferStorage( GL_PIXEL_PACK_BUFFER, size, 0,
+                                 _mapFlags | GL_CLIENT_STORAGE_BIT ));
+    _data = glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, size, _mapFlags );
+    EQ_GL_CALL( glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 ));
+#endif
+
+    if( !_data )
+    {
+        LBWARN << "Can't map persistent buffer of " << size << " bytes"
+               << std::endl;
+        flush( glewContext );
+        return false;
+    }
+    _size = size;
+    return true;
+}
+
+void ReadbackBuffer::flush( const GLEWContext* glewContext )
+{
+    if( _fence )
+        EQ_GL_CALL( glDeleteSync( _fence ));
+    if( _id ) // unmaps the storage
+        EQ_GL_CALL( glDeleteBuffers( 1, &_id ));
+
+    _id = 0;
+    _size = 0;
+    _data = 0;
+    _fence = 0;
+}
+
+}
+}
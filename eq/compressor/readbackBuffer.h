@@ -0,0 +1,84 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PLUGIN_READBACKBUFFER
+#define EQ_PLUGIN_READBACKBUFFER
+
+#include <eq/gl.h>
+
+namespace eq
+{
+namespace plugin
+{
+/**
+ * A pixel pack buffer which stays mapped for its lifetime.
+ *
+ * A readback into the buffer is guarded by a fence. Once finish() returns, the
+ * mapped memory holds the pixels and is handed to the compressors directly,
+ * without copying it out of the buffer. The memory stays valid until the next
+ * readback into the same buffer.
+ *
+ * The GL objects are only released by flush(), which has to be called with a
+ * context sharing the one used in start(). The destructor does not call GL.
+ *
+ * Needs GL_ARB_buffer_storage and GL_ARB_sync, as provided by current drivers
+ * and by Mesa's software rasterizers.
+ */
+class ReadbackBuffer
+{
+public:
+    ReadbackBuffer();
+    ~ReadbackBuffer();
+
+    /** @return true if persistently mapped buffers are supported. */
+    static bool isSupported( const GLEWContext* glewContext );
+
+    /**
+     * Start reading the given area of the framebuffer into the buffer.
+     *
+     * @return true on success, false if the buffer could not be allocated.
+     */
+    bool start( const GLEWContext* glewContext, const eq_uint64_t dims[4],
+                unsigned format, unsigned type, eq_uint64_t size );
+
+    /**
+     * Wait for the readback, from any context sharing the one used in start().
+     *
+     * @return the mapped pixels, or 0 on error.
+     */
+    void* finish( const GLEWContext* glewContext );
+
+    /** @return true if a readback was started but not finished. */
+    bool isPending() const { return _fence != 0; }
+
+    /** Delete the fence and the buffer, unmapping the pixels. */
+    void flush( const GLEWContext* glewContext );
+
+private:
+    unsigned _id;     //!< the GL buffer name
+    eq_uint64_t _size;  //!< the size of the buffer storage
+    void* _data;        //!< the persistently mapped storage
+    GLsync _fence;      //!< set after the readback, deleted in finish()
+
+    bool _resize( const GLEWContext* glewContext, eq_uint64_t size );
+
+    ReadbackBuffer( const ReadbackBuffer& ) = delete;
+    ReadbackBuffer& operator=( const ReadbackBuffer& ) = delete;
+};
+}
+}
+#endif // EQ_PLUGIN_READBACKBUFFER
@@ -138,6 +138,13 @@ public:
 #ifdef EQUALIZER_USE_GLSTATS
     /** Global statistics data. */
     lunchbox::Lockable< GLStats::Data, lunchbox::SpinLock > statistics;
+
+    /** The pipe idle part of the statistics text. */
+    std::string idleText;
+
+    /** The slowest command per queue and type of the last sampled frame. */
+    typedef std::map< std::string, Statistic > QueueStatistics;
+    QueueStatistics slowestCommands;
 #endif
 
     /** The last started frame. */
@@ -388,6 +395,8 @@ bool Config::update()
     client->enableSendOnRegister();
 #ifdef EQUALIZER_USE_GLSTATS
     _impl->statistics->clear();
+    _impl->idleText.clear();
+    _impl->slowestCommands.clear();
 #endif
     handleEvents();
     return result;
@@ -801,6 +810,9 @@ void Config::addStatistic( const uint32_t originator LB_UNUSED,
           item.thread = THREAD_ASYNC2;
           // no break;
       case Statistic::CHANNEL_FRAME_WAIT_READY:
+      case Statistic::CHANNEL_CULL:
+      case Statistic::CHANNEL_EMPTY_SPACE:
+      case Statistic::CHANNEL_FRAME_WAIT_DUMP:
           type.group = "channel";
           item.layer = 1;
           break;
@@ -843,7 +855,7 @@ void Config::addStatistic( const uint32_t originator LB_UNUSED,
 
       case Statistic::PIPE_IDLE:
       {
-          const std::string& string = _impl->statistics->getText();
+          const std::string& string = _impl->idleText;
           const float idle = stat.idleTime * 100ll / stat.totalTime;
           std::stringstream text;
           if( string.empty( ))
@@ -863,9 +875,25 @@ void Config::addStatistic( const uint32_t originator LB_UNUSED,
                        << idle << left.substr( left.find( '%' ));
               }
           }
-          _impl->statistics->setText( text.str( ));
+          _impl->idleText = text.str();
+          _updateStatisticsText();
+          return;
+      }
+
+      case Statistic::PIPE_COMMAND_LATENCY:
+      case Statistic::PIPE_COMMAND_HANDLE:
+      {
+          const std::string key = std::string( stat.resourceName ) + ' ' +
+                                  Statistic::getName( stat.type );
+          Statistic& slowest = _impl->slowestCommands[ key ];
+          if( slowest.frameNumber != stat.frameNumber ||
+              slowest.percentile99 < stat.percentile99 )
+          {
+              slowest = stat;
+              _updateStatisticsText();
+          }
+          return;
       }
-      // no break;
 
       case Statistic::WINDOW_FPS:
       case Statistic::NONE:
@@ -877,6 +905,7 @@ void Config::addStatistic( const uint32_t originator LB_UNUSED,
       case Statistic::CHANNEL_FRAME_COMPRESS:
       case Statistic::CHANNEL_ASYNC_READBACK:
       case Statistic::CHANNEL_READBACK:
+      case Statistic::CHANNEL_EMPTY_SPACE:
       {
           std::stringstream text;
           text << unsigned( 100.f * stat.ratio ) << '%';
@@ -901,6 +930,27 @@ void Config::addStatistic( const uint32_t originator LB_UNUSED,
 #endif
 }
 
+void Config::_updateStatisticsText()
+{
+#ifdef EQUALIZER_USE_GLSTATS
+    std::stringstream text;
+    text << _impl->idleText;
+
+    // Report the command with the worst tail latency per queue
+    for( detail::Config::QueueStatistics::const_iterator i =
+             _impl->slowestCommands.begin();
+         i != _impl->slowestCommands.end(); ++i )
+    {
+        const Statistic& slowest = i->second;
+        if( !text.str().empty( ))
+            text << ", ";
+        text << i->first << " cmd " << slowest.command << " p99 "
+             << slowest.percentile99 << "us";
+    }
+    _impl->statistics->setText( text.str( ));
+#endif
+}
+
 bool Config::_needsLocalSync() const
 {
     const Nodes& nodes = getNodes();
@@ -489,6 +489,7 @@ private:
     friend class Node;
 
     bool _needsLocalSync() const;
+    void _updateStatisticsText();
 
     bool _handleNewEvent( EventICommand& command );
     bool _handleEvent( const Event& event );
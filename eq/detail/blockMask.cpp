@@ -0,0 +1,278 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "blockMask.h"
+
+#include "../pixelData.h"
+
+#include <lunchbox/debug.h>
+#include <algorithm>
+#include <cstring>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+/** @return true if any of the n pixels differs from the background. */
+template< size_t size >
+bool _differs( const uint8_t* pixels, const size_t n, const uint8_t* bg )
+{
+    for( size_t i = 0; i < n; ++i, pixels += size )
+        if( ::memcmp( pixels, bg, size ) != 0 )
+            return true;
+    return false;
+}
+
+bool _differs( const uint8_t* pixels, const size_t n, const uint8_t* bg,
+               const size_t size )
+{
+    switch( size )
+    {
+    case 4: return _differs< 4 >( pixels, n, bg );
+    case 8: return _differs< 8 >( pixels, n, bg );
+    case 16: return _differs< 16 >( pixels, n, bg );
+    default:
+        for( size_t i = 0; i < n; ++i, pixels += size )
+            if( ::memcmp( pixels, bg, size ) != 0 )
+                return true;
+        return false;
+    }
+}
+
+/** @return a row of one block width filled with the background. */
+std::vector< uint8_t > _makeRow( const uint8_t* bg, const size_t size,
+                                 const size_t n )
+{
+    std::vector< uint8_t > row( size * n );
+    for( size_t i = 0; i < n; ++i )
+        ::memcpy( &row[ i * size ], bg, size );
+    return row;
+}
+}
+
+BlockMask::BlockMask()
+    : _blockSize( 0 )
+    , _nBlocksX( 0 )
+    , _nBlocksY( 0 )
+    , _nOccupied( 0 )
+{}
+
+void BlockMask::reset( const PixelViewport& pvp, const uint32_t blockSize )
+{
+    LBASSERT( blockSize > 0 );
+    LBASSERT( pvp.hasArea( ));
+    _pvp = pvp;
+    _blockSize = blockSize;
+    _nBlocksX = ( pvp.w + blockSize - 1 ) / blockSize;
+    _nBlocksY = ( pvp.h + blockSize - 1 ) / blockSize;
+    _nOccupied = 0;
+    _bits.assign( getNumBytes( pvp, blockSize ), 0 );
+}
+
+size_t BlockMask::getNumBytes( const PixelViewport& pvp,
+                               const uint32_t blockSize )
+{
+    const size_t nBlocksX = ( pvp.w + blockSize - 1 ) / blockSize;
+    const size_t nBlocksY = ( pvp.h + blockSize - 1 ) / blockSize;
+    return ( nBlocksX * nBlocksY + 7 ) / 8;
+}
+
+void BlockMask::addOccupied( const PixelData& pixels, const void* background )
+{
+    LBASSERT( pixels.pvp.w == _pvp.w && pixels.pvp.h == _pvp.h );
+    const size_t size = pixels.pixelSize;
+    const size_t width = _pvp.w;
+    const uint8_t* data = static_cast< const uint8_t* >( pixels.pixels );
+    const uint8_t* bg = static_cast< const uint8_t* >( background );
+
+    for( size_t y = 0; y < size_t( _pvp.h ); ++y )
+    {
+        const uint8_t* row = data + y * width * size;
+        const size_t first = ( y / _blockSize ) * _nBlocksX;
+        for( size_t x = 0; x < _nBlocksX; ++x )
+        {
+            if( _isOccupied( first + x ))
+                continue;
+
+            const size_t start = x * _blockSize;
+            const size_t n = std::min< size_t >( _blockSize, width - start );
+            if( _differs( row + start * size, n, bg, size ))
+                _setOccupied( first + x );
+        }
+    }
+    _count();
+}
+
+void BlockMask::addChanged( const PixelData& pixels,
+                            const PixelData& reference )
+{
+    LBASSERT( pixels.pvp.w == _pvp.w && pixels.pvp.h == _pvp.h );
+    LBASSERT( reference.pvp.w == _pvp.w && reference.pvp.h == _pvp.h );
+    LBASSERT( pixels.pixelSize == reference.pixelSize );
+    const size_t size = pixels.pixelSize;
+    const size_t width = _pvp.w;
+    const uint8_t* data = static_cast< const uint8_t* >( pixels.pixels );
+    const uint8_t* ref = static_cast< const uint8_t* >( reference.pixels );
+
+    for( size_t y = 0; y < size_t( _pvp.h ); ++y )
+    {
+        const size_t offset = y * width * size;
+        const size_t first = ( y / _blockSize ) * _nBlocksX;
+        for( size_t x = 0; x < _nBlocksX; ++x )
+        {
+            if( _isOccupied( first + x ))
+                continue;
+
+            const size_t start = offset + x * _blockSize * size;
+            const size_t n = std::min< size_t >( _blockSize,
+                                                 width - x * _blockSize );
+            if( ::memcmp( data + start, ref + start, n * size ) != 0 )
+                _setOccupied( first + x );
+        }
+    }
+    _count();
+}
+
+void BlockMask::setBits( const uint8_t* bits )
+{
+    ::memcpy( _bits.data(), bits, _bits.size( ));
+    _count();
+}
+
+PixelViewport BlockMask::getPackedViewport() const
+{
+    return PixelViewport( 0, 0, _blockSize, int32_t( _nOccupied*_blockSize ));
+}
+
+void BlockMask::pack( const PixelData& pixels, const void* bg,
+                      void* out ) const
+{
+    LBASSERT( pixels.pvp.w == _pvp.w && pixels.pvp.h == _pvp.h );
+    const size_t size = pixels.pixelSize;
+    const size_t width = _pvp.w;
+    const size_t height = _pvp.h;
+    const size_t rowSize = _blockSize * size;
+    const uint8_t* data = static_cast< const uint8_t* >( pixels.pixels );
+    const std::vector< uint8_t > background =
+        _makeRow( static_cast< const uint8_t* >( bg ), size, _blockSize );
+    uint8_t* to = static_cast< uint8_t* >( out );
+
+    for( size_t i = 0; i < getNumBlocks(); ++i )
+    {
+        if( !_isOccupied( i ))
+            continue;
+
+        const size_t x = ( i % _nBlocksX ) * _blockSize;
+        const size_t y = ( i / _nBlocksX ) * _blockSize;
+        const size_t n = std::min< size_t >( _blockSize, width - x );
+        for( size_t j = 0; j < _blockSize; ++j, to += rowSize )
+        {
+            if( y + j >= height )
+            {
+                ::memcpy( to, background.data(), rowSize );
+                continue;
+            }
+            ::memcpy( to, data + (( y + j ) * width + x ) * size, n * size );
+            ::memcpy( to + n * size, background.data(), rowSize - n * size );
+        }
+    }
+}
+
+void BlockMask::unpack( const void* blocks, const void* bg,
+                        PixelData& pixels ) const
+{
+    LBASSERT( pixels.pvp.w == _pvp.w && pixels.pvp.h == _pvp.h );
+    const size_t size = pixels.pixelSize;
+    const size_t width = _pvp.w;
+    const size_t height = _pvp.h;
+    const size_t blockBytes = _blockSize * _blockSize * size;
+    const std::vector< uint8_t > background = bg ?
+        _makeRow( static_cast< const uint8_t* >( bg ), size, _blockSize ) :
+        std::vector< uint8_t >();
+    const uint8_t* from = static_cast< const uint8_t* >( blocks );
+    uint8_t* data = static_cast< uint8_t* >( pixels.pixels );
+
+    size_t first = 0; // packed index of the first block of the block row
+    for( size_t y = 0; y < height; ++y )
+    {
+        const size_t blockY = y / _blockSize;
+        const size_t j = y - blockY * _blockSize; // row within the block
+        if( j == 0 && blockY > 0 )
+        {
+            for( size_t x = 0; x < _nBlocksX; ++x )
+                if( _isOccupied( ( blockY - 1 ) * _nBlocksX + x ))
+                    ++first;
+        }
+
+        uint8_t* row = data + y * width * size;
+        size_t packed = first;
+        for( size_t x = 0; x < _nBlocksX; ++x )
+        {
+            const size_t start = x * _blockSize;
+            const size_t n = std::min< size_t >( _blockSize, width - start );
+            uint8_t* to = row + start * size;
+            if( _isOccupied( blockY * _nBlocksX + x ))
+            {
+                ::memcpy( to, from + packed * blockBytes +
+                              j * _blockSize * size, n * size );
+                ++packed;
+            }
+            else if( bg )
+                ::memcpy( to, background.data(), n * size );
+        }
+    }
+}
+
+void BlockMask::copy( const PixelData& from, PixelData& to ) const
+{
+    LBASSERT( from.pvp.w == _pvp.w && from.pvp.h == _pvp.h );
+    LBASSERT( to.pvp.w == _pvp.w && to.pvp.h == _pvp.h );
+    LBASSERT( from.pixelSize == to.pixelSize );
+    const size_t size = from.pixelSize;
+    const size_t width = _pvp.w;
+    const uint8_t* source = static_cast< const uint8_t* >( from.pixels );
+    uint8_t* dest = static_cast< uint8_t* >( to.pixels );
+
+    for( size_t y = 0; y < size_t( _pvp.h ); ++y )
+    {
+        const size_t offset = y * width * size;
+        const size_t first = ( y / _blockSize ) * _nBlocksX;
+        for( size_t x = 0; x < _nBlocksX; ++x )
+        {
+            if( !_isOccupied( first + x ))
+                continue;
+
+            const size_t start = offset + x * _blockSize * size;
+            const size_t n = std::min< size_t >( _blockSize,
+                                                 width - x * _blockSize );
+            ::memcpy( dest + start, source + start, n * size );
+        }
+    }
+}
+
+void BlockMask::_count()
+{
+    _nOccupied = 0;
+    for( size_t i = 0; i < getNumBlocks(); ++i )
+        if( _isOccupied( i ))
+            ++_nOccupied;
+}
+
+}
+}
@@ -0,0 +1,118 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_BLOCKMASK_H
+#define EQ_DETAIL_BLOCKMASK_H
+
+#include <eq/types.h>
+
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+
+/**
+ * The occupancy of the square blocks of an image, one bit per block.
+ *
+ * A block is empty if all its pixels equal the background, i.e., the clear
+ * color or the clear depth, see Image::getBackground(). Occupied blocks are
+ * packed into a column of full blocks, i.e., an image of one block width,
+ * padding the blocks at the right and top edge with the background. The packed pixels are compressed and transmitted
+ * like any other image: Channel::_transmitImage sends the bit field and the
+ * background pixel after the FrameData::ImageHeader, whose viewport is the one
+ * of the packed blocks.
+ *
+ * For the temporal delta encoding, the mask marks the blocks which changed
+ * since a reference frame instead, and all other blocks are taken from the
+ * reference image of the receiver.
+ */
+class BlockMask
+{
+public:
+    BlockMask();
+
+    /** Size the mask for the given viewport and mark all blocks empty. */
+    void reset( const PixelViewport& pvp, uint32_t blockSize );
+
+    /** Mark the blocks containing pixels different from the background. */
+    void addOccupied( const PixelData& pixels, const void* background );
+
+    /** Mark the blocks containing pixels different from the reference. */
+    void addChanged( const PixelData& pixels, const PixelData& reference );
+
+    /** Set the mask from a transmitted bit field of getNumBytes() size. */
+    void setBits( const uint8_t* bits );
+
+    /** @return the bit field of occupied blocks, row by row. */
+    const uint8_t* getBits() const { return _bits.data(); }
+
+    /** @return the size of the bit field in bytes. */
+    size_t getNumBytes() const { return _bits.size(); }
+
+    /** @return the size of the bit field for the given viewport in bytes. */
+    static size_t getNumBytes( const PixelViewport& pvp, uint32_t blockSize );
+
+    /** @return the width and height of one block. */
+    uint32_t getBlockSize() const { return _blockSize; }
+
+    /** @return the total number of blocks. */
+    size_t getNumBlocks() const { return _nBlocksX * _nBlocksY; }
+
+    /** @return the number of occupied blocks. */
+    size_t getNumOccupied() const { return _nOccupied; }
+
+    /** @return the viewport of the packed occupied blocks. */
+    PixelViewport getPackedViewport() const;
+
+    /**
+     * Copy the occupied blocks of the pixels into a column of blocks, padding
+     * the edge blocks with the background.
+     */
+    void pack( const PixelData& pixels, const void* background,
+               void* out ) const;
+
+    /**
+     * Fill the pixels with the background, and copy the packed blocks into
+     * their occupied positions. Empty blocks are left untouched if no
+     * background is given.
+     */
+    void unpack( const void* blocks, const void* background,
+                 PixelData& pixels ) const;
+
+    /** Copy the occupied blocks between two images of the mask's size. */
+    void copy( const PixelData& from, PixelData& to ) const;
+
+private:
+    PixelViewport _pvp;
+    uint32_t _blockSize;
+    size_t _nBlocksX;
+    size_t _nBlocksY;
+    size_t _nOccupied;
+    std::vector< uint8_t > _bits;
+
+    bool _isOccupied( const size_t i ) const
+        { return _bits[ i >> 3 ] & ( 1u << ( i & 7 )); }
+    void _setOccupied( const size_t i ) { _bits[ i >> 3 ] |= 1u << ( i & 7 ); }
+    void _count();
+};
+
+}
+}
+
+#endif // EQ_DETAIL_BLOCKMASK_H
@@ -21,8 +21,15 @@
 #include "../image.h"
 #include "../resultImageListener.h"
 #include "fileFrameWriter.h"
+#include "referenceImage.h"
 
+#include <co/objectVersion.h>
+#include <lunchbox/lock.h>
+#include <lunchbox/lockable.h>
+#include <lunchbox/scopedMutex.h>
 #include <boost/foreach.hpp>
+#include <map>
+#include <tuple>
 
 #ifdef EQUALIZER_USE_DEFLECT
 #  include "../deflect/proxy.h"
@@ -61,6 +68,11 @@ public:
     ~Channel()
     {
         statistics->clear();
+        for( ReferenceImages::const_iterator i = referenceImages.begin();
+             i != referenceImages.end(); ++i )
+        {
+            delete i->second;
+        }
     }
 
     void addResultImageListener( ResultImageListener* listener )
@@ -84,7 +96,10 @@ public:
     void frameViewFinish( eq::Channel& channel )
     {
         if( channel.getSAttribute( channel.SATTR_DUMP_IMAGE ).empty( ))
+        {
             removeResultImageListener( &frameWriter );
+            frameWriter.stop();
+        }
         else
         {
             ResultImageListeners::iterator i =
@@ -110,6 +125,38 @@ public:
             listener->notifyNewImage( channel, framebufferImage );
     }
 
+    /** The destination node, eye and index of a transmitted image. */
+    typedef std::tuple< uint128_t, Eye, uint64_t > ReferenceKey;
+
+    /**
+     * @return the last frame sent for the given image, dropping the ones
+     *         unused for too long. Lock the returned reference while using it.
+     */
+    ReferenceImage* getReferenceImage( const ReferenceKey& key,
+                                       const uint32_t frameNumber )
+    {
+        lunchbox::ScopedMutex<> mutex( referenceLock );
+        ReferenceImages::iterator i = referenceImages.begin();
+        while( i != referenceImages.end( ))
+        {
+            if( i->first != key && i->second->isObsolete( frameNumber ))
+            {
+                delete i->second;
+                referenceImages.erase( i++ );
+            }
+            else
+                ++i;
+        }
+
+        ReferenceImage*& reference = referenceImages[ key ];
+        if( !reference )
+            reference = new ReferenceImage( lunchbox::make_UUID( ));
+        else if( reference->isObsolete( frameNumber ))
+            reference->invalidate(); // dropped by the receiver
+        reference->lastFrame = frameNumber;
+        return reference;
+    }
+
     void downloadFramebuffer( eq::Channel& channel )
     {
         framebufferImage.setAlphaUsage( true );
@@ -172,6 +219,32 @@ public:
     /** Dumps images when the channel is configured to do so */
     FileFrameWriter frameWriter;
 
+    /** The references of the delta encoded output frames. */
+    typedef std::map< ReferenceKey, ReferenceImage* > ReferenceImages;
+    ReferenceImages referenceImages;
+    lunchbox::Lock referenceLock;
+
+    /** A ready signal waiting for the image transmissions of its frame. */
+    struct ReadyNode
+    {
+        co::ObjectVersion frameData;
+        std::vector< uint128_t > nodes;
+        co::NodeIDs netNodes;
+    };
+    typedef std::vector< ReadyNode > ReadyNodes;
+
+    /** The queued image transmissions of one frame. */
+    struct Transmits
+    {
+        Transmits() : pending( 0 ) {}
+        uint32_t pending; //!< queued or running image transmissions
+        ReadyNodes readyNodes; //!< signals sent once all are finished
+    };
+    typedef std::map< uint32_t, Transmits > TransmitsMap;
+
+    /** The image transmissions in flight, by frame number. */
+    lunchbox::Lockable< TransmitsMap > transmits;
+
     bool _updateFrameBuffer;
 };
 
@@ -17,33 +17,299 @@
 
 #include "fileFrameWriter.h"
 
+#include "frameCapture.h"
+
 #include <eq/channel.h>
+#include <eq/channelStatistics.h>
 #include <eq/image.h>
+#include <eq/pixelData.h>
 
+#include <lunchbox/buffer.h>
+#include <lunchbox/clock.h>
 #include <lunchbox/log.h>
+#include <lunchbox/thread.h>
+#include <pression/compressor.h>
+
+#include <algorithm>
 
 namespace eq
 {
 namespace detail
 {
+namespace
+{
+/** Writer threads per channel, overlapping conversion and file I/O. */
+const size_t _nWriters = 2;
+
+/** Pooled buffers per channel, bounds the memory use and the queue. */
+const size_t _nBuffers = 4;
+
+const std::string _sequenceExtension( ".eqs" );
+
+bool _isSequence( const std::string& name )
+{
+    return name.size() > _sequenceExtension.size() &&
+           name.compare( name.size() - _sequenceExtension.size(),
+                         _sequenceExtension.size(), _sequenceExtension ) == 0;
+}
+}
+
+/** The copy of one image, owned by the pool when unused. */
+struct FileFrameWriter::Dump
+{
+    Dump() : premultipliedAlpha( false ), sequence( 0 ), slot( 0 )
+           , frameNumber( 0 ) {}
+
+    PixelData data; // pixels point to buffer
+    lunchbox::Bufferb buffer;
+    bool premultipliedAlpha;
+
+    std::string filename; // or:
+    FrameCapture* sequence;
+    uint64_t slot;
+    uint32_t frameNumber;
+    uint128_t channelID;
+    RenderContext context;
+};
+
+class FileFrameWriter::Writer : public lunchbox::Thread
+{
+public:
+    explicit Writer( FileFrameWriter& parent ) : _parent( parent ) {}
+
+protected:
+    bool init() override { setName( "Dump" ); return true; }
+
+    void run() override
+    {
+        while( Dump* dump = _parent._pop( ))
+            _parent._release( dump, _write( *dump ));
+        _compressor.clear();
+    }
+
+private:
+    FileFrameWriter& _parent;
+    pression::Compressor _compressor; // for image sequences
+    std::vector< uint8_t > _payload;
+
+    bool _write( const Dump& dump )
+    {
+        if( dump.sequence )
+        {
+            _payload.clear();
+            FrameCapture::packImage( dump.data, 1.f, &_compressor, _payload );
+            return _parent._append( dump, _payload );
+        }
+
+        if( Image::writeImage( dump.filename, dump.data,
+                               dump.premultipliedAlpha ))
+        {
+            return true;
+        }
+        LBWARN << "Could not write file " << dump.filename << std::endl;
+        return false;
+    }
+};
+
 FileFrameWriter::FileFrameWriter()
     : ResultImageListener()
+    , _nDumps( 0 )
+    , _nPending( 0 )
+    , _running( false )
+    , _nSequenced( 0 )
+    , _nextSlot( 0 )
 {
 }
 
+FileFrameWriter::~FileFrameWriter()
+{
+    stop();
+}
+
 void FileFrameWriter::notifyNewImage( eq::Channel& channel,
                                       const eq::Image& image )
 {
     const std::string& prefix =
             channel.getSAttribute( eq::Channel::SATTR_DUMP_IMAGE );
     LBASSERT( !prefix.empty( ));
-    const std::string fileName = prefix + channel.getDumpImageFileName();
-    if( !image.writeImage( fileName, eq::Frame::BUFFER_COLOR ))
-        LBWARN << "Could not write file " << fileName << std::endl;
+
+    if( !image.hasPixelData( eq::Frame::BUFFER_COLOR ))
+    {
+        LBWARN << "Could not dump image of frame " << channel.getCurrentFrame()
+               << ", no pixel data" << std::endl;
+        return;
+    }
+
+    const bool isSequence = _isSequence( prefix );
+    if( isSequence != bool( _sequence ) ||
+        ( _sequence && _sequence->getFilename() != prefix ))
+    {
+        flush();
+        _sequence.reset( isSequence ? new FrameCapture( prefix ) : 0 );
+        _nSequenced = 0;
+        _nextSlot = 0;
+    }
+
+    const PixelData& data = image.getPixelData( eq::Frame::BUFFER_COLOR );
+    Dump* dump = _obtainDump( channel );
+    dump->buffer.replace( data.pixels, data.pvp.getArea() * data.pixelSize );
+    dump->data.internalFormat = data.internalFormat;
+    dump->data.externalFormat = data.externalFormat;
+    dump->data.pixelSize = data.pixelSize;
+    dump->data.pvp = data.pvp;
+    dump->data.pixels = dump->buffer.getData();
+    dump->premultipliedAlpha = image.hasPremultipliedAlpha();
+    dump->frameNumber = channel.getCurrentFrame();
+    dump->channelID = channel.getID();
+    dump->context = image.getContext();
+    dump->sequence = _sequence.get();
+    if( !dump->sequence )
+        dump->filename = prefix + channel.getDumpImageFileName();
+
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        if( dump->sequence )
+            dump->slot = _nSequenced++;
+        _queue.push_back( dump );
+        _stats.maxQueued = std::max( _stats.maxQueued, _nPending );
+    }
+    _condition.notify_all();
 }
 
-FileFrameWriter::~FileFrameWriter()
+void FileFrameWriter::flush()
+{
+    std::unique_lock< std::mutex > lock( _mutex );
+    _condition.wait( lock, [this] { return _nPending == 0; } );
+}
+
+void FileFrameWriter::stop()
+{
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        if( !_running )
+            return;
+        _condition.wait( lock, [this] { return _nPending == 0; } );
+        _running = false;
+    }
+    _condition.notify_all();
+
+    for( Writer* writer : _writers )
+    {
+        writer->join();
+        delete writer;
+    }
+    _writers.clear();
+
+    for( Dump* dump : _free )
+        delete dump;
+    _free.clear();
+    _nDumps = 0;
+    _sequence.reset();
+    _nSequenced = 0;
+    _nextSlot = 0;
+
+    if( _stats.nImages > 0 )
+        LBINFO << "Dumped " << _stats.nImages << " images, "
+               << ( _stats.nBytes >> 20 ) << " MB, pipe thread waited "
+               << _stats.nStalls << " times for " << _stats.stallTime
+               << " ms, at most " << _stats.maxQueued << " images queued"
+               << std::endl;
+    _stats = Statistics();
+}
+
+FileFrameWriter::Dump* FileFrameWriter::_obtainDump( Channel& channel )
+{
+    std::unique_lock< std::mutex > lock( _mutex );
+    if( !_running )
+    {
+        _running = true;
+        for( size_t i = 0; i < _nWriters; ++i )
+        {
+            _writers.push_back( new Writer( *this ));
+            _writers.back()->start();
+        }
+    }
+
+    ++_nPending;
+    if( _free.empty() && _nDumps < _nBuffers )
+    {
+        ++_nDumps;
+        return new Dump;
+    }
+
+    if( _free.empty( ))
+    {
+        if( _stats.nStalls == 0 )
+            LBWARN << "Image dump can't keep up, blocking pipe thread"
+                   << std::endl;
+        ++_stats.nStalls;
+        ChannelStatistics event( Statistic::CHANNEL_FRAME_WAIT_DUMP, &channel );
+        const lunchbox::Clock clock;
+        _condition.wait( lock, [this] { return !_free.empty(); } );
+        _stats.stallTime += clock.getTime64();
+    }
+
+    Dump* dump = _free.front();
+    _free.pop_front();
+    return dump;
+}
+
+FileFrameWriter::Dump* FileFrameWriter::_pop()
+{
+    std::unique_lock< std::mutex > lock( _mutex );
+    _condition.wait( lock, [this] { return !_queue.empty() || !_running; } );
+    if( _queue.empty( ))
+        return 0; // stopped
+
+    Dump* dump = _queue.front();
+    _queue.pop_front();
+    return dump;
+}
+
+/*  Append a dumped image and a single-frame assembly of it to the sequence.
+    The writers compress concurrently, the records are appended in slot
+    order to keep the frame order.  */
+bool FileFrameWriter::_append( const Dump& dump,
+                               const std::vector< uint8_t >& payload )
+{
+    const co::ObjectVersion frameData( dump.channelID,
+                                       uint128_t( dump.frameNumber ));
+    const FrameCapture::ImageRecord image =
+        { frameData, dump.context, dump.data.pvp, Zoom::NONE, uint128_t(),
+          dump.frameNumber, Frame::BUFFER_COLOR, 1, 0, payload.size() };
+    const FrameCapture::FrameRecord frame =
+        { frameData, Vector2i( 0, 0 ), Zoom::NONE, Frame::BUFFER_COLOR,
+          FILTER_NEAREST };
+
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        _condition.wait( lock, [this, &dump] { return _nextSlot == dump.slot; });
+    }
+
+    const bool ok = dump.sequence->writeImage( image, payload.data( )) &&
+        dump.sequence->writeAssembly( dump.frameNumber,
+                                      FrameCapture::FrameRecords( 1, frame ));
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        ++_nextSlot;
+    }
+    _condition.notify_all();
+    return ok;
+}
+
+void FileFrameWriter::_release( Dump* dump, const bool written )
 {
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        if( written )
+        {
+            ++_stats.nImages;
+            _stats.nBytes += dump->buffer.getSize();
+        }
+        _free.push_back( dump );
+        --_nPending;
+    }
+    _condition.notify_all();
 }
 
 }
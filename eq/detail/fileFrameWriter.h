@@ -21,14 +21,30 @@
 #include <eq/resultImageListener.h> // base class
 #include <eq/types.h>
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace eq
 {
 namespace detail
 {
+class FrameCapture;
 
 /**
  * Persist the color buffer of a channel to a file.
- * The name of the file is Channel::SATTR_DUMP_IMAGE.rgb
+ *
+ * The name of the file is Channel::SATTR_DUMP_IMAGE followed by
+ * Channel::getDumpImageFileName(). If SATTR_DUMP_IMAGE ends in '.eqs', all
+ * images are losslessly compressed and appended to this image sequence
+ * instead, a FrameCapture which can be replayed by eq::FrameReplay.
+ *
+ * The pipe thread only copies the pixels into a pooled buffer, the files are
+ * written by background threads. When all buffers are queued because the disk
+ * can't keep up, the pipe thread waits for a free buffer, which is reported as
+ * Statistic::CHANNEL_FRAME_WAIT_DUMP.
  */
 class FileFrameWriter : public ResultImageListener
 {
@@ -37,6 +53,50 @@ public:
     ~FileFrameWriter();
 
     void notifyNewImage( eq::Channel& channel, const eq::Image& image ) final;
+
+    /** Wait until all copied images are written. */
+    void flush();
+
+    /** Write all images, stop the writer threads and free the buffers. */
+    void stop();
+
+private:
+    /** Backpressure statistics of one recording, logged on stop(). */
+    struct Statistics
+    {
+        Statistics() : nImages( 0 ), nBytes( 0 ), nStalls( 0 ), stallTime( 0 )
+                     , maxQueued( 0 ) {}
+
+        uint64_t nImages;  //!< written images
+        uint64_t nBytes;   //!< written pixel bytes, before compression
+        uint64_t nStalls;  //!< images which waited for a free buffer
+        int64_t stallTime; //!< total time waited by the pipe thread, in ms
+        size_t maxQueued;  //!< maximum number of unwritten images
+    };
+
+    struct Dump;
+    class Writer;
+    typedef std::deque< Dump* > Dumps;
+    typedef std::vector< Writer* > Writers;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    Dumps _free;      // pooled buffers
+    Dumps _queue;     // copied images to be written
+    size_t _nDumps;   // allocated buffers
+    size_t _nPending; // buffers in use by the pipe thread, queued or writing
+    bool _running;
+    Writers _writers;
+    Statistics _stats;
+
+    std::unique_ptr< FrameCapture > _sequence;
+    uint64_t _nSequenced; // images queued for the sequence
+    uint64_t _nextSlot;   // of the next image appended to the sequence
+
+    Dump* _obtainDump( Channel& channel );
+    bool _append( const Dump& dump, const std::vector< uint8_t >& payload );
+    Dump* _pop();
+    void _release( Dump* dump, bool written );
 };
 
 }
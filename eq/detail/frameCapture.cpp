@@ -0,0 +1,235 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "frameCapture.h"
+
+#include "../frame.h"
+#include "../frameData.h"
+#include "../image.h"
+#include "../pixelData.h"
+
+#include <co/global.h>
+#include <lunchbox/log.h>
+#include <pression/compressor.h>
+#include <pression/plugins/compressor.h>
+
+namespace eq
+{
+namespace detail
+{
+const uint64_t FrameCapture::magic = 0x3170436d72467145ull; // "EqFrmCp1"
+const uint32_t FrameCapture::version = 2;
+
+FrameCapture::FrameCapture( const std::string& filename )
+    : _filename( filename )
+    , _file( filename.c_str(), std::ios::out | std::ios::binary |
+                               std::ios::trunc )
+    , _warned( false )
+{
+    if( !_file.is_open( ))
+    {
+        LBWARN << "Can't open frame capture " << filename << " for writing"
+               << std::endl;
+        return;
+    }
+    const uint32_t headerSize = sizeof( FrameData::ImageHeader );
+    _file.write( reinterpret_cast< const char* >( &magic ), sizeof( magic ));
+    _file.write( reinterpret_cast< const char* >( &version ),
+                 sizeof( version ));
+    _file.write( reinterpret_cast< const char* >( &headerSize ),
+                 sizeof( headerSize ));
+    LBINFO << "Capturing frames to " << filename << std::endl;
+}
+
+FrameCapture::~FrameCapture()
+{}
+
+bool FrameCapture::writeImage( const ImageRecord& record, const uint8_t* data )
+{
+    std::lock_guard< std::mutex > lock( _mutex );
+    _writeImage( record, data );
+    return _checkError();
+}
+
+bool FrameCapture::writeAssembly( const uint32_t frameNumber,
+                                  const Frames& frames )
+{
+    std::lock_guard< std::mutex > lock( _mutex );
+
+    FrameRecords records;
+    records.reserve( frames.size( ));
+    for( const Frame* frame : frames )
+    {
+        ConstFrameDataPtr data = frame->getFrameData();
+        const co::ObjectVersion version( data.get( ));
+
+        // images not received by the node, e.g., from local output frames
+        uint128_t& captured = _captured[ version.identifier ];
+        if( captured != version.version )
+        {
+            for( const Image* image : frame->getImages( ))
+                _writeLocalImage( version, frameNumber, *image );
+            captured = version.version;
+        }
+
+        Zoom zoom = frame->getZoom();
+        zoom.apply( data->getZoom( ));
+        const FrameRecord record = { version, frame->getOffset(), zoom,
+                                     data->getBuffers(),
+                                     uint32_t( frame->getZoomFilter( )) };
+        records.push_back( record );
+    }
+
+    _writeAssembly( frameNumber, records );
+    return _checkError();
+}
+
+bool FrameCapture::writeAssembly( const uint32_t frameNumber,
+                                  const FrameRecords& frames )
+{
+    std::lock_guard< std::mutex > lock( _mutex );
+    _writeAssembly( frameNumber, frames );
+    return _checkError();
+}
+
+void FrameCapture::packImage( const PixelData& data, const float quality,
+                              pression::Compressor* compressor,
+                              std::vector< uint8_t >& payload )
+{
+    LBASSERT( data.pixels );
+    if( compressor && ( !compressor->isGood() ||
+                   compressor->getInfo().tokenType != data.externalFormat ))
+    {
+        compressor->setup( co::Global::getPluginRegistry(),
+                           data.externalFormat, 1.f /* lossless */,
+                           false /* ignore alpha */ );
+    }
+
+    const bool compress = compressor && compressor->isGood() &&
+                          compressor->getInfo().name > EQ_COMPRESSOR_NONE;
+    pression::CompressorResult result;
+    if( compress )
+    {
+        uint64_t inDims[4];
+        data.pvp.convertToPlugin( inDims );
+        compressor->compress( data.pixels, inDims, EQ_COMPRESSOR_DATA_2D );
+        result = compressor->getResult();
+    }
+
+    const FrameData::ImageHeader header =
+        { data.internalFormat, data.externalFormat, data.pixelSize, data.pvp,
+          compress ? result.compressor : EQ_COMPRESSOR_NONE,
+          compress ? uint32_t( EQ_COMPRESSOR_DATA_2D ) : 0u,
+          compress ? uint32_t( result.chunks.size( )) : 1, quality, 0, 0 };
+    payload.insert( payload.end(),
+                    reinterpret_cast< const uint8_t* >( &header ),
+                    reinterpret_cast< const uint8_t* >( &header + 1 ));
+
+    if( !compress )
+    {
+        const uint64_t size = data.pvp.getArea() * data.pixelSize;
+        const uint8_t* pixels = reinterpret_cast< const uint8_t* >(
+                                    data.pixels );
+        payload.insert( payload.end(),
+                        reinterpret_cast< const uint8_t* >( &size ),
+                        reinterpret_cast< const uint8_t* >( &size + 1 ));
+        payload.insert( payload.end(), pixels, pixels + size );
+        return;
+    }
+
+    for( const pression::CompressorChunk& chunk : result.chunks )
+    {
+        const uint64_t size = chunk.getNumBytes();
+        const uint8_t* bytes = reinterpret_cast< const uint8_t* >( chunk.data );
+        payload.insert( payload.end(),
+                        reinterpret_cast< const uint8_t* >( &size ),
+                        reinterpret_cast< const uint8_t* >( &size + 1 ));
+        payload.insert( payload.end(), bytes, bytes + size );
+    }
+}
+
+void FrameCapture::_writeAssembly( const uint32_t frameNumber,
+                                   const FrameRecords& frames )
+{
+    const uint32_t type = RECORD_ASSEMBLY;
+    const AssemblyRecord assembly = { frameNumber, uint32_t( frames.size( ))};
+    _file.write( reinterpret_cast< const char* >( &type ), sizeof( type ));
+    _file.write( reinterpret_cast< const char* >( &assembly ),
+                 sizeof( assembly ));
+    if( !frames.empty( ))
+        _file.write( reinterpret_cast< const char* >( frames.data( )),
+                     frames.size() * sizeof( FrameRecord ));
+    _file.flush();
+}
+
+void FrameCapture::_writeImage( const ImageRecord& record,
+                                const uint8_t* data )
+{
+    const uint32_t type = RECORD_IMAGE;
+    _file.write( reinterpret_cast< const char* >( &type ), sizeof( type ));
+    _file.write( reinterpret_cast< const char* >( &record ), sizeof( record ));
+    _file.write( reinterpret_cast< const char* >( data ), record.size );
+    _captured[ record.frameData.identifier ] = record.frameData.version;
+}
+
+void FrameCapture::_writeLocalImage( const co::ObjectVersion& frameData,
+                                     const uint32_t frameNumber,
+                                     const Image& image )
+{
+    ImageRecord record = { frameData, image.getContext(),
+                           image.getPixelViewport(), image.getZoom(),
+                           uint128_t(), frameNumber, 0,
+                           image.getAlphaUsage(), 0, 0 };
+    std::vector< uint8_t > payload;
+
+    // uncompressed, in the layout of Channel::_transmitImage
+    Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        if( !image.hasPixelData( buffer ))
+            continue;
+
+        packImage( image.getPixelData( buffer ), image.getQuality( buffer ),
+                   0, payload );
+        record.buffers |= buffer;
+    }
+
+    if( record.buffers == 0 )
+    {
+        if( !_warned )
+            LBWARN << "Can't capture images without pixel data, e.g., "
+                   << "texture images" << std::endl;
+        _warned = true;
+        return;
+    }
+
+    record.size = payload.size();
+    _writeImage( record, payload.data( ));
+}
+
+bool FrameCapture::_checkError()
+{
+    if( !_file.fail( ))
+        return true;
+
+    LBWARN << "Error writing frame capture " << _filename << std::endl;
+    return false;
+}
+
+}
+}
@@ -0,0 +1,155 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_FRAMECAPTURE_H
+#define EQ_DETAIL_FRAMECAPTURE_H
+
+#include <eq/types.h>
+#include <eq/fabric/pixelViewport.h> // member
+#include <eq/fabric/renderContext.h> // member
+#include <eq/fabric/zoom.h>          // member
+#include <co/objectVersion.h>        // member
+
+#include <boost/noncopyable.hpp>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace pression { class Compressor; }
+
+namespace eq
+{
+namespace detail
+{
+
+/**
+ * A capture of the images received by a node and of the frame assembly of its
+ * channels, replayed offline by eq::FrameReplay.
+ *
+ * The file starts with a 64 bit magic number, the 32 bit format version and
+ * the 32 bit size of FrameData::ImageHeader, since payloads embed it. Readers
+ * reject files with a different version or header size. The header is followed
+ * by records starting with their 32 bit type. An image record is an
+ * ImageRecord followed by its payload, exactly as sent by
+ * Channel::_transmitImage. An assembly record is an AssemblyRecord followed by
+ * one FrameRecord per input frame. Images assembled without being received,
+ * e.g., from local output frames, are written as uncompressed payloads before
+ * their assembly record.
+ *
+ * Image sequences dumped by a FileFrameWriter use the same format, with one
+ * image and one single-frame assembly per dumped frame.
+ */
+class FrameCapture : public boost::noncopyable
+{
+public:
+    enum Record
+    {
+        RECORD_IMAGE = 1,
+        RECORD_ASSEMBLY
+    };
+
+    /** A transmitted image, the fields of its transmit command. */
+    struct ImageRecord
+    {
+        co::ObjectVersion frameData;
+        RenderContext context;
+        PixelViewport pvp;
+        Zoom zoom;
+        uint128_t stream;
+        uint32_t frameNumber;
+        uint32_t buffers;
+        uint32_t useAlpha;
+        uint32_t sequence;
+        uint64_t size; //!< of the payload in bytes
+    };
+
+    /** The assembly of a channel, followed by nFrames FrameRecords. */
+    struct AssemblyRecord
+    {
+        uint32_t frameNumber;
+        uint32_t nFrames;
+    };
+
+    /** An input frame, with the parameters of its ImageOps. */
+    struct FrameRecord
+    {
+        co::ObjectVersion frameData;
+        Vector2i offset;
+        Zoom zoom; //!< frame and frame data zoom, without the image zoom
+        uint32_t buffers;
+        uint32_t zoomFilter;
+    };
+
+    typedef std::vector< FrameRecord > FrameRecords;
+
+    static const uint64_t magic;
+    static const uint32_t version; //!< of the file format
+
+    /**
+     * Append an image buffer to a payload, in the layout of
+     * Channel::_transmitImage.
+     *
+     * @param data the pixel data of the buffer.
+     * @param quality the quality of the buffer.
+     * @param compressor the compressor to use, set up losslessly for the
+     *        pixel format if needed, or 0 to store the pixels uncompressed.
+     * @param payload the payload to append to.
+     */
+    static void packImage( const PixelData& data, float quality,
+                           pression::Compressor* compressor,
+                           std::vector< uint8_t >& payload );
+
+    /** Create the capture file, truncating an existing file. */
+    explicit FrameCapture( const std::string& filename );
+    ~FrameCapture();
+
+    /** @return true if the file is open for writing. */
+    bool isGood() const { return _file.is_open(); }
+
+    /** @return the name of the capture file. */
+    const std::string& getFilename() const { return _filename; }
+
+    /** Append a received image payload, thread safe. */
+    bool writeImage( const ImageRecord& record, const uint8_t* data );
+
+    /** Append the assembly of the given frames, thread safe. */
+    bool writeAssembly( uint32_t frameNumber, const Frames& frames );
+
+    /** Append an assembly of the given frame records, thread safe. */
+    bool writeAssembly( uint32_t frameNumber, const FrameRecords& frames );
+
+private:
+    const std::string _filename;
+    std::ofstream _file;
+    std::mutex _mutex;
+
+    /** The last frame data version with captured images, per identifier. */
+    std::map< uint128_t, uint128_t > _captured;
+    bool _warned; // about images without pixel data
+
+    void _writeImage( const ImageRecord& record, const uint8_t* data );
+    void _writeAssembly( uint32_t frameNumber, const FrameRecords& frames );
+    void _writeLocalImage( const co::ObjectVersion& frameData,
+                           uint32_t frameNumber, const Image& image );
+    bool _checkError();
+};
+
+}
+}
+
+#endif // EQ_DETAIL_FRAMECAPTURE_H
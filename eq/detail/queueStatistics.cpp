@@ -0,0 +1,153 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "queueStatistics.h"
+
+#include <eq/fabric/statistic.h>
+#include <lunchbox/bitOperation.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _MSC_VER
+#  define snprintf _snprintf
+#endif
+
+namespace eq
+{
+namespace detail
+{
+
+Histogram::Histogram()
+    : _count( 0 )
+    , _sum( 0 )
+    , _max( 0 )
+{
+    ::memset( _buckets, 0, sizeof( _buckets ));
+}
+
+void Histogram::add( const int64_t value )
+{
+    const int32_t bit = value > 0 ?
+                 lunchbox::getIndexOfLastBit( uint64_t( value )) + 1 : 0;
+    ++_buckets[ LB_MIN( bit, int32_t( NUM_BUCKETS - 1 )) ];
+    ++_count;
+    _sum += value;
+    _max = LB_MAX( _max, value );
+}
+
+int64_t Histogram::getPercentile( const float percentile ) const
+{
+    const uint64_t target = uint64_t( percentile * float( _count ));
+    uint64_t count = 0;
+    for( size_t i = 0; i < NUM_BUCKETS; ++i )
+    {
+        count += _buckets[i];
+        if( count > target || count == _count )
+            return LB_MIN( int64_t( 1 ) << i, _max );
+    }
+    return _max;
+}
+
+QueueStatistics::QueueStatistics()
+    : _maxDepth( 0 )
+    , _dispatched( 0 )
+    , _dispatchTime( -1 )
+{}
+
+void QueueStatistics::notifyPush( const bool front )
+{
+    const int64_t now = _getTime();
+    lunchbox::ScopedFastWrite mutex( _lock );
+    if( front )
+        _pushTimes.push_front( now );
+    else
+        _pushTimes.push_back( now );
+    _maxDepth = LB_MAX( _maxDepth, _pushTimes.size( ));
+}
+
+void QueueStatistics::notifyPop( const co::ICommands& commands,
+                                 const bool empty )
+{
+    const int64_t now = _getTime();
+    lunchbox::ScopedFastWrite mutex( _lock );
+    for( co::ICommandsCIter i = commands.begin(); i != commands.end(); ++i )
+    {
+        if( !i->isValid( ))
+            continue;
+
+        // Commands pushed before statistics were enabled have no push time
+        if( !_pushTimes.empty( ))
+        {
+            _times[ i->getCommand() ].latency.add( now - _pushTimes.front( ));
+            _pushTimes.pop_front();
+        }
+    }
+    if( empty ) // resync, all recorded pushes have been dispatched
+        _pushTimes.clear();
+
+    // The handling time of batched commands can't be attributed
+    if( commands.size() == 1 && commands.front().isValid( ))
+    {
+        _dispatched = commands.front().getCommand();
+        _dispatchTime = now;
+    }
+}
+
+void QueueStatistics::notifyDispatchDone()
+{
+    if( _dispatchTime < 0 )
+        return;
+
+    const int64_t time = _getTime() - _dispatchTime;
+    lunchbox::ScopedFastWrite mutex( _lock );
+    _times[ _dispatched ].handling.add( time );
+    _dispatchTime = -1;
+}
+
+void QueueStatistics::swap( CommandTimesMap& times, size_t& maxDepth )
+{
+    lunchbox::ScopedFastWrite mutex( _lock );
+    _times.swap( times );
+    _times.clear();
+    maxDepth = _maxDepth;
+    _maxDepth = _pushTimes.size();
+}
+
+void QueueStatistics::fill( Statistic& statistic, const uint32_t command,
+                            const Histogram& histogram, const size_t maxDepth,
+                            const char* suffix )
+{
+    statistic.command = command;
+    statistic.samples = uint32_t( histogram.getCount( ));
+    statistic.maxDepth = uint32_t( maxDepth );
+    statistic.median = histogram.getPercentile( .5f );
+    statistic.percentile99 = histogram.getPercentile( .99f );
+    statistic.mean = float( histogram.getMean( ));
+
+    if( !suffix )
+        return;
+
+    char name[32];
+    snprintf( name, 32, "%s %s", statistic.resourceName, suffix );
+    name[31] = 0;
+    ::memcpy( statistic.resourceName, name, 32 );
+}
+
+}
+}
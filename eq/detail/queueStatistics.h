@@ -0,0 +1,131 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_QUEUESTATISTICS_H
+#define EQ_DETAIL_QUEUESTATISTICS_H
+
+#include <eq/types.h>
+
+#include <co/iCommand.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/spinLock.h>
+#include <boost/noncopyable.hpp>
+#include <deque>
+#include <map>
+
+namespace eq
+{
+namespace detail
+{
+
+/** A histogram of durations in microseconds with power-of-two buckets. */
+class Histogram
+{
+public:
+    Histogram();
+
+    /** Add one sample, in microseconds. */
+    void add( int64_t value );
+
+    /** @return the number of samples. */
+    uint64_t getCount() const { return _count; }
+
+    /** @return the average sample value, in microseconds. */
+    int64_t getMean() const { return _count ? _sum / int64_t( _count ) : 0; }
+
+    /** @return the largest sample value, in microseconds. */
+    int64_t getMax() const { return _max; }
+
+    /**
+     * @return the upper bound of the bucket holding the given percentile
+     *         [0..1], in microseconds.
+     */
+    int64_t getPercentile( float percentile ) const;
+
+private:
+    enum { NUM_BUCKETS = 40 };
+    uint64_t _buckets[ NUM_BUCKETS ]; // bucket i holds [2^(i-1), 2^i)
+    uint64_t _count;
+    int64_t _sum;
+    int64_t _max;
+};
+
+/** The time histograms recorded for one command type. */
+struct CommandTimes
+{
+    Histogram latency;  //!< time from enqueue to dispatch
+    Histogram handling; //!< time spent in the command handler
+};
+
+typedef std::map< uint32_t, CommandTimes > CommandTimesMap;
+
+/**
+ * Per-command queue instrumentation of an eq::CommandQueue.
+ *
+ * Push notifications may come from any thread, pop notifications only from
+ * the thread draining the queue. The handler time of a command is the time
+ * between its dispatch and the next pop on the queue, which is the handler
+ * execution time for the WorkerThread dispatch loop.
+ */
+class QueueStatistics : public boost::noncopyable
+{
+public:
+    QueueStatistics();
+
+    /** Record the enqueue of one command. */
+    void notifyPush( bool front );
+
+    /** Record the dispatch of popped commands and the new queue size. */
+    void notifyPop( const co::ICommands& commands, bool empty );
+
+    /** Record the end of the handler of the last dispatched command. */
+    void notifyDispatchDone();
+
+    /** Retrieve and reset the recorded times and the maximum queue depth. */
+    void swap( CommandTimesMap& times, size_t& maxDepth );
+
+    /**
+     * Fill a PIPE_COMMAND_LATENCY or PIPE_COMMAND_HANDLE statistic.
+     *
+     * @param statistic the event data, with the resource name already set.
+     * @param command the command type.
+     * @param histogram the times recorded for the command.
+     * @param maxDepth the maximum queue depth during the sampling period.
+     * @param suffix appended to the resource name to identify the queue.
+     */
+    static void fill( Statistic& statistic, uint32_t command,
+                      const Histogram& histogram, size_t maxDepth,
+                      const char* suffix );
+
+private:
+    lunchbox::Clock _clock;
+    lunchbox::SpinLock _lock;
+
+    std::deque< int64_t > _pushTimes;
+    size_t _maxDepth;
+    CommandTimesMap _times;
+
+    uint32_t _dispatched; // last single dispatched command
+    int64_t _dispatchTime; // -1 if no dispatch is pending
+
+    int64_t _getTime() const { return int64_t( _clock.getTimed() * 1000. ); }
+};
+
+}
+}
+
+#endif // EQ_DETAIL_QUEUESTATISTICS_H
@@ -0,0 +1,55 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "referenceImage.h"
+
+namespace eq
+{
+namespace detail
+{
+
+ReferenceImage::ReferenceImage( const uint128_t& stream_ )
+    : stream( stream_ )
+    , sequence( 0 )
+    , keyframe( 0 )
+    , lastFrame( 0 )
+{}
+
+void ReferenceImage::update( const Image& frame, const uint32_t sequence_,
+                             const bool keyframe_ )
+{
+    if( keyframe_ )
+    {
+        image.reset(); // copies all pixels below
+        keyframe = sequence_;
+    }
+
+    Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+        if( frame.hasPixelData( buffers[i] ))
+            image.copyBlocks( buffers[i], frame );
+    sequence = sequence_;
+}
+
+void ReferenceImage::invalidate()
+{
+    image.reset();
+    sequence = 0;
+}
+
+}
+}
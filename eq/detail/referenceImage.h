@@ -0,0 +1,71 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_REFERENCEIMAGE_H
+#define EQ_DETAIL_REFERENCEIMAGE_H
+
+#include "../image.h" // member
+
+#include <lunchbox/lock.h>
+#include <boost/noncopyable.hpp>
+
+namespace eq
+{
+namespace detail
+{
+
+/**
+ * The last frame of an image stream, the reference of the temporal delta
+ * encoding of output frames.
+ *
+ * The sending channel keeps one per destination node, eye and image, and
+ * transmits only the blocks which changed since the reference. The receiving
+ * node keeps one per stream to patch the changed blocks onto. The frames of a
+ * stream are numbered: a receiver which misses a frame drops its reference
+ * and asks the sender for a keyframe, see Node::takeKeyframeRequest().
+ * Keyframes are also sent periodically.
+ */
+class ReferenceImage : public boost::noncopyable
+{
+public:
+    /** Streams unused for this many frames are dropped on both sides. */
+    static const uint32_t maxAge = 300;
+
+    explicit ReferenceImage( const uint128_t& stream );
+
+    /** Take the pixels of the given frame, all or only its changed blocks. */
+    void update( const Image& frame, uint32_t sequence, bool keyframe );
+
+    /** Drop the pixels until the next keyframe. */
+    void invalidate();
+
+    /** @return true if the stream was not used for maxAge frames. */
+    bool isObsolete( const uint32_t frameNumber ) const
+        { return frameNumber > lastFrame + maxAge; }
+
+    lunchbox::Lock lock;    //!< serializes the transmissions of the stream
+    const uint128_t stream; //!< identifies the stream on the receiver
+    Image image;            //!< the pixels of the reference frame
+    uint32_t sequence;      //!< the number of the frame in image, 0 if none
+    uint32_t keyframe;      //!< the number of the last keyframe
+    uint32_t lastFrame;     //!< the frame number of the last use
+};
+
+}
+}
+
+#endif // EQ_DETAIL_REFERENCEIMAGE_H
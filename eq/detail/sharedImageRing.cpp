@@ -0,0 +1,325 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "sharedImageRing.h"
+
+#include <lunchbox/atomic.h>
+#include <lunchbox/log.h>
+#include <lunchbox/scopedMutex.h>
+#include <new>
+
+#ifndef _WIN32
+#  include <dirent.h>
+#  include <fcntl.h>
+#  include <signal.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  include <cerrno>
+#  include <cstring>
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+const uint64_t _magic = 0x32676e6952714521ull; // "!EqRing2"
+const uint64_t _alignment = 64;
+const std::string _prefix( "eqImageRing" );
+
+struct RingHeader
+{
+    uint64_t magic;
+    uint64_t size;
+    uint64_t owner; // process identifier of the producer
+    uint8_t pad[ _alignment - 3 * sizeof( uint64_t ) ];
+};
+
+/** Precedes each slot, the only state shared by producer and consumers. */
+struct SlotHeader
+{
+    uint64_t size; // of the slot, including this header
+    lunchbox::a_int32_t released;
+};
+
+uint64_t _align( const uint64_t size )
+{
+    return ( size + _alignment - 1 ) & ~( _alignment - 1 );
+}
+
+const uint64_t _slotHeaderSize = _align( sizeof( SlotHeader ));
+
+std::string _getName( const co::NodeID& nodeID )
+{
+    return "/" + _prefix + nodeID.getString();
+}
+
+#ifdef __linux__
+/**
+ * Unlink the rings left behind by crashed producers. The segments of a
+ * producer which did not exit cleanly would otherwise stay in /dev/shm until
+ * the next reboot.
+ */
+void _unlinkStaleRings()
+{
+    DIR* dir = ::opendir( "/dev/shm" );
+    if( !dir )
+        return;
+
+    while( const dirent* entry = ::readdir( dir ))
+    {
+        const std::string name( entry->d_name );
+        if( name.compare( 0, _prefix.size(), _prefix ) != 0 )
+            continue;
+
+        const std::string& path = "/" + name;
+        const int fd = ::shm_open( path.c_str(), O_RDONLY, 0 );
+        if( fd < 0 )
+            continue;
+
+        RingHeader header;
+        const bool valid = ::read( fd, &header, sizeof( header )) ==
+                               ssize_t( sizeof( header )) &&
+                           header.magic == _magic;
+        ::close( fd );
+
+        if( valid && ::kill( pid_t( header.owner ), 0 ) != 0 &&
+            errno == ESRCH )
+        {
+            LBINFO << "Removing stale shared image ring " << name << std::endl;
+            ::shm_unlink( path.c_str( ));
+        }
+    }
+    ::closedir( dir );
+}
+#else
+void _unlinkStaleRings() {}
+#endif
+}
+
+SharedImageRing::SharedImageRing( const std::string& name, const int fd,
+                                  uint8_t* base, const uint64_t size,
+                                  const bool owner )
+    : _name( name )
+    , _fd( fd )
+    , _base( base )
+    , _size( size )
+    , _owner( owner )
+    , _data( base + sizeof( RingHeader ))
+    , _capacity( size - sizeof( RingHeader ))
+    , _head( 0 )
+    , _tail( 0 )
+    , _used( 0 )
+{}
+
+#ifdef _WIN32
+SharedImageRing* SharedImageRing::create( const co::NodeID&, const uint64_t )
+{
+    return 0;
+}
+
+SharedImageRing* SharedImageRing::open( const co::NodeID& )
+{
+    return 0;
+}
+
+SharedImageRing::~SharedImageRing()
+{}
+
+#else
+SharedImageRing* SharedImageRing::create( const co::NodeID& nodeID,
+                                          uint64_t size )
+{
+    size = _align( size );
+    if( size <= sizeof( RingHeader ) + _slotHeaderSize )
+        return 0;
+
+    _unlinkStaleRings();
+
+    const std::string& name = _getName( nodeID );
+    const int fd = ::shm_open( name.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                               S_IRUSR | S_IWUSR );
+    if( fd < 0 )
+    {
+        LBWARN << "Can't create shared image ring " << name << ": "
+               << ::strerror( errno ) << std::endl;
+        return 0;
+    }
+
+    // pages are only committed when touched by the first ring cycle
+    if( ::ftruncate( fd, off_t( size )) != 0 )
+    {
+        LBWARN << "Can't size shared image ring " << name << ": "
+               << ::strerror( errno ) << std::endl;
+        ::close( fd );
+        ::shm_unlink( name.c_str( ));
+        return 0;
+    }
+
+    void* base = ::mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    if( base == MAP_FAILED )
+    {
+        LBWARN << "Can't map shared image ring " << name << ": "
+               << ::strerror( errno ) << std::endl;
+        ::close( fd );
+        ::shm_unlink( name.c_str( ));
+        return 0;
+    }
+
+    RingHeader* header = reinterpret_cast< RingHeader* >( base );
+    header->size = size;
+    header->owner = uint64_t( ::getpid( ));
+    header->magic = _magic;
+
+    LBDEBUG << "Created shared image ring " << name << " of " << (size >> 20)
+            << " MB" << std::endl;
+    return new SharedImageRing( name, fd, static_cast< uint8_t* >( base ),
+                                size, true );
+}
+
+SharedImageRing* SharedImageRing::open( const co::NodeID& nodeID )
+{
+    const std::string& name = _getName( nodeID );
+    const int fd = ::shm_open( name.c_str(), O_RDWR, 0 );
+    if( fd < 0 ) // not on this host
+        return 0;
+
+    struct stat status;
+    if( ::fstat( fd, &status ) != 0 ||
+        uint64_t( status.st_size ) <= sizeof( RingHeader ))
+    {
+        ::close( fd );
+        return 0;
+    }
+
+    const uint64_t size = status.st_size;
+    void* base = ::mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    if( base == MAP_FAILED )
+    {
+        LBWARN << "Can't map shared image ring " << name << ": "
+               << ::strerror( errno ) << std::endl;
+        ::close( fd );
+        return 0;
+    }
+
+    const RingHeader* header = reinterpret_cast< const RingHeader* >( base );
+    if( header->magic != _magic || header->size != size )
+    {
+        LBWARN << "Invalid shared image ring " << name << std::endl;
+        ::munmap( base, size );
+        ::close( fd );
+        return 0;
+    }
+
+    return new SharedImageRing( name, fd, static_cast< uint8_t* >( base ),
+                                size, false );
+}
+
+SharedImageRing::~SharedImageRing()
+{
+    ::munmap( _base, _size );
+    ::close( _fd );
+    if( _owner ) // receivers keep their mapping until they are done
+        ::shm_unlink( _name.c_str( ));
+}
+#endif
+
+uint8_t* SharedImageRing::allocate( const uint64_t size, uint64_t& offset )
+{
+    LBASSERT( _owner );
+    const uint64_t needed = _slotHeaderSize + _align( size );
+
+    lunchbox::ScopedFastWrite mutex( _lock );
+    _reclaim();
+
+    if( needed > _capacity || _capacity - _used < needed )
+        return 0;
+
+    if( _head >= _tail && _capacity - _head < needed )
+    {
+        // pad the end of the ring and wrap around, if the start is free
+        if( _tail < needed )
+            return 0;
+        _newSlot( _capacity - _head, true );
+    }
+    else if( _head < _tail && _tail - _head < needed )
+        return 0;
+
+    offset = _head;
+    return _newSlot( needed, false );
+}
+
+uint8_t* SharedImageRing::getData( const uint64_t offset, const uint64_t size )
+{
+    if( offset > _capacity - _slotHeaderSize )
+        return 0;
+
+    const SlotHeader* slot =
+        reinterpret_cast< const SlotHeader* >( _data + offset );
+    if( slot->size > _capacity - offset ||
+        slot->size < _slotHeaderSize + size )
+    {
+        return 0;
+    }
+    return _data + offset + _slotHeaderSize;
+}
+
+void SharedImageRing::release( const uint64_t offset )
+{
+    LBASSERT( offset <= _capacity - _slotHeaderSize );
+    if( offset > _capacity - _slotHeaderSize )
+        return;
+
+    SlotHeader* slot = reinterpret_cast< SlotHeader* >( _data + offset );
+    slot->released = 1;
+}
+
+void SharedImageRing::_reclaim()
+{
+    while( _used > 0 )
+    {
+        const SlotHeader* slot =
+            reinterpret_cast< const SlotHeader* >( _data + _tail );
+        if( slot->released == 0 )
+            return;
+
+        _used -= slot->size;
+        _tail += slot->size;
+        if( _tail == _capacity )
+            _tail = 0;
+    }
+    _head = _tail = 0; // empty, restart at the beginning
+}
+
+uint8_t* SharedImageRing::_newSlot( const uint64_t size, const bool released )
+{
+    SlotHeader* slot = new( _data + _head ) SlotHeader;
+    slot->size = size;
+    slot->released = released ? 1 : 0;
+
+    uint8_t* data = _data + _head + _slotHeaderSize;
+    _used += size;
+    _head += size;
+    if( _head == _capacity )
+        _head = 0;
+    return data;
+}
+
+}
+}
@@ -0,0 +1,107 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_SHAREDIMAGERING_H
+#define EQ_DETAIL_SHAREDIMAGERING_H
+
+#include <eq/types.h>
+
+#include <lunchbox/spinLock.h>
+#include <boost/noncopyable.hpp>
+
+namespace eq
+{
+namespace detail
+{
+
+/**
+ * A ring buffer of image data in shared memory, one per node process.
+ *
+ * The producing node writes the same image payload as sent by a
+ * CMD_NODE_FRAMEDATA_TRANSMIT into the ring, and sends only the slot offset to
+ * receiving nodes on the same host which confirmed that they mapped the ring.
+ * Receivers use uncompressed pixels in place as the pixel data of their
+ * images, and release the slot when the frame data is reused for a later
+ * frame. Block-sparse and delta images are decoded from the ring and release
+ * their slot right away. Slots are reclaimed by the producer in allocation
+ * order, once released.
+ *
+ * The ring is unlinked by its producer on destruction. Rings of crashed
+ * producers are removed by the next producer on the host.
+ */
+class SharedImageRing : public boost::noncopyable
+{
+public:
+    /** Create the writable ring of the given local node. */
+    static SharedImageRing* create( const co::NodeID& nodeID, uint64_t size );
+
+    /** Map the ring of the given node on the same host, or return 0. */
+    static SharedImageRing* open( const co::NodeID& nodeID );
+
+    ~SharedImageRing();
+
+    /** @name Producer interface, thread safe. */
+    //@{
+    /**
+     * Allocate a slot of the given size.
+     *
+     * @param size the payload size in bytes.
+     * @param offset returns the slot offset for the receiver.
+     * @return the payload address, or 0 if the ring is full.
+     */
+    uint8_t* allocate( uint64_t size, uint64_t& offset );
+
+    /** Release a slot which was allocated but not handed over. */
+    void cancel( uint64_t offset ) { release( offset ); }
+    //@}
+
+    /** @name Consumer interface. */
+    //@{
+    /** @return the payload of the slot, or 0 if the slot is invalid. */
+    uint8_t* getData( uint64_t offset, uint64_t size );
+
+    /** Mark the slot as consumed, ignoring invalid offsets. */
+    void release( uint64_t offset );
+    //@}
+
+private:
+    SharedImageRing( const std::string& name, int fd, uint8_t* base,
+                     uint64_t size, bool owner );
+
+    const std::string _name;
+    const int _fd;
+    uint8_t* const _base;
+    const uint64_t _size;
+    const bool _owner;
+
+    uint8_t* _data;      // first slot
+    uint64_t _capacity;  // usable bytes after the ring header
+
+    // producer state, not shared
+    lunchbox::SpinLock _lock;
+    uint64_t _head; // next allocation
+    uint64_t _tail; // oldest unreclaimed slot
+    uint64_t _used; // allocated bytes, including wrap-around padding
+
+    void _reclaim();
+    uint8_t* _newSlot( uint64_t size, bool released );
+};
+
+}
+}
+
+#endif // EQ_DETAIL_SHAREDIMAGERING_H
@@ -151,6 +151,9 @@ protected:
 
     /** @sa Serializable::setDirty() @internal */
     EQFABRIC_INL virtual void setDirty( const uint64_t bits );
+    /** @internal @sa Object::updateUserDataOwner() */
+    EQFABRIC_INL virtual void updateUserDataOwner( Object* owner,
+                                                   const bool hasUserData );
 
     /** @internal */
     virtual void activateLayout( const uint32_t index )
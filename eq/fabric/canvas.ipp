@@ -112,8 +112,13 @@ void Canvas< CFG, C, S, L >::serialize( co::DataOStream& os,
 
     if( dirtyBits & DIRTY_LAYOUT )
         os << _data.activeLayout;
-    if( dirtyBits & DIRTY_SEGMENTS && isMaster( ))
-        os.serializeChildren( _segments );
+    if( dirtyBits & DIRTY_SEGMENTS )
+    {
+        if( isMaster( ))
+            os.serializeChildren( _segments );
+        else
+            serializeCommittedChildren( os, _segments );
+    }
     if( dirtyBits & DIRTY_LAYOUTS )
         os.serializeChildren( _layouts );
     if( dirtyBits & DIRTY_FRUSTUM )
@@ -136,7 +141,7 @@ void Canvas< CFG, C, S, L >::deserialize( co::DataIStream& is,
     if( dirtyBits & DIRTY_SEGMENTS )
     {
         if( isMaster( ))
-            syncChildren( _segments );
+            syncChildren( is, _segments );
         else
         {
             Segments result;
@@ -180,6 +185,13 @@ void Canvas< CFG, C, S, L >::setDirty( const uint64_t dirtyBits )
     _config->setDirty( CFG::DIRTY_CANVASES );
 }
 
+template< class CFG, class C, class S, class L >
+void Canvas< CFG, C, S, L >::updateUserDataOwner( Object* owner,
+                                                  const bool hasUserData )
+{
+    _config->updateUserDataOwner( owner, hasUserData );
+}
+
 template< class CFG, class C, class S, class L >
 void Canvas< CFG, C, S, L >::create( S** segment )
 {
@@ -292,6 +292,10 @@ public:
         IATTR_HINT_STATISTICS,
         /** Use a send token for output frames (OFF, ON) */
         IATTR_HINT_SENDTOKEN,
+        /** Send changed blocks of output frames (OFF, ON, keyframe rate) */
+        IATTR_HINT_DELTA,
+        /** Crop read back images to their regions of interest (OFF, ON) */
+        IATTR_HINT_ROI,
         IATTR_LAST,
         IATTR_ALL = IATTR_LAST + 5
     };
@@ -300,6 +304,8 @@ public:
     enum SAttribute
     {
         SATTR_DUMP_IMAGE,
+        /** Capture received images and their assembly to the named file */
+        SATTR_CAPTURE_FRAMES,
         SATTR_LAST,
         SATTR_ALL = SATTR_LAST + 5
     };
@@ -342,6 +348,9 @@ protected:
 
     /** @internal @sa Serializable::setDirty() */
     EQFABRIC_INL virtual void setDirty( const uint64_t bits );
+    /** @internal @sa Object::updateUserDataOwner() */
+    EQFABRIC_INL virtual void updateUserDataOwner( Object* owner,
+                                                   const bool hasUserData );
 
     /** @name Render context access */
     //@{
@@ -36,11 +36,14 @@ namespace
 #define MAKE_ATTR_STRING( attr ) ( std::string("EQ_CHANNEL_") + #attr )
 static std::string _iAttributeStrings[] = {
     MAKE_ATTR_STRING( IATTR_HINT_STATISTICS ),
-    MAKE_ATTR_STRING( IATTR_HINT_SENDTOKEN )
+    MAKE_ATTR_STRING( IATTR_HINT_SENDTOKEN ),
+    MAKE_ATTR_STRING( IATTR_HINT_DELTA ),
+    MAKE_ATTR_STRING( IATTR_HINT_ROI )
 };
 
 static std::string _sAttributeStrings[] = {
-    MAKE_ATTR_STRING( SATTR_DUMP_IMAGE )
+    MAKE_ATTR_STRING( SATTR_DUMP_IMAGE ),
+    MAKE_ATTR_STRING( SATTR_CAPTURE_FRAMES )
 };
 }
 
@@ -169,6 +172,13 @@ void Channel< W, C >::setDirty( const uint64_t dirtyBits )
     _window->setDirty( W::DIRTY_CHANNELS );
 }
 
+template< class W, class C >
+void Channel< W, C >::updateUserDataOwner( Object* owner,
+                                           const bool hasUserData )
+{
+    _window->updateUserDataOwner( owner, hasUserData );
+}
+
 //----------------------------------------------------------------------
 // viewport
 //----------------------------------------------------------------------
@@ -108,6 +108,10 @@ namespace fabric
         CMD_NODE_FRAME_TASKS_FINISH,
         CMD_NODE_FRAMEDATA_TRANSMIT,
         CMD_NODE_FRAMEDATA_READY,
+        CMD_NODE_FRAMEDATA_TRANSMIT_SHARED,
+        CMD_NODE_IMAGE_RING_OPEN,
+        CMD_NODE_IMAGE_RING_OPEN_REPLY,
+        CMD_NODE_KEYFRAME_REQUEST,
         CMD_NODE_CUSTOM = CMD_OBJECT_CUSTOM + 20
     };
 
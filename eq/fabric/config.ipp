@@ -644,18 +644,16 @@ N* Config< S, C, O, L, CV, N, V >::_findNode( const uint128_t& id )
 template< class S, class C, class O, class L, class CV, class N, class V >
 uint128_t Config< S, C, O, L, CV, N, V >::commit( const uint32_t incarnation )
 {
+    setUserDataOwnersDirty();
+
     if( Serializable::isDirty( DIRTY_NODES ))
         commitChildren< N >( _nodes, incarnation );
     if( Serializable::isDirty( DIRTY_OBSERVERS ))
         commitChildren< O, C >( _observers, static_cast< C* >( this ),
                                 CMD_CONFIG_NEW_OBSERVER, incarnation );
-
-    // Always traverse layouts and canvases: view/segment objects may be dirty
-    commitChildren< L, C >( _layouts, static_cast<C*>( this ),
-                            CMD_CONFIG_NEW_LAYOUT, incarnation );
-    commitChildren< CV, C >( _canvases, static_cast<C*>( this ),
-                            CMD_CONFIG_NEW_CANVAS, incarnation );
-
+    if( Serializable::isDirty( DIRTY_LAYOUTS ))
+        commitChildren< L, C >( _layouts, static_cast<C*>( this ),
+                                CMD_CONFIG_NEW_LAYOUT, incarnation );
     if( Serializable::isDirty( DIRTY_CANVASES ))
         commitChildren< CV, C >( _canvases, static_cast< C* >( this ),
                                  CMD_CONFIG_NEW_CANVAS, incarnation );
@@ -684,6 +682,17 @@ void Config< S, C, O, L, CV, N, V >::serialize( co::DataOStream& os,
         if( dirtyBits & Config::DIRTY_CANVASES )
             os.serializeChildren( _canvases );
     }
+    else
+    {
+        if( dirtyBits & Config::DIRTY_NODES )
+            serializeCommittedChildren( os, _nodes );
+        if( dirtyBits & Config::DIRTY_OBSERVERS )
+            serializeCommittedChildren( os, _observers );
+        if( dirtyBits & Config::DIRTY_LAYOUTS )
+            serializeCommittedChildren( os, _layouts );
+        if( dirtyBits & Config::DIRTY_CANVASES )
+            serializeCommittedChildren( os, _canvases );
+    }
     if( dirtyBits & Config::DIRTY_LATENCY )
         os << _data.latency;
 }
@@ -702,13 +711,13 @@ void Config< S, C, O, L, CV, N, V >::deserialize( co::DataIStream& is,
     if( isMaster( ))
     {
         if( dirtyBits & Config::DIRTY_NODES )
-            syncChildren( _nodes );
+            syncChildren( is, _nodes );
         if( dirtyBits & Config::DIRTY_OBSERVERS )
-            syncChildren( _observers );
+            syncChildren( is, _observers );
         if( dirtyBits & Config::DIRTY_LAYOUTS )
-            syncChildren( _layouts );
+            syncChildren( is, _layouts );
         if( dirtyBits & Config::DIRTY_CANVASES )
-            syncChildren( _canvases );
+            syncChildren( is, _canvases );
     }
     else
     {
@@ -37,5 +37,43 @@ void FrameData::deserialize( co::DataIStream& is )
     is >> _pvp >> _context >> _zoom >> _frameType >> _buffers;
 }
 
+void FrameData::serializeDelta( co::DataOStream& os,
+                                const FrameData& previous ) const
+{
+    uint32_t dirty = 0;
+    if( _pvp != previous._pvp )
+        dirty |= DIRTY_PVP;
+    if( _zoom != previous._zoom )
+        dirty |= DIRTY_ZOOM;
+    if( _frameType != previous._frameType )
+        dirty |= DIRTY_TYPE;
+    if( _buffers != previous._buffers )
+        dirty |= DIRTY_BUFFERS;
+
+    os << dirty << _context;
+    if( dirty & DIRTY_PVP )
+        os << _pvp;
+    if( dirty & DIRTY_ZOOM )
+        os << _zoom;
+    if( dirty & DIRTY_TYPE )
+        os << _frameType;
+    if( dirty & DIRTY_BUFFERS )
+        os << _buffers;
+}
+
+void FrameData::deserializeDelta( co::DataIStream& is )
+{
+    uint32_t dirty = 0;
+    is >> dirty >> _context;
+    if( dirty & DIRTY_PVP )
+        is >> _pvp;
+    if( dirty & DIRTY_ZOOM )
+        is >> _zoom;
+    if( dirty & DIRTY_TYPE )
+        is >> _frameType;
+    if( dirty & DIRTY_BUFFERS )
+        is >> _buffers;
+}
+
 }
 }
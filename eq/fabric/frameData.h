@@ -82,7 +82,28 @@ public:
     EQFABRIC_API void serialize( co::DataOStream& os ) const;
     EQFABRIC_API void deserialize( co::DataIStream& is );
 
+    /**
+     * @internal
+     * Serialize the parameters which differ from the previous version.
+     *
+     * The render context changes every frame and is always written.
+     */
+    EQFABRIC_API void serializeDelta( co::DataOStream& os,
+                                      const FrameData& previous ) const;
+
+    /** @internal Deserialize the output of serializeDelta(). */
+    EQFABRIC_API void deserializeDelta( co::DataIStream& is );
+
 protected:
+    /** @internal The parameters written by serializeDelta(). */
+    enum DirtyBits
+    {
+        DIRTY_PVP     = LB_BIT1,
+        DIRTY_ZOOM    = LB_BIT2,
+        DIRTY_TYPE    = LB_BIT3,
+        DIRTY_BUFFERS = LB_BIT4
+    };
+
     PixelViewport _pvp;
     RenderContext _context; //<! source channel render context
     Zoom          _zoom;
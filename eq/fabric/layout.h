@@ -104,6 +104,9 @@ protected:
 
     /** @internal */
     EQFABRIC_INL virtual void setDirty( const uint64_t bits );
+    /** @internal @sa Object::updateUserDataOwner() */
+    EQFABRIC_INL virtual void updateUserDataOwner( Object* owner,
+                                                   const bool hasUserData );
 
     /** @internal */
     enum DirtyBits
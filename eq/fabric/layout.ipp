@@ -77,7 +77,6 @@ void Layout< C, L, V >::attach( const uint128_t& id,
 template< class C, class L, class V >
 uint128_t Layout< C, L, V >::commit( const uint32_t incarnation )
 {
-    // Always traverse views: view proxy objects may be dirty
     commitChildren< V >( _views, CMD_LAYOUT_NEW_VIEW, incarnation );
     return Object::commit( incarnation );
 }
@@ -88,8 +87,13 @@ void Layout< C, L, V >::serialize( co::DataOStream& os,
 {
     Object::serialize( os, dirtyBits );
 
-    if( dirtyBits & DIRTY_VIEWS && isMaster( ))
-        os.serializeChildren( _views );
+    if( dirtyBits & DIRTY_VIEWS )
+    {
+        if( isMaster( ))
+            os.serializeChildren( _views );
+        else
+            serializeCommittedChildren( os, _views );
+    }
 }
 
 template< class C, class L, class V >
@@ -101,7 +105,7 @@ void Layout< C, L, V >::deserialize( co::DataIStream& is,
     if( dirtyBits & DIRTY_VIEWS )
     {
         if( isMaster( ))
-            syncChildren( _views );
+            syncChildren( is, _views );
         else
         {
             Views result;
@@ -118,6 +122,13 @@ void Layout< C, L, V >::setDirty( const uint64_t dirtyBits )
     _config->setDirty( C::DIRTY_LAYOUTS );
 }
 
+template< class C, class L, class V >
+void Layout< C, L, V >::updateUserDataOwner( Object* owner,
+                                             const bool hasUserData )
+{
+    _config->updateUserDataOwner( owner, hasUserData );
+}
+
 template< class C, class L, class V >
 void Layout< C, L, V >::notifyDetach()
 {
@@ -82,6 +82,13 @@ public:
         IATTR_THREAD_MODEL,
         IATTR_LAUNCH_TIMEOUT, //!< Timeout when auto-launching the node
         IATTR_HINT_AFFINITY,
+        /**
+         * Number of image compression and transmission threads.
+         *
+         * AUTO starts one thread per pipe, limited to the cores of the
+         * machine divided by the number of nodes in the process.
+         */
+        IATTR_TRANSMIT_THREADS,
         IATTR_LAST,
         IATTR_ALL = IATTR_LAST + 5
     };
@@ -126,6 +133,9 @@ protected:
 
     /** @sa Serializable::setDirty() @internal */
     EQFABRIC_INL virtual void setDirty( const uint64_t bits );
+    /** @internal @sa Object::updateUserDataOwner() */
+    EQFABRIC_INL virtual void updateUserDataOwner( Object* owner,
+                                                   const bool hasUserData );
 
     /** @internal */
     virtual ChangeType getChangeType() const { return UNBUFFERED; }
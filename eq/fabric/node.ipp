@@ -37,7 +37,8 @@ namespace
 std::string _iAttributeStrings[] = {
     MAKE_ATTR_STRING( IATTR_THREAD_MODEL ),
     MAKE_ATTR_STRING( IATTR_LAUNCH_TIMEOUT ),
-    MAKE_ATTR_STRING( IATTR_HINT_AFFINITY )
+    MAKE_ATTR_STRING( IATTR_HINT_AFFINITY ),
+    MAKE_ATTR_STRING( IATTR_TRANSMIT_THREADS )
 };
 
 }
@@ -100,10 +101,15 @@ Node< C, N, P, V >::serialize( co::DataOStream& os, const uint64_t dirtyBits )
     Object::serialize( os, dirtyBits );
     if( dirtyBits & DIRTY_ATTRIBUTES )
         os << co::Array< int32_t >( _data.iAttributes, IATTR_ALL );
-    if( dirtyBits & DIRTY_PIPES && isMaster( ))
+    if( dirtyBits & DIRTY_PIPES )
     {
-        os << _mapNodeObjects();
-        os.serializeChildren( _pipes );
+        if( isMaster( ))
+        {
+            os << _mapNodeObjects();
+            os.serializeChildren( _pipes );
+        }
+        else
+            serializeCommittedChildren( os, _pipes );
     }
     if( dirtyBits & DIRTY_MEMBER )
         os << _isAppNode;
@@ -118,7 +124,7 @@ Node< C, N, P, V >::deserialize( co::DataIStream& is, const uint64_t dirtyBits)
     if( dirtyBits & DIRTY_PIPES )
     {
         if( isMaster( ))
-            syncChildren( _pipes );
+            syncChildren( is, _pipes );
         else
         {
             const bool useChildren = is.read< bool >();
@@ -144,6 +150,13 @@ void Node< C, N, P, V >::setDirty( const uint64_t dirtyBits )
     _config->setDirty( C::DIRTY_NODES );
 }
 
+template< class C, class N, class P, class V >
+void Node< C, N, P, V >::updateUserDataOwner( Object* owner,
+                                              const bool hasUserData )
+{
+    _config->updateUserDataOwner( owner, hasUserData );
+}
+
 template< class C, class N, class P, class V >
 void Node< C, N, P, V >::notifyDetach()
 {
@@ -24,6 +24,7 @@
 #include <co/dataIStream.h>
 #include <co/dataOStream.h>
 #include <co/types.h>
+#include <lunchbox/atomic.h>
 
 namespace eq
 {
@@ -45,6 +46,7 @@ class Object
 public:
     Object()
         : userData( 0 )
+        , slaveCommits( 0 )
         , tasks( TASK_NONE )
         , serial( CO_INSTANCE_INVALID )
     {}
@@ -53,6 +55,7 @@ public:
         : data( from.data )
         , backup()
         , userData( from.userData )
+        , slaveCommits( 0 )
         , tasks( from.tasks )
         , serial( from.serial )
     {}
@@ -74,6 +77,8 @@ public:
     BackupData backup; //!< Backed up version (from .eqc)
 
     co::Object* userData; //!< User data object
+    std::vector< fabric::Object* > userDataOwners; //!< Registered at the root
+    lunchbox::a_int32_t slaveCommits; //!< Slave commits not yet announced
     uint32_t tasks; //!< Worst-case set of tasks
     uint32_t serial; //!< Server-unique serial number
 
@@ -181,6 +186,54 @@ void Object::notifyDetach()
     getLocalNode()->releaseObject( _impl->userData );
 }
 
+void Object::updateUserDataOwner( Object* owner, const bool hasUserData )
+{
+    std::vector< Object* >& owners = _impl->userDataOwners;
+    if( hasUserData )
+    {
+        owners.push_back( owner );
+        return;
+    }
+
+    std::vector< Object* >::iterator i = std::find( owners.begin(),
+                                                    owners.end(), owner );
+    LBASSERT( i != owners.end( ));
+    if( i != owners.end( ))
+        owners.erase( i );
+}
+
+void Object::setUserDataOwnersDirty()
+{
+    const std::vector< Object* >& owners = _impl->userDataOwners;
+    for( std::vector< Object* >::const_iterator i = owners.begin();
+         i != owners.end(); ++i )
+    {
+        Object* owner = *i;
+        if( owner != this && owner->isDirty( ))
+            owner->setDirty( DIRTY_NONE ); // marks the parents dirty
+    }
+}
+
+bool Object::takeSlaveCommit()
+{
+    const int32_t commits = _impl->slaveCommits;
+    if( commits == 0 )
+        return false;
+    _impl->slaveCommits -= commits;
+    return true;
+}
+
+void Object::_serializeIDs( co::DataOStream& os,
+                            const std::vector< uint128_t >& ids )
+{
+    os << ids;
+}
+
+std::vector< uint128_t > Object::_deserializeIDs( co::DataIStream& is )
+{
+    return is.read< std::vector< uint128_t > >();
+}
+
 void Object::backup()
 {
     LBASSERT( !_impl->userData );
@@ -196,6 +249,9 @@ void Object::restore()
 
 void Object::serialize( co::DataOStream& os, const uint64_t dirtyBits )
 {
+    if( !isMaster( )) // announced to the master by the parent's commit
+        ++_impl->slaveCommits;
+
     if( dirtyBits & DIRTY_NAME )
         os << _impl->data.name;
     if( dirtyBits & DIRTY_USERDATA )
@@ -310,7 +366,10 @@ void Object::setUserData( co::Object* userData )
         _impl->userData->getLocalNode()->releaseObject( _impl->userData );
     }
 
+    const bool hadUserData = _impl->userData != 0;
     _impl->userData = userData;
+    if( hadUserData != ( userData != 0 ))
+        updateUserDataOwner( this, userData != 0 );
 
     if( hasMasterUserData( ))
         setDirty( DIRTY_USERDATA );
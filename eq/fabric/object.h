@@ -26,6 +26,8 @@
 #include <co/objectVersion.h>       // member
 #include <co/serializable.h>        // base class
 
+#include <algorithm>
+
 namespace eq
 {
 namespace fabric
@@ -90,6 +92,22 @@ public:
     EQFABRIC_API virtual uint128_t commit( const uint32_t incarnation =
                                            CO_COMMIT_NEXT );
 
+    /**
+     * @internal Register or deregister an object which has user data.
+     *
+     * Changes of user data objects do not call setDirty(). The root of the
+     * hierarchy keeps all objects with user data, and marks the path to the
+     * changed ones dirty before commit. Subclasses forward to their parent.
+     */
+    EQFABRIC_API virtual void updateUserDataOwner( Object* owner,
+                                                   const bool hasUserData );
+
+    /** @internal @return true once after each slave commit of this object. */
+    EQFABRIC_API bool takeSlaveCommit();
+
+    /** @internal Mark all registered objects with dirty user data dirty. */
+    EQFABRIC_API void setUserDataOwnersDirty();
+
     /** @internal Back up app-specific data, excluding child data. */
     EQFABRIC_API virtual void backup();
 
@@ -172,7 +190,12 @@ protected:
             child->commit( incarnation );
         }
 
-    /** @internal commit, register child slave instances with the server. */
+    /**
+     * @internal commit, register child slave instances with the server.
+     *
+     * Attached children without changes are skipped. A child's setDirty()
+     * marks its parent dirty, so a clean child has no dirty descendants.
+     */
     template< class C, class S >
     void commitChildren( const std::vector< C* >& children, S* sender,
                          uint32_t cmd, const uint32_t incarnation );
@@ -183,14 +206,19 @@ protected:
                          const uint32_t incarnation )
         { commitChildren< C, Object >( children, this, cmd, incarnation ); }
 
-    /** @internal commit all children. */
+    /** @internal commit all dirty children. */
     template< class C >
     void commitChildren( const std::vector< C* >& children,
                          const uint32_t incarnation );
 
-    /** @internal sync all children to head version. */
+    /** @internal write the children committed since the last call. */
+    template< class C >
+    void serializeCommittedChildren( co::DataOStream& os,
+                                     const std::vector< C* >& children );
+
+    /** @internal sync the children committed by a slave to head version. */
     template< class C >
-    void syncChildren( const std::vector< C* >& children );
+    void syncChildren( co::DataIStream& is, const std::vector< C* >& children );
 
     /** @internal unmap/deregister all children. */
     template< class P, class C >
@@ -201,6 +229,11 @@ protected:
 
 private:
     detail::Object* const _impl;
+
+    EQFABRIC_API static void _serializeIDs( co::DataOStream& os,
+                                           const std::vector< uint128_t >& );
+    EQFABRIC_API static std::vector< uint128_t > _deserializeIDs(
+        co::DataIStream& is );
 };
 
 // Template Implementation
@@ -232,6 +265,8 @@ Object::commitChildren( const std::vector< C* >& children, S* sender,
          i != children.end(); ++i )
     {
         C* child = *i;
+        if( child->isAttached() && !child->isDirty( ))
+            continue;
         commitChild< C, S >( child, sender, cmd, incarnation );
     }
 }
@@ -246,19 +281,40 @@ inline void Object::commitChildren( const std::vector< C* >& children,
     {
         C* child = *i;
         LBASSERT( child->isAttached( ));
-        child->commit( incarnation );
+        if( child->isDirty( ))
+            child->commit( incarnation );
     }
 }
 
-template< class C >
-inline void Object::syncChildren( const std::vector< C* >& children )
+template< class C > inline void
+Object::serializeCommittedChildren( co::DataOStream& os,
+                                    const std::vector< C* >& children )
 {
+    std::vector< uint128_t > committed;
+    for( typename std::vector< C* >::const_iterator i = children.begin();
+         i != children.end(); ++i )
+    {
+        C* child = *i;
+        if( child->takeSlaveCommit( ))
+            committed.push_back( child->getID( ));
+    }
+    _serializeIDs( os, committed );
+}
+
+template< class C > inline void
+Object::syncChildren( co::DataIStream& is, const std::vector< C* >& children )
+{
+    const std::vector< uint128_t >& committed = _deserializeIDs( is );
     for( typename std::vector< C* >::const_iterator i = children.begin();
          i != children.end(); ++i )
     {
         C* child = *i;
         LBASSERT( child->isMaster( )); // slaves are synced using version
-        child->sync();
+        if( std::find( committed.begin(), committed.end(),
+                       child->getID( )) != committed.end( ))
+        {
+            child->sync();
+        }
     }
 }
 
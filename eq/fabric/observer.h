@@ -138,6 +138,8 @@ protected:
     virtual void deserialize( co::DataIStream& is,
                               const uint64_t dirtyBits );
     virtual void setDirty( const uint64_t bits ); //!< @internal
+    virtual void updateUserDataOwner( Object* owner,
+                                      const bool hasUserData ); //!< @internal
 
     /** @internal */
     enum DirtyBits
@@ -119,6 +119,13 @@ void Observer< C, O >::setDirty( const uint64_t dirtyBits )
     _config->setDirty( C::DIRTY_OBSERVERS );
 }
 
+template< typename C, typename O >
+void Observer< C, O >::updateUserDataOwner( Object* owner,
+                                            const bool hasUserData )
+{
+    _config->updateUserDataOwner( owner, hasUserData );
+}
+
 template< typename C, typename O >
 VisitorResult Observer< C, O >::accept( Visitor& visitor )
 {
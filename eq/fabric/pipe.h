@@ -115,6 +115,7 @@ public:
         IATTR_HINT_THREAD,   //!< Execute tasks in separate thread (default)
         IATTR_HINT_AFFINITY, //!< Bind render thread to subset of cores
         IATTR_HINT_CUDA_GL_INTEROP, //!< Configure CUDA context
+        IATTR_HINT_STATISTICS, //!< Instrument pipe thread command queues
         IATTR_LAST,
         IATTR_ALL = IATTR_LAST + 5
     };
@@ -166,6 +167,9 @@ protected:
 
     /** @internal @sa Serializable::setDirty() */
     EQFABRIC_INL virtual void setDirty( const uint64_t bits );
+    /** @internal @sa Object::updateUserDataOwner() */
+    EQFABRIC_INL virtual void updateUserDataOwner( Object* owner,
+                                                   const bool hasUserData );
 
     /** @internal */
     virtual ChangeType getChangeType() const { return UNBUFFERED; }
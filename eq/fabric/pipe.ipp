@@ -41,6 +41,7 @@ std::string _iPipeAttributeStrings[] = {
     MAKE_PIPE_ATTR_STRING( IATTR_HINT_THREAD ),
     MAKE_PIPE_ATTR_STRING( IATTR_HINT_AFFINITY ),
     MAKE_PIPE_ATTR_STRING( IATTR_HINT_CUDA_GL_INTEROP ),
+    MAKE_PIPE_ATTR_STRING( IATTR_HINT_STATISTICS ),
 };
 
 }
@@ -118,10 +119,15 @@ void Pipe< N, P, W, V >::serialize( co::DataOStream& os,
     Object::serialize( os, dirtyBits );
     if( dirtyBits & DIRTY_ATTRIBUTES )
         os << co::Array< int32_t >( _iAttributes, IATTR_ALL );
-    if( dirtyBits & DIRTY_WINDOWS && isMaster( ))
+    if( dirtyBits & DIRTY_WINDOWS )
     {
-        os << _mapNodeObjects();
-        os.serializeChildren( _windows );
+        if( isMaster( ))
+        {
+            os << _mapNodeObjects();
+            os.serializeChildren( _windows );
+        }
+        else
+            serializeCommittedChildren( os, _windows );
     }
     if( dirtyBits & DIRTY_PIXELVIEWPORT )
         os << _data.pvp;
@@ -139,7 +145,7 @@ void Pipe< N, P, W, V >::deserialize( co::DataIStream& is,
     if( dirtyBits & DIRTY_WINDOWS )
     {
         if( isMaster( ))
-            syncChildren( _windows );
+            syncChildren( is, _windows );
         else
         {
             const bool useChildren = is.read< bool >();
@@ -171,6 +177,13 @@ void Pipe< N, P, W, V >::setDirty( const uint64_t dirtyBits )
     _node->setDirty( N::DIRTY_PIPES );
 }
 
+template< class N, class P, class W, class V >
+void Pipe< N, P, W, V >::updateUserDataOwner( Object* owner,
+                                              const bool hasUserData )
+{
+    _node->updateUserDataOwner( owner, hasUserData );
+}
+
 template< class N, class P, class W, class V >
 void Pipe< N, P, W, V >::notifyDetach()
 {
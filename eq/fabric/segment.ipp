@@ -116,6 +116,13 @@ void Segment< C, S, CH >::setDirty( const uint64_t dirtyBits )
     _canvas->setDirty( C::DIRTY_SEGMENTS );
 }
 
+template< class C, class S, class CH >
+void Segment< C, S, CH >::updateUserDataOwner( Object* owner,
+                                               const bool hasUserData )
+{
+    _canvas->updateUserDataOwner( owner, hasUserData );
+}
+
 template< class C, class S, class CH >
 VisitorResult Segment< C, S, CH >::accept( Visitor& visitor )
 {
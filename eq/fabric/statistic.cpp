@@ -84,6 +84,16 @@ static StatisticData _statisticData[] =
    "finish frame", Vector3f( .5f, .5f, .5f ) },
  { Statistic::CONFIG_WAIT_FINISH_FRAME,
    "wait finish",  Vector3f( 1.0f, 0.f, 0.f ) },
+ { Statistic::PIPE_COMMAND_LATENCY,
+   "queue latency", Vector3f( 1.f, 1.f, 1.f ) },
+ { Statistic::PIPE_COMMAND_HANDLE,
+   "command",      Vector3f( 1.f, 1.f, 1.f ) },
+ { Statistic::CHANNEL_CULL,
+   "cull",         Vector3f( .5f, .5f, 1.f ) },
+ { Statistic::CHANNEL_EMPTY_SPACE,
+   "empty space",  Vector3f( .7f, .7f, .7f ) },
+ { Statistic::CHANNEL_FRAME_WAIT_DUMP,
+   "wait dump",    Vector3f( 1.f, 0.f, 0.f ) },
  { Statistic::ALL,
    "ALL EVENTS",   Vector3f( 0.0f, 0.f, 0.f ) }} ;
 }
@@ -111,6 +121,13 @@ std::ostream& operator << ( std::ostream& os, const Statistic& event )
     os << event.resourceName << ": " << event.type << ' ' << event.frameNumber
        << ' ' << event.task << ' ' << event.startTime << " - " << event.endTime
        << ' ' << event.idleTime << '/' << event.totalTime;
+    if( event.type == Statistic::PIPE_COMMAND_LATENCY ||
+        event.type == Statistic::PIPE_COMMAND_HANDLE )
+    {
+        os << " cmd " << event.command << ' ' << event.samples << "x p50 "
+           << event.median << "us p99 " << event.percentile99 << "us mean "
+           << event.mean << "us depth " << event.maxDepth;
+    }
     return os;
 }
 
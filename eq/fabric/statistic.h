@@ -66,6 +66,19 @@ struct Statistic
         CONFIG_FINISH_FRAME, //!< Sampling of Config::finishFrame
         /** Sampling of synchronization time during Config::finishFrame */
         CONFIG_WAIT_FINISH_FRAME,
+        /**
+         * Time from enqueue to dispatch of one command type in a pipe,
+         * transfer or node main thread queue, see command.
+         */
+        PIPE_COMMAND_LATENCY,
+        /** Handler time of one command type, see command */
+        PIPE_COMMAND_HANDLE,
+        CHANNEL_CULL, //!< Sampling of application culling during frameDraw
+        /** Sampling of rendering with empty space skipping during frameDraw,
+            the ratio is the skipped part */
+        CHANNEL_EMPTY_SPACE,
+        /** Pipe thread wait for a free image dump buffer */
+        CHANNEL_FRAME_WAIT_DUMP,
         ALL          // must be last
     };
 
@@ -76,13 +89,40 @@ struct Statistic
 
     int64_t  startTime; //!< Absolute start time of the operation
     int64_t  endTime;    //!< Absolute end time of the operation
-    int64_t  idleTime;  //!< Absolute idle time of PIPE_IDLE
-    int64_t  totalTime;  //!< Total time of a pipe frame (PIPE_IDLE)
 
-    float    ratio; //!< compression ratio (transfer, compression)
-    float    currentFPS; //!< FPS of last frame (WINDOW_FPS)
-    float    averageFPS; //!< Weighted sum averaging of FPS (WINDOW_FPS)
-    float    pad; //!< @internal
+    // PIPE_COMMAND_LATENCY and PIPE_COMMAND_HANDLE events share the value
+    // slots of the other types, so that they do not grow every event
+    union
+    {
+        int64_t idleTime;  //!< Absolute idle time of PIPE_IDLE
+        int64_t median;    //!< Median command time in us (PIPE_COMMAND_*)
+    };
+    union
+    {
+        int64_t totalTime;    //!< Total time of a pipe frame (PIPE_IDLE)
+        int64_t percentile99; //!< 99th percentile in us (PIPE_COMMAND_*)
+    };
+
+    union
+    {
+        float ratio; //!< compression ratio (transfer, compression)
+        float mean;  //!< Mean command time in us (PIPE_COMMAND_*)
+    };
+    union
+    {
+        float    currentFPS; //!< FPS of last frame (WINDOW_FPS)
+        uint32_t command;    //!< The sampled command type (PIPE_COMMAND_*)
+    };
+    union
+    {
+        float    averageFPS; //!< Weighted sum averaging of FPS (WINDOW_FPS)
+        uint32_t samples;    //!< Number of sampled commands (PIPE_COMMAND_*)
+    };
+    union
+    {
+        float    pad;      //!< @internal
+        uint32_t maxDepth; //!< Maximum queue depth (PIPE_COMMAND_*)
+    };
 
     char resourceName[32]; //!< A non-unique name of the originator
 
@@ -122,6 +162,7 @@ template<> inline void byteswap( eq::fabric::Statistic& value )
     byteswap( value.ratio );
     byteswap( value.currentFPS );
     byteswap( value.averageFPS );
+    byteswap( value.pad );
 }
 }
 
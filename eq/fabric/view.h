@@ -283,6 +283,9 @@ protected:
 
     /** @internal */
     EQFABRIC_INL virtual void setDirty( const uint64_t bits );
+    /** @internal @sa Object::updateUserDataOwner() */
+    EQFABRIC_INL virtual void updateUserDataOwner( Object* owner,
+                                                   const bool hasUserData );
 
     /** @internal */
     void setSAttribute( const SAttribute attr, const std::string& value )
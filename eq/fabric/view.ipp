@@ -179,6 +179,14 @@ void View< L, V, O >::setDirty( const uint64_t dirtyBits )
         _layout->setDirty( L::DIRTY_VIEWS );
 }
 
+template< class L, class V, class O >
+void View< L, V, O >::updateUserDataOwner( Object* owner,
+                                           const bool hasUserData )
+{
+    if( _layout )
+        _layout->updateUserDataOwner( owner, hasUserData );
+}
+
 template< class L, class V, class O >
 void View< L, V, O >::changeMode( const Mode mode )
 {
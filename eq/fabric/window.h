@@ -171,6 +171,9 @@ namespace fabric
 
         /** @sa Serializable::setDirty() @internal */
         EQFABRIC_INL virtual void setDirty( const uint64_t bits );
+        /** @internal @sa Object::updateUserDataOwner() */
+        EQFABRIC_INL virtual void updateUserDataOwner( Object* owner,
+                                                       const bool hasUserData );
 
         /** @internal */
         void _setDrawableConfig( const DrawableConfig& drawableConfig );
@@ -149,10 +149,15 @@ void Window< P, W, C, Settings >::serialize( co::DataOStream& os,
     Object::serialize( os, dirtyBits );
     if( dirtyBits & DIRTY_SETTINGS )
         _data.windowSettings.serialize( os );
-    if( dirtyBits & DIRTY_CHANNELS && isMaster( ))
+    if( dirtyBits & DIRTY_CHANNELS )
     {
-        os << _mapNodeObjects();
-        os.serializeChildren( _channels );
+        if( isMaster( ))
+        {
+            os << _mapNodeObjects();
+            os.serializeChildren( _channels );
+        }
+        else
+            serializeCommittedChildren( os, _channels );
     }
     if( dirtyBits & DIRTY_VIEWPORT )
         os << _data.vp << _data.pvp << _data.fixedVP;
@@ -170,7 +175,7 @@ void Window< P, W, C, Settings >::deserialize( co::DataIStream& is,
     if( dirtyBits & DIRTY_CHANNELS )
     {
         if( isMaster( ))
-            syncChildren( _channels );
+            syncChildren( is, _channels );
         else
         {
             const bool useChildren = is.read< bool >();
@@ -209,6 +214,13 @@ void Window< P, W, C, Settings >::setDirty( const uint64_t dirtyBits )
     _pipe->setDirty( P::DIRTY_WINDOWS );
 }
 
+template< class P, class W, class C, class Settings >
+void Window< P, W, C, Settings >::updateUserDataOwner( Object* owner,
+                                                       const bool hasUserData )
+{
+    _pipe->updateUserDataOwner( owner, hasUserData );
+}
+
 template< class P, class W, class C, class Settings >
 void Window< P, W, C, Settings >::notifyDetach()
 {
@@ -22,6 +22,9 @@
 
 #include "nodeStatistics.h"
 #include "channelStatistics.h"
+#include "detail/blockMask.h"
+#include "detail/referenceImage.h"
+#include "detail/sharedImageRing.h"
 #include "exception.h"
 #include "image.h"
 #include "log.h"
@@ -50,6 +53,18 @@ typedef std::vector< FrameData::Listener* > Listeners;
 
 namespace detail
 {
+/** A shared image ring slot used in place by the pixel data of an image. */
+struct MappedSlot
+{
+    MappedSlot( Image* image_, SharedImageRing* ring_, const uint64_t offset_ )
+        : image( image_ ), ring( ring_ ), offset( offset_ ) {}
+
+    Image* image;
+    SharedImageRing* ring;
+    uint64_t offset;
+};
+typedef std::vector< MappedSlot > MappedSlots;
+
 class FrameData
 {
 public:
@@ -70,6 +85,10 @@ public:
 
     Images pendingImages;
 
+    /** The ring slots of the images and of the pending images. */
+    MappedSlots slots;
+    MappedSlots pendingSlots;
+
     uint64_t version; //!< The current version
 
     /** Data ready monitor for output->input synchronization. */
@@ -84,6 +103,18 @@ public:
 
     uint32_t colorCompressor;
     uint32_t depthCompressor;
+
+    /** Hand the slots back to their producers, once the images are unused. */
+    static void releaseSlots( MappedSlots& mappedSlots )
+    {
+        for( const MappedSlot& slot : mappedSlots )
+        {
+            slot.image->unmapPixelData( Frame::BUFFER_COLOR );
+            slot.image->unmapPixelData( Frame::BUFFER_DEPTH );
+            slot.ring->release( slot.offset );
+        }
+        mappedSlots.clear();
+    }
 };
 }
 
@@ -96,6 +127,7 @@ FrameData::FrameData()
 FrameData::~FrameData()
 {
     clear();
+    detail::FrameData::releaseSlots( _impl->pendingSlots );
 
     for( Image* image : _impl->imageCache )
     {
@@ -160,8 +192,22 @@ void FrameData::applyInstanceData( co::DataIStream& is )
     LBLOG( LOG_ASSEMBLY ) << "applied " << this << std::endl;
 }
 
+void FrameData::pack( co::DataOStream& os )
+{
+    LBUNREACHABLE;
+    serializeDelta( os, *this );
+}
+
+void FrameData::unpack( co::DataIStream& is )
+{
+    clear();
+    deserializeDelta( is );
+    LBLOG( LOG_ASSEMBLY ) << "applied delta " << this << std::endl;
+}
+
 void FrameData::clear()
 {
+    detail::FrameData::releaseSlots( _impl->slots );
     _impl->imageCacheLock.set();
     _impl->imageCache.insert( _impl->imageCache.end(), _impl->images.begin(),
                               _impl->images.end( ));
@@ -333,6 +379,59 @@ Images FrameData::startReadback( const Frame& frame,
     return images;
 }
 
+void FrameData::cropImages( const size_t first, const uint128_t& frameID )
+{
+    // new images for additional areas are appended after the last one
+    size_t last = _impl->images.size();
+    for( size_t i = first; i < last; ++i )
+    {
+        Image* image = _impl->images[i];
+        if( image->getStorageType() != Frame::TYPE_MEMORY ||
+            image->hasAsyncReadback( ))
+        {
+            continue;
+        }
+
+        // images at the same index track their statistics across frames
+        const PixelViewport& pvp = image->getPixelViewport();
+        const PixelViewports& regions =
+            _impl->roiFinder.findRegions( *image, uint32_t( i ), frameID );
+
+        PixelViewports areas;
+        for( PixelViewport region : regions )
+        {
+            region.intersect( pvp );
+            if( region.hasArea( ))
+                areas.push_back( region );
+        }
+
+        if( areas.empty( ))
+        {
+            _impl->imageCacheLock.set();
+            _impl->imageCache.push_back( image );
+            _impl->imageCacheLock.unset();
+            _impl->images.erase( _impl->images.begin() + i );
+            --i;
+            --last;
+            continue;
+        }
+        if( areas.size() == 1 && areas.front() == pvp )
+            continue;
+
+        for( size_t j = 1; j < areas.size(); ++j )
+        {
+            Image* area = _allocImage( Frame::TYPE_MEMORY, DrawableConfig(),
+                                       true /* set quality */ );
+            area->setAlphaUsage( image->getAlphaUsage( ));
+            area->setZoom( image->getZoom( ));
+            area->setContext( image->getContext( ));
+            area->crop( *image, areas[j] );
+            _impl->images.push_back( area );
+        }
+        image->crop( *image, areas.front( ));
+    }
+}
+
 void FrameData::setVersion( const uint64_t version )
 {
     LBASSERTINFO( _impl->version <= version, _impl->version << " > "
@@ -363,6 +462,7 @@ void FrameData::setReady( const co::ObjectVersion& frameData,
     LBASSERT( _impl->version == frameData.version.low( ));
 
     _impl->images.swap( _impl->pendingImages );
+    _impl->slots.swap( _impl->pendingSlots );
     fabric::FrameData::operator = ( data );
     _setReady( frameData.version.low());
 
@@ -410,11 +510,18 @@ void FrameData::removeListener( Listener& listener )
 bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
                           const PixelViewport& pvp, const Zoom& zoom,
                           const RenderContext& context, const uint32_t buffers_,
-                          const bool useAlpha, uint8_t* data )
+                          const bool useAlpha, uint8_t* data,
+                          detail::ReferenceImage* reference,
+                          const uint32_t sequence,
+                          detail::SharedImageRing* ring, const uint64_t slot )
 {
     LBASSERT( _impl->readyVersion < frameDataVersion.version.low( ));
     if( _impl->readyVersion >= frameDataVersion.version.low( ))
+    {
+        if( ring )
+            ring->release( slot );
         return false;
+    }
 
     Image* image = _allocImage( Frame::TYPE_MEMORY, DrawableConfig(),
                                 false /* set quality */ );
@@ -422,6 +529,12 @@ bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
     image->setPixelViewport( pvp );
     image->setAlphaUsage( useAlpha );
 
+    // delta frames need the previous frame of their stream
+    const bool hasReference = reference && reference->sequence > 0 &&
+                              reference->sequence + 1 == sequence;
+    bool keyframe = true;
+    bool mapped = false;
+
     Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
     for( unsigned i = 0; i < 2; ++i )
     {
@@ -439,6 +552,17 @@ bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
             pixelData.pvp             = header->pvp;
             pixelData.compressorFlags = header->compressorFlags;
 
+            // block-sparse and delta images carry the mask and background
+            const uint8_t* mask = data;
+            const uint8_t* background = data;
+            if( header->blockSize > 0 )
+            {
+                data += detail::BlockMask::getNumBytes( pvp,
+                                                        header->blockSize );
+                background = data;
+                data += header->pixelSize;
+            }
+
             const uint32_t compressor = header->compressorName;
             if( compressor > EQ_COMPRESSOR_NONE )
             {
@@ -470,10 +594,45 @@ bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
             image->setZoom( zoom );
             image->setContext( context );
             image->setQuality( buffer, header->quality );
-            image->setPixelData( buffer, pixelData );
+            if( header->delta && hasReference )
+                image->setBlockData( buffer, pixelData, header->blockSize,
+                                     mask, reference->image );
+            else if( header->delta )
+            {
+                LBWARN << "Missing reference for delta frame " << sequence
+                       << ", image incomplete until the requested keyframe"
+                       << std::endl;
+                image->setBlockData( buffer, pixelData, header->blockSize,
+                                     mask, static_cast< const void* >( 0 ));
+            }
+            else if( header->blockSize > 0 )
+                image->setBlockData( buffer, pixelData, header->blockSize,
+                                     mask, background );
+            else if( ring && compressor <= EQ_COMPRESSOR_NONE )
+            {
+                // use the pixels in place, the slot is released by clear()
+                image->mapPixelData( buffer, pixelData );
+                mapped = true;
+            }
+            else
+                image->setPixelData( buffer, pixelData );
+            keyframe = keyframe && !header->delta;
         }
     }
 
+    if( reference )
+    {
+        if( keyframe || hasReference )
+            reference->update( *image, sequence, keyframe );
+        else
+            reference->invalidate();
+    }
+
+    if( mapped )
+        _impl->pendingSlots.push_back( detail::MappedSlot( image, ring, slot ));
+    else if( ring )
+        ring->release( slot );
+
     _impl->pendingImages.push_back( image );
     return true;
 }
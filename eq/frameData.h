@@ -29,7 +29,10 @@
 
 namespace eq
 {
-namespace detail { class FrameData; }
+namespace detail
+{
+class FrameData; class ReferenceImage; class SharedImageRing;
+}
 
 /**
  * A holder for multiple images.
@@ -61,6 +64,8 @@ public:
         uint32_t                compressorFlags;
         uint32_t                nChunks;
         float                   quality;
+        uint32_t                blockSize; //!< block-sparse if not 0
+        uint32_t                delta; //!< changed blocks only if not 0
     };
 
     /** Construct a new frame data holder. @version 1.0 */
@@ -154,6 +159,19 @@ public:
                           const PixelViewports& regions,
                           const RenderContext& context );
 
+    /**
+     * @internal Crop the read back images to their regions of interest.
+     *
+     * Finds the areas containing pixels in each memory image from the given
+     * index on the CPU. Each image is cropped to its first area, and a new
+     * image is added for each other area. Empty images are removed, and
+     * images with a pending asynchronous readback are kept.
+     *
+     * @param first the index of the first image to crop.
+     * @param frameID the identifier of the current frame.
+     */
+    void cropImages( size_t first, const uint128_t& frameID );
+
     /**
      * Set the frame data ready.
      *
@@ -195,18 +213,30 @@ public:
     void removeListener( Listener& listener );
     //@}
 
-    /** @internal */
+    /**
+     * @internal Add a transmitted image.
+     *
+     * Delta frames are patched onto the given reference of their stream,
+     * which is then updated with the new frame. Data in a shared image ring
+     * slot is released to its producer, uncompressed pixels only once the
+     * frame data is cleared for a later frame, since they are used in place.
+     */
     bool addImage( const co::ObjectVersion& frameDataVersion,
                    const PixelViewport& pvp, const Zoom& zoom,
                    const RenderContext& context, const uint32_t buffers,
-                   const bool useAlpha, uint8_t* data );
+                   const bool useAlpha, uint8_t* data,
+                   detail::ReferenceImage* reference = 0,
+                   uint32_t sequence = 0, detail::SharedImageRing* ring = 0,
+                   uint64_t slot = 0 );
     void setReady( const co::ObjectVersion& frameData,
                    const fabric::FrameData& data ); //!< @internal
 
 protected:
-    virtual ChangeType getChangeType() const { return INSTANCE; }
+    virtual ChangeType getChangeType() const { return DELTA; }
     virtual void getInstanceData( co::DataOStream& os );
     virtual void applyInstanceData( co::DataIStream& is );
+    virtual void pack( co::DataOStream& os );
+    virtual void unpack( co::DataIStream& is );
 
 private:
     detail::FrameData* const _impl;
@@ -0,0 +1,324 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "frameReplay.h"
+
+#include "compositor.h"
+#include "frameData.h"
+#include "image.h"
+#include "imageOp.h"
+#include "detail/frameCapture.h"
+#include "detail/referenceImage.h"
+
+#include <lunchbox/clock.h>
+#include <lunchbox/log.h>
+#include <fstream>
+#include <map>
+
+namespace eq
+{
+namespace detail
+{
+class FrameReplay
+{
+public:
+    explicit FrameReplay( const std::string& name )
+        : filename( name )
+        , file( name.c_str(), std::ios::in | std::ios::binary )
+        , good( false )
+        , result( 0 )
+    {
+        if( !file.is_open( ))
+        {
+            LBWARN << "Can't open frame capture " << filename << std::endl;
+            return;
+        }
+        rewind();
+    }
+
+    ~FrameReplay()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for( const auto& reference : references )
+            delete reference.second;
+        references.clear();
+        datas.clear();
+        times = eq::FrameReplay::Times();
+        images.clear();
+        result = 0;
+    }
+
+    void rewind()
+    {
+        clear();
+        file.clear();
+        file.seekg( 0 );
+
+        uint64_t magic = 0;
+        good = _read( magic ) && magic == FrameCapture::magic;
+        if( !good )
+        {
+            LBWARN << filename << " is not a frame capture" << std::endl;
+            return;
+        }
+
+        uint32_t version = 0;
+        uint32_t headerSize = 0;
+        good = _read( version ) && _read( headerSize ) &&
+               version == FrameCapture::version &&
+               headerSize == sizeof( FrameData::ImageHeader );
+        if( !good )
+            LBWARN << filename << " has the incompatible frame capture "
+                   << "format " << version << " with " << headerSize
+                   << " byte image headers, expected format "
+                   << FrameCapture::version << std::endl;
+    }
+
+    bool next( const bool blend )
+    {
+        if( !good )
+            return false;
+
+        times = eq::FrameReplay::Times();
+        images.clear();
+        result = 0;
+
+        uint32_t type = 0;
+        while( _read( type ))
+        {
+            switch( type )
+            {
+            case FrameCapture::RECORD_IMAGE:
+                if( !_replayImage( ))
+                    return _fail();
+                break;
+
+            case FrameCapture::RECORD_ASSEMBLY:
+                return _replayAssembly( blend ) || _fail();
+
+            default:
+                LBWARN << "Unknown record type " << type << " in "
+                       << filename << std::endl;
+                return _fail();
+            }
+        }
+        return false; // end of capture
+    }
+
+    /** A frame data of the capture, replayed like on the receiving node. */
+    struct Data
+    {
+        Data() : version( 0 ), ready( false ) {}
+
+        FrameDataPtr frameData;
+        uint64_t version;
+        bool ready;
+    };
+    typedef std::map< uint128_t, Data > Datas;
+    typedef std::map< uint128_t, ReferenceImage* > ReferenceImages;
+
+    const std::string filename;
+    std::ifstream file;
+    bool good;
+
+    Datas datas;
+    ReferenceImages references;
+    std::vector< uint8_t > payload;
+    std::vector< FrameCapture::FrameRecord > frames;
+
+    eq::FrameReplay::Times times;
+    Images images;
+    const Image* result;
+
+private:
+    template< class T > bool _read( T& value )
+    {
+        return _read( &value, sizeof( T ));
+    }
+
+    bool _read( void* data, const uint64_t size )
+    {
+        file.read( reinterpret_cast< char* >( data ), size );
+        return file.good();
+    }
+
+    bool _fail()
+    {
+        LBWARN << "Error replaying " << filename << ", stopping" << std::endl;
+        good = false;
+        return false;
+    }
+
+    FrameDataPtr _getFrameData( const co::ObjectVersion& version )
+    {
+        LBASSERT( version.version.high() == 0 );
+        const uint64_t number = version.version.low();
+        Data& data = datas[ version.identifier ];
+        if( data.frameData && data.version == number )
+            return data.frameData;
+
+        // new frame data or skipped version, restart like a new node
+        if( !data.frameData || !data.ready || data.version + 1 != number )
+        {
+            data.frameData = new FrameData;
+            data.frameData->setID( version.identifier );
+        }
+        data.frameData->setVersion( number );
+        data.version = number;
+        data.ready = false;
+        return data.frameData;
+    }
+
+    ReferenceImage* _getReferenceImage( const uint128_t& stream )
+    {
+        if( stream == 0 )
+            return 0;
+
+        ReferenceImage*& reference = references[ stream ];
+        if( !reference )
+            reference = new ReferenceImage( stream );
+        return reference;
+    }
+
+    bool _replayImage()
+    {
+        FrameCapture::ImageRecord record;
+        if( !_read( record ))
+            return false;
+
+        payload.resize( record.size );
+        if( !_read( payload.data(), record.size ))
+            return false;
+
+        FrameDataPtr frameData = _getFrameData( record.frameData );
+        ReferenceImage* reference = _getReferenceImage( record.stream );
+
+        const lunchbox::Clock clock;
+        if( !frameData->addImage( record.frameData, record.pvp, record.zoom,
+                                  record.context, record.buffers,
+                                  record.useAlpha != 0, payload.data(),
+                                  reference, record.sequence ))
+        {
+            return false;
+        }
+        times.decode += clock.getTimef();
+        times.size += record.size;
+        ++times.nImages;
+        return true;
+    }
+
+    bool _replayAssembly( const bool blend )
+    {
+        FrameCapture::AssemblyRecord assembly;
+        if( !_read( assembly ))
+            return false;
+
+        frames.resize( assembly.nFrames );
+        if( !frames.empty() &&
+            !_read( frames.data(),
+                    frames.size() * sizeof( FrameCapture::FrameRecord )))
+        {
+            return false;
+        }
+        times.frameNumber = assembly.frameNumber;
+
+        ImageOps ops;
+        for( const FrameCapture::FrameRecord& frame : frames )
+        {
+            Datas::iterator i = datas.find( frame.frameData.identifier );
+            if( i == datas.end() ||
+                i->second.version != frame.frameData.version.low( ))
+            {
+                continue; // no images in this frame
+            }
+
+            Data& data = i->second;
+            if( !data.ready )
+            {
+                data.frameData->setReady( frame.frameData,
+                                          fabric::FrameData( ));
+                data.ready = true;
+            }
+
+            for( Image* image : data.frameData->getImages( ))
+            {
+                images.push_back( image );
+
+                ImageOp op;
+                op.image = image;
+                op.buffers = frame.buffers;
+                op.offset = frame.offset;
+                op.zoom = frame.zoom;
+                op.zoom.apply( image->getZoom( ));
+                op.zoomFilter = op.zoom == Zoom::NONE ? FILTER_NEAREST :
+                                ZoomFilter( frame.zoomFilter );
+                ops.push_back( op );
+            }
+        }
+
+        const lunchbox::Clock clock;
+        result = ops.empty() ? 0 : Compositor::mergeImagesCPU( ops, blend );
+        times.merge = clock.getTimef();
+        return true;
+    }
+};
+}
+
+FrameReplay::FrameReplay( const std::string& filename )
+    : _impl( new detail::FrameReplay( filename ))
+{}
+
+FrameReplay::~FrameReplay()
+{
+    delete _impl;
+}
+
+bool FrameReplay::isGood() const
+{
+    return _impl->good;
+}
+
+bool FrameReplay::next( const bool blend )
+{
+    return _impl->next( blend );
+}
+
+void FrameReplay::rewind()
+{
+    _impl->rewind();
+}
+
+const FrameReplay::Times& FrameReplay::getTimes() const
+{
+    return _impl->times;
+}
+
+const Images& FrameReplay::getImages() const
+{
+    return _impl->images;
+}
+
+const Image* FrameReplay::getResult() const
+{
+    return _impl->result;
+}
+
+}
@@ -0,0 +1,95 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_FRAMEREPLAY_H
+#define EQ_FRAMEREPLAY_H
+
+#include <eq/api.h>
+#include <eq/types.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace eq
+{
+namespace detail { class FrameReplay; }
+
+/**
+ * Replays a frame capture offline, for tuning and regression testing image
+ * decompression and compositing without a cluster.
+ *
+ * A capture is written by a node when one of its channels has the
+ * Channel::SATTR_CAPTURE_FRAMES attribute set. It contains the images received
+ * by the node, exactly as sent by the source channels, and the input frames of
+ * each frame assembly. The replay adds the images to their frame data using
+ * the code path of the receiving node, and merges the images of each assembly
+ * using Compositor::mergeImagesCPU(). The OpenGL drawing of the assembly is not
+ * replayed.
+ */
+class FrameReplay : public boost::noncopyable
+{
+public:
+    /** The statistics of one replayed frame assembly. @version 1.12 */
+    struct Times
+    {
+        uint32_t frameNumber; //!< the captured frame number
+        uint32_t nImages;     //!< the images added since the last assembly
+        uint64_t size;        //!< the payload size of these images in bytes
+        float decode;         //!< the time in ms to add and decompress them
+        float merge;          //!< the time in ms to merge the assembled images
+    };
+
+    /** Open the given capture file. @version 1.12 */
+    EQ_API explicit FrameReplay( const std::string& filename );
+
+    /** Destruct the replay. @version 1.12 */
+    EQ_API ~FrameReplay();
+
+    /** @return true if the capture file is open and valid. @version 1.12 */
+    EQ_API bool isGood() const;
+
+    /**
+     * Replay the records up to and including the next frame assembly.
+     *
+     * @param blend blend the images instead of depth-compositing them, see
+     *              Compositor::mergeImagesCPU().
+     * @return false at the end of the capture or on errors.
+     * @version 1.12
+     */
+    EQ_API bool next( bool blend = false );
+
+    /** Restart the replay at the beginning of the capture. @version 1.12 */
+    EQ_API void rewind();
+
+    /** @return the statistics of the last assembly. @version 1.12 */
+    EQ_API const Times& getTimes() const;
+
+    /** @return the decoded input images of the last assembly. @version 1.12 */
+    EQ_API const Images& getImages() const;
+
+    /**
+     * @return the merged image of the last assembly, or 0 if it could not be
+     *         merged on the CPU.
+     * @version 1.12
+     */
+    EQ_API const Image* getResult() const;
+
+private:
+    detail::FrameReplay* const _impl;
+};
+}
+
+#endif // EQ_FRAMEREPLAY_H
@@ -21,13 +21,13 @@
 #include "image.h"
 
 #include "gl.h"
-#include "half.h"
 #include "log.h"
 #include "pixelData.h"
 #include "windowSystem.h"
 
 #include <eq/util/frameBufferObject.h>
 #include <eq/util/objectManager.h>
+#include <eq/util/pixelConversion.h>
 #include <eq/fabric/renderContext.h>
 
 #include <co/global.h>
@@ -42,7 +42,10 @@
 #include <pression/uploader.h>
 
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <vector>
 
 #ifdef _WIN32
 #  include <malloc.h>
@@ -50,6 +53,7 @@
 #  include <alloca.h>
 #endif
 
+#include "detail/blockMask.h"
 #include "transferFinder.h"
 
 #ifdef EQUALIZER_USE_OPENSCENEGRAPH
@@ -128,6 +132,12 @@ struct Attachment
     /** Current pixel data (memory images). */
     Memory memory;
 
+    /** The occupied blocks of sparse pixel data, see detail::BlockMask. */
+    Memory blocks;
+
+    /** The pixel of the empty blocks of the block data. */
+    std::vector< uint8_t > background;
+
     Zoom zoom; //!< zoom factor of pending readback
 
     Attachment()
@@ -149,6 +159,7 @@ struct Attachment
     void flush()
     {
         memory.flush();
+        blocks.flush();
         texture.flush();
         resetPlugins();
     }
@@ -174,6 +185,8 @@ public:
         : type( eq::Frame::TYPE_MEMORY )
         , ignoreAlpha( false )
         , hasPremultipliedAlpha( false )
+        , clearColor( Vector4f::ZERO )
+        , clearDepth( 1.f )
     {}
 
     /** The rectangle of the current pixel data. */
@@ -196,6 +209,13 @@ public:
 
     bool hasPremultipliedAlpha;
 
+    /** The clear values of the read back frame buffer. */
+    Vector4f clearColor;
+    float clearDepth;
+
+    /** The occupied blocks of the memory pixel data. */
+    BlockMask blockMask;
+
     Attachment& getAttachment( const eq::Frame::Buffer buffer )
     {
         switch( buffer )
@@ -229,6 +249,62 @@ public:
     const Memory& getMemory( const eq::Frame::Buffer buffer ) const
         { return getAttachment( buffer ).memory; }
 
+    /** Compress the given pixels with the compressor of the attachment. */
+    void compress( Attachment& attachment, Memory& data )
+    {
+        // both share the output of the compressor
+        attachment.memory.compressedData = pression::CompressorResult();
+        attachment.blocks.compressedData = pression::CompressorResult();
+
+        const Memory& memory = attachment.memory;
+        pression::Compressor& compressor =
+            attachment.compressor[ attachment.active ];
+
+        if( !compressor.isGood() ||
+            compressor.getInfo().tokenType != memory.externalFormat ||
+            memory.compressorName == EQ_COMPRESSOR_AUTO )
+        {
+            if( memory.compressorName == EQ_COMPRESSOR_AUTO )
+            {
+                const uint32_t tokenType = memory.externalFormat;
+                const float downloadQuality =
+                    attachment.downloader[ attachment.active ].getInfo().quality;
+                const float quality = attachment.quality / downloadQuality;
+
+                compressor.setup( co::Global::getPluginRegistry(), tokenType,
+                                   quality, ignoreAlpha );
+            }
+            else
+                compressor.setup( co::Global::getPluginRegistry(),
+                                  memory.compressorName );
+
+            if( !compressor.isGood( ))
+            {
+                LBWARN << "No compressor found for token type 0x" << std::hex
+                       << memory.externalFormat << std::dec << std::endl;
+                compressor.clear();
+            }
+        }
+
+        data.compressedData.compressor = compressor.getInfo().name;
+        LBASSERT( data.compressedData.compressor != EQ_COMPRESSOR_AUTO );
+        LBASSERT( data.compressedData.compressor != EQ_COMPRESSOR_INVALID );
+        if( data.compressedData.compressor == EQ_COMPRESSOR_NONE )
+            return;
+
+        data.compressorFlags = EQ_COMPRESSOR_DATA_2D;
+        if( ignoreAlpha && memory.hasAlpha )
+        {
+            LBASSERT( &attachment == &color );
+            data.compressorFlags |= EQ_COMPRESSOR_IGNORE_ALPHA;
+        }
+
+        uint64_t inDims[4];
+        data.pvp.convertToPlugin( inDims );
+        compressor.compress( data.pixels, inDims, data.compressorFlags );
+        data.compressedData = compressor.getResult();
+    }
+
     EqCompressorInfos findTransferers( const eq::Frame::Buffer buffer,
                                        const GLEWContext* gl ) const
     {
@@ -257,6 +333,8 @@ void Image::reset()
 {
     _impl->ignoreAlpha = false;
     _impl->hasPremultipliedAlpha = false;
+    _impl->clearColor = Vector4f::ZERO;
+    _impl->clearDepth = 1.f;
     setPixelViewport( PixelViewport( ));
     setContext( RenderContext( ));
 }
@@ -527,6 +605,8 @@ bool Image::startReadback( const uint32_t buffers, const PixelViewport& pvp,
 
     _impl->pvp = pvp;
     _impl->context = context;
+    EQ_GL_CALL( glGetFloatv( GL_COLOR_CLEAR_VALUE, _impl->clearColor.array ));
+    EQ_GL_CALL( glGetFloatv( GL_DEPTH_CLEAR_VALUE, &_impl->clearDepth ));
     _impl->color.memory.state = Memory::INVALID;
     _impl->depth.memory.state = Memory::INVALID;
 
@@ -849,34 +929,8 @@ void Image::validatePixelData( const Frame::Buffer buffer )
 
 void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
 {
+    _setPixelFormat( buffer, pixels );
     Memory& memory = _impl->getMemory( buffer );
-    memory.externalFormat = pixels.externalFormat;
-    memory.internalFormat = pixels.internalFormat;
-    memory.pixelSize = pixels.pixelSize;
-    memory.pvp       = pixels.pvp;
-    memory.state     = Memory::INVALID;
-    memory.compressedData = pression::CompressorResult();
-    memory.hasAlpha = false;
-
-    const EqCompressorInfos& transferrers = _impl->findTransferers( buffer,
-                                                           0 /*GLEW context*/ );
-    if( transferrers.empty( ))
-        LBWARN << "No upload engines found for given pixel data" << std::endl;
-    else
-    {
-        memory.hasAlpha =
-            transferrers.front().capabilities & EQ_COMPRESSOR_IGNORE_ALPHA;
-#ifndef NDEBUG
-        for( EqCompressorInfosCIter i = transferrers.begin();
-             i != transferrers.end(); ++i )
-        {
-            LBASSERTINFO( memory.hasAlpha ==
-                          bool( i->capabilities & EQ_COMPRESSOR_IGNORE_ALPHA ),
-                          "Uploaders don't agree on alpha state of external " <<
-                          "format: " << transferrers.front() << " != " << *i );
-        }
-#endif
-    }
 
     const uint32_t size = getPixelDataSize( buffer );
     LBASSERT( size > 0 );
@@ -931,6 +985,57 @@ void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
                                          outDims, pixels.compressorFlags );
 }
 
+void Image::mapPixelData( const Frame::Buffer buffer, const PixelData& pixels )
+{
+    LBASSERT( pixels.compressedData.compressor <= EQ_COMPRESSOR_NONE );
+    LBASSERT( pixels.pixels );
+
+    _setPixelFormat( buffer, pixels );
+    Memory& memory = _impl->getMemory( buffer );
+    memory.pixels = pixels.pixels;
+    memory.state = Memory::VALID;
+}
+
+void Image::unmapPixelData( const Frame::Buffer buffer )
+{
+    Memory& memory = _impl->getMemory( buffer );
+    memory.pixels = 0;
+    memory.state = Memory::INVALID;
+}
+
+void Image::_setPixelFormat( const Frame::Buffer buffer,
+                             const PixelData& pixels )
+{
+    Memory& memory = _impl->getMemory( buffer );
+    memory.externalFormat = pixels.externalFormat;
+    memory.internalFormat = pixels.internalFormat;
+    memory.pixelSize = pixels.pixelSize;
+    memory.pvp       = pixels.pvp;
+    memory.state     = Memory::INVALID;
+    memory.compressedData = pression::CompressorResult();
+    memory.hasAlpha = false;
+
+    const EqCompressorInfos& transferrers = _impl->findTransferers( buffer,
+                                                           0 /*GLEW context*/ );
+    if( transferrers.empty( ))
+        LBWARN << "No upload engines found for given pixel data" << std::endl;
+    else
+    {
+        memory.hasAlpha =
+            transferrers.front().capabilities & EQ_COMPRESSOR_IGNORE_ALPHA;
+#ifndef NDEBUG
+        for( EqCompressorInfosCIter i = transferrers.begin();
+             i != transferrers.end(); ++i )
+        {
+            LBASSERTINFO( memory.hasAlpha ==
+                          bool( i->capabilities & EQ_COMPRESSOR_IGNORE_ALPHA ),
+                          "Uploaders don't agree on alpha state of external " <<
+                          "format: " << transferrers.front() << " != " << *i );
+        }
+#endif
+    }
+}
+
 /** Find and activate a compression engine */
 bool Image::allocCompressor( const Frame::Buffer buffer, const uint32_t name )
 {
@@ -1012,52 +1117,354 @@ const PixelData& Image::compressPixelData( const Frame::Buffer buffer )
         return memory;
     }
 
-    pression::Compressor& compressor = attachment.compressor[attachment.active];
+    _impl->compress( attachment, memory );
+    return memory;
+}
 
-    if( !compressor.isGood() ||
-        compressor.getInfo().tokenType != getExternalFormat( buffer ) ||
-        memory.compressorName == EQ_COMPRESSOR_AUTO )
+void Image::setClearValues( const Vector4f& color, const float depth )
+{
+    _impl->clearColor = color;
+    _impl->clearDepth = depth;
+}
+
+bool Image::getBackground( const Frame::Buffer buffer,
+                           std::vector< uint8_t >& pixel ) const
+{
+    const Memory& memory = _impl->getMemory( buffer );
+    const Vector4f& color = _impl->clearColor;
+    pixel.assign( memory.pixelSize, 0 );
+
+    switch( memory.externalFormat )
+    {
+    case EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT:
     {
-        if( memory.compressorName == EQ_COMPRESSOR_AUTO )
+        if( memory.pixelSize != sizeof( uint32_t ))
+            return false;
+        // as converted by glReadPixels
+        const float depth = std::min( std::max( _impl->clearDepth, 0.f ), 1.f );
+        const uint32_t value = uint32_t( double( depth ) * 4294967295. + .5 );
+        ::memcpy( pixel.data(), &value, sizeof( value ));
+        return true;
+    }
+
+    case EQ_COMPRESSOR_DATATYPE_RGBA:
+    case EQ_COMPRESSOR_DATATYPE_BGRA:
+    {
+        if( memory.pixelSize != 4 )
+            return false;
+        const bool bgra = memory.externalFormat == EQ_COMPRESSOR_DATATYPE_BGRA;
+        for( size_t i = 0; i < 4; ++i )
         {
-            const uint32_t tokenType = getExternalFormat( buffer );
-            const float downloadQuality =
-                attachment.downloader[ attachment.active ].getInfo().quality;
-            const float quality = attachment.quality / downloadQuality;
+            const float value = std::min( std::max( color[i], 0.f ), 1.f );
+            pixel[ bgra && i < 3 ? 2 - i : i ] = uint8_t( value * 255.f + .5f );
+        }
+        return true;
+    }
 
-            compressor.setup( co::Global::getPluginRegistry(), tokenType,
-                               quality, _impl->ignoreAlpha );
+    case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+    case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+    case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+    case EQ_COMPRESSOR_DATATYPE_BGRA32F:
+    {
+        Vector4f value = color;
+        if( memory.externalFormat == EQ_COMPRESSOR_DATATYPE_BGRA16F ||
+            memory.externalFormat == EQ_COMPRESSOR_DATATYPE_BGRA32F )
+        {
+            std::swap( value[0], value[2] );
+        }
+        if( memory.pixelSize == 4 * sizeof( float ))
+            ::memcpy( pixel.data(), value.array, memory.pixelSize );
+        else if( memory.pixelSize == 4 * sizeof( uint16_t ))
+        {
+            uint16_t* half = reinterpret_cast< uint16_t* >( pixel.data( ));
+            util::pixel::floatToHalf( value.array, half, 4 );
         }
         else
-            compressor.setup( co::Global::getPluginRegistry(),
-                              memory.compressorName );
+            return false;
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+float Image::findBlocks( const uint32_t blockSize )
+{
+    if( !_impl->pvp.hasArea( ))
+        return 1.f;
+
+    detail::BlockMask& mask = _impl->blockMask;
+    mask.reset( _impl->pvp, blockSize );
+
+    Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        if( !hasPixelData( buffer ))
+            continue;
+
+        Attachment& attachment = _impl->getAttachment( buffer );
+        if( !getBackground( buffer, attachment.background ))
+            _setBlockBackground( buffer, getPixelPointer( buffer ));
+        mask.addOccupied( attachment.memory, attachment.background.data( ));
+    }
+
+    return float( mask.getNumOccupied( )) / float( mask.getNumBlocks( ));
+}
+
+const void* Image::getBlockBackground( const Frame::Buffer buffer ) const
+{
+    return _impl->getAttachment( buffer ).background.data();
+}
+
+void Image::_setBlockBackground( const Frame::Buffer buffer,
+                                 const void* pixel )
+{
+    Attachment& attachment = _impl->getAttachment( buffer );
+    const uint8_t* data = static_cast< const uint8_t* >( pixel );
+    attachment.background.assign( data, data + attachment.memory.pixelSize );
+}
+
+const uint8_t* Image::getBlockMask() const
+{
+    return _impl->blockMask.getBits();
+}
+
+size_t Image::getBlockMaskSize() const
+{
+    return _impl->blockMask.getNumBytes();
+}
+
+const PixelData& Image::getBlockData( const Frame::Buffer buffer,
+                                      const bool compress )
+{
+    Attachment& attachment = _impl->getAttachment( buffer );
+    const Memory& memory = attachment.memory;
+    const detail::BlockMask& mask = _impl->blockMask;
+    LBASSERT( memory.state == Memory::VALID );
+    LBASSERT( memory.pvp.w == _impl->pvp.w && memory.pvp.h == _impl->pvp.h );
+
+    Memory& blocks = attachment.blocks;
+    blocks.internalFormat = memory.internalFormat;
+    blocks.externalFormat = memory.externalFormat;
+    blocks.pixelSize = memory.pixelSize;
+    blocks.pvp = mask.getPackedViewport();
+    blocks.hasAlpha = memory.hasAlpha;
+    blocks.compressorFlags = 0;
+    blocks.compressedData = pression::CompressorResult();
+    if( mask.getNumOccupied() == 0 )
+    {
+        blocks.pixels = 0;
+        return blocks;
+    }
+
+    blocks.useLocalBuffer();
+    blocks.state = Memory::VALID;
+    LBASSERT( attachment.background.size() == memory.pixelSize );
+    mask.pack( memory, attachment.background.data(), blocks.pixels );
+
+    if( compress && memory.compressorName != EQ_COMPRESSOR_NONE )
+        _impl->compress( attachment, blocks );
+    return blocks;
+}
 
-        if( !compressor.isGood( ))
+void Image::setBlockData( const Frame::Buffer buffer, const PixelData& blocks,
+                          const uint32_t blockSize, const uint8_t* bits,
+                          const void* background )
+{
+    const void* from = _setBlocks( buffer, blocks, blockSize, bits );
+    if( !background )
+        clearPixelData( buffer );
+    _impl->blockMask.unpack( from, background,
+                             _impl->getAttachment( buffer ).memory );
+}
+
+void Image::setBlockData( const Frame::Buffer buffer, const PixelData& blocks,
+                          const uint32_t blockSize, const uint8_t* bits,
+                          const Image& reference )
+{
+    const void* from = _setBlocks( buffer, blocks, blockSize, bits );
+    Memory& memory = _impl->getAttachment( buffer ).memory;
+    const PixelData& previous = reference._impl->getMemory( buffer );
+    if( !reference.hasPixelData( buffer ) ||
+        previous.pvp.w != memory.pvp.w || previous.pvp.h != memory.pvp.h ||
+        previous.externalFormat != memory.externalFormat ||
+        previous.pixelSize != memory.pixelSize )
+    {
+        LBWARN << "Reference image does not match delta frame" << std::endl;
+        clearPixelData( buffer );
+    }
+    else
+        ::memcpy( memory.pixels, previous.pixels, getPixelDataSize( buffer ));
+    _impl->blockMask.unpack( from, 0, memory );
+}
+
+float Image::findChangedBlocks( const Image& reference,
+                                const uint32_t blockSize )
+{
+    if( !_impl->pvp.hasArea( ))
+        return 1.f;
+
+    Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        if( !hasPixelData( buffer ))
+            continue;
+        if( !reference.hasPixelData( buffer ))
+            return 1.f;
+
+        const PixelData& pixels = getPixelData( buffer );
+        const PixelData& previous = reference.getPixelData( buffer );
+        if( previous.pvp.w != pixels.pvp.w || previous.pvp.h != pixels.pvp.h ||
+            previous.externalFormat != pixels.externalFormat ||
+            previous.pixelSize != pixels.pixelSize )
         {
-            LBWARN << "No compressor found for token type 0x" << std::hex
-                   << getExternalFormat( buffer ) << std::dec << std::endl;
-            compressor.clear();
+            return 1.f;
         }
     }
 
-    memory.compressedData.compressor = compressor.getInfo().name;
-    LBASSERT( memory.compressedData.compressor != EQ_COMPRESSOR_AUTO );
-    LBASSERT( memory.compressedData.compressor != EQ_COMPRESSOR_INVALID );
-    if( memory.compressedData.compressor == EQ_COMPRESSOR_NONE )
-        return memory;
+    detail::BlockMask& mask = _impl->blockMask;
+    mask.reset( _impl->pvp, blockSize );
+    for( size_t i = 0; i < 2; ++i )
+    {
+        if( !hasPixelData( buffers[i] ))
+            continue;
 
-    memory.compressorFlags = EQ_COMPRESSOR_DATA_2D;
-    if( _impl->ignoreAlpha && memory.hasAlpha )
+        // only pads the edge blocks, the receiver keeps unchanged blocks
+        _setBlockBackground( buffers[i], getPixelPointer( buffers[i] ));
+        mask.addChanged( getPixelData( buffers[i] ),
+                         reference.getPixelData( buffers[i] ));
+    }
+
+    return float( mask.getNumOccupied( )) / float( mask.getNumBlocks( ));
+}
+
+void Image::copyBlocks( const Frame::Buffer buffer, const Image& from )
+{
+    const Memory& source = from._impl->getAttachment( buffer ).memory;
+    Memory& memory = _impl->getAttachment( buffer ).memory;
+    LBASSERT( source.state == Memory::VALID );
+
+    if( memory.state != Memory::VALID ||
+        memory.pvp.w != source.pvp.w || memory.pvp.h != source.pvp.h ||
+        memory.externalFormat != source.externalFormat ||
+        memory.pixelSize != source.pixelSize )
     {
-        LBASSERT( buffer == Frame::BUFFER_COLOR );
-        memory.compressorFlags |= EQ_COMPRESSOR_IGNORE_ALPHA;
+        PixelData pixels; // raw pixels only, not the compressed cache
+        pixels.internalFormat = source.internalFormat;
+        pixels.externalFormat = source.externalFormat;
+        pixels.pixelSize = source.pixelSize;
+        pixels.pvp = source.pvp;
+        pixels.pixels = source.pixels;
+        if( _impl->pvp != from.getPixelViewport( ))
+            setPixelViewport( from.getPixelViewport( ));
+        setPixelData( buffer, pixels );
+        return;
     }
 
-    uint64_t inDims[4];
-    memory.pvp.convertToPlugin( inDims );
-    compressor.compress( memory.pixels, inDims, memory.compressorFlags );
-    memory.compressedData = compressor.getResult();
-    return memory;
+    from._impl->blockMask.copy( source, memory );
+}
+
+void Image::crop( const Image& from, const PixelViewport& region )
+{
+    const PixelViewport& pvp = from._impl->pvp;
+    LBASSERT( region.hasArea( ));
+    LBASSERT( region.x >= pvp.x && region.getXEnd() <= pvp.getXEnd( ));
+    LBASSERT( region.y >= pvp.y && region.getYEnd() <= pvp.getYEnd( ));
+    const size_t x = region.x - pvp.x;
+    const size_t y = region.y - pvp.y;
+
+    Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        if( !from.hasPixelData( buffer ))
+            continue;
+
+        const Memory& source = from._impl->getMemory( buffer );
+        Memory& memory = _impl->getMemory( buffer );
+        const size_t size = source.pixelSize;
+        const size_t width = source.pvp.w;
+        const size_t rowSize = region.w * size;
+        const uint8_t* in = static_cast< const uint8_t* >( source.pixels ) +
+                            ( y * width + x ) * size;
+        const PixelViewport cropped( source.pvp.x + int32_t( x ),
+                                     source.pvp.y + int32_t( y ),
+                                     region.w, region.h );
+        LBASSERT( source.pvp.w == pvp.w && source.pvp.h == pvp.h );
+
+        if( &memory != &source )
+        {
+            memory.internalFormat = source.internalFormat;
+            memory.externalFormat = source.externalFormat;
+            memory.pixelSize = source.pixelSize;
+            memory.compressorFlags = source.compressorFlags;
+            memory.hasAlpha = source.hasAlpha;
+            memory.pvp = cropped;
+            memory.useLocalBuffer();
+        }
+        else
+            memory.pvp = cropped;
+
+        // rows move to lower addresses when cropping in place
+        uint8_t* out = static_cast< uint8_t* >( memory.pixels );
+        for( int32_t j = 0; j < region.h; ++j )
+            ::memmove( out + j * rowSize, in + j * width * size, rowSize );
+
+        memory.state = Memory::VALID;
+        memory.compressedData = pression::CompressorResult();
+    }
+    _impl->pvp = region;
+    _impl->clearColor = from._impl->clearColor;
+    _impl->clearDepth = from._impl->clearDepth;
+}
+
+const void* Image::_setBlocks( const Frame::Buffer buffer,
+                               const PixelData& blocks,
+                               const uint32_t blockSize, const uint8_t* bits )
+{
+    detail::BlockMask& mask = _impl->blockMask;
+    mask.reset( _impl->pvp, blockSize );
+    mask.setBits( bits );
+
+    Attachment& attachment = _impl->getAttachment( buffer );
+    Memory& memory = attachment.memory;
+    if( mask.getNumOccupied() == 0 )
+    {
+        PixelData empty;
+        empty.internalFormat = blocks.internalFormat;
+        empty.externalFormat = blocks.externalFormat;
+        empty.pixelSize = blocks.pixelSize;
+        empty.pvp = _impl->pvp;
+        setPixelData( buffer, empty ); // allocates memory
+        return 0;
+    }
+
+    // set up the formats, decompressing the packed blocks into the memory
+    LBASSERT( blocks.pvp == mask.getPackedViewport( ));
+    setPixelData( buffer, blocks );
+    LBASSERTINFO( memory.pixelSize == blocks.pixelSize,
+                  "Decompressor changed pixel size of block-sparse image" );
+
+    const void* from = blocks.pixels;
+    if( blocks.compressedData.compressor > EQ_COMPRESSOR_NONE )
+    {
+        // keep the decompressed blocks aside
+        Memory& packed = attachment.blocks;
+        packed.internalFormat = memory.internalFormat;
+        packed.externalFormat = memory.externalFormat;
+        packed.pixelSize = memory.pixelSize;
+        packed.pvp = memory.pvp;
+        packed.useLocalBuffer();
+        ::memcpy( packed.pixels, memory.pixels, getPixelDataSize( buffer ));
+        from = packed.pixels;
+    }
+
+    memory.pvp = _impl->pvp;
+    validatePixelData( buffer );
+    return from;
 }
 
 
@@ -1130,82 +1537,125 @@ struct RGBHeader
 #endif
 ;
 
-void put32f( std::ostream& os, const char* ptr )
+/** Pixels converted per chunk, the planes are written in chunks of this. */
+const size_t _chunkPixels = 1024 * 1024;
+
+/** The conversion applied to each plane before writing it. */
+enum Conversion
 {
-    // cppcheck-suppress invalidPointerCast
-    const float& value = *reinterpret_cast< const float* >( ptr );
-    const uint8_t byte = uint8_t( value * 255.f );
-    os.write( (const char*)&byte, 1 );
-}
-void put16f( std::ostream& os, const char* ptr )
+    CONVERT_NONE,
+    CONVERT_UNPREMULTIPLY, //!< divide 8 bit color planes by the alpha plane
+    CONVERT_HALF, //!< half float to 8 bit
+    CONVERT_FLOAT //!< float to 8 bit
+};
+
+#ifdef EQUALIZER_USE_OPENSCENEGRAPH
+void _unpremultiply( const char* in, char* out, const size_t nPixels )
 {
-    const uint16_t& value = *reinterpret_cast< const uint16_t* >(ptr);
-    const float f = half_to_float( value );
-    put32f( os, (const char*)&f );
-}
+    std::vector< uint8_t > planes( nPixels * 4 );
+    void* channels[] = { &planes[0], &planes[ nPixels ],
+                         &planes[ nPixels * 2 ], &planes[ nPixels * 3 ] };
+    util::pixel::deinterleave( in, nPixels, 4, 1, channels );
+    for( size_t i = 0; i < 3; ++i )
+        util::pixel::unpremultiply( &planes[ nPixels * i ],
+                                    &planes[ nPixels * 3 ], nPixels );
+    util::pixel::interleave( channels, nPixels, 4, 1, out );
 }
+#endif
 
-bool Image::writeImage( const std::string& filename,
-                        const Frame::Buffer buffer ) const
+/**
+ * Write the header and the given channels as planes. The pixels are split into
+ * planes and converted in chunks, each plane chunk is written in one call.
+ */
+bool _writePlanes( const std::string& filename, const RGBHeader& header,
+                   const char* data, const size_t nPixels,
+                   const size_t* channels, const size_t nChannels,
+                   const size_t bpc, const Conversion conversion )
 {
-    const Memory& memory = _impl->getMemory( buffer );
-
-    const PixelViewport& pvp = memory.pvp;
-    const size_t nPixels = pvp.w * pvp.h;
-
-    if( nPixels == 0 || memory.state != Memory::VALID )
+    std::ofstream image( filename.c_str(), std::ios::out | std::ios::binary );
+    if( !image.is_open( ))
+    {
+        LBERROR << "Can't open " << filename << " for writing" << std::endl;
         return false;
+    }
 
-    const unsigned char* data =
-         reinterpret_cast<const unsigned char*>( getPixelPointer( buffer ));
-
-    unsigned char* convertedData = nullptr;
-
-    // glReadPixels with alpha has ARGB premultiplied format: post-divide alpha
-    if( _impl->hasPremultipliedAlpha &&
-        getExternalFormat( buffer ) == EQ_COMPRESSOR_DATATYPE_BGRA )
+    RGBHeader bigEndian = header;
+    bigEndian.convert();
+    image.write( reinterpret_cast< const char* >( &bigEndian ),
+                 sizeof( bigEndian ));
+
+    const size_t chunkPixels = LB_MIN( nPixels, _chunkPixels );
+    const size_t planeSize = chunkPixels * bpc;
+    const size_t outBpc = header.bytesPerChannel;
+    std::vector< char > chunk( planeSize * nChannels );
+    std::vector< uint8_t > converted( outBpc == bpc ? 0 : chunkPixels );
+
+    // channel i of the input is plane j of the file if channels[j] == i
+    void* planes[ 4 ];
+    for( size_t i = 0; i < nChannels; ++i )
+        planes[ channels[i] ] = &chunk[ i * planeSize ];
+    const uint8_t* alpha = nChannels == 4 ?
+        reinterpret_cast< const uint8_t* >( &chunk[ 3 * planeSize ]) : 0;
+
+    for( size_t j = 0; j < nPixels; j += _chunkPixels )
     {
-        convertedData = new unsigned char[nPixels*4];
+        const size_t n = LB_MIN( nPixels - j, _chunkPixels );
+        util::pixel::deinterleave( data + j * nChannels * bpc, n, nChannels,
+                                   bpc, planes );
 
-        const uint32_t* bgraData = reinterpret_cast< const uint32_t* >( data );
-        uint32_t* bgraConverted = reinterpret_cast< uint32_t* >( convertedData);
-        for( size_t i = 0; i < nPixels; ++i, ++bgraConverted, ++bgraData )
+        for( size_t i = 0; i < nChannels; ++i )
         {
-            *bgraConverted = *bgraData;
-            uint32_t& pixel = *bgraConverted;
-            const uint32_t alpha = pixel >> 24;
-            if( alpha != 0 )
+            const char* plane = &chunk[ i * planeSize ];
+            switch( conversion )
             {
-                const uint32_t red = (pixel >> 16) & 0xff;
-                const uint32_t green = (pixel >> 8) & 0xff;
-                const uint32_t blue = pixel & 0xff;
-                *bgraConverted = (( alpha << 24 ) |
-                                 (((255 * red) / alpha ) << 16 ) |
-                                 (((255 * green) / alpha )  << 8 ) |
-                                 ((255 * blue) / alpha ));
+            case CONVERT_NONE:
+                break;
+            case CONVERT_UNPREMULTIPLY:
+                if( i < 3 )
+                    util::pixel::unpremultiply(
+                        reinterpret_cast< uint8_t* >( &chunk[ i * planeSize ]),
+                        alpha, n );
+                break;
+            case CONVERT_HALF:
+                util::pixel::halfToUnorm8(
+                    reinterpret_cast< const uint16_t* >( plane ),
+                    converted.data(), n );
+                plane = reinterpret_cast< const char* >( converted.data( ));
+                break;
+            case CONVERT_FLOAT:
+                util::pixel::floatToUnorm8(
+                    reinterpret_cast< const float* >( plane ),
+                    converted.data(), n );
+                plane = reinterpret_cast< const char* >( converted.data( ));
+                break;
             }
+
+            image.seekp( sizeof( RGBHeader ) + ( i * nPixels + j ) * outBpc );
+            image.write( plane, n * outBpc );
         }
     }
 
-    const bool retVal = _writeImage( filename, buffer,
-                                     convertedData ? convertedData : data );
-    delete [] convertedData;
-    return retVal;
+    image.close();
+    if( image.fail( ))
+    {
+        LBERROR << "Error writing " << filename << std::endl;
+        return false;
+    }
+    return true;
 }
 
-bool Image::_writeImage( const std::string& filename,
-                         const Frame::Buffer buffer,
-                         const unsigned char* data_ ) const
+bool _writeImage( const std::string& filename, const PixelData& pixels,
+                  const bool premultipliedAlpha )
 {
-    const Memory& memory = _impl->getMemory( buffer );
-    const PixelViewport& pvp = memory.pvp;
+    const PixelViewport& pvp = pixels.pvp;
     const size_t nPixels = pvp.w * pvp.h;
+    const uint32_t externalFormat = pixels.externalFormat;
 
     RGBHeader header;
     header.width  = pvp.w;
     header.height = pvp.h;
 
-    switch( getExternalFormat( buffer ))
+    switch( externalFormat )
     {
         case EQ_COMPRESSOR_DATATYPE_RGB10_A2:
             header.maxValue = 1023;
@@ -1261,7 +1711,7 @@ bool Image::_writeImage( const std::string& filename,
 
     // Swap red & blue where needed
     bool swapRB = false;
-    switch( getExternalFormat( buffer ))
+    switch( externalFormat )
     {
         case EQ_COMPRESSOR_DATATYPE_RGB10_A2:
         case EQ_COMPRESSOR_DATATYPE_RGBA:
@@ -1276,75 +1726,48 @@ bool Image::_writeImage( const std::string& filename,
 
     const uint8_t bpc = header.bytesPerChannel;
     const uint16_t nChannels = header.depth;
-    const size_t depth = nChannels * bpc;
+    const char* data = reinterpret_cast< const char* >( pixels.pixels );
 
     const boost::filesystem::path path( filename );
 #ifdef EQUALIZER_USE_OPENSCENEGRAPH
     if( path.extension() != ".rgb" )
     {
+        std::vector< char > converted;
+        if( premultipliedAlpha &&
+            externalFormat == EQ_COMPRESSOR_DATATYPE_BGRA )
+        {
+            converted.resize( nPixels * 4 );
+            _unpremultiply( data, converted.data(), nPixels );
+            data = converted.data();
+        }
+
         osg::ref_ptr<osg::Image> osgImage = new osg::Image();
-        osgImage->setImage( pvp.w, pvp.h, depth, getExternalFormat( buffer ),
+        osgImage->setImage( pvp.w, pvp.h, nChannels * bpc, externalFormat,
                             swapRB ? GL_RGBA : GL_BGRA, GL_UNSIGNED_BYTE,
-                            const_cast< unsigned char* >( data_ ),
+                            reinterpret_cast< unsigned char* >(
+                                const_cast< char* >( data )),
                             osg::Image::NO_DELETE );
         return osgDB::writeImageFile( *osgImage, filename );
     }
 #endif
 
-    std::ofstream image( filename.c_str(), std::ios::out | std::ios::binary );
-    if( !image.is_open( ))
-    {
-        LBERROR << "Can't open " << filename << " for writing" << std::endl;
-        return false;
-    }
-
-    const size_t nBytes = nPixels * depth;
     if( header.bytesPerChannel > 2 )
         LBWARN << static_cast< int >( header.bytesPerChannel )
                << " bytes per channel not supported by RGB spec" << std::endl;
 
     strncpy( header.filename, filename.c_str(), 80 );
-    header.convert();
-    image.write( reinterpret_cast<const char *>( &header ), sizeof( header ));
-    header.convert();
-
-    const char* data = reinterpret_cast< const char* >( data_ );
-
-    // Each channel is saved separately
-    if( nChannels == 3 || nChannels == 4 )
-    {
-        // channel one is R or B
-        if ( swapRB )
-            for( size_t j = 0 * bpc; j < nBytes; j += depth )
-                image.write( &data[j], bpc );
-        else
-            for( size_t j = 2 * bpc; j < nBytes; j += depth )
-                image.write( &data[j], bpc );
 
-        // channel two is G
-        for( size_t j = 1 * bpc; j < nBytes; j += depth )
-            image.write( &data[j], bpc );
+    // Each channel is saved separately: R or B, G, B or R, Alpha
+    const size_t channels[] = { swapRB ? 0u : 2u, 1, swapRB ? 2u : 0u, 3 };
 
-        // channel three is B or G
-        if ( swapRB )
-            for( size_t j = 2 * bpc; j < nBytes; j += depth )
-                image.write( &data[j], bpc );
-        else
-            for( size_t j = 0; j < nBytes; j += depth )
-                image.write( &data[j], bpc );
-
-        // channel four is Alpha
-        if( nChannels == 4 )
-            for( size_t j = 3 * bpc; j < nBytes; j += depth )
-                image.write( &data[j], bpc );
-    }
-    else
+    // glReadPixels with alpha has ARGB premultiplied format: post-divide alpha
+    const bool divide = premultipliedAlpha &&
+                        externalFormat == EQ_COMPRESSOR_DATATYPE_BGRA;
+    if( !_writePlanes( filename, header, data, nPixels, channels, nChannels,
+                       bpc, divide ? CONVERT_UNPREMULTIPLY : CONVERT_NONE ))
     {
-        for( size_t i = 0; i < nChannels; i += bpc )
-           for( size_t j = i * bpc; j < nBytes; j += depth )
-              image.write(&data[j], bpc );
+        return false;
     }
-    image.close();
 
     if( header.bytesPerChannel == 1 )
         return true;
@@ -1356,58 +1779,37 @@ bool Image::_writeImage( const std::string& filename,
 #else
                                       path.filename();
 #endif
-    image.open( smallFilename.c_str(), std::ios::out | std::ios::binary );
-    if( !image.is_open( ))
-    {
-        LBERROR << "Can't open " << smallFilename << " for writing" <<std::endl;
-        return false;
-    }
 
     header.bytesPerChannel = 1;
     header.maxValue = 255;
-    header.convert();
-    image.write( reinterpret_cast<const char *>( &header ), sizeof( header ));
-    header.convert();
 
     LBASSERTINFO( bpc == 2 || bpc == 4, bpc );
-    const bool twoBPC = bpc == 2;
-
-    if( nChannels == 3 || nChannels == 4 )
-    {
-        // channel one is R or B
-        if ( swapRB )
-            for( size_t j = 0 * bpc; j < nBytes; j += depth )
-                twoBPC ? put16f( image, &data[j] ) : put32f( image, &data[j] );
-        else
-            for( size_t j = 2 * bpc; j < nBytes; j += depth )
-                twoBPC ? put16f( image, &data[j] ) : put32f( image, &data[j] );
-
-        // channel two is G
-        for( size_t j = 1 * bpc; j < nBytes; j += depth )
-                twoBPC ? put16f( image, &data[j] ) : put32f( image, &data[j] );
+    return _writePlanes( smallFilename, header, data, nPixels, channels,
+                         nChannels, bpc,
+                         bpc == 2 ? CONVERT_HALF : CONVERT_FLOAT );
+}
+}
 
-        // channel three is B or G
-        if ( swapRB )
-            for( size_t j = 2 * bpc; j < nBytes; j += depth )
-                twoBPC ? put16f( image, &data[j] ) : put32f( image, &data[j] );
-        else
-            for( size_t j = 0; j < nBytes; j += depth )
-                twoBPC ? put16f( image, &data[j] ) : put32f( image, &data[j] );
+bool Image::writeImage( const std::string& filename,
+                        const Frame::Buffer buffer ) const
+{
+    const Memory& memory = _impl->getMemory( buffer );
+    if( memory.state != Memory::VALID )
+        return false;
+    return writeImage( filename, memory, _impl->hasPremultipliedAlpha );
+}
 
-         // channel four is Alpha
-        if( nChannels == 4 )
-            for( size_t j = 3 * bpc; j < nBytes; j += depth )
-                twoBPC ? put16f( image, &data[j] ) : put32f( image, &data[j] );
-    }
-    else
-    {
-        for( size_t i = 0; i < nChannels; i += bpc )
-           for( size_t j = i * bpc; j < nBytes; j += depth )
-               twoBPC ? put16f( image, &data[j] ) : put32f( image, &data[j] );
-    }
-    image.close();
+bool Image::writeImage( const std::string& filename, const PixelData& data,
+                        const bool premultipliedAlpha )
+{
+    if( !data.pixels || !data.pvp.hasArea( ))
+        return false;
+    return _writeImage( filename, data, premultipliedAlpha );
+}
 
-    return true;
+bool Image::hasPremultipliedAlpha() const
+{
+    return _impl->hasPremultipliedAlpha;
 }
 
 bool Image::readImage( const std::string& filename, const Frame::Buffer buffer )
@@ -1471,7 +1873,6 @@ bool Image::readImage( const std::string& filename, const Frame::Buffer buffer )
     }
 
     const uint8_t bpc = header.bytesPerChannel;
-    const size_t depth = nChannels * bpc;
     const size_t nPixels = header.width * header.height;
     const size_t nComponents = nPixels * nChannels;
     const size_t nBytes = nComponents * bpc;
@@ -1594,46 +1995,10 @@ bool Image::readImage( const std::string& filename, const Frame::Buffer buffer )
     LBASSERTINFO( nBytes <= getPixelDataSize( buffer ),
                   nBytes << " > " << getPixelDataSize( buffer ));
     // Each channel is saved separately
-    switch( bpc )
-    {
-    case 1:
-        for( size_t i = 0; i < nChannels; ++i )
-            for( size_t j = i; j < nComponents; j += nChannels )
-            {
-                data[j] = *addr;
-                ++addr;
-            }
-        break;
-
-    case 2:
-        for( size_t i = 0; i < nChannels; ++i )
-            for( size_t j = i; j < nComponents; j += nChannels )
-            {
-                reinterpret_cast< uint16_t* >( data )[ j ] =
-                    *reinterpret_cast< const uint16_t* >( addr );
-                addr += bpc;
-            }
-        break;
-
-    case 4:
-        for( size_t i = 0; i < nChannels; ++i )
-            for( size_t j = i; j < nComponents; j += nChannels )
-            {
-                reinterpret_cast< uint32_t* >( data )[ j ] =
-                    *reinterpret_cast< const uint32_t* >( addr );
-                addr += bpc;
-            }
-        break;
-
-    default:
-        for( size_t i = 0; i < depth; i += bpc )
-            for( size_t j = i * bpc; j < nBytes; j += depth )
-            {
-                memcpy( &data[j], addr, bpc );
-                addr += bpc;
-            }
-        break;
-    }
+    const void* planes[ 4 ];
+    for( size_t i = 0; i < nChannels; ++i )
+        planes[i] = addr + i * nPixels * bpc;
+    util::pixel::interleave( planes, nPixels, nChannels, bpc, data );
     return true;
 }
 
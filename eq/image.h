@@ -380,6 +380,126 @@ public:
 
     /** @internal */
     EQ_API uint32_t getDownloaderName( const Frame::Buffer buffer ) const;
+
+    /** @internal @return true if the color pixels have premultiplied alpha. */
+    EQ_API bool hasPremultipliedAlpha() const;
+
+    /**
+     * @internal Write uncompressed pixel data as image file.
+     *
+     * Used to write pixel data copied from an image, e.g., from another thread.
+     * @sa writeImage( const std::string&, const Frame::Buffer )
+     */
+    EQ_API static bool writeImage( const std::string& filename,
+                                   const PixelData& data,
+                                   bool premultipliedAlpha );
+
+    /**
+     * @internal Set the values the frame buffer was cleared with.
+     *
+     * Set by startReadback() from the current GL clear color and depth.
+     */
+    EQ_API void setClearValues( const Vector4f& color, float depth );
+
+    /**
+     * @internal Get the pixel of a cleared area of the memory pixel data.
+     *
+     * The background is the clear color for the color buffer and the clear
+     * depth for the depth buffer, converted to the external format.
+     * @return false if the external format has no known conversion.
+     */
+    EQ_API bool getBackground( Frame::Buffer buffer,
+                               std::vector< uint8_t >& pixel ) const;
+
+    /**
+     * @internal Find the blocks of the memory pixel data which differ from the
+     * background in any buffer.
+     *
+     * The background is given by getBackground(), or is the first pixel of
+     * buffers with an unknown format. Used to transmit only the occupied
+     * blocks of sparse images.
+     * @return the fraction of occupied blocks.
+     */
+    EQ_API float findBlocks( uint32_t blockSize );
+
+    /**
+     * @internal @return the pixel filling the empty blocks of the buffer, as
+     *           used by the last findBlocks().
+     */
+    EQ_API const void* getBlockBackground( Frame::Buffer buffer ) const;
+
+    /** @internal @return the occupancy bit mask set by findBlocks(). */
+    EQ_API const uint8_t* getBlockMask() const;
+
+    /** @internal @return the size of the occupancy bit mask in bytes. */
+    EQ_API size_t getBlockMaskSize() const;
+
+    /**
+     * @internal @return the occupied blocks found by findBlocks() as a column
+     *           of blocks, compressed if requested.
+     */
+    EQ_API const PixelData& getBlockData( Frame::Buffer buffer,
+                                          bool compress );
+
+    /**
+     * @internal Set the pixel data from the occupied blocks of a block-sparse
+     * image, filling all other blocks with the background pixel, or clearing
+     * them if no background is given.
+     *
+     * The pixel viewport of the image has to be set before.
+     */
+    EQ_API void setBlockData( Frame::Buffer buffer, const PixelData& blocks,
+                              uint32_t blockSize, const uint8_t* mask,
+                              const void* background );
+
+    /**
+     * @internal Find the blocks of the given size which differ from the
+     * reference image in any buffer.
+     *
+     * Used to transmit only the changed blocks of a frame. The mask is
+     * accessed and packed like the one of findBlocks().
+     * @return the fraction of changed blocks, or 1 if the reference has a
+     *         different size or pixel format.
+     */
+    EQ_API float findChangedBlocks( const Image& reference,
+                                    uint32_t blockSize );
+
+    /**
+     * @internal Set the pixel data from the changed blocks of a delta frame,
+     * taking all other blocks from the reference image.
+     *
+     * The pixel viewport of the image has to be set before.
+     */
+    EQ_API void setBlockData( Frame::Buffer buffer, const PixelData& blocks,
+                              uint32_t blockSize, const uint8_t* mask,
+                              const Image& reference );
+
+    /**
+     * @internal Update this image with the blocks of the given image marked
+     * by its block mask, or copy all pixels if the formats differ.
+     */
+    EQ_API void copyBlocks( Frame::Buffer buffer, const Image& from );
+
+    /**
+     * @internal Set the pixel viewport and the memory pixel data of this image
+     * to a region of the given image, which may be this image.
+     *
+     * Used to transmit only the regions of interest of a read back image.
+     * @param from the image with memory pixel data.
+     * @param region the area to keep, within the pixel viewport of from.
+     */
+    EQ_API void crop( const Image& from, const PixelViewport& region );
+
+    /**
+     * @internal Use uncompressed pixel data in place as the memory pixel data
+     * of the given buffer, without copying it.
+     *
+     * The pixels have to stay valid until unmapPixelData() is called.
+     */
+    EQ_API void mapPixelData( Frame::Buffer buffer, const PixelData& data );
+
+    /** @internal Invalidate the pixel data set by mapPixelData(). */
+    EQ_API void unmapPixelData( Frame::Buffer buffer );
     //@}
 
 private:
@@ -408,6 +528,9 @@ private:
                              const uint32_t pixelSize,
                              const bool hasAlpha );
 
+    /** Set the format of the memory pixel data, invalidating it. */
+    void _setPixelFormat( Frame::Buffer buffer, const PixelData& pixels );
+
     bool _readback( const Frame::Buffer buffer, const Zoom& zoom,
                     util::ObjectManager& glObjects );
 
@@ -416,8 +539,13 @@ private:
 
     void _finishReadback( const Frame::Buffer buffer, const GLEWContext* );
     bool _readbackZoom( const Frame::Buffer buffer, util::ObjectManager& om );
-    bool _writeImage( const std::string& filename, const Frame::Buffer buffer,
-                      const unsigned char* data ) const;
+
+    /** Set the padding pixel of the block data to the given pixel. */
+    void _setBlockBackground( Frame::Buffer buffer, const void* pixel );
+
+    /** Set up the full pixel data from block data, @return the blocks. */
+    const void* _setBlocks( Frame::Buffer buffer, const PixelData& blocks,
+                            uint32_t blockSize, const uint8_t* mask );
 };
 };
 #endif // EQ_IMAGE_H
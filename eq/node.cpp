@@ -20,6 +20,7 @@
 #include "node.h"
 
 #include "client.h"
+#include "commandQueue.h"
 #include "config.h"
 #include "error.h"
 #include "exception.h"
@@ -30,6 +31,10 @@
 #include "nodeStatistics.h"
 #include "pipe.h"
 #include "server.h"
+#include "detail/frameCapture.h"
+#include "detail/queueStatistics.h"
+#include "detail/referenceImage.h"
+#include "detail/sharedImageRing.h"
 
 #include <eq/fabric/commands.h>
 #include <eq/fabric/elementVisitor.h>
@@ -40,7 +45,11 @@
 #include <co/connection.h>
 #include <co/global.h>
 #include <co/objectICommand.h>
+#include <co/objectOCommand.h>
 #include <lunchbox/scopedMutex.h>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <thread>
 
 namespace eq
 {
@@ -50,6 +59,21 @@ typedef stde::hash_map< uint128_t, co::Barrier* > BarrierHash;
 typedef stde::hash_map< uint128_t, FrameDataPtr > FrameDataHash;
 typedef FrameDataHash::const_iterator FrameDataHashCIter;
 typedef FrameDataHash::iterator FrameDataHashIter;
+typedef stde::hash_map< co::NodeID, detail::SharedImageRing* > ImageRingHash;
+typedef ImageRingHash::const_iterator ImageRingHashCIter;
+enum ImageRingPeer
+{
+    IMAGE_RING_PENDING, //!< asked to map the ring, no reply yet
+    IMAGE_RING_MAPPED,
+    IMAGE_RING_FAILED
+};
+typedef stde::hash_map< co::NodeID, ImageRingPeer > ImageRingPeerHash;
+typedef stde::hash_map< uint128_t, detail::ReferenceImage* > ReferenceImageHash;
+typedef ReferenceImageHash::iterator ReferenceImageHashIter;
+typedef stde::hash_map< uint128_t, uint32_t > KeyframeRequestHash;
+
+/** Virtual size, pages are only committed when used. */
+const uint64_t _sharedImageRingSize = uint64_t( 256 ) << 20;
 
 enum State
 {
@@ -59,28 +83,93 @@ enum State
     STATE_RUNNING,
     STATE_FAILED
 };
+
+bool _hasQueueStatistics( const Node* node )
+{
+    const Pipes& pipes = node->getPipes();
+    for( PipesCIter i = pipes.begin(); i != pipes.end(); ++i )
+        if( (*i)->getIAttribute( Pipe::IATTR_HINT_STATISTICS ) == ON )
+            return true;
+    return false;
+}
+
+// The node main thread queue is the eq::Client command queue
+CommandQueue* _getMainThreadQueue( Node* node )
+{
+    return static_cast< CommandQueue* >( node->getMainThreadQueue( ));
+}
+
+void _setupQueueStatistics( Node* node )
+{
+    if( _hasQueueStatistics( node ))
+        _getMainThreadQueue( node )->enableStatistics();
+}
+
+void _emitQueueStatistics( Node* node, const uint32_t frameNumber )
+{
+    detail::QueueStatistics* statistics =
+        _getMainThreadQueue( node )->getStatistics();
+    if( !statistics )
+        return;
+
+    detail::CommandTimesMap times;
+    size_t maxDepth = 0;
+    statistics->swap( times, maxDepth );
+
+    for( detail::CommandTimesMap::const_iterator i = times.begin();
+         i != times.end(); ++i )
+    {
+        NodeStatistics latency( Statistic::PIPE_COMMAND_LATENCY, node,
+                                frameNumber );
+        detail::QueueStatistics::fill( latency.event.data.statistic, i->first,
+                                       i->second.latency, maxDepth, "main" );
+
+        if( i->second.handling.getCount() == 0 )
+            continue;
+        NodeStatistics handle( Statistic::PIPE_COMMAND_HANDLE, node,
+                               frameNumber );
+        detail::QueueStatistics::fill( handle.event.data.statistic, i->first,
+                                       i->second.handling, maxDepth, "main" );
+    }
+}
 }
 
 namespace detail
 {
+/** Image compression and transmission thread, all share the node queue. */
 class TransmitThread : public lunchbox::Thread
 {
 public:
-    TransmitThread()
-        : _queue( co::Global::getCommandQueueLimit( ))
+    TransmitThread( co::CommandQueue& queue, const uint32_t index )
+        : _queue( queue )
+        , _index( index )
+        , _affinity( lunchbox::Thread::NONE )
     {}
     virtual ~TransmitThread() {}
 
-    co::CommandQueue& getQueue() { return _queue; }
+    /** Set the affinity applied when the thread is started. */
+    void setInitialAffinity( const int32_t affinity ) { _affinity = affinity; }
 
 protected:
-    bool init() override { setName( "Xmit" ); return true; }
+    bool init() override
+    {
+        setName( std::string( "Xmit" ) +
+                 boost::lexical_cast< std::string >( _index ));
+        if( _affinity != lunchbox::Thread::NONE )
+            lunchbox::Thread::setAffinity( _affinity );
+        return true;
+    }
+
     void run() override;
 
 private:
-    co::CommandQueue _queue;
+    co::CommandQueue& _queue;
+    const uint32_t _index;
+    int32_t _affinity;
 };
 
+typedef std::vector< TransmitThread* > TransmitThreads;
+
 class Node
 {
 public:
@@ -88,8 +177,69 @@ public:
         : state( STATE_STOPPED )
         , finishedFrame( 0 )
         , unlockedFrame( 0 )
+        , transmitQueue( co::Global::getCommandQueueLimit( ))
+        , imageRing( 0 )
+        , imageRingFailed( false )
+        , frameCapture( 0 )
     {}
 
+    ~Node()
+    {
+        for( TransmitThreads::const_iterator i = transmitters->begin();
+             i != transmitters->end(); ++i )
+        {
+            delete *i;
+        }
+        for( ImageRingHashCIter i = imageRings.begin();
+             i != imageRings.end(); ++i )
+        {
+            delete i->second;
+        }
+        for( ReferenceImageHashIter i = referenceImages.begin();
+             i != referenceImages.end(); ++i )
+        {
+            delete i->second;
+        }
+        delete imageRing;
+        delete frameCapture;
+    }
+
+    /** @return the active frame capture, or 0. */
+    FrameCapture* getFrameCapture()
+    {
+        lunchbox::ScopedMutex<> mutex( frameCaptureLock );
+        return frameCapture && frameCapture->isGood() ? frameCapture : 0;
+    }
+
+    /**
+     * @return the last frame received on the given delta stream, or 0 if the
+     *         image is not delta encoded. Command thread only.
+     */
+    ReferenceImage* getReferenceImage( const uint128_t& stream,
+                                       const uint32_t frameNumber )
+    {
+        ReferenceImageHashIter i = referenceImages.begin();
+        while( i != referenceImages.end( ))
+        {
+            if( i->second->isObsolete( frameNumber ))
+            {
+                delete i->second;
+                referenceImages.erase( i++ );
+            }
+            else
+                ++i;
+        }
+
+        if( stream == 0 )
+            return 0;
+
+        ReferenceImage*& reference = referenceImages[ stream ];
+        if( !reference )
+            reference = new ReferenceImage( stream );
+        reference->lastFrame = frameNumber;
+        return reference;
+    }
+
     /** The configInit/configExit state. */
     lunchbox::Monitor< State > state;
 
@@ -108,7 +258,35 @@ public:
     /** All frame datas used by the node during rendering. */
     lunchbox::Lockable< FrameDataHash > frameDatas;
 
-    TransmitThread transmitter;
+    /**
+     * The queue of the image transmit threads. Outlives the threads, since
+     * channels register their commands on it when they are attached.
+     */
+    co::CommandQueue transmitQueue;
+
+    /** The image transmit threads, all pop from the transmit queue. */
+    lunchbox::Lockable< TransmitThreads, lunchbox::SpinLock > transmitters;
+
+    /** The images sent to nodes on the same host, created on first use. */
+    SharedImageRing* imageRing;
+    bool imageRingFailed;
+    lunchbox::Lock imageRingLock;
+
+    /** The receivers asked to map the image ring, and their answer. */
+    ImageRingPeerHash imageRingPeers;
+
+    /** The rings of the nodes sending images, command thread only. */
+    ImageRingHash imageRings;
+
+    /** The references of the received delta streams, command thread only. */
+    ReferenceImageHash referenceImages;
+
+    /** The last undecodable frame of the sent delta streams, per stream. */
+    lunchbox::Lockable< KeyframeRequestHash > keyframeRequests;
+
+    /** The capture of the received images, created on first use. */
+    FrameCapture* frameCapture;
+    lunchbox::Lock frameCaptureLock;
 };
 
 }
@@ -136,7 +314,6 @@ void Node::attach( const uint128_t& id, const uint32_t instanceID )
 
     co::CommandQueue* queue = getMainThreadQueue();
     co::CommandQueue* commandQ = getCommandThreadQueue();
-    co::CommandQueue* transmitQ = getTransmitterQueue();
 
     registerCommand( fabric::CMD_NODE_CREATE_PIPE,
                      NodeFunc( this, &Node::_cmdCreatePipe ), queue );
@@ -144,8 +321,6 @@ void Node::attach( const uint128_t& id, const uint32_t instanceID )
                      NodeFunc( this, &Node::_cmdDestroyPipe ), queue );
     registerCommand( fabric::CMD_NODE_CONFIG_INIT,
                      NodeFunc( this, &Node::_cmdConfigInit ), queue );
-    registerCommand( fabric::CMD_NODE_SET_AFFINITY,
-                     NodeFunc( this, &Node::_cmdSetAffinity), transmitQ );
     registerCommand( fabric::CMD_NODE_CONFIG_EXIT,
                      NodeFunc( this, &Node::_cmdConfigExit ), queue );
     registerCommand( fabric::CMD_NODE_FRAME_START,
@@ -160,6 +335,16 @@ void Node::attach( const uint128_t& id, const uint32_t instanceID )
                      NodeFunc( this, &Node::_cmdFrameDataTransmit ), commandQ );
     registerCommand( fabric::CMD_NODE_FRAMEDATA_READY,
                      NodeFunc( this, &Node::_cmdFrameDataReady ), commandQ );
+    registerCommand( fabric::CMD_NODE_FRAMEDATA_TRANSMIT_SHARED,
+                     NodeFunc( this, &Node::_cmdFrameDataTransmitShared ),
+                     commandQ );
+    registerCommand( fabric::CMD_NODE_IMAGE_RING_OPEN,
+                     NodeFunc( this, &Node::_cmdImageRingOpen ), commandQ );
+    registerCommand( fabric::CMD_NODE_IMAGE_RING_OPEN_REPLY,
+                     NodeFunc( this, &Node::_cmdImageRingOpenReply ),
+                     commandQ );
+    registerCommand( fabric::CMD_NODE_KEYFRAME_REQUEST,
+                     NodeFunc( this, &Node::_cmdKeyframeRequest ), commandQ );
 }
 
 void Node::setDirty( const uint64_t bits )
@@ -195,7 +380,106 @@ co::CommandQueue* Node::getCommandThreadQueue()
 
 co::CommandQueue* Node::getTransmitterQueue()
 {
-    return &_impl->transmitter.getQueue();
+    return &_impl->transmitQueue;
+}
+
+void Node::_startTransmitters()
+{
+    int32_t nThreads = getIAttribute( IATTR_TRANSMIT_THREADS );
+    if( nThreads <= 0 ) // AUTO: one per pipe, share the cores between nodes
+    {
+        const size_t nNodes = std::max( getConfig()->getNodes().size(),
+                                        size_t( 1 ));
+        const size_t nCores = std::max( std::thread::hardware_concurrency(),
+                                        1u );
+        const size_t nPipes = getPipes().size();
+        nThreads = int32_t( std::max( std::min( nPipes, nCores / nNodes ),
+                                      size_t( 1 )));
+    }
+
+    int32_t affinity = getIAttribute( IATTR_HINT_AFFINITY );
+    if( affinity == AUTO || affinity == OFF )
+        affinity = lunchbox::Thread::NONE;
+
+    lunchbox::ScopedFastWrite mutex( _impl->transmitters );
+    LBASSERT( _impl->transmitters->empty( ));
+    for( int32_t i = 0; i < nThreads; ++i )
+    {
+        detail::TransmitThread* thread =
+            new detail::TransmitThread( _impl->transmitQueue, uint32_t( i ));
+        thread->setInitialAffinity( affinity );
+        thread->start();
+        _impl->transmitters->push_back( thread );
+    }
+}
+
+void Node::_stopTransmitters()
+{
+    lunchbox::ScopedFastWrite mutex( _impl->transmitters );
+    detail::TransmitThreads& transmitters = _impl->transmitters.data;
+    // one wakeup per thread, each thread exits on the first one it pops
+    for( size_t i = 0; i < transmitters.size(); ++i )
+        _impl->transmitQueue.push( co::ICommand( ));
+
+    for( detail::TransmitThreads::const_iterator i = transmitters.begin();
+         i != transmitters.end(); ++i )
+    {
+        (*i)->join();
+        delete *i;
+    }
+    transmitters.clear();
+}
+
+detail::SharedImageRing* Node::getSharedImageRing( co::NodePtr node,
+                                                   const uint128_t& nodeID )
+{
+    {
+        lunchbox::ScopedMutex<> mutex( _impl->imageRingLock );
+        if( !_impl->imageRing && !_impl->imageRingFailed )
+        {
+            _impl->imageRing = detail::SharedImageRing::create(
+                getLocalNode()->getNodeID(), _sharedImageRingSize );
+            _impl->imageRingFailed = !_impl->imageRing;
+        }
+        if( !_impl->imageRing )
+            return 0;
+
+        ImageRingPeerHash::const_iterator i =
+            _impl->imageRingPeers.find( node->getNodeID( ));
+        if( i != _impl->imageRingPeers.end( ))
+            return i->second == IMAGE_RING_MAPPED ? _impl->imageRing : 0;
+
+        _impl->imageRingPeers[ node->getNodeID() ] = IMAGE_RING_PENDING;
+    }
+
+    // Hand over slots only to nodes which mapped the ring, otherwise neither
+    // the image nor the slot could be recovered. Images use the connection
+    // until _cmdImageRingOpenReply records the answer.
+    co::ObjectOCommand( co::Connections( 1, node->getConnection( )),
+                        fabric::CMD_NODE_IMAGE_RING_OPEN,
+                        co::COMMANDTYPE_OBJECT, nodeID, CO_INSTANCE_ALL )
+        << getID();
+    return 0;
+}
+
+detail::FrameCapture* Node::getFrameCapture( const std::string& filename )
+{
+    lunchbox::ScopedMutex<> mutex( _impl->frameCaptureLock );
+    if( !_impl->frameCapture )
+        _impl->frameCapture = new detail::FrameCapture( filename );
+    return _impl->frameCapture;
+}
+
+uint32_t Node::takeKeyframeRequest( const uint128_t& stream )
+{
+    lunchbox::ScopedWrite mutex( _impl->keyframeRequests );
+    KeyframeRequestHash::iterator i = _impl->keyframeRequests.data.find( stream );
+    if( i == _impl->keyframeRequests.data.end( ))
+        return 0;
+
+    const uint32_t sequence = i->second;
+    _impl->keyframeRequests.data.erase( i );
+    return sequence;
 }
 
 uint32_t Node::getCurrentFrame() const
@@ -250,6 +534,16 @@ FrameDataPtr Node::getFrameData( const co::ObjectVersion& frameDataVersion )
     return data;
 }
 
+void Node::setFrameDataVersion( FrameDataPtr data,
+                                const co::ObjectVersion& frameDataVersion )
+{
+    LBASSERT( data->getID() == frameDataVersion.identifier );
+    LBASSERT( frameDataVersion.version.high() == 0 );
+
+    lunchbox::ScopedWrite mutex( _impl->frameDatas );
+    data->setVersion( frameDataVersion.version.low( ));
+}
+
 void Node::releaseFrameData( FrameDataPtr data )
 {
     lunchbox::ScopedWrite mutex( _impl->frameDatas );
@@ -303,10 +597,8 @@ void Node::_setAffinity()
             break;
 
         default:
-            co::LocalNodePtr node = getLocalNode();
-            send( node, fabric::CMD_NODE_SET_AFFINITY ) << affinity;
-
-            node->setAffinity( affinity );
+            // the transmit threads apply it when they are started
+            getLocalNode()->setAffinity( affinity );
             break;
     }
 }
@@ -501,6 +793,17 @@ void Node::_flushObjects()
     _impl->frameDatas->clear();
 }
 
+void Node::_requestKeyframe( co::NodePtr producer, const uint128_t& producerID,
+                             const uint128_t& stream, const uint32_t sequence )
+{
+    LBLOG( LOG_ASSEMBLY ) << "Request keyframe for delta stream " << stream
+                          << " after frame " << sequence << std::endl;
+    co::ObjectOCommand( co::Connections( 1, producer->getConnection( )),
+                        fabric::CMD_NODE_KEYFRAME_REQUEST,
+                        co::COMMANDTYPE_OBJECT, producerID, CO_INSTANCE_ALL )
+        << stream << sequence;
+}
+
 void detail::TransmitThread::run()
 {
     while( true )
@@ -521,8 +824,7 @@ void Node::dirtyClientExit()
         Pipe* pipe = *i;
         pipe->cancelThread();
     }
-    getTransmitterQueue()->push( co::ICommand( )); // wake up to exit
-    _impl->transmitter.join();
+    _stopTransmitters();
 }
 
 //---------------------------------------------------------------------------
@@ -588,8 +890,9 @@ bool Node::_cmdConfigInit( co::ICommand& cmd )
     _impl->unlockedFrame = frameNumber;
     _impl->finishedFrame = frameNumber;
     _setAffinity();
+    _setupQueueStatistics( this );
 
-    _impl->transmitter.start();
+    _startTransmitters();
     const uint64_t result = configInit( initID );
 
     if( getIAttribute( IATTR_THREAD_MODEL ) == eq::UNDEFINED )
@@ -618,8 +921,7 @@ bool Node::_cmdConfigExit( co::ICommand& cmd )
     }
 
     _impl->state = configExit() ? STATE_STOPPED : STATE_FAILED;
-    getTransmitterQueue()->push( co::ICommand( )); // wake up to exit
-    _impl->transmitter.join();
+    _stopTransmitters();
     _flushObjects();
 
     getConfig()->send( getLocalNode(),
@@ -652,6 +954,7 @@ bool Node::_cmdFrameStart( co::ICommand& cmd )
     sync( version );
 
     config->_frameStart();
+    _emitQueueStatistics( this, frameNumber );
     frameStart( frameID, frameNumber );
 
     LBASSERTINFO( _impl->currentFrame >= frameNumber,
@@ -719,8 +1022,9 @@ bool Node::_cmdFrameDataTransmit( co::ICommand& cmd )
     const uint32_t buffers = command.read< uint32_t >();
     const uint32_t frameNumber = command.read< uint32_t >();
     const bool useAlpha = command.read< bool >();
-    const uint8_t* data = reinterpret_cast< const uint8_t* >(
-                command.getRemainingBuffer( command.getRemainingBufferSize( )));
+    const uint128_t& stream = command.read< uint128_t >();
+    const uint32_t sequence = command.read< uint32_t >();
+    const uint128_t& producerID = command.read< uint128_t >();
 
     LBLOG( LOG_ASSEMBLY )
         << "received image data for " << frameDataVersion << ", buffers "
@@ -728,6 +1032,17 @@ bool Node::_cmdFrameDataTransmit( co::ICommand& cmd )
 
     LBASSERT( pvp.isValid( ));
 
+    const uint64_t size = command.getRemainingBufferSize();
+    const uint8_t* data = reinterpret_cast< const uint8_t* >(
+                                            command.getRemainingBuffer( size ));
+    if( detail::FrameCapture* capture = _impl->getFrameCapture( ))
+    {
+        const detail::FrameCapture::ImageRecord record =
+            { frameDataVersion, context, pvp, zoom, stream, frameNumber,
+              buffers, useAlpha, sequence, size };
+        capture->writeImage( record, data );
+    }
+
     FrameDataPtr frameData = getFrameData( frameDataVersion );
     LBASSERT( !frameData->isReady() );
 
@@ -737,8 +1052,129 @@ bool Node::_cmdFrameDataTransmit( co::ICommand& cmd )
     // Note on the const_cast: since the PixelData structure stores non-const
     // pointers, we have to go non-const at some point, even though we do not
     // modify the data.
+    detail::ReferenceImage* reference =
+        _impl->getReferenceImage( stream, frameNumber );
     LBCHECK( frameData->addImage( frameDataVersion, pvp, zoom, context, buffers,
-                                  useAlpha, const_cast< uint8_t* >( data )));
+                                  useAlpha, const_cast< uint8_t* >( data ),
+                                  reference, sequence ));
+    if( reference && reference->sequence != sequence )
+        _requestKeyframe( command.getRemoteNode(), producerID, stream,
+                          sequence );
+    return true;
+}
+
+bool Node::_cmdFrameDataTransmitShared( co::ICommand& cmd )
+{
+    co::ObjectICommand command( cmd );
+
+    const co::ObjectVersion& frameDataVersion =
+                                            command.read< co::ObjectVersion >();
+    const PixelViewport& pvp = command.read< PixelViewport >();
+    const Zoom& zoom = command.read< Zoom >();
+    const RenderContext& context = command.read< RenderContext >();
+    const uint32_t buffers = command.read< uint32_t >();
+    const uint32_t frameNumber = command.read< uint32_t >();
+    const bool useAlpha = command.read< bool >();
+    const uint64_t offset = command.read< uint64_t >();
+    const uint64_t size = command.read< uint64_t >();
+    const uint128_t& stream = command.read< uint128_t >();
+    const uint32_t sequence = command.read< uint32_t >();
+    const uint128_t& producerID = command.read< uint128_t >();
+
+    LBLOG( LOG_ASSEMBLY )
+        << "received shared image data for " << frameDataVersion
+        << ", buffers " << buffers << " pvp " << pvp << std::endl;
+
+    LBASSERT( pvp.isValid( ));
+
+    // The ring was mapped when the producer asked in _cmdImageRingOpen
+    const co::NodeID& producer = command.getRemoteNode()->getNodeID();
+    detail::SharedImageRing* ring = _impl->imageRings[ producer ];
+    LBASSERT( ring );
+    if( !ring )
+    {
+        LBERROR << "Shared image data from " << producer << " without mapped "
+                << "ring" << std::endl;
+        return true;
+    }
+
+    uint8_t* data = ring->getData( offset, size );
+    if( !data )
+    {
+        LBERROR << "Invalid shared image data from " << producer << std::endl;
+        ring->release( offset );
+        return true;
+    }
+
+    if( detail::FrameCapture* capture = _impl->getFrameCapture( ))
+    {
+        const detail::FrameCapture::ImageRecord record =
+            { frameDataVersion, context, pvp, zoom, stream, frameNumber,
+              buffers, useAlpha, sequence, size };
+        capture->writeImage( record, data );
+    }
+
+    FrameDataPtr frameData = getFrameData( frameDataVersion );
+    LBASSERT( !frameData->isReady() );
+
+    NodeStatistics event( Statistic::NODE_FRAME_DECOMPRESS, this,
+                          frameNumber );
+
+    // addImage() releases the slot, or keeps it for pixels used in place
+    detail::ReferenceImage* reference =
+        _impl->getReferenceImage( stream, frameNumber );
+    LBCHECK( frameData->addImage( frameDataVersion, pvp, zoom, context, buffers,
+                                  useAlpha, data, reference, sequence, ring,
+                                  offset ));
+    if( reference && reference->sequence != sequence )
+        _requestKeyframe( command.getRemoteNode(), producerID, stream,
+                          sequence );
+    return true;
+}
+
+bool Node::_cmdImageRingOpen( co::ICommand& cmd )
+{
+    co::ObjectICommand command( cmd );
+    const uint128_t& producerID = command.read< uint128_t >();
+
+    co::NodePtr node = command.getRemoteNode();
+    detail::SharedImageRing*& ring = _impl->imageRings[ node->getNodeID() ];
+    if( !ring )
+        ring = detail::SharedImageRing::open( node->getNodeID( ));
+
+    LBLOG( LOG_ASSEMBLY ) << ( ring ? "Mapped" : "Can't map" )
+                          << " shared image ring of " << node->getNodeID()
+                          << std::endl;
+    co::ObjectOCommand( co::Connections( 1, node->getConnection( )),
+                        fabric::CMD_NODE_IMAGE_RING_OPEN_REPLY,
+                        co::COMMANDTYPE_OBJECT, producerID, CO_INSTANCE_ALL )
+        << ( ring != 0 );
+    return true;
+}
+
+bool Node::_cmdImageRingOpenReply( co::ICommand& cmd )
+{
+    co::ObjectICommand command( cmd );
+    const bool mapped = command.read< bool >();
+    const co::NodeID& receiver = command.getRemoteNode()->getNodeID();
+
+    LBLOG( LOG_ASSEMBLY ) << receiver << ( mapped ? " mapped" : " can't map" )
+                          << " the shared image ring" << std::endl;
+    lunchbox::ScopedMutex<> mutex( _impl->imageRingLock );
+    _impl->imageRingPeers[ receiver ] = mapped ? IMAGE_RING_MAPPED :
+                                                 IMAGE_RING_FAILED;
+    return true;
+}
+
+bool Node::_cmdKeyframeRequest( co::ICommand& cmd )
+{
+    co::ObjectICommand command( cmd );
+    const uint128_t& stream = command.read< uint128_t >();
+    const uint32_t sequence = command.read< uint32_t >();
+
+    lunchbox::ScopedWrite mutex( _impl->keyframeRequests );
+    uint32_t& request = _impl->keyframeRequests.data[ stream ];
+    request = std::max( request, sequence );
     return true;
 }
 
@@ -761,13 +1197,6 @@ bool Node::_cmdFrameDataReady( co::ICommand& cmd )
     return true;
 }
 
-bool Node::_cmdSetAffinity( co::ICommand& cmd )
-{
-    co::ObjectICommand command( cmd );
-
-    lunchbox::Thread::setAffinity( command.read< int32_t >( ));
-    return true;
-}
 }
 
 #include <eq/fabric/node.ipp>
@@ -28,7 +28,7 @@
 
 namespace eq
 {
-namespace detail { class Node; }
+namespace detail { class FrameCapture; class Node; class SharedImageRing; }
 
 /**
  * A Node represents a single computer in the cluster.
@@ -64,6 +64,36 @@ public:
     EQ_API co::CommandQueue* getCommandThreadQueue(); //!< @internal
     co::CommandQueue* getTransmitterQueue(); //!< @internal
 
+    /**
+     * @internal
+     * Get the shared memory ring for handing images to the given node.
+     *
+     * On first use for a node, the node is asked to map the ring. Until it
+     * replied, and if it can't map the ring, 0 is returned. Thread safe,
+     * never waits for the reply.
+     *
+     * @param node the receiving node.
+     * @param nodeID the identifier of the receiving eq::Node.
+     * @return the ring, or 0 if the node can't use it.
+     */
+    detail::SharedImageRing* getSharedImageRing( co::NodePtr node,
+                                                 const uint128_t& nodeID );
+
+    /**
+     * @internal
+     * @return the capture of the images received by this node, created with
+     *         the given file name on first use. All channels of the node
+     *         capture to the first file.
+     */
+    detail::FrameCapture* getFrameCapture( const std::string& filename );
+
+    /**
+     * @internal
+     * @return the last frame of the given delta stream which a receiver could
+     *         not decode, or 0. Clears the request of the stream.
+     */
+    uint32_t takeKeyframeRequest( const uint128_t& stream );
+
     /** @internal node thread only. */
     uint32_t getCurrentFrame() const;
 
@@ -85,6 +115,14 @@ public:
      */
     FrameDataPtr getFrameData( const co::ObjectVersion& frameDataVersion );
 
+    /**
+     * @internal
+     * Set the version of a frame data previously returned by getFrameData(),
+     * without looking it up again.
+     */
+    void setFrameDataVersion( FrameDataPtr data,
+                              const co::ObjectVersion& frameDataVersion );
+
     /** @internal Release the frame data instance. */
     void releaseFrameData( FrameDataPtr data );
 
@@ -264,6 +302,8 @@ private:
     detail::Node* const _impl;
 
     void _setAffinity();
+    void _startTransmitters();
+    void _stopTransmitters();
 
     void _finishFrame( const uint32_t frameNumber ) const;
     void _frameFinish( const uint128_t& frameID,
@@ -271,6 +311,10 @@ private:
 
     void _flushObjects();
 
+    /** Ask the producer of a delta stream to send a keyframe. */
+    void _requestKeyframe( co::NodePtr producer, const uint128_t& producerID,
+                           const uint128_t& stream, uint32_t sequence );
+
     /** The command functions. */
     bool _cmdCreatePipe( co::ICommand& command );
     bool _cmdDestroyPipe( co::ICommand& command );
@@ -281,8 +325,11 @@ private:
     bool _cmdFrameDrawFinish( co::ICommand& command );
     bool _cmdFrameTasksFinish( co::ICommand& command );
     bool _cmdFrameDataTransmit( co::ICommand& command );
+    bool _cmdFrameDataTransmitShared( co::ICommand& command );
+    bool _cmdImageRingOpen( co::ICommand& command );
+    bool _cmdImageRingOpenReply( co::ICommand& command );
+    bool _cmdKeyframeRequest( co::ICommand& command );
     bool _cmdFrameDataReady( co::ICommand& command );
-    bool _cmdSetAffinity( co::ICommand& command );
 
     LB_TS_VAR( _nodeThread );
 };
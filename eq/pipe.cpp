@@ -42,6 +42,7 @@
 
 #include "messagePump.h"
 #include "systemPipe.h"
+#include "detail/queueStatistics.h"
 
 #include "computeContext.h"
 #ifdef EQUALIZER_USE_CUDA
@@ -89,7 +90,24 @@ enum State
     STATE_FAILED
 };
 
-typedef stde::hash_map< uint128_t, Frame* > FrameHash;
+typedef std::vector< FrameDataPtr > FrameDataRing;
+
+/** An assembly frame and the frame datas it cycles through. */
+struct FrameSlot
+{
+    FrameSlot() : frame( 0 ), size( 0 ) {}
+
+    Frame* frame;
+
+    /**
+     * The server recycles (latency + 1) frame datas per eye pass, which are
+     * found here in steady state without a node lookup.
+     */
+    FrameDataRing datas;
+    size_t size; //!< the maximum number of datas
+};
+
+typedef stde::hash_map< uint128_t, FrameSlot > FrameHash;
 typedef stde::hash_map< uint128_t, FrameDataPtr > FrameDataHash;
 typedef stde::hash_map< uint128_t, View* > ViewHash;
 typedef stde::hash_map< uint128_t, co::QueueSlave* > QueueHash;
@@ -98,6 +116,47 @@ typedef FrameDataHash::const_iterator FrameDataHashCIter;
 typedef ViewHash::const_iterator ViewHashCIter;
 typedef ViewHash::iterator ViewHashIter;
 typedef QueueHash::const_iterator QueueHashCIter;
+
+/**
+ * Prefer the NUMA node of the given socket affinity for the memory allocated by
+ * the calling thread. Allocations fall back to other nodes when it is full.
+ */
+void _bindMemory( const int32_t affinity )
+{
+#ifdef EQUALIZER_USE_HWLOC_GL
+    if( affinity < lunchbox::Thread::SOCKET ||
+        affinity > lunchbox::Thread::SOCKET_MAX )
+    {
+        return; // core affinities keep the default, local allocation policy
+    }
+
+    hwloc_topology_t topology;
+    if( hwloc_topology_init( &topology ) < 0 )
+        return;
+    if( hwloc_topology_load( topology ) < 0 )
+    {
+        hwloc_topology_destroy( topology );
+        return;
+    }
+
+    // The thread runs on the socket, so first-touch allocates locally. Unlike
+    // a strict binding, this does not fail allocations when the node is full.
+    const unsigned index = unsigned( affinity - lunchbox::Thread::SOCKET );
+    const hwloc_obj_t socket = hwloc_get_obj_by_type( topology,
+                                                      HWLOC_OBJ_SOCKET, index );
+    if( !socket ||
+        hwloc_set_membind_nodeset( topology, socket->nodeset,
+                                   HWLOC_MEMBIND_FIRSTTOUCH,
+                                   HWLOC_MEMBIND_THREAD ) < 0 )
+    {
+        LBWARN << "Memory placement on socket " << index << " failed: "
+               << lunchbox::sysError << std::endl;
+    }
+    hwloc_topology_destroy( topology );
+#else
+    (void)affinity;
+#endif
+}
 }
 
 namespace detail
@@ -129,22 +188,32 @@ private:
 
 
 /** Asynchronous, per-pipe readback thread. */
-class TransferThread : public co::Worker
+class TransferThread : public eq::Worker
 {
 public:
     explicit TransferThread( const uint32_t index )
-        : co::Worker( co::Global::getCommandQueueLimit( ))
+        : eq::Worker( co::Global::getCommandQueueLimit( ))
         , _index( index )
         , _qThread( nullptr )
         , _stop( false )
+        , _affinity( lunchbox::Thread::NONE )
     {}
 
+    /** Set the affinity applied when the thread is started. */
+    void setInitialAffinity( const int32_t affinity ) { _affinity = affinity; }
+
     bool init() override
     {
-        if( !co::Worker::init( ))
+        if( !eq::Worker::init( ))
             return false;
         setName( std::string( "Tfer" ) +
                  boost::lexical_cast< std::string >( _index ));
+        // finish readbacks into memory local to the pipe thread
+        if( _affinity != lunchbox::Thread::NONE )
+        {
+            lunchbox::Thread::setAffinity( _affinity );
+            _bindMemory( _affinity );
+        }
 #ifdef EQ_QT_USED
         _qThread = QThread::currentThread();
 #endif
@@ -160,6 +229,7 @@ private:
     uint32_t _index;
     QThread* _qThread;
     bool _stop; // thread will exit if this is true
+    int32_t _affinity;
 };
 
 class Pipe
@@ -182,6 +252,7 @@ public:
         , thread( 0 )
         , transferThread( index )
         , computeContext( 0 )
+        , affinity( lunchbox::Thread::NONE )
     {}
 
     ~Pipe()
@@ -237,6 +308,9 @@ public:
 
     /** GPU Computing context */
     ComputeContext *computeContext;
+
+    /** The resolved affinity of the pipe thread. */
+    int32_t affinity;
 };
 
 void RenderThread::run()
@@ -541,14 +615,60 @@ void Pipe::_setupAffinity()
     switch( affinity )
     {
         case AUTO:
-            lunchbox::Thread::setAffinity( _getAutoAffinity( ));
+            _impl->affinity = _getAutoAffinity();
             break;
 
         case OFF:
+            _impl->affinity = lunchbox::Thread::NONE;
+            break;
+
         default:
-            lunchbox::Thread::setAffinity( affinity );
+            _impl->affinity = affinity;
             break;
     }
+    lunchbox::Thread::setAffinity( _impl->affinity );
+    _bindMemory( _impl->affinity );
+}
+
+int32_t Pipe::getAffinity() const
+{
+    return _impl->affinity;
+}
+
+void Pipe::_setupQueueStatistics()
+{
+    if( getIAttribute( IATTR_HINT_STATISTICS ) != ON )
+        return;
+
+    // The node main thread queue is instrumented by the node
+    if( _impl->thread )
+        _impl->thread->getWorkerQueue()->enableStatistics();
+    _impl->transferThread.getWorkerQueue()->enableStatistics();
+}
+
+void Pipe::_emitQueueStatistics( CommandQueue* queue, const char* suffix )
+{
+    detail::QueueStatistics* statistics = queue->getStatistics();
+    if( !statistics )
+        return;
+
+    detail::CommandTimesMap times;
+    size_t maxDepth = 0;
+    statistics->swap( times, maxDepth );
+
+    for( detail::CommandTimesMap::const_iterator i = times.begin();
+         i != times.end(); ++i )
+    {
+        PipeStatistics latency( Statistic::PIPE_COMMAND_LATENCY, this );
+        detail::QueueStatistics::fill( latency.event.data.statistic, i->first,
+                                       i->second.latency, maxDepth, suffix );
+
+        if( i->second.handling.getCount() == 0 )
+            continue;
+        PipeStatistics handle( Statistic::PIPE_COMMAND_HANDLE, this );
+        detail::QueueStatistics::fill( handle.event.data.statistic, i->first,
+                                       i->second.handling, maxDepth, suffix );
+    }
 }
 
 void Pipe::_exitCommandQueue()
@@ -607,7 +727,8 @@ Frame* Pipe::getFrame( const co::ObjectVersion& frameVersion, const Eye eye,
                        const bool isOutput )
 {
     LB_TS_THREAD( _pipeThread );
-    Frame* frame = _impl->frames[ frameVersion.identifier ];
+    FrameSlot& slot = _impl->frames[ frameVersion.identifier ];
+    Frame* frame = slot.frame;
 
     if( !frame )
     {
@@ -615,7 +736,9 @@ Frame* Pipe::getFrame( const co::ObjectVersion& frameVersion, const Eye eye,
         frame = new Frame();
 
         LBCHECK( client->mapObject( frame, frameVersion ));
-        _impl->frames[ frameVersion.identifier ] = frame;
+        slot.frame = frame;
+        slot.size = ( getConfig()->getLatency() + 1 ) * fabric::NUM_EYES;
+        slot.datas.reserve( slot.size );
     }
     else
         frame->sync( frameVersion.version );
@@ -623,8 +746,31 @@ Frame* Pipe::getFrame( const co::ObjectVersion& frameVersion, const Eye eye,
     const co::ObjectVersion& dataVersion = frame->getDataVersion( eye );
     LBLOG( LOG_ASSEMBLY ) << "Use " << dataVersion << std::endl;
 
-    FrameDataPtr frameData = getNode()->getFrameData( dataVersion );
-    LBASSERT( frameData );
+    FrameDataPtr frameData;
+    for( FrameDataRing::const_iterator i = slot.datas.begin();
+         i != slot.datas.end(); ++i )
+    {
+        if( (*i)->getID() == dataVersion.identifier )
+        {
+            frameData = *i;
+            getNode()->setFrameDataVersion( frameData, dataVersion );
+            break;
+        }
+    }
+
+    if( !frameData ) // new frame data, warm-up or config change
+    {
+        frameData = getNode()->getFrameData( dataVersion );
+        LBASSERT( frameData );
+        if( slot.datas.size() >= slot.size ) // drop the oldest
+            slot.datas.erase( slot.datas.begin( ));
+        slot.datas.push_back( frameData );
+
+        if( isOutput )
+            _impl->outputFrameDatas[ dataVersion.identifier ] = frameData;
+        else
+            _impl->inputFrameDatas[ dataVersion.identifier ] = frameData;
+    }
 
     if( isOutput )
     {
@@ -635,11 +781,7 @@ Frame* Pipe::getFrame( const co::ObjectVersion& frameVersion, const Eye eye,
         }
         else if( frameData->getVersion() < dataVersion.version )
             frameData->sync( dataVersion.version );
-
-        _impl->outputFrameDatas[ dataVersion.identifier ] = frameData;
     }
-    else
-        _impl->inputFrameDatas[ dataVersion.identifier ] = frameData;
 
     frame->setFrameData( frameData );
     return frame;
@@ -651,7 +793,7 @@ void Pipe::flushFrames( util::ObjectManager& om )
     ClientPtr client = getClient();
     for( FrameHashCIter i = _impl->frames.begin(); i !=_impl->frames.end(); ++i)
     {
-        Frame* frame = i->second;
+        Frame* frame = i->second.frame;
         frame->setFrameData( 0 ); // datas are flushed below
         client->unmapObject( frame );
         delete frame;
@@ -1082,6 +1224,7 @@ bool Pipe::startTransferThread()
     if( _impl->transferThread.isRunning( ))
         return true;
 
+    _impl->transferThread.setInitialAffinity( _impl->affinity );
     return _impl->transferThread.start();
 }
 
@@ -1226,6 +1369,7 @@ bool Pipe::_cmdConfigInit( co::ICommand& cmd )
         _impl->finishedFrame = frameNumber;
         _impl->unlockedFrame = frameNumber;
         _impl->state = STATE_INITIALIZING;
+        _setupQueueStatistics();
 
         result = configInit( initID );
 
@@ -1319,6 +1463,9 @@ bool Pipe::_cmdFrameStart( co::ICommand& cmd )
         waitEvent.event.data.statistic.totalTime =
             LB_MAX( _impl->frameTime - lastFrameTime, 1 ); // avoid SIGFPE
     }
+    if( _impl->thread )
+        _emitQueueStatistics( _impl->thread->getWorkerQueue(), 0 );
+    _emitQueueStatistics( _impl->transferThread.getWorkerQueue(), "tfer" );
 
     LBASSERTINFO( _impl->currentFrame + 1 == frameNumber,
                   "current " <<_impl->currentFrame << " start " << frameNumber);
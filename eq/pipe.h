@@ -196,6 +196,13 @@ public:
     /** @internal Checks if async readback thread is running. */
     bool hasTransferThread() const;
 
+    /**
+     * @internal
+     * @return the resolved affinity of the pipe thread, followed by the
+     *         workers processing the pipe's images.
+     */
+    int32_t getAffinity() const;
+
     /**
      * @name Interface to and from the SystemPipe, the window-system
      *       specific pieces for a pipe.
@@ -392,6 +399,8 @@ private:
     //-------------------- Methods --------------------
     void _setupCommandQueue();
     void _setupAffinity();
+    void _setupQueueStatistics();
+    void _emitQueueStatistics( CommandQueue* queue, const char* suffix );
     void _exitCommandQueue();
 
     /** @internal @return lunchbox::Thread::Affinity mask for this GPU.  */
@@ -29,13 +29,17 @@
 
 #include "gl.h"
 #include "log.h"
+#include "pixelData.h"
 
 #include <eq/util/frameBufferObject.h>
 #include <eq/util/objectManager.h>
+#include <eq/util/pixelConversion.h>
 #include <eq/util/shader.h>
 #include <lunchbox/os.h>
 #include <pression/plugins/compressor.h>
 
+#include <algorithm>
+
 
 namespace eq
 {
@@ -174,6 +178,64 @@ void ROIFinder::_init( )
     }
 }
 
+void ROIFinder::_initFromPixels( const PixelData& pixels,
+                                 const std::vector< uint8_t >& background,
+                                 const bool depth, const bool useAlpha )
+{
+    _areasToCheck.clear();
+    memset( &_mask[0]   , 0, _mask.size( ));
+
+    const PixelViewport& pvp = _pvpOriginal;
+    LBASSERT( pixels.pvp.w == pvp.w && pixels.pvp.h == pvp.h );
+    LBASSERT( static_cast<int32_t>(_mask.size()) >= _wb*_h  );
+    LBASSERT( background.size() == pixels.pixelSize );
+
+    // the alpha of the clear color is only significant if the image uses it
+    const size_t size = pixels.pixelSize;
+    std::vector< uint8_t > mask( size, 0xff );
+    if( !depth && !useAlpha )
+    {
+        switch( pixels.externalFormat )
+        {
+        case EQ_COMPRESSOR_DATATYPE_RGBA:
+        case EQ_COMPRESSOR_DATATYPE_BGRA:
+        case EQ_COMPRESSOR_DATATYPE_RGBA_UINT_8_8_8_8_REV:
+        case EQ_COMPRESSOR_DATATYPE_BGRA_UINT_8_8_8_8_REV:
+        case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+        case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+        case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+        case EQ_COMPRESSOR_DATATYPE_BGRA32F:
+            // alpha is the last of four equally sized channels
+            std::fill( mask.end() - size / 4, mask.end(), 0 );
+            break;
+        default:
+            break;
+        }
+    }
+
+    const uint8_t* src = static_cast< const uint8_t* >( pixels.pixels );
+    for( int32_t y = 0; y < pvp.h; y++ )
+    {
+        uint8_t* dst = &_mask[ (( pvp.y + y ) / GRID_SIZE - _pvp.y ) * _wb ];
+        for( int32_t x = 0; x < _w; x++ )
+        {
+            if( dst[x] )
+                continue;
+
+            const int32_t start =
+                LB_MAX(( _pvp.x + x ) * GRID_SIZE, pvp.x ) - pvp.x;
+            const int32_t end =
+                LB_MIN(( _pvp.x + x + 1 ) * GRID_SIZE, pvp.x + pvp.w ) - pvp.x;
+            if( util::pixel::differs( src + start * size, end - start, size,
+                                      mask.data(), background.data( )))
+            {
+                dst[x] = 255;
+            }
+        }
+        src += pvp.w * size;
+    }
+}
+
 void ROIFinder::_invalidateAreas( Area* areas, uint8_t num )
 {
     for( uint8_t i = 0; i < num; i++ )
@@ -667,4 +729,64 @@ PixelViewports ROIFinder::findRegions( const uint32_t         buffers,
     return result;
 }
 
+PixelViewports ROIFinder::findRegions( const Image&     image,
+                                       const uint32_t   stage,
+                                       const uint128_t& frameID )
+{
+    const PixelViewport& pvp = image.getPixelViewport();
+    PixelViewports result;
+    result.push_back( pvp );
+
+    LBLOG( LOG_ASSEMBLY ) << "ROIFinder::getObjects " << pvp
+                          << " from pixels" << std::endl;
+
+    if( image.getZoom() != Zoom::NONE )
+    {
+        LBLOG( LOG_ASSEMBLY ) << "R-B optimization impossible when zoom is used"
+                              << std::endl;
+        return result;
+    }
+
+    const bool depth = image.hasPixelData( Frame::BUFFER_DEPTH );
+    const Frame::Buffer buffer = depth ? Frame::BUFFER_DEPTH :
+                                         Frame::BUFFER_COLOR;
+    if( !pvp.hasArea() || !image.hasPixelData( buffer ))
+        return result;
+    LBASSERT( pvp.x >= 0 && pvp.y >= 0 );
+
+    // zoomed readbacks have pixel data of another size than the image
+    const PixelData& pixels = image.getPixelData( buffer );
+    if( pixels.pvp.w != pvp.w || pixels.pvp.h != pvp.h )
+        return result;
+
+    // empty pixels have the clear depth, or the clear color without depth
+    std::vector< uint8_t > background;
+    if( !image.getBackground( buffer, background ))
+        return result;
+
+#ifdef EQ_ROI_USE_TRACKER
+    uint8_t* ticket;
+    if( !_roiTracker.useROIFinder( pvp, stage, frameID, ticket ))
+        return result;
+#endif
+
+    _pvpOriginal = pvp;
+    _resize( _getBoundingPVP( pvp ));
+
+    // Analyze read back pixels and find regions of interest
+    _initFromPixels( pixels, background, depth, image.getAlphaUsage( ));
+
+    _emptyFinder.update( &_mask[0], _wb, _hb );
+    _emptyFinder.setLimits( 200, 0.002f );
+
+    result.clear();
+    _findAreas( result );
+
+#ifdef EQ_ROI_USE_TRACKER
+    _roiTracker.updateDelay( result, ticket );
+#endif
+
+    return result;
+}
+
 }
@@ -55,6 +55,26 @@ public:
                                 const uint32_t         stage,
                                 const uint128_t&       frameID,
                                 util::ObjectManager&   glObjects );
+
+    /**
+     * Selects the areas of a read back image which contain pixels.
+     *
+     * Builds the per-block occupancy on the CPU from the depth buffer, or else
+     * the color buffer of the image, and does not need a GL context. Empty
+     * pixels have the clear depth, or else the clear color, see
+     * Image::getBackground(). The alpha of the clear color only counts if the
+     * image uses alpha. Zoomed images and pixel formats without a known
+     * background are not analyzed.
+     *
+     * @param image   the image with memory pixel data.
+     * @param stage   compositing stage (to track separate statistics).
+     * @param frameID ID of current frame (to track separate statistics).
+     *
+     * @return Areas containing pixels, aligned to the block grid.
+     */
+    PixelViewports findRegions( const Image&     image,
+                                const uint32_t   stage,
+                                const uint128_t& frameID );
 private:
     ROIFinder( const ROIFinder& ) = delete;
     ROIFinder& operator=( const ROIFinder& ) = delete;
@@ -71,6 +91,11 @@ private:
         that was previously read-back from GPU in _readbackInfo */
     void _init( );
 
+    /** Clears masks, fills per-block occupancy _mask from read back pixels */
+    void _initFromPixels( const PixelData& pixels,
+                          const std::vector< uint8_t >& background,
+                          bool depth, bool useAlpha );
+
     /** Updates dimensions and resizes arrays */
     void _resize( const PixelViewport& pvp );
 
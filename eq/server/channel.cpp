@@ -511,6 +511,8 @@ void Channel::output( std::ostream& os ) const
 
         os << ( i==IATTR_HINT_STATISTICS ? "hint_statistics   " :
                 i==IATTR_HINT_SENDTOKEN ?  "hint_sendtoken    " :
+                i==IATTR_HINT_DELTA ?      "hint_delta        " :
+                i==IATTR_HINT_ROI ?        "hint_roi          " :
                                            "ERROR " )
            << static_cast< fabric::IAttribute >( value ) << std::endl;
     }
@@ -529,7 +531,8 @@ void Channel::output( std::ostream& os ) const
             attrPrinted = true;
         }
 
-        os << ( i == SATTR_DUMP_IMAGE ? "dump_image        " : "ERROR " )
+        os << ( i == SATTR_DUMP_IMAGE ?     "dump_image        " :
+                i == SATTR_CAPTURE_FRAMES ? "capture_frames    " : "ERROR " )
            << "\"" << value << "\"" << std::endl;
     }
 
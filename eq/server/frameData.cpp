@@ -35,6 +35,7 @@ FrameData::FrameData()
 void FrameData::getInstanceData( co::DataOStream& os )
 {
     serialize( os );
+    _committed = *this;
 }
 
 void FrameData::applyInstanceData( co::DataIStream& is )
@@ -43,5 +44,18 @@ void FrameData::applyInstanceData( co::DataIStream& is )
     deserialize( is );
 }
 
+void FrameData::pack( co::DataOStream& os )
+{
+    // Recycled frame datas mostly keep their parameters between frames
+    serializeDelta( os, _committed );
+    _committed = *this;
+}
+
+void FrameData::unpack( co::DataIStream& is )
+{
+    LBUNREACHABLE;
+    deserializeDelta( is );
+}
+
 }
 }
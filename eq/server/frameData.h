@@ -21,6 +21,7 @@
 
 #include <eq/fabric/frame.h>      // for Frame::Type
 #include <eq/fabric/frameData.h>  // member
+#include <eq/server/api.h>
 #include <eq/server/types.h>
 
 namespace eq
@@ -32,7 +33,7 @@ class FrameData : public fabric::FrameData, public co::Object
 {
 public:
     /** Construct a new FrameData. */
-    FrameData();
+    EQSERVER_API FrameData();
     virtual ~FrameData(){}
 
     /** @name Data Access */
@@ -52,11 +53,16 @@ public:
     //@}
 
 protected:
-    virtual ChangeType getChangeType() const { return INSTANCE; }
-    virtual void getInstanceData( co::DataOStream& os );
-    virtual void applyInstanceData( co::DataIStream& is );
+    virtual ChangeType getChangeType() const { return DELTA; }
+    EQSERVER_API virtual void getInstanceData( co::DataOStream& os );
+    EQSERVER_API virtual void applyInstanceData( co::DataIStream& is );
+    EQSERVER_API virtual void pack( co::DataOStream& os );
+    EQSERVER_API virtual void unpack( co::DataIStream& is );
 
 private:
+    /** The parameters of the last commit, base of the next delta. */
+    fabric::FrameData _committed;
+
     /** The zoom factor of the output frame after readback. */
     Zoom _zoom;
 
@@ -76,6 +76,7 @@ void Global::_setupDefaults()
 
     _nodeIAttributes[Node::IATTR_LAUNCH_TIMEOUT] = 60000; // ms
     _nodeIAttributes[Node::IATTR_HINT_AFFINITY] = fabric::AUTO;
+    _nodeIAttributes[Node::IATTR_TRANSMIT_THREADS] = fabric::AUTO;
     _nodeSAttributes[Node::SATTR_LAUNCH_COMMAND] =
         "ssh -n %h %c --eq-logfile %q%d/%h.%n.log%q";
 #ifdef WIN32
@@ -91,6 +92,7 @@ void Global::_setupDefaults()
     _pipeIAttributes[Pipe::IATTR_HINT_THREAD] = fabric::ON;
     _pipeIAttributes[Pipe::IATTR_HINT_CUDA_GL_INTEROP] = fabric::OFF;
     _pipeIAttributes[Pipe::IATTR_HINT_AFFINITY] = fabric::AUTO;
+    _pipeIAttributes[Pipe::IATTR_HINT_STATISTICS] = fabric::OFF;
 
     // window
     for( uint32_t i=0; i<WindowSettings::IATTR_ALL; ++i )
@@ -126,6 +128,8 @@ void Global::_setupDefaults()
     _channelIAttributes[Channel::IATTR_HINT_STATISTICS] = fabric::NICEST;
 #endif
     _channelIAttributes[Channel::IATTR_HINT_SENDTOKEN] = fabric::OFF;
+    _channelIAttributes[Channel::IATTR_HINT_DELTA] = fabric::OFF;
+    _channelIAttributes[Channel::IATTR_HINT_ROI] = fabric::OFF;
 
     // compound
     for( uint32_t i=0; i<Compound::IATTR_ALL; ++i )
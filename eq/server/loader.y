@@ -102,7 +102,10 @@
 %token EQTOKEN_GLOBAL
 %token EQTOKEN_CHANNEL_IATTR_HINT_STATISTICS
 %token EQTOKEN_CHANNEL_IATTR_HINT_SENDTOKEN
+%token EQTOKEN_CHANNEL_IATTR_HINT_DELTA
+%token EQTOKEN_CHANNEL_IATTR_HINT_ROI
 %token EQTOKEN_CHANNEL_SATTR_DUMP_IMAGE
+%token EQTOKEN_CHANNEL_SATTR_CAPTURE_FRAMES
 %token EQTOKEN_COMPOUND_IATTR_STEREO_MODE
 %token EQTOKEN_COMPOUND_IATTR_STEREO_ANAGLYPH_LEFT_MASK
 %token EQTOKEN_COMPOUND_IATTR_STEREO_ANAGLYPH_RIGHT_MASK
@@ -119,10 +122,12 @@
 %token EQTOKEN_NODE_IATTR_THREAD_MODEL
 %token EQTOKEN_NODE_IATTR_HINT_AFFINITY
 %token EQTOKEN_NODE_IATTR_HINT_STATISTICS
+%token EQTOKEN_NODE_IATTR_TRANSMIT_THREADS
 %token EQTOKEN_NODE_IATTR_LAUNCH_TIMEOUT
 %token EQTOKEN_PIPE_IATTR_HINT_CUDA_GL_INTEROP
 %token EQTOKEN_PIPE_IATTR_HINT_THREAD
 %token EQTOKEN_PIPE_IATTR_HINT_AFFINITY
+%token EQTOKEN_PIPE_IATTR_HINT_STATISTICS
 %token EQTOKEN_VIEW_SATTR_DISPLAYCLUSTER
 %token EQTOKEN_WINDOW_IATTR_HINT_CORE_PROFILE
 %token EQTOKEN_WINDOW_IATTR_HINT_OPENGL_MAJOR
@@ -159,6 +164,8 @@
 %token EQTOKEN_HINT_DECORATION
 %token EQTOKEN_HINT_STATISTICS
 %token EQTOKEN_HINT_SENDTOKEN
+%token EQTOKEN_HINT_DELTA
+%token EQTOKEN_HINT_ROI
 %token EQTOKEN_HINT_SWAPSYNC
 %token EQTOKEN_HINT_DRAWABLE
 %token EQTOKEN_HINT_THREAD
@@ -221,6 +228,7 @@
 %token EQTOKEN_LAUNCH_COMMAND
 %token EQTOKEN_LAUNCH_COMMAND_QUOTE
 %token EQTOKEN_LAUNCH_TIMEOUT
+%token EQTOKEN_TRANSMIT_THREADS
 %token EQTOKEN_PORT
 %token EQTOKEN_FILENAME
 %token EQTOKEN_TASK
@@ -300,6 +308,7 @@
 %token EQTOKEN_SOCKET
 %token EQTOKEN_DISPLAYCLUSTER
 %token EQTOKEN_DUMP_IMAGE
+%token EQTOKEN_CAPTURE_FRAMES
 
 %union{
     const char*             _string;
@@ -405,6 +414,11 @@ global:
          LBWARN << "Ignoring deprecated attribute Node::IATTR_HINT_STATISTICS"
                 << std::endl;
      }
+     | EQTOKEN_NODE_IATTR_TRANSMIT_THREADS IATTR
+     {
+         eq::server::Global::instance()->setNodeIAttribute(
+             eq::server::Node::IATTR_TRANSMIT_THREADS, $2 );
+     }
      | EQTOKEN_PIPE_IATTR_HINT_THREAD IATTR
      {
          eq::server::Global::instance()->setPipeIAttribute(
@@ -420,6 +434,11 @@ global:
          eq::server::Global::instance()->setPipeIAttribute(
              eq::server::Pipe::IATTR_HINT_CUDA_GL_INTEROP, $2 );
      }
+     | EQTOKEN_PIPE_IATTR_HINT_STATISTICS IATTR
+     {
+         eq::server::Global::instance()->setPipeIAttribute(
+             eq::server::Pipe::IATTR_HINT_STATISTICS, $2 );
+     }
      | EQTOKEN_WINDOW_IATTR_HINT_CORE_PROFILE IATTR
      {
          eq::server::Global::instance()->setWindowIAttribute(
@@ -525,6 +544,16 @@ global:
          eq::server::Global::instance()->setChannelIAttribute(
              eq::server::Channel::IATTR_HINT_SENDTOKEN, $2 );
      }
+     | EQTOKEN_CHANNEL_IATTR_HINT_DELTA IATTR
+     {
+         eq::server::Global::instance()->setChannelIAttribute(
+             eq::server::Channel::IATTR_HINT_DELTA, $2 );
+     }
+     | EQTOKEN_CHANNEL_IATTR_HINT_ROI IATTR
+     {
+         eq::server::Global::instance()->setChannelIAttribute(
+             eq::server::Channel::IATTR_HINT_ROI, $2 );
+     }
      | EQTOKEN_COMPOUND_IATTR_STEREO_MODE IATTR
      {
          eq::server::Global::instance()->setCompoundIAttribute(
@@ -550,6 +579,11 @@ global:
         eq::server::Global::instance()->setChannelSAttribute(
             eq::server::Channel::SATTR_DUMP_IMAGE, $2 );
      }
+     | EQTOKEN_CHANNEL_SATTR_CAPTURE_FRAMES STRING
+     {
+        eq::server::Global::instance()->setChannelSAttribute(
+            eq::server::Channel::SATTR_CAPTURE_FRAMES, $2 );
+     }
      | EQTOKEN_VIEW_SATTR_DISPLAYCLUSTER STRING
      {
         eq::server::Global::instance()->setViewSAttribute(
@@ -654,6 +688,8 @@ nodeAttribute:
         { node->setIAttribute( eq::server::Node::IATTR_THREAD_MODEL, $2 ); }
     | EQTOKEN_LAUNCH_TIMEOUT IATTR
         { node->setIAttribute( eq::server::Node::IATTR_LAUNCH_TIMEOUT, $2 ); }
+    | EQTOKEN_TRANSMIT_THREADS IATTR
+        { node->setIAttribute( eq::server::Node::IATTR_TRANSMIT_THREADS, $2 ); }
     | EQTOKEN_HINT_STATISTICS IATTR
         {
             LBWARN
@@ -691,6 +727,8 @@ pipeAttribute:
     | EQTOKEN_HINT_CUDA_GL_INTEROP IATTR
         { eqPipe->setIAttribute( eq::server::Pipe::IATTR_HINT_CUDA_GL_INTEROP,
                                  $2 ); }
+    | EQTOKEN_HINT_STATISTICS IATTR
+        { eqPipe->setIAttribute( eq::server::Pipe::IATTR_HINT_STATISTICS, $2);}
 
 window: EQTOKEN_WINDOW '{'
             {
@@ -782,9 +820,18 @@ channelAttribute:
     | EQTOKEN_HINT_SENDTOKEN IATTR
         { channel->setIAttribute( eq::server::Channel::IATTR_HINT_SENDTOKEN,
                                   $2 ); }
+    | EQTOKEN_HINT_DELTA IATTR
+        { channel->setIAttribute( eq::server::Channel::IATTR_HINT_DELTA,
+                                  $2 ); }
+    | EQTOKEN_HINT_ROI IATTR
+        { channel->setIAttribute( eq::server::Channel::IATTR_HINT_ROI,
+                                  $2 ); }
     | EQTOKEN_DUMP_IMAGE STRING
         { channel->setSAttribute( eq::server::Channel::SATTR_DUMP_IMAGE,
                                   $2 ); }
+    | EQTOKEN_CAPTURE_FRAMES STRING
+        { channel->setSAttribute( eq::server::Channel::SATTR_CAPTURE_FRAMES,
+                                  $2 ); }
 observer: EQTOKEN_OBSERVER '{' { observer = new eq::server::Observer( config );}
             observerFields '}' { observer = 0; }
 observerFields: /*null*/ | observerFields observerField
@@ -835,6 +835,7 @@ void Node::output( std::ostream& os ) const
         os << ( i== Node::IATTR_LAUNCH_TIMEOUT ? "launch_timeout       " :
                 i== Node::IATTR_THREAD_MODEL   ? "thread_model         " :
                 i== Node::IATTR_HINT_AFFINITY  ? "hint_affinity        " :
+                i== Node::IATTR_TRANSMIT_THREADS ? "transmit_threads     " :
                 "ERROR" )
            << static_cast< fabric::IAttribute >( value ) << std::endl;
     }
@@ -32,6 +32,7 @@
 #include <eq/util/bitmapFont.h>
 #include <eq/util/frameBufferObject.h>
 #include <eq/util/objectManager.h>
+#include <eq/util/pixelConversion.h>
 #include <eq/util/shader.h>
 
 #endif // EQUTIL_H
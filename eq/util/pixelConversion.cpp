@@ -0,0 +1,762 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pixelConversion.h"
+
+#include <lunchbox/debug.h>
+#include <cstring>
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+#  define EQ_PIXEL_SIMD
+#  include <immintrin.h>
+#  define EQ_TARGET( isa ) __attribute__(( target( isa )))
+#endif
+
+namespace eq
+{
+namespace util
+{
+namespace pixel
+{
+namespace
+{
+//---------------------------------------------------------------------------
+// scalar code paths, also used for the tails of the SIMD loops
+//---------------------------------------------------------------------------
+inline float _halfToFloat( const uint16_t value )
+{
+    const uint32_t sign = uint32_t( value & 0x8000 ) << 16;
+    const uint32_t exponent = ( value >> 10 ) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+
+    if( exponent == 0x1f ) // infinity or NaN, quiet signaling NaNs
+        bits = sign | 0x7f800000 | ( mantissa << 13 ) |
+               ( mantissa ? 0x400000 : 0 );
+    else if( exponent != 0 )
+        bits = sign | (( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+    else if( mantissa == 0 )
+        bits = sign;
+    else // denormal half, normalize
+    {
+        uint32_t normalized = 113;
+        while( !( mantissa & 0x400 ))
+        {
+            mantissa <<= 1;
+            --normalized;
+        }
+        bits = sign | ( normalized << 23 ) | (( mantissa & 0x3ff ) << 13 );
+    }
+
+    float result;
+    ::memcpy( &result, &bits, sizeof( result ));
+    return result;
+}
+
+inline uint16_t _floatToHalf( const float value )
+{
+    uint32_t bits;
+    ::memcpy( &bits, &value, sizeof( bits ));
+    const uint16_t sign = ( bits >> 16 ) & 0x8000;
+    const uint32_t magnitude = bits & 0x7fffffff;
+
+    if( magnitude > 0x7f800000 ) // NaN, keep the upper mantissa and quiet
+        return sign | 0x7e00 | (( magnitude >> 13 ) & 0x3ff );
+    if( magnitude >= 0x477ff000 ) // 65520 and above round to infinity
+        return sign | 0x7c00;
+    if( magnitude < 0x38800000 ) // denormal half or zero, let the FPU round
+    {
+        float denormal;
+        ::memcpy( &denormal, &magnitude, sizeof( denormal ));
+        denormal += 0.5f;
+        uint32_t rounded;
+        ::memcpy( &rounded, &denormal, sizeof( rounded ));
+        return sign | uint16_t( rounded - 0x3f000000 );
+    }
+
+    // rebias the exponent and round the mantissa to nearest even
+    const uint32_t odd = ( magnitude >> 13 ) & 1;
+    return sign | uint16_t(( magnitude - 0x38000000 + 0xfff + odd ) >> 13 );
+}
+
+inline uint8_t _toUnorm8( const float value )
+{
+    const float scaled = value * 255.f;
+    if( scaled >= 255.f )
+        return 255;
+    return scaled > 0.f ? uint8_t( scaled ) : 0; // NaN fails both tests
+}
+
+template< size_t size > void _deinterleave( const uint8_t* in,
+                                            const size_t nPixels,
+                                            const size_t nChannels,
+                                            uint8_t* const* planes )
+{
+    const size_t stride = nChannels * size;
+    for( size_t c = 0; c < nChannels; ++c )
+    {
+        const uint8_t* from = in + c * size;
+        uint8_t* to = planes[c];
+        for( size_t i = 0; i < nPixels; ++i, from += stride, to += size )
+            ::memcpy( to, from, size );
+    }
+}
+
+template< size_t size > void _interleave( const uint8_t* const* planes,
+                                          const size_t nPixels,
+                                          const size_t nChannels,
+                                          uint8_t* out )
+{
+    const size_t stride = nChannels * size;
+    for( size_t c = 0; c < nChannels; ++c )
+    {
+        const uint8_t* from = planes[c];
+        uint8_t* to = out + c * size;
+        for( size_t i = 0; i < nPixels; ++i, from += size, to += stride )
+            ::memcpy( to, from, size );
+    }
+}
+
+void _unpremultiply( uint8_t* color, const uint8_t* alpha, const size_t n )
+{
+    for( size_t i = 0; i < n; ++i )
+    {
+        if( alpha[i] == 0 )
+            continue;
+        const uint32_t divided = 255u * color[i] / alpha[i];
+        color[i] = uint8_t( divided > 255 ? 255 : divided );
+    }
+}
+
+bool _differs( const uint8_t* in, const size_t nBytes, const uint8_t* mask,
+               const uint8_t* background, const size_t pixelSize )
+{
+    for( size_t i = 0; i < nBytes; i += pixelSize )
+        for( size_t j = 0; j < pixelSize; ++j )
+            if(( in[ i + j ] ^ background[j] ) & mask[j] )
+                return true;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// SIMD code paths
+//---------------------------------------------------------------------------
+#ifdef EQ_PIXEL_SIMD
+struct Instructions
+{
+    Instructions()
+    {
+        __builtin_cpu_init();
+        sse2 = __builtin_cpu_supports( "sse2" );
+        ssse3 = __builtin_cpu_supports( "ssse3" );
+        avx2 = __builtin_cpu_supports( "avx2" );
+        f16c = __builtin_cpu_supports( "avx" ) &&
+               __builtin_cpu_supports( "f16c" );
+        enabled = true;
+    }
+
+    bool sse2;
+    bool ssse3;
+    bool avx2;
+    bool f16c;
+    bool enabled;
+};
+
+Instructions& _getInstructions()
+{
+    static Instructions instructions;
+    return instructions;
+}
+
+bool _useSSE2() { const Instructions& i = _getInstructions();
+                  return i.enabled && i.sse2; }
+bool _useSSSE3() { const Instructions& i = _getInstructions();
+                   return i.enabled && i.ssse3; }
+bool _useAVX2() { const Instructions& i = _getInstructions();
+                  return i.enabled && i.avx2; }
+bool _useF16C() { const Instructions& i = _getInstructions();
+                  return i.enabled && i.f16c; }
+
+EQ_TARGET( "avx,f16c" )
+size_t _halfToFloatF16C( const uint16_t* in, float* out, const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 8 <= n; i += 8 )
+    {
+        const __m128i half = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( in + i ));
+        _mm256_storeu_ps( out + i, _mm256_cvtph_ps( half ));
+    }
+    return i;
+}
+
+EQ_TARGET( "avx,f16c" )
+size_t _floatToHalfF16C( const float* in, uint16_t* out, const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 8 <= n; i += 8 )
+    {
+        const __m128i half = _mm256_cvtps_ph( _mm256_loadu_ps( in + i ),
+                                              _MM_FROUND_TO_NEAREST_INT );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( out + i ), half );
+    }
+    return i;
+}
+
+/** Scale, clamp and truncate 16 floats and pack them into 16 bytes. */
+EQ_TARGET( "avx2" )
+__m128i _toUnorm8AVX2( const __m256 first, const __m256 second )
+{
+    const __m256 scale = _mm256_set1_ps( 255.f );
+    const __m256 zero = _mm256_setzero_ps();
+    // max returns the second operand for NaN, which converts NaN to zero
+    const __m256i a = _mm256_cvttps_epi32(
+        _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( first, scale ), zero ),
+                       scale ));
+    const __m256i b = _mm256_cvttps_epi32(
+        _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( second, scale ), zero ),
+                       scale ));
+    // packs interleave the 128 bit lanes, restore the order afterwards
+    const __m256i words = _mm256_packs_epi32( a, b );
+    const __m256i bytes = _mm256_packus_epi16( words, words );
+    const __m256i ordered = _mm256_permutevar8x32_epi32(
+        bytes, _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 ));
+    return _mm256_castsi256_si128( ordered );
+}
+
+EQ_TARGET( "avx2" )
+size_t _floatToUnorm8AVX2( const float* in, uint8_t* out, const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 16 <= n; i += 16 )
+    {
+        const __m128i bytes = _toUnorm8AVX2( _mm256_loadu_ps( in + i ),
+                                             _mm256_loadu_ps( in + i + 8 ));
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( out + i ), bytes );
+    }
+    return i;
+}
+
+EQ_TARGET( "avx2,f16c" )
+size_t _halfToUnorm8AVX2( const uint16_t* in, uint8_t* out, const size_t n )
+{
+    size_t i = 0;
+    for( ; i + 16 <= n; i += 16 )
+    {
+        const __m256 first = _mm256_cvtph_ps( _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( in + i )));
+        const __m256 second = _mm256_cvtph_ps( _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( in + i + 8 )));
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( out + i ),
+                          _toUnorm8AVX2( first, second ));
+    }
+    return i;
+}
+
+/** Transpose a 4x4 matrix of 32 bit values. */
+EQ_TARGET( "sse2" )
+void _transpose( __m128i& a, __m128i& b, __m128i& c, __m128i& d )
+{
+    const __m128i ab0 = _mm_unpacklo_epi32( a, b ); // a0 b0 a1 b1
+    const __m128i ab1 = _mm_unpackhi_epi32( a, b ); // a2 b2 a3 b3
+    const __m128i cd0 = _mm_unpacklo_epi32( c, d );
+    const __m128i cd1 = _mm_unpackhi_epi32( c, d );
+    a = _mm_unpacklo_epi64( ab0, cd0 ); // a0 b0 c0 d0
+    b = _mm_unpackhi_epi64( ab0, cd0 );
+    c = _mm_unpacklo_epi64( ab1, cd1 );
+    d = _mm_unpackhi_epi64( ab1, cd1 );
+}
+
+/** Deinterleave 4 x 8 bit pixels, 16 pixels per iteration. */
+EQ_TARGET( "ssse3" )
+size_t _deinterleave4x8SSSE3( const uint8_t* in, const size_t nPixels,
+                              uint8_t* const* planes )
+{
+    // gather the bytes of each channel of four pixels into one 32 bit value
+    const __m128i shuffle = _mm_setr_epi8( 0, 4, 8, 12, 1, 5, 9, 13,
+                                           2, 6, 10, 14, 3, 7, 11, 15 );
+    size_t i = 0;
+    for( ; i + 16 <= nPixels; i += 16 )
+    {
+        const __m128i* from = reinterpret_cast< const __m128i* >( in + i * 4 );
+        __m128i a = _mm_shuffle_epi8( _mm_loadu_si128( from ), shuffle );
+        __m128i b = _mm_shuffle_epi8( _mm_loadu_si128( from + 1 ), shuffle );
+        __m128i c = _mm_shuffle_epi8( _mm_loadu_si128( from + 2 ), shuffle );
+        __m128i d = _mm_shuffle_epi8( _mm_loadu_si128( from + 3 ), shuffle );
+        _transpose( a, b, c, d );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[0] + i ), a );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[1] + i ), b );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[2] + i ), c );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[3] + i ), d );
+    }
+    return i;
+}
+
+/** Deinterleave 3 x 8 bit pixels, 16 pixels per iteration. */
+EQ_TARGET( "ssse3" )
+size_t _deinterleave3x8SSSE3( const uint8_t* in, const size_t nPixels,
+                              uint8_t* const* planes )
+{
+    // shuffle masks selecting the bytes of channel c from each of the three
+    // input vectors, -1 zeroes the bytes taken from another vector
+    static const struct Masks
+    {
+        Masks()
+        {
+            for( size_t c = 0; c < 3; ++c )
+                for( size_t v = 0; v < 3; ++v )
+                    for( int j = 0; j < 16; ++j )
+                    {
+                        const int source = j * 3 + int( c ) - int( v ) * 16;
+                        values[c][v][j] = ( source >= 0 && source < 16 ) ?
+                                          int8_t( source ) : int8_t( -1 );
+                    }
+        }
+        int8_t values[3][3][16];
+    } masks;
+
+    size_t i = 0;
+    for( ; i + 16 <= nPixels; i += 16 )
+    {
+        const __m128i* from = reinterpret_cast< const __m128i* >( in + i * 3 );
+        const __m128i a = _mm_loadu_si128( from );
+        const __m128i b = _mm_loadu_si128( from + 1 );
+        const __m128i c = _mm_loadu_si128( from + 2 );
+        for( size_t j = 0; j < 3; ++j )
+        {
+            const __m128i* mask =
+                reinterpret_cast< const __m128i* >( masks.values[j] );
+            const __m128i plane = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_shuffle_epi8( a, _mm_loadu_si128( mask )),
+                    _mm_shuffle_epi8( b, _mm_loadu_si128( mask + 1 ))),
+                _mm_shuffle_epi8( c, _mm_loadu_si128( mask + 2 )));
+            _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[j] + i ),
+                              plane );
+        }
+    }
+    return i;
+}
+
+/** Deinterleave 4 x 32 bit pixels, 4 pixels per iteration. */
+EQ_TARGET( "sse2" )
+size_t _deinterleave4x32SSE2( const uint8_t* in, const size_t nPixels,
+                              uint8_t* const* planes )
+{
+    size_t i = 0;
+    for( ; i + 4 <= nPixels; i += 4 )
+    {
+        const __m128i* from = reinterpret_cast< const __m128i* >( in + i * 16 );
+        __m128i a = _mm_loadu_si128( from );
+        __m128i b = _mm_loadu_si128( from + 1 );
+        __m128i c = _mm_loadu_si128( from + 2 );
+        __m128i d = _mm_loadu_si128( from + 3 );
+        _transpose( a, b, c, d );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[0] + i*4 ), a );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[1] + i*4 ), b );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[2] + i*4 ), c );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( planes[3] + i*4 ), d );
+    }
+    return i;
+}
+
+/** Interleave 4 x 8 bit pixels, 16 pixels per iteration. */
+EQ_TARGET( "sse2" )
+size_t _interleave4x8SSE2( const uint8_t* const* planes, const size_t nPixels,
+                           uint8_t* out )
+{
+    size_t i = 0;
+    for( ; i + 16 <= nPixels; i += 16 )
+    {
+        const __m128i r = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[0] + i ));
+        const __m128i g = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[1] + i ));
+        const __m128i b = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[2] + i ));
+        const __m128i a = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[3] + i ));
+        const __m128i rg0 = _mm_unpacklo_epi8( r, g );
+        const __m128i rg1 = _mm_unpackhi_epi8( r, g );
+        const __m128i ba0 = _mm_unpacklo_epi8( b, a );
+        const __m128i ba1 = _mm_unpackhi_epi8( b, a );
+
+        __m128i* to = reinterpret_cast< __m128i* >( out + i * 4 );
+        _mm_storeu_si128( to, _mm_unpacklo_epi16( rg0, ba0 ));
+        _mm_storeu_si128( to + 1, _mm_unpackhi_epi16( rg0, ba0 ));
+        _mm_storeu_si128( to + 2, _mm_unpacklo_epi16( rg1, ba1 ));
+        _mm_storeu_si128( to + 3, _mm_unpackhi_epi16( rg1, ba1 ));
+    }
+    return i;
+}
+
+/** Interleave 3 x 8 bit pixels, 16 pixels per iteration. */
+EQ_TARGET( "ssse3" )
+size_t _interleave3x8SSSE3( const uint8_t* const* planes, const size_t nPixels,
+                            uint8_t* out )
+{
+    // shuffle masks selecting the bytes of output vector v from the plane of
+    // channel c, -1 zeroes the bytes taken from another plane
+    static const struct Masks
+    {
+        Masks()
+        {
+            for( size_t v = 0; v < 3; ++v )
+                for( size_t c = 0; c < 3; ++c )
+                    for( size_t j = 0; j < 16; ++j )
+                    {
+                        const size_t byte = v * 16 + j;
+                        values[v][c][j] = ( byte % 3 == c ) ?
+                                          int8_t( byte / 3 ) : int8_t( -1 );
+                    }
+        }
+        int8_t values[3][3][16];
+    } masks;
+
+    size_t i = 0;
+    for( ; i + 16 <= nPixels; i += 16 )
+    {
+        const __m128i r = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[0] + i ));
+        const __m128i g = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[1] + i ));
+        const __m128i b = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[2] + i ));
+        __m128i* to = reinterpret_cast< __m128i* >( out + i * 3 );
+        for( size_t j = 0; j < 3; ++j )
+        {
+            const __m128i* mask =
+                reinterpret_cast< const __m128i* >( masks.values[j] );
+            const __m128i pixels = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_shuffle_epi8( r, _mm_loadu_si128( mask )),
+                    _mm_shuffle_epi8( g, _mm_loadu_si128( mask + 1 ))),
+                _mm_shuffle_epi8( b, _mm_loadu_si128( mask + 2 )));
+            _mm_storeu_si128( to + j, pixels );
+        }
+    }
+    return i;
+}
+
+/** Interleave 4 x 32 bit pixels, 4 pixels per iteration. */
+EQ_TARGET( "sse2" )
+size_t _interleave4x32SSE2( const uint8_t* const* planes,
+                            const size_t nPixels, uint8_t* out )
+{
+    size_t i = 0;
+    for( ; i + 4 <= nPixels; i += 4 )
+    {
+        __m128i a = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[0] + i * 4 ));
+        __m128i b = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[1] + i * 4 ));
+        __m128i c = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[2] + i * 4 ));
+        __m128i d = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( planes[3] + i * 4 ));
+        _transpose( a, b, c, d );
+
+        __m128i* to = reinterpret_cast< __m128i* >( out + i * 16 );
+        _mm_storeu_si128( to, a );
+        _mm_storeu_si128( to + 1, b );
+        _mm_storeu_si128( to + 2, c );
+        _mm_storeu_si128( to + 3, d );
+    }
+    return i;
+}
+
+/**
+ * Compare 64 bytes per iteration against a background and mask repeating
+ * every 16 bytes. Sets the number of bytes compared without a difference.
+ */
+EQ_TARGET( "sse2" )
+bool _differsSSE2( const uint8_t* in, const size_t nBytes,
+                   const uint8_t* mask_, const uint8_t* background_,
+                   size_t& done )
+{
+    const __m128i mask = _mm_loadu_si128(
+        reinterpret_cast< const __m128i* >( mask_ ));
+    const __m128i background = _mm_and_si128( mask, _mm_loadu_si128(
+        reinterpret_cast< const __m128i* >( background_ )));
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for( ; i + 64 <= nBytes; i += 64 )
+    {
+        const __m128i* from = reinterpret_cast< const __m128i* >( in + i );
+        const __m128i a = _mm_xor_si128( _mm_and_si128(
+            _mm_loadu_si128( from ), mask ), background );
+        const __m128i b = _mm_xor_si128( _mm_and_si128(
+            _mm_loadu_si128( from + 1 ), mask ), background );
+        const __m128i c = _mm_xor_si128( _mm_and_si128(
+            _mm_loadu_si128( from + 2 ), mask ), background );
+        const __m128i d = _mm_xor_si128( _mm_and_si128(
+            _mm_loadu_si128( from + 3 ), mask ), background );
+        const __m128i any = _mm_or_si128( _mm_or_si128( a, b ),
+                                          _mm_or_si128( c, d ));
+        if( _mm_movemask_epi8( _mm_cmpeq_epi8( any, zero )) != 0xffff )
+            return true;
+    }
+    for( ; i + 16 <= nBytes; i += 16 )
+    {
+        const __m128i a = _mm_xor_si128( _mm_and_si128( _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( in + i )), mask ), background );
+        if( _mm_movemask_epi8( _mm_cmpeq_epi8( a, zero )) != 0xffff )
+            return true;
+    }
+    done = i;
+    return false;
+}
+
+/**
+ * Unpremultiply 8 values per iteration. The float quotient is exact enough:
+ * the quotient of two integers below 2^16 is at least 1/255 away from the next
+ * integer, more than the rounding error of the division.
+ */
+EQ_TARGET( "avx2" )
+size_t _unpremultiplyAVX2( uint8_t* color, const uint8_t* alpha,
+                           const size_t n )
+{
+    const __m256 scale = _mm256_set1_ps( 255.f );
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi32( 255 );
+    size_t i = 0;
+    for( ; i + 8 <= n; i += 8 )
+    {
+        const __m256i c = _mm256_cvtepu8_epi32( _mm_loadl_epi64(
+            reinterpret_cast< const __m128i* >( color + i )));
+        const __m256i a = _mm256_cvtepu8_epi32( _mm_loadl_epi64(
+            reinterpret_cast< const __m128i* >( alpha + i )));
+        const __m256 quotient = _mm256_div_ps(
+            _mm256_mul_ps( _mm256_cvtepi32_ps( c ), scale ),
+            _mm256_cvtepi32_ps( _mm256_max_epi32( a, _mm256_set1_epi32( 1 ))));
+        const __m256i divided =
+            _mm256_min_epi32( _mm256_cvttps_epi32( quotient ), max );
+        const __m256i result = _mm256_blendv_epi8(
+            divided, c, _mm256_cmpeq_epi32( a, zero ));
+
+        // pack the low bytes of the eight 32 bit values
+        const __m256i bytes = _mm256_shuffle_epi8( result, _mm256_setr_epi8(
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 ));
+        const __m128i packed = _mm_unpacklo_epi32(
+            _mm256_castsi256_si128( bytes ),
+            _mm256_extracti128_si256( bytes, 1 ));
+        _mm_storel_epi64( reinterpret_cast< __m128i* >( color + i ), packed );
+    }
+    return i;
+}
+#else
+bool _useSSE2() { return false; }
+bool _useSSSE3() { return false; }
+bool _useAVX2() { return false; }
+bool _useF16C() { return false; }
+#endif
+}
+
+void halfToFloat( const uint16_t* in, float* out, const size_t n )
+{
+    size_t i = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( _useF16C( ))
+        i = _halfToFloatF16C( in, out, n );
+#endif
+    for( ; i < n; ++i )
+        out[i] = _halfToFloat( in[i] );
+}
+
+void floatToHalf( const float* in, uint16_t* out, const size_t n )
+{
+    size_t i = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( _useF16C( ))
+        i = _floatToHalfF16C( in, out, n );
+#endif
+    for( ; i < n; ++i )
+        out[i] = _floatToHalf( in[i] );
+}
+
+void floatToUnorm8( const float* in, uint8_t* out, const size_t n )
+{
+    size_t i = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( _useAVX2( ))
+        i = _floatToUnorm8AVX2( in, out, n );
+#endif
+    for( ; i < n; ++i )
+        out[i] = _toUnorm8( in[i] );
+}
+
+void halfToUnorm8( const uint16_t* in, uint8_t* out, const size_t n )
+{
+    size_t i = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( _useAVX2() && _useF16C( ))
+        i = _halfToUnorm8AVX2( in, out, n );
+#endif
+    for( ; i < n; ++i )
+        out[i] = _toUnorm8( _halfToFloat( in[i] ));
+}
+
+void deinterleave( const void* in_, const size_t nPixels,
+                   const size_t nChannels, const size_t channelSize,
+                   void* const* planes_ )
+{
+    LBASSERTINFO( nChannels > 0 && nChannels <= 4, nChannels );
+    const uint8_t* in = static_cast< const uint8_t* >( in_ );
+    uint8_t* planes[4];
+    for( size_t c = 0; c < nChannels; ++c )
+        planes[c] = static_cast< uint8_t* >( planes_[c] );
+
+    size_t done = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( channelSize == 1 && nChannels == 4 && _useSSSE3( ))
+        done = _deinterleave4x8SSSE3( in, nPixels, planes );
+    else if( channelSize == 1 && nChannels == 3 && _useSSSE3( ))
+        done = _deinterleave3x8SSSE3( in, nPixels, planes );
+    else if( channelSize == 4 && nChannels == 4 && _useSSE2( ))
+        done = _deinterleave4x32SSE2( in, nPixels, planes );
+#endif
+    if( done == nPixels )
+        return;
+
+    in += done * nChannels * channelSize;
+    for( size_t c = 0; c < nChannels; ++c )
+        planes[c] += done * channelSize;
+
+    switch( channelSize )
+    {
+    case 1:
+        _deinterleave< 1 >( in, nPixels - done, nChannels, planes );
+        break;
+    case 2:
+        _deinterleave< 2 >( in, nPixels - done, nChannels, planes );
+        break;
+    case 4:
+        _deinterleave< 4 >( in, nPixels - done, nChannels, planes );
+        break;
+    default:
+        LBUNIMPLEMENTED;
+    }
+}
+
+void interleave( const void* const* planes_, const size_t nPixels,
+                 const size_t nChannels, const size_t channelSize, void* out_ )
+{
+    LBASSERTINFO( nChannels > 0 && nChannels <= 4, nChannels );
+    uint8_t* out = static_cast< uint8_t* >( out_ );
+    const uint8_t* planes[4];
+    for( size_t c = 0; c < nChannels; ++c )
+        planes[c] = static_cast< const uint8_t* >( planes_[c] );
+
+    size_t done = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( channelSize == 1 && nChannels == 4 && _useSSE2( ))
+        done = _interleave4x8SSE2( planes, nPixels, out );
+    else if( channelSize == 1 && nChannels == 3 && _useSSSE3( ))
+        done = _interleave3x8SSSE3( planes, nPixels, out );
+    else if( channelSize == 4 && nChannels == 4 && _useSSE2( ))
+        done = _interleave4x32SSE2( planes, nPixels, out );
+#endif
+    if( done == nPixels )
+        return;
+
+    out += done * nChannels * channelSize;
+    for( size_t c = 0; c < nChannels; ++c )
+        planes[c] += done * channelSize;
+
+    switch( channelSize )
+    {
+    case 1:
+        _interleave< 1 >( planes, nPixels - done, nChannels, out );
+        break;
+    case 2:
+        _interleave< 2 >( planes, nPixels - done, nChannels, out );
+        break;
+    case 4:
+        _interleave< 4 >( planes, nPixels - done, nChannels, out );
+        break;
+    default:
+        LBUNIMPLEMENTED;
+    }
+}
+
+void unpremultiply( uint8_t* color, const uint8_t* alpha, const size_t n )
+{
+    size_t i = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( _useAVX2( ))
+        i = _unpremultiplyAVX2( color, alpha, n );
+#endif
+    _unpremultiply( color + i, alpha + i, n - i );
+}
+
+bool differs( const void* pixels, const size_t nPixels,
+              const size_t pixelSize, const void* mask_,
+              const void* background_ )
+{
+    const uint8_t* in = static_cast< const uint8_t* >( pixels );
+    const uint8_t* mask = static_cast< const uint8_t* >( mask_ );
+    const uint8_t* background = static_cast< const uint8_t* >( background_ );
+    const size_t nBytes = nPixels * pixelSize;
+
+    size_t done = 0;
+#ifdef EQ_PIXEL_SIMD
+    if( pixelSize <= 16 && 16 % pixelSize == 0 && _useSSE2( ))
+    {
+        // repeat the pixel to one vector, pixels do not straddle vectors
+        uint8_t masks[16];
+        uint8_t backgrounds[16];
+        for( size_t i = 0; i < 16; i += pixelSize )
+        {
+            ::memcpy( masks + i, mask, pixelSize );
+            ::memcpy( backgrounds + i, background, pixelSize );
+        }
+        if( _differsSSE2( in, nBytes, masks, backgrounds, done ))
+            return true;
+    }
+#endif
+    return _differs( in + done, nBytes - done, mask, background, pixelSize );
+}
+
+void setSIMDEnabled( const bool enable )
+{
+#ifdef EQ_PIXEL_SIMD
+    _getInstructions().enabled = enable;
+#else
+    (void)enable;
+#endif
+}
+
+std::string getSIMDInstructions()
+{
+    std::string instructions;
+    if( _useSSE2( ))
+        instructions += "SSE2 ";
+    if( _useSSSE3( ))
+        instructions += "SSSE3 ";
+    if( _useAVX2( ))
+        instructions += "AVX2 ";
+    if( _useF16C( ))
+        instructions += "F16C ";
+    return instructions.empty() ? "none" :
+                                  instructions.substr( 0, instructions.size()-1 );
+}
+
+}
+}
+}
@@ -0,0 +1,121 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQUTIL_PIXELCONVERSION_H
+#define EQUTIL_PIXELCONVERSION_H
+
+#include <eq/api.h>
+#include <eq/types.h>
+
+#include <string>
+
+namespace eq
+{
+namespace util
+{
+/**
+ * Batch conversions of pixel data.
+ *
+ * All functions operate on spans of values, and use SSE, AVX and F16C
+ * instructions when supported by the CPU. The results are bit-identical to the
+ * scalar code paths.
+ */
+namespace pixel
+{
+
+/**
+ * Convert half floats to floats.
+ *
+ * Signaling NaNs are converted to quiet NaNs, as done by the F16C
+ * instructions.
+ * @version 1.12
+ */
+EQ_API void halfToFloat( const uint16_t* in, float* out, size_t n );
+
+/**
+ * Convert floats to half floats, rounding to the nearest even value.
+ * @version 1.12
+ */
+EQ_API void floatToHalf( const float* in, uint16_t* out, size_t n );
+
+/**
+ * Convert floats in [0, 1] to 8 bit values, truncating the scaled value.
+ *
+ * Values outside [0, 1] are clamped, NaN is converted to 0.
+ * @version 1.12
+ */
+EQ_API void floatToUnorm8( const float* in, uint8_t* out, size_t n );
+
+/** Convert half floats to 8 bit values, see floatToUnorm8(). @version 1.12 */
+EQ_API void halfToUnorm8( const uint16_t* in, uint8_t* out, size_t n );
+
+/**
+ * Split interleaved pixels into one plane per channel.
+ *
+ * The order of the planes determines the channel order, e.g., passing the
+ * red and blue plane in swapped order converts from BGRA to RGBA.
+ *
+ * @param in the interleaved pixels.
+ * @param nPixels the number of pixels.
+ * @param nChannels the number of channels per pixel, at most four.
+ * @param channelSize the size of one channel value, 1, 2 or 4 bytes.
+ * @param planes the output planes, one for each channel.
+ * @version 1.12
+ */
+EQ_API void deinterleave( const void* in, size_t nPixels, size_t nChannels,
+                          size_t channelSize, void* const* planes );
+
+/** Merge one plane per channel into interleaved pixels. @version 1.12 */
+EQ_API void interleave( const void* const* planes, size_t nPixels,
+                        size_t nChannels, size_t channelSize, void* out );
+
+/**
+ * Divide an 8 bit color plane by its alpha plane, in place.
+ *
+ * Computes min( 255, 255 * color / alpha ) for each value, values with zero
+ * alpha are unchanged.
+ * @version 1.12
+ */
+EQ_API void unpremultiply( uint8_t* color, const uint8_t* alpha, size_t n );
+
+/**
+ * Test if any pixel differs from a background pixel in the bits of a mask.
+ *
+ * Stops at the first differing pixel. Used to find the occupied areas of
+ * read back images, e.g., with a mask excluding the alpha channel.
+ *
+ * @param pixels the pixels to test.
+ * @param nPixels the number of pixels.
+ * @param pixelSize the size of one pixel in bytes.
+ * @param mask the bits of a pixel to compare, pixelSize bytes.
+ * @param background the background pixel, pixelSize bytes.
+ * @return true if any masked pixel differs from the masked background.
+ * @version 1.12
+ */
+EQ_API bool differs( const void* pixels, size_t nPixels, size_t pixelSize,
+                     const void* mask, const void* background );
+
+/** @internal Enable or disable the SIMD code paths, for testing. */
+EQ_API void setSIMDEnabled( bool enable );
+
+/** @internal @return the instruction sets used by the conversions. */
+EQ_API std::string getSIMDInstructions();
+}
+}
+}
+
+#endif // EQUTIL_PIXELCONVERSION_H
@@ -0,0 +1,204 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVOLVE_BRICK_GRID_H
+#define EVOLVE_BRICK_GRID_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace eVolve
+{
+
+    /** Minimum and maximum value of each brick of a volume.
+
+        The value range of the bricks is computed once from the volume data.
+        A new transfer function only reclassifies the bricks from their value
+        range, without reading the volume again.
+    */
+    class BrickGrid
+    {
+    public:
+        static const uint32_t brickSize  = 8; //!< voxels per brick and axis
+        static const uint32_t brickApron = 3; //!< voxels sampled around it
+
+        /** Bounding box of the visible bricks in one layer of bricks */
+        struct Layer
+        {
+            uint32_t x0, x1, y0, y1; //!< inclusive, x0 > x1 if empty
+            uint32_t nVisible;       //!< number of visible bricks
+        };
+
+        BrickGrid() : _bW( 0 ), _bH( 0 ), _bD( 0 ) {}
+
+        /** @return true if compute() has not been called. */
+        bool isEmpty() const { return _min.empty(); }
+
+        /** Find the value range of each brick, including the apron of voxels
+            which are sampled by interpolation and preintegration inside the
+            brick.
+
+            @param values first scalar value of the volume
+            @param stride bytes between two voxels
+        */
+        void compute( const uint8_t* values, const uint32_t w, const uint32_t h,
+                      const uint32_t d, const uint32_t stride )
+        {
+            _bW = ( w + brickSize - 1 ) / brickSize;
+            _bH = ( h + brickSize - 1 ) / brickSize;
+            _bD = ( d + brickSize - 1 ) / brickSize;
+            _min.resize( size_t( _bW ) * _bH * _bD );
+            _max.resize( size_t( _bW ) * _bH * _bD );
+
+            // brick layers are independent
+            const int32_t bD = int32_t( _bD );
+#pragma omp parallel for
+            for( int32_t layer = 0; layer < bD; ++layer )
+            {
+                const uint32_t bz = uint32_t( layer );
+                const uint32_t z0 = _begin( bz );
+                const uint32_t z1 = _end( bz, d );
+
+                for( uint32_t by = 0; by < _bH; ++by )
+                {
+                    const uint32_t y0 = _begin( by );
+                    const uint32_t y1 = _end( by, h );
+
+                    for( uint32_t bx = 0; bx < _bW; ++bx )
+                    {
+                        const uint32_t x0 = _begin( bx );
+                        const uint32_t x1 = _end( bx, w );
+                        uint8_t minValue = 255;
+                        uint8_t maxValue = 0;
+                        for( uint32_t z = z0; z < z1; ++z )
+                            for( uint32_t y = y0; y < y1; ++y )
+                            {
+                                const uint8_t* row = values +
+                                    ( size_t( z ) * h + y ) * w * stride;
+                                for( uint32_t x = x0; x < x1; ++x )
+                                {
+                                    const uint8_t value = row[ x * stride ];
+                                    minValue = std::min( minValue, value );
+                                    maxValue = std::max( maxValue, value );
+                                }
+                            }
+
+                        const size_t i = _index( bx, by, bz );
+                        _min[ i ] = minValue;
+                        _max[ i ] = maxValue;
+                    }
+                }
+            }
+        }
+
+        /** Classify all bricks using the transfer function.
+
+            @param TF RGBA transfer function with up to 256 entries
+            @param visibility returns 255 for each visible brick, in a grid
+                   of tW x tH x tD bricks
+        */
+        void classify( const std::vector< uint8_t >& TF,
+                       std::vector< uint8_t >& visibility,
+                       const uint32_t tW, const uint32_t tH,
+                       const uint32_t tD )
+        {
+            // number of values with non-zero opacity below each value, the
+            // preintegration lookup is linearly filtered, so widen ranges by
+            // one
+            const size_t nTF = TF.size() / 4;
+            std::vector< uint32_t > opaque( 257, 0 );
+            for( size_t i = 0; i < 256; ++i )
+                opaque[i+1] = opaque[i] + ( i < nTF && TF[i*4+3] > 0 ? 1 : 0 );
+
+            visibility.assign( size_t( tW ) * tH * tD, 0 );
+            _layers.resize( _bD );
+            for( uint32_t bz = 0; bz < _bD; ++bz )
+            {
+                Layer& layer = _layers[ bz ];
+                layer.x0 = _bW;
+                layer.x1 = 0;
+                layer.y0 = _bH;
+                layer.y1 = 0;
+                layer.nVisible = 0;
+
+                for( uint32_t by = 0; by < _bH; ++by )
+                    for( uint32_t bx = 0; bx < _bW; ++bx )
+                    {
+                        const size_t i = _index( bx, by, bz );
+                        const uint32_t lo = _min[i] > 0 ? _min[i] - 1 : 0;
+                        const uint32_t hi = _max[i] < 255 ? _max[i] + 1 : 255;
+                        if( opaque[ hi + 1 ] == opaque[ lo ] )
+                            continue;
+
+                        visibility[( size_t( bz ) * tH + by ) * tW + bx ] = 255;
+                        layer.x0 = std::min( layer.x0, bx );
+                        layer.x1 = std::max( layer.x1, bx );
+                        layer.y0 = std::min( layer.y0, by );
+                        layer.y1 = std::max( layer.y1, by );
+                        ++layer.nVisible;
+                    }
+            }
+        }
+
+        uint32_t getWidth()  const { return _bW; } //!< bricks along x
+        uint32_t getHeight() const { return _bH; } //!< bricks along y
+        uint32_t getDepth()  const { return _bD; } //!< bricks along z
+
+        /** @return the visible bricks of a layer after classify(). */
+        const Layer& getLayer( const uint32_t bz ) const
+            { return _layers[ bz ]; }
+
+    private:
+        uint32_t _bW;
+        uint32_t _bH;
+        uint32_t _bD;
+        std::vector< uint8_t > _min;    //!< minimum value per brick
+        std::vector< uint8_t > _max;    //!< maximum value per brick
+        std::vector< Layer >   _layers; //!< visible bricks per layer
+
+        size_t _index( const uint32_t bx, const uint32_t by,
+                       const uint32_t bz ) const
+            { return ( size_t( bz ) * _bH + by ) * _bW + bx; }
+
+        static uint32_t _begin( const uint32_t brick )
+        {
+            const uint32_t first = brick * brickSize;
+            return first > brickApron ? first - brickApron : 0;
+        }
+
+        static uint32_t _end( const uint32_t brick, const uint32_t n )
+        {
+            const uint32_t end = ( brick + 1 ) * brickSize + brickApron;
+            return end < n ? end : n;
+        }
+    };
+
+}
+
+#endif // EVOLVE_BRICK_GRID_H
@@ -177,8 +177,13 @@ void Channel::frameDraw( const eq::uint128_t& )
     const int normalsQuality = _getFrameData().getNormalsQuality();
 
     const eq::Range& range = getRange();
-    renderer->render( range, modelview, invRotationM, taintColor,
-                      normalsQuality );
+    {
+        // sample the rendering and report the empty part of the range
+        eq::ChannelStatistics event( eq::Statistic::CHANNEL_EMPTY_SPACE, this );
+        renderer->render( range, modelview, invRotationM, taintColor,
+                          normalsQuality );
+        event.event.data.statistic.ratio = renderer->getSkippedFraction();
+    }
     checkError( "error during rendering " );
 
     _image.setContext( getContext( ));
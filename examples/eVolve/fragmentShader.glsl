@@ -31,51 +31,63 @@
 
 uniform sampler3D volume; //gx, gy, gz, v
 uniform sampler2D preInt; // r,  g,  b, a
+uniform sampler3D bricks; // a != 0 if brick is visible
 
 uniform float shininess;
 uniform int   normalsQuality;
 uniform vec3  viewVec;
 uniform vec3  sizeVec;
 uniform vec4  taint; // .rgb should be pre-multiplied with .a
+uniform vec2  depthClamp; // depth of first and last voxel, the texture wraps
+
+vec4 lookup( vec3 coords )
+{
+    coords.z = clamp( coords.z, depthClamp.x, depthClamp.y );
+    return texture3D( volume, coords );
+}
 
 void main (void)
 {
+// Empty space skipping, transparent segments don't change the frame buffer
+    if( texture3D( bricks, gl_TexCoord[2].xyz ).a == 0.0 )
+        discard;
+
 // Normals
     vec3 coords = (gl_TexCoord[0].xyz+gl_TexCoord[1].xyz)/2.0;
     vec3 lookupMP;
 
 if( sizeVec.x > 0.5 )
 {
-    lookupMP = texture3D( volume, coords ).rgb - 0.5;
+    lookupMP = lookup( coords ).rgb - 0.5;
 }
 else
 {
 // basic
     lookupMP = vec3(
-        texture3D( volume, coords + vec3( sizeVec.x,0.0,0.0) ).a -
-        texture3D( volume, coords + vec3(-sizeVec.x,0.0,0.0) ).a,
-        texture3D( volume, coords + vec3(0.0, sizeVec.y,0.0) ).a -
-        texture3D( volume, coords + vec3(0.0,-sizeVec.y,0.0) ).a,
-        texture3D( volume, coords + vec3(0.0,0.0, sizeVec.z) ).a -
-        texture3D( volume, coords + vec3(0.0,0.0,-sizeVec.z) ).a ) * 6.0;
+        lookup( coords + vec3( sizeVec.x,0.0,0.0) ).a -
+        lookup( coords + vec3(-sizeVec.x,0.0,0.0) ).a,
+        lookup( coords + vec3(0.0, sizeVec.y,0.0) ).a -
+        lookup( coords + vec3(0.0,-sizeVec.y,0.0) ).a,
+        lookup( coords + vec3(0.0,0.0, sizeVec.z) ).a -
+        lookup( coords + vec3(0.0,0.0,-sizeVec.z) ).a ) * 6.0;
 
 // medium
     if( normalsQuality < 2 )
     {
-        float lu = texture3D( volume, coords + vec3(-sizeVec.x, sizeVec.y,0.0) ).a;
-        float ld = texture3D( volume, coords + vec3(-sizeVec.x,-sizeVec.y,0.0) ).a;
-        float lb = texture3D( volume, coords + vec3(-sizeVec.x,0.0,-sizeVec.z) ).a;
-        float lf = texture3D( volume, coords + vec3(-sizeVec.x,0.0, sizeVec.z) ).a;
+        float lu = lookup( coords + vec3(-sizeVec.x, sizeVec.y,0.0) ).a;
+        float ld = lookup( coords + vec3(-sizeVec.x,-sizeVec.y,0.0) ).a;
+        float lb = lookup( coords + vec3(-sizeVec.x,0.0,-sizeVec.z) ).a;
+        float lf = lookup( coords + vec3(-sizeVec.x,0.0, sizeVec.z) ).a;
 
-        float ru = texture3D( volume, coords + vec3( sizeVec.x, sizeVec.y,0.0) ).a;
-        float rd = texture3D( volume, coords + vec3( sizeVec.x,-sizeVec.y,0.0) ).a;
-        float rb = texture3D( volume, coords + vec3( sizeVec.x,0.0,-sizeVec.z) ).a;
-        float rf = texture3D( volume, coords + vec3( sizeVec.x,0.0, sizeVec.z) ).a;
+        float ru = lookup( coords + vec3( sizeVec.x, sizeVec.y,0.0) ).a;
+        float rd = lookup( coords + vec3( sizeVec.x,-sizeVec.y,0.0) ).a;
+        float rb = lookup( coords + vec3( sizeVec.x,0.0,-sizeVec.z) ).a;
+        float rf = lookup( coords + vec3( sizeVec.x,0.0, sizeVec.z) ).a;
 
-        float ub = texture3D( volume, coords + vec3(0.0, sizeVec.y,-sizeVec.z) ).a;
-        float uf = texture3D( volume, coords + vec3(0.0, sizeVec.y, sizeVec.z) ).a;
-        float db = texture3D( volume, coords + vec3(0.0,-sizeVec.y,-sizeVec.z) ).a;
-        float df = texture3D( volume, coords + vec3(0.0,-sizeVec.y, sizeVec.z) ).a;
+        float ub = lookup( coords + vec3(0.0, sizeVec.y,-sizeVec.z) ).a;
+        float uf = lookup( coords + vec3(0.0, sizeVec.y, sizeVec.z) ).a;
+        float db = lookup( coords + vec3(0.0,-sizeVec.y,-sizeVec.z) ).a;
+        float df = lookup( coords + vec3(0.0,-sizeVec.y, sizeVec.z) ).a;
 
         lookupMP += vec3(
             ru + rd + rb + rf - lu - ld - lb - lf,
@@ -86,15 +98,15 @@ else
 // full
     if( normalsQuality < 1 )
     {
-        float lub = texture3D( volume, coords + vec3(-sizeVec.x, sizeVec.y,-sizeVec.z) ).a;
-        float luf = texture3D( volume, coords + vec3(-sizeVec.x, sizeVec.y, sizeVec.z) ).a;
-        float ldb = texture3D( volume, coords + vec3(-sizeVec.x,-sizeVec.y,-sizeVec.z) ).a;
-        float ldf = texture3D( volume, coords + vec3(-sizeVec.x,-sizeVec.y, sizeVec.z) ).a;
+        float lub = lookup( coords + vec3(-sizeVec.x, sizeVec.y,-sizeVec.z) ).a;
+        float luf = lookup( coords + vec3(-sizeVec.x, sizeVec.y, sizeVec.z) ).a;
+        float ldb = lookup( coords + vec3(-sizeVec.x,-sizeVec.y,-sizeVec.z) ).a;
+        float ldf = lookup( coords + vec3(-sizeVec.x,-sizeVec.y, sizeVec.z) ).a;
 
-        float rub = texture3D( volume, coords + vec3( sizeVec.x, sizeVec.y,-sizeVec.z) ).a;
-        float ruf = texture3D( volume, coords + vec3( sizeVec.x, sizeVec.y, sizeVec.z) ).a;
-        float rdb = texture3D( volume, coords + vec3( sizeVec.x,-sizeVec.y,-sizeVec.z) ).a;
-        float rdf = texture3D( volume, coords + vec3( sizeVec.x,-sizeVec.y, sizeVec.z) ).a;
+        float rub = lookup( coords + vec3( sizeVec.x, sizeVec.y,-sizeVec.z) ).a;
+        float ruf = lookup( coords + vec3( sizeVec.x, sizeVec.y, sizeVec.z) ).a;
+        float rdb = lookup( coords + vec3( sizeVec.x,-sizeVec.y,-sizeVec.z) ).a;
+        float rdf = lookup( coords + vec3( sizeVec.x,-sizeVec.y, sizeVec.z) ).a;
 
         lookupMP += vec3(
             lub + luf + ldb + ldf - rub - ruf - rdb - rdf,
@@ -104,8 +116,8 @@ else
 }
 
 // Preintegration (colors)
-    float lookupSF = texture3D(volume, gl_TexCoord[0].xyz).a;
-    float lookupSB = texture3D(volume, gl_TexCoord[1].xyz).a;
+    float lookupSF = lookup( gl_TexCoord[0].xyz).a;
+    float lookupSB = lookup( gl_TexCoord[1].xyz).a;
 
     vec4 preInt_ = texture2D(preInt, vec2(lookupSF, lookupSB));
 
@@ -39,6 +39,8 @@ using hlpFuncs::hFile;
 
 static GLuint createPreintegrationTable( const uint8_t* Table );
 
+static uint32_t calcMinPow2( uint32_t size );
+
 static bool readTransferFunction( FILE* file, std::vector<uint8_t>& TF );
 
 static bool readDimensionsAndScaling
@@ -60,8 +62,14 @@ RawVolumeModel::RawVolumeModel( const std::string& filename  )
         , _tW( 0 )
         , _tH( 0 )
         , _tD( 0 )
+        , _bytes( 0 )
         , _resolution( 0 )
         , _hasDerivatives( true )
+        , _volumeData( 0 )
+        , _volumeName( 0 )
+        , _slabDepth( 0 )
+        , _brickName( 0 )
+        , _tfChanged( true )
         , _glewContext( 0 )
 {}
 
@@ -91,6 +99,9 @@ bool RawVolumeModel::loadHeader( const float brightness, const float alpha )
         return false;
 
     _resolution = LB_MAX( _w, LB_MAX( _h, _d ) );
+    _bytes      = _hasDerivatives ? 4 : 1;
+    _slabDepth  = LB_MIN( 16u, calcMinPow2( _d ));
+    _slabs.setNSlabs( ( _d + _slabDepth - 1 ) / _slabDepth );
 
     if( !readTransferFunction( header.f, _TF ))
         return false;
@@ -115,40 +126,40 @@ bool RawVolumeModel::loadHeader( const float brightness, const float alpha )
 }
 
 
-static int32_t calcHashKey( const eq::Range& range )
-{
-    return static_cast<int32_t>(( range.start*10000.f + range.end )*10000.f );
-}
-
-
 bool RawVolumeModel::getVolumeInfo( VolumeInfo& info, const eq::Range& range )
 {
     if( !_headerLoaded && !loadHeader( 1.0f, 1.0f ))
         return false;
 
-    if( _preintName == 0 )
+    if( !_volumeData && !_mapVolume( ))
+        return false;
+
+    if( _bricks.isEmpty( ))
+    {
+        // the scalar value is stored after the derivatives
+        _bricks.compute( _volumeData + ( _hasDerivatives ? 3 : 0 ),
+                         _w, _h, _d, _bytes );
+        LBLOG( eq::LOG_CUSTOM ) << "bricks: " << _bricks.getWidth() << "x"
+                                << _bricks.getHeight() << "x"
+                                << _bricks.getDepth() << std::endl;
+    }
+
+    if( _tfChanged )
     {
         LBLOG( eq::LOG_CUSTOM ) << "Creating preint" << std::endl;
+        if( _preintName != 0 )
+            glDeleteTextures( 1, &_preintName );
         _preintName = createPreintegrationTable( &_TF[0] );
+        _updateBrickVisibility();
+        _tfChanged = false;
     }
 
-          VolumePart* volumePart = 0;
-    const int32_t     key        = calcHashKey( range );
+    if( !_updateVolumeTexture( info.TD, range ))
+        return false;
 
-    if( _volumeHash.find( key ) == _volumeHash.end( ) )
-    {
-        // new key
-        volumePart = &_volumeHash[ key ];
-        if( !_createVolumeTexture( volumePart->volume, volumePart->TD, range ))
-            return false;
-    }
-    else
-    {   // old key
-        volumePart = &_volumeHash[ key ];
-    }
+    _getVisibleBox( info, range );
 
-    info.volume     = volumePart->volume;
-    info.TD         = volumePart->TD;
+    info.volume     = _volumeName;
     info.preint     = _preintName;
     info.volScaling = _volScaling;
     if( _hasDerivatives )
@@ -166,13 +177,11 @@ bool RawVolumeModel::getVolumeInfo( VolumeInfo& info, const eq::Range& range )
 }
 
 
-void RawVolumeModel::releaseVolumeInfo( const eq::Range& range )
+void RawVolumeModel::setTransferFunction( const std::vector< uint8_t >& TF )
 {
-    const int32_t key = calcHashKey( range );
-    if( _volumeHash.find( key ) == _volumeHash.end() )
-        return;
-
-    _volumeHash.erase( key );
+    LBASSERT( TF.size() == 256*4 );
+    _TF = TF;
+    _tfChanged = true;
 }
 
 
@@ -195,16 +204,36 @@ static uint32_t calcMinPow2( uint32_t size )
 }
 
 
-/** Reading requested part of volume and derivatives from data file
+bool RawVolumeModel::_mapVolume()
+{
+    _volumeData = static_cast< const uint8_t* >( _volumeMap.map( _filename ));
+    if( !_volumeData )
+    {
+        LBERROR << "Can't open model data file" << std::endl;
+        return false;
+    }
+
+    const size_t size = size_t( _w ) * _h * _d * _bytes;
+    if( _volumeMap.getSize() < size )
+    {
+        LBERROR << "Model data file too small: " << _volumeMap.getSize()
+                << " instead of " << size << " bytes" << std::endl;
+        _volumeMap.unmap();
+        _volumeData = 0;
+        return false;
+    }
+    return true;
+}
+
+
+/** Makes the requested part of the volume resident in the slab ring
 */
-bool RawVolumeModel::_createVolumeTexture(        GLuint&    volume,
-                                                  DataInTextureDimensions& TD,
-                                            const eq::Range& range    )
+bool RawVolumeModel::_updateVolumeTexture(       DataInTextureDimensions& TD,
+                                           const eq::Range&              range )
 {
     const uint32_t w = _w;
     const uint32_t h = _h;
     const uint32_t d = _d;
-    const uint32_t bytes = _hasDerivatives ? 4 : 1;
 
     const int32_t bwStart = 2; //border width from left
     const int32_t bwEnd   = 2; //border width from right
@@ -221,94 +250,198 @@ bool RawVolumeModel::_createVolumeTexture(        GLuint&    volume,
     const uint32_t end   =
                 static_cast<uint32_t>( clip<int32_t>( e+bwEnd  , 0, d-1 ) );
 
-    const uint32_t depth = end-start+1;
-
-    _tW = calcMinPow2( w );
-    _tH = calcMinPow2( h );
-    _tD = calcMinPow2( depth );
-
-    //texture scaling coefficients
-    TD.W  = static_cast<float>( w     ) / static_cast<float>( _tW );
-    TD.H  = static_cast<float>( h     ) / static_cast<float>( _tH );
-    TD.D  = static_cast<float>( e-s+1 ) / static_cast<float>( _tD );
-    TD.D /= range.end>range.start ? (range.end-range.start) : 1.0f;
+    const uint32_t firstSlab = start / _slabDepth;
+    const uint32_t lastSlab  = end   / _slabDepth;
+    const uint32_t nSlabs    = lastSlab - firstSlab + 1;
 
-    // Shift coefficient and left border in texture for depth
-    TD.Do = range.start;
-    TD.Db = range.start > 0.0001 ? bwStart / static_cast<float>(_tD) : 0;
-
-    LBLOG( eq::LOG_CUSTOM )
-            << "==============================================="   << std::endl
-            << " w: "  << w << " " << _tW
-            << " h: "  << h << " " << _tH
-            << " d: "  << d << " " << depth << " " << _tD           << std::endl
-            << " r: "  << _resolution                              << std::endl
-            << " ws: " << TD.W  << " hs: " << TD.H  << " wd: " << TD.D
-            << " Do: " << TD.Do << " Db: " << TD.Db                << std::endl
-            << " s= "  << start << " e= "  << end                  << std::endl;
-
-    // Reading of requested part of a volume
-    std::vector<uint8_t> data( _tW*_tH*_tD*bytes, 0 );
-    const uint32_t  wh4 =   w *   h * bytes;
-    const uint32_t tWH4 = _tW * _tH * bytes;
-
-    std::ifstream file ( _filename.c_str(), std::ifstream::in |
-                         std::ifstream::binary | std::ifstream::ate );
-
-    if( !file.is_open() )
-    {
-        LBERROR << "Can't open model data file";
-        return false;
-    }
+    LBASSERT( _glewContext );
+    if( _slabs.update( firstSlab, lastSlab ))
+        _allocateVolumeTexture( _slabs.getNSlots( ));
+    else
+        glBindTexture( GL_TEXTURE_3D, _volumeName );
+
+    const std::vector< uint32_t >& uploads = _slabs.getUploads();
+    for( size_t i = 0; i < uploads.size(); ++i )
+        _uploadSlab( uploads[i] );
+    const size_t nUploads = uploads.size();
+
+    // texture coordinates address the whole volume, the depth wraps around
+    TD.W    = static_cast<float>( w ) / static_cast<float>( _tW );
+    TD.H    = static_cast<float>( h ) / static_cast<float>( _tH );
+    TD.D    = static_cast<float>( d ) / static_cast<float>( _tD );
+    TD.Do   = 0.f;
+    TD.Db   = 0.f;
+    TD.Zmin = 0.5f / static_cast<float>( _tD );
+    TD.Zmax = ( static_cast<float>( d ) - 0.5f ) / static_cast<float>( _tD );
+
+    if( nUploads > 0 )
+        LBLOG( eq::LOG_CUSTOM )
+            << "uploaded " << nUploads << " of " << nSlabs << " slabs for "
+            << range << ", s= " << start << " e= " << end << std::endl;
+    return true;
+}
 
-    file.seekg( wh4*start, std::ios::beg );
 
-    if( w==_tW && h==_tH ) // width and height are power of 2
-    {
-        file.read( (char*)( &data[0] ), wh4*depth );
-    }
-    else if( w==_tW )     // only width is power of 2
+void RawVolumeModel::_allocateVolumeTexture( const uint32_t nSlots )
+{
+    if( _volumeName == 0 )
     {
-        for( uint32_t i=0; i<depth; i++ )
-            file.read( (char*)( &data[i*tWH4] ), wh4 );
+        glGenTextures( 1, &_volumeName );
+        LBLOG( eq::LOG_CUSTOM ) << "generated texture: " << _volumeName
+                                << std::endl;
     }
-    else
-    {               // nor width nor heigh is power of 2
-        const uint32_t   w4 =   w * bytes;
-        const uint32_t  tW4 = _tW * bytes;
-
-        for( uint32_t i=0; i<depth; i++ )
-            for( uint32_t j=0; j<h; j++ )
-                file.read( (char*)( &data[ i*tWH4 + j*tW4] ), w4 );
-    }
-
-    file.close();
-
-    LBASSERT( _glewContext );
-    // create 3D texture
-    glGenTextures( 1, &volume );
-    LBLOG( eq::LOG_CUSTOM ) << "generated texture: " << volume << std::endl;
-    glBindTexture(GL_TEXTURE_3D, volume);
+    glBindTexture( GL_TEXTURE_3D, _volumeName );
 
     glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_S    , GL_CLAMP_TO_EDGE );
     glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_T    , GL_CLAMP_TO_EDGE );
-    glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_R    , GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_R    , GL_REPEAT        );
     glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR        );
     glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR        );
 
+    _tW = calcMinPow2( _w );
+    _tH = calcMinPow2( _h );
+    _tD = nSlots * _slabDepth;
+
+    LBLOG( eq::LOG_CUSTOM )
+            << "==============================================="   << std::endl
+            << " w: "  << _w << " " << _tW
+            << " h: "  << _h << " " << _tH
+            << " d: "  << _d << " " << _tD
+            << " slabs: " << nSlots << "x" << _slabDepth           << std::endl;
+
+    // slabs only fill the width and height of the data, clear the padding
+    std::vector< uint8_t > data;
+    if( _w != _tW || _h != _tH )
+        data.resize( size_t( _tW ) * _tH * _tD * _bytes, 0 );
+    const GLvoid* pixels = data.empty() ? 0 : &data[0];
+
     if( _hasDerivatives )
     {
         glTexImage3D(   GL_TEXTURE_3D,
                         0, GL_RGBA, _tW, _tH, _tD,
-                        0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)(&data[0]) );
+                        0, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
     }else
     {
         glTexImage3D(   GL_TEXTURE_3D,
                         0, GL_ALPHA, _tW, _tH, _tD,
-                        0, GL_ALPHA, GL_UNSIGNED_BYTE, (GLvoid*)(&data[0]) );
+                        0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels );
     }
+}
 
-    return true;
+
+/** Copies one slab from the mapped volume to its slot in the bound texture
+*/
+void RawVolumeModel::_uploadSlab( const uint32_t slab )
+{
+    const uint32_t slot  = _slabs.getSlot( slab );
+    const uint32_t first = slab * _slabDepth;
+    const uint32_t depth = LB_MIN( _slabDepth, _d - first );
+    const uint8_t* data  = _volumeData + size_t( first ) * _w * _h * _bytes;
+
+    glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    glTexSubImage3D( GL_TEXTURE_3D, 0, 0, 0, slot * _slabDepth,
+                     _w, _h, depth, _hasDerivatives ? GL_RGBA : GL_ALPHA,
+                     GL_UNSIGNED_BYTE, data );
+    glPopClientAttrib();
+}
+
+
+/** Classifies all bricks using the transfer function and uploads the result
+*/
+void RawVolumeModel::_updateBrickVisibility()
+{
+    const uint32_t tBW = calcMinPow2( _bricks.getWidth( ));
+    const uint32_t tBH = calcMinPow2( _bricks.getHeight( ));
+    const uint32_t tBD = calcMinPow2( _bricks.getDepth( ));
+    std::vector< uint8_t > data;
+    _bricks.classify( _TF, data, tBW, tBH, tBD );
+
+    if( _brickName == 0 )
+    {
+        glGenTextures( 1, &_brickName );
+        glBindTexture( GL_TEXTURE_3D, _brickName );
+        glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+        glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    }
+    else
+        glBindTexture( GL_TEXTURE_3D, _brickName );
+
+    glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    glTexImage3D( GL_TEXTURE_3D, 0, GL_ALPHA, tBW, tBH, tBD,
+                  0, GL_ALPHA, GL_UNSIGNED_BYTE, &data[0] );
+    glPopClientAttrib();
+}
+
+
+/** Computes the bounding box of the visible bricks within the range
+*/
+void RawVolumeModel::_getVisibleBox( VolumeInfo& info,
+                                     const eq::Range& range ) const
+{
+    const uint32_t d = _d;
+    const int32_t s =
+            clip<int32_t>( static_cast< int32_t >( d*range.start ), 0, d-1 );
+    const int32_t e =
+            clip<int32_t>( static_cast< int32_t >( d*range.end-1 ), 0, d-1 );
+
+    const uint32_t brickSize = BrickGrid::brickSize;
+    const uint32_t bW = _bricks.getWidth();
+    const uint32_t bH = _bricks.getHeight();
+    const uint32_t bD = _bricks.getDepth();
+    const uint32_t first = s / brickSize;
+    const uint32_t last  = e / brickSize;
+
+    BrickGrid::Layer box = { bW, 0, bH, 0, 0 };
+    uint32_t z0 = last + 1;
+    uint32_t z1 = first;
+    for( uint32_t bz = first; bz <= last; ++bz )
+    {
+        const BrickGrid::Layer& layer = _bricks.getLayer( bz );
+        if( layer.nVisible == 0 )
+            continue;
+
+        box.x0 = LB_MIN( box.x0, layer.x0 );
+        box.x1 = LB_MAX( box.x1, layer.x1 );
+        box.y0 = LB_MIN( box.y0, layer.y0 );
+        box.y1 = LB_MAX( box.y1, layer.y1 );
+        box.nVisible += layer.nVisible;
+        z0 = LB_MIN( z0, bz );
+        z1 = LB_MAX( z1, bz );
+    }
+
+    const float zRs = -1.f + 2.f * range.start;
+    const float zRe = -1.f + 2.f * range.end;
+
+    info.bricks       = _brickName;
+    info.brickScale.W = float( _w ) / float( brickSize * calcMinPow2( bW ));
+    info.brickScale.H = float( _h ) / float( brickSize * calcMinPow2( bH ));
+    info.brickScale.D = float( _d ) / float( brickSize * calcMinPow2( bD ));
+    info.skipped      = 1.f - float( box.nVisible ) /
+                              float(( last - first + 1 ) * bW * bH );
+
+    if( box.nVisible == 0 )
+    {
+        info.boxMin = eq::Vector3f( -1.f, -1.f, zRs );
+        info.boxMax = info.boxMin;
+        return;
+    }
+
+    const float fW = 2.f / float( _w );
+    const float fH = 2.f / float( _h );
+    const float fD = 2.f / float( _d );
+    info.boxMin = eq::Vector3f(
+        -1.f + fW * float( box.x0 * brickSize ),
+        -1.f + fH * float( box.y0 * brickSize ),
+        LB_MAX( zRs, -1.f + fD * float( z0 * brickSize )));
+    info.boxMax = eq::Vector3f(
+        -1.f + fW * float( LB_MIN( (box.x1+1) * brickSize, _w )),
+        -1.f + fH * float( LB_MIN( (box.y1+1) * brickSize, _h )),
+        LB_MIN( zRe, -1.f + fD * float( LB_MIN( (z1+1) * brickSize, _d ))));
 }
 
 
@@ -29,7 +29,11 @@
 #ifndef EVOLVE_RAW_VOL_MODEL_H
 #define EVOLVE_RAW_VOL_MODEL_H
 
+#include "brickGrid.h"
+#include "slabRing.h"
+
 #include <eq/eq.h>
+#include <lunchbox/memoryMap.h>
 
 namespace eVolve
 {
@@ -47,7 +51,8 @@ namespace eVolve
         Zn = Db + (Z - Do) * D
 
         so X and Y just scaled, but Z should be modifyed according to
-        proper range.
+        proper range. The depth of the texture wraps around, Zmin and Zmax
+        are the texture depths of the first and last voxel of the volume.
     */
     struct DataInTextureDimensions
     {
@@ -56,6 +61,8 @@ namespace eVolve
         float D;    //!< Depth  of data in texture (0..1]
         float Do;   //!< Depth offset (start of range)
         float Db;   //!< Depth border (necessary for preintegration)
+        float Zmin; //!< Depth of the first voxel center
+        float Zmax; //!< Depth of the last voxel center
     };
 
     /** Contain overall volume proportions relatively [-1,-1,-1]..[1,1,1] cube
@@ -75,9 +82,28 @@ namespace eVolve
         VolumeScaling           volScaling; //!< Proportions of volume
         VolumeScaling           voxelSize;  //!< Relative volume size (0..1]
         DataInTextureDimensions TD; //!< Data dimensions within volume texture
+
+        GLuint                  bricks;     //!< brick visibility texture
+        VolumeScaling           brickScale; //!< Volume to brick texture scale
+        eq::Vector3f            boxMin;     //!< Visible part of range, min
+        eq::Vector3f            boxMax;     //!< Visible part of range, max
+        float                   skipped;    //!< Empty fraction of range
     };
 
-    /** Load model to texture */
+    /** Load model to texture.
+
+        The volume file is memory mapped and cut into fixed-size slabs along
+        z. The slabs are kept in a 3D texture used as a ring buffer, slab s
+        lives in slot s % nSlots. A range change only uploads the slabs which
+        are not resident yet, the texture is only reallocated if the union
+        of the recently used ranges grows beyond the capacity of the ring.
+
+        For empty space skipping the volume is also divided into bricks with
+        the minimum and maximum value of each brick. A brick is invisible if
+        the transfer function is transparent for all its values. A new
+        transfer function only reclassifies the bricks, the volume texture is
+        kept.
+    */
     class RawVolumeModel
     {
     public:
@@ -87,7 +113,8 @@ namespace eVolve
 
         bool getVolumeInfo( VolumeInfo& info, const eq::Range& range );
 
-        void releaseVolumeInfo( const eq::Range& range );
+        /** Set a new transfer function, 256 RGBA values */
+        void setTransferFunction( const std::vector< uint8_t >& TF );
 
         const std::string&   getFileName()      const { return _filename;    }
               uint32_t       getResolution()    const { return _resolution;  }
@@ -100,18 +127,16 @@ namespace eVolve
 
     protected:
 
-        bool _createVolumeTexture(    GLuint&                  volume,
-                                      DataInTextureDimensions& TD,
-                                const eq::Range&               range );
+        bool _updateVolumeTexture( DataInTextureDimensions& TD,
+                                   const eq::Range&         range );
 
     private:
-        struct VolumePart
-        {
-            GLuint                  volume; //!< 3D texture ID
-            DataInTextureDimensions TD;     //!< Data dimensions within volume
-        };
+        bool _mapVolume();
+        void _allocateVolumeTexture( uint32_t nSlots );
+        void _uploadSlab( uint32_t slab );
 
-        stde::hash_map< int32_t, VolumePart > _volumeHash; //!< 3D textures info
+        void _updateBrickVisibility();
+        void _getVisibleBox( VolumeInfo& info, const eq::Range& range ) const;
 
         bool         _headerLoaded;     //!< header is loaded successfully
         std::string  _filename;         //!< name of volume data file
@@ -124,6 +149,7 @@ namespace eVolve
         uint32_t     _tW;               //!< volume texture width
         uint32_t     _tH;               //!< volume texture height
         uint32_t     _tD;               //!< volume texture depth
+        uint32_t     _bytes;            //!< bytes per voxel
         uint32_t     _resolution;       //!< max( _w, _h, _d ) of a model
 
         VolumeScaling _volScaling;      //!< Proportions of volume
@@ -132,6 +158,17 @@ namespace eVolve
 
         bool _hasDerivatives;           //!< true if raw+der used
 
+        lunchbox::MemoryMap     _volumeMap;  //!< host copy of the volume
+        const uint8_t*          _volumeData; //!< mapped volume data
+
+        GLuint                  _volumeName; //!< 3D texture of slab ring
+        uint32_t                _slabDepth;  //!< slices per slab
+        SlabRing                _slabs;      //!< resident slab per slot
+
+        BrickGrid               _bricks;      //!< brick min/max grid
+        GLuint                  _brickName;   //!< brick visibility texture
+        bool                    _tfChanged;   //!< preint and bricks outdated
+
         const GLEWContext*   _glewContext;    //!< OpenGL function table
     };
 
@@ -42,13 +42,14 @@ RawVolumeModelRenderer::RawVolumeModelRenderer( const std::string& filename,
     , _precision( precision )
     , _glewContext( 0 )
     , _ortho( false )
+    , _skipped( 0.f )
 {
 }
 
 
 static void renderSlices( const SliceClipper& sliceClipper )
 {
-    int numberOfSlices = static_cast<int>( 3.6 / sliceClipper.sliceDistance );
+    const int numberOfSlices = sliceClipper.numberOfSlices;
 
     for( int s = 0; s < numberOfSlices; ++s )
     {
@@ -95,7 +96,20 @@ void RawVolumeModelRenderer::_putVolumeDataToShader(
     tParamNameGL = glGetUniformLocationARB( shader, "Db" );
     glUniform1fARB( tParamNameGL, TD.Db );
 
+    tParamNameGL = glGetUniformLocationARB( shader, "depthClamp" );
+    glUniform2fARB( tParamNameGL, TD.Zmin, TD.Zmax ); //f-shader
+
+    tParamNameGL = glGetUniformLocationARB( shader, "brickScale" );
+    glUniform3fARB( tParamNameGL, volumeInfo.brickScale.W,
+                                  volumeInfo.brickScale.H,
+                                  volumeInfo.brickScale.D ); //v-shader
+
     // Put Volume data to the shader
+    glActiveTextureARB( GL_TEXTURE2 );
+    glBindTexture( GL_TEXTURE_3D, volumeInfo.bricks ); //visible bricks
+    tParamNameGL = glGetUniformLocationARB( shader, "bricks" );
+    glUniform1iARB( tParamNameGL,  2    ); //f-shader
+
     glActiveTextureARB( GL_TEXTURE1 );
     glBindTexture( GL_TEXTURE_2D, volumeInfo.preint ); //preintegrated values
     tParamNameGL = glGetUniformLocationARB( shader, "preInt" );
@@ -157,6 +171,10 @@ bool RawVolumeModelRenderer::render( const eq::Range& range,
         return false;
     }
 
+    _skipped = volumeInfo.skipped;
+    if( _skipped >= 1.f ) // nothing visible in range
+        return true;
+
     glScalef( volumeInfo.volScaling.W,
               volumeInfo.volScaling.H,
               volumeInfo.volScaling.D );
@@ -172,7 +190,8 @@ bool RawVolumeModelRenderer::render( const eq::Range& range,
     _putVolumeDataToShader( volumeInfo, float( sliceDistance ),
                             invRotationM, taintColor, normalsQuality );
 
-    _sliceClipper.updatePerFrameInfo( modelviewM, sliceDistance, range );
+    _sliceClipper.updatePerFrameInfo( modelviewM, sliceDistance,
+                                      volumeInfo.boxMin, volumeInfo.boxMax );
 
     //Render slices
     glEnable( GL_BLEND );
@@ -66,6 +66,9 @@ public:
                  const eq::Vector4f&  taintColor,
                  const int            normalsQuality );
 
+    /** @return the fraction of the last rendered range skipped as empty */
+    float getSkippedFraction() const { return _skipped; }
+
     void setPrecision( const uint32_t precision ){ _precision = precision; }
     void setOrtho( const uint32_t ortho )        { _ortho = ortho; }
 
@@ -87,6 +90,7 @@ private:
     const GLEWContext*    _glewContext;   //!< OpenGL function table
 
     bool            _ortho;         //!< ortogonal/perspective projection
+    float           _skipped;       //!< empty fraction of last range
 
 };
 
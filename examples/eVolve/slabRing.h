@@ -0,0 +1,168 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVOLVE_SLAB_RING_H
+#define EVOLVE_SLAB_RING_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace eVolve
+{
+
+    /** Bookkeeping of the slabs resident in the ring of a volume texture.
+
+        Slab s lives in slot s % nSlots, which keeps the texture depth
+        wrapping around the whole volume. All channels using a model share
+        one ring, so the ring is sized for the union of the slab ranges
+        requested recently. Channels with different ranges then no longer
+        evict each other's slabs. Ranges which have not been requested for
+        maxAge updates are dropped from the union.
+    */
+    class SlabRing
+    {
+    public:
+        explicit SlabRing( const uint32_t maxAge = 8 )
+            : _nSlabs( 0 ), _maxAge( maxAge ), _time( 0 ) {}
+
+        /** Set the number of slabs of the volume, invalidates the ring. */
+        void setNSlabs( const uint32_t nSlabs )
+        {
+            _nSlabs = nSlabs;
+            _active.clear();
+            _slots.clear();
+            _uploads.clear();
+        }
+
+        /** Make the slabs [first, last] resident.
+
+            @return true if the ring has to be reallocated with getNSlots()
+                    slots, false if the existing ring is kept. In both cases
+                    getUploads() lists the slabs to copy into their slot.
+        */
+        bool update( const uint32_t first, const uint32_t last )
+        {
+            ++_time;
+            _touch( first, last );
+
+            uint32_t lo = first;
+            uint32_t hi = last;
+            for( size_t i = 0; i < _active.size(); ++i )
+            {
+                lo = std::min( lo, _active[i].first );
+                hi = std::max( hi, _active[i].last );
+            }
+
+            bool reallocate = false;
+            const uint32_t span = hi - lo + 1;
+            if( _slots.empty() || span > _slots.size( ))
+            {
+                // leave room for one slab on each side to absorb small
+                // range changes
+                _slots.assign( std::min( _pow2( span + 2 ),
+                                         _pow2( _nSlabs )), -1 );
+                reallocate = true;
+            }
+
+            _uploads.clear();
+            for( uint32_t i = first; i <= last; ++i )
+            {
+                int32_t& slab = _slots[ getSlot( i )];
+                if( slab == int32_t( i ))
+                    continue;
+                slab = i;
+                _uploads.push_back( i );
+            }
+            return reallocate;
+        }
+
+        /** @return the slabs to upload after the last update(). */
+        const std::vector< uint32_t >& getUploads() const { return _uploads; }
+
+        /** @return the number of slots of the ring. */
+        uint32_t getNSlots() const { return uint32_t( _slots.size( )); }
+
+        /** @return the slot of the given slab. */
+        uint32_t getSlot( const uint32_t slab ) const
+            { return slab % uint32_t( _slots.size( )); }
+
+    private:
+        struct Interval
+        {
+            uint32_t first;
+            uint32_t last;
+            uint32_t used; //!< update time of the last request
+        };
+
+        uint32_t _nSlabs;
+        const uint32_t _maxAge;
+        uint32_t _time;
+
+        std::vector< Interval > _active; //!< recently requested ranges
+        std::vector< int32_t >  _slots;  //!< resident slab per slot
+        std::vector< uint32_t > _uploads;
+
+        void _touch( const uint32_t first, const uint32_t last )
+        {
+            bool found = false;
+            for( size_t i = 0; i < _active.size(); )
+            {
+                Interval& interval = _active[i];
+                if( interval.first == first && interval.last == last )
+                {
+                    interval.used = _time;
+                    found = true;
+                }
+                if( _time - interval.used > _maxAge )
+                {
+                    interval = _active.back();
+                    _active.pop_back();
+                }
+                else
+                    ++i;
+            }
+            if( !found )
+            {
+                const Interval interval = { first, last, _time };
+                _active.push_back( interval );
+            }
+        }
+
+        static uint32_t _pow2( uint32_t size )
+        {
+            uint32_t res = 1;
+            while( res < size )
+                res <<= 1;
+            return res;
+        }
+    };
+
+}
+
+#endif // EVOLVE_SLAB_RING_H
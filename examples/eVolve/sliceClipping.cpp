@@ -74,28 +74,31 @@ SliceClipper::SliceClipper()
     , frontIndex( 0 )
     , sliceDistance( 0 )
     , planeStart( 0 )
+    , numberOfSlices( 0 )
 {
 }
 
 void SliceClipper::updatePerFrameInfo( const eq::Matrix4f& modelviewM,
                                        const double newSliceDistance,
-                                       const eq::Range& range
+                                       const eq::Vector3f& boxMin,
+                                       const eq::Vector3f& boxMax
 )
 {
-    double zRs = -1+2.*range.start;
-    double zRe = -1+2.*range.end;
+    const float xS = boxMin.x(), xE = boxMax.x();
+    const float yS = boxMin.y(), yE = boxMax.y();
+    const float zS = boxMin.z(), zE = boxMax.z();
 
     //rendering parallelepipid's verteces
     eq::Vector4f vertices[8];
-    vertices[0] = eq::Vector4f(-1.0,-1.0,zRs, 1.0);
-    vertices[1] = eq::Vector4f( 1.0,-1.0,zRs, 1.0);
-    vertices[2] = eq::Vector4f(-1.0, 1.0,zRs, 1.0);
-    vertices[3] = eq::Vector4f( 1.0, 1.0,zRs, 1.0);
+    vertices[0] = eq::Vector4f( xS, yS, zS, 1.0 );
+    vertices[1] = eq::Vector4f( xE, yS, zS, 1.0 );
+    vertices[2] = eq::Vector4f( xS, yE, zS, 1.0 );
+    vertices[3] = eq::Vector4f( xE, yE, zS, 1.0 );
 
-    vertices[4] = eq::Vector4f(-1.0,-1.0,zRe, 1.0);
-    vertices[5] = eq::Vector4f( 1.0,-1.0,zRe, 1.0);
-    vertices[6] = eq::Vector4f(-1.0, 1.0,zRe, 1.0);
-    vertices[7] = eq::Vector4f( 1.0, 1.0,zRe, 1.0);
+    vertices[4] = eq::Vector4f( xS, yS, zE, 1.0 );
+    vertices[5] = eq::Vector4f( xE, yS, zE, 1.0 );
+    vertices[6] = eq::Vector4f( xS, yE, zE, 1.0 );
+    vertices[7] = eq::Vector4f( xE, yE, zE, 1.0 );
 
     for( int i=0; i<8; i++ )
         for( int j=0; j<3; j++)
@@ -127,6 +130,11 @@ void SliceClipper::updatePerFrameInfo( const eq::Matrix4f& modelviewM,
     planeStart  = viewVec.dot( vertices[nSequence[frontIndex][0]] );
     double dS   = ceil( planeStart/sliceDistance );
     planeStart  = dS * sliceDistance;
+
+    // slices are aligned to multiples of the slice distance, independent of
+    // the box, so only the slices intersecting the box need to be drawn
+    numberOfSlices = maxDist < planeStart ? 0 :
+                     int(( maxDist - planeStart ) / sliceDistance ) + 1;
 }
 
 
@@ -44,9 +44,12 @@ struct SliceClipper
 
     typedef eq::Vector3f float3;
 
+    /** Set up the slices through the box [boxMin, boxMax] within the
+        [-1,-1,-1]..[1,1,1] volume cube. */
     void updatePerFrameInfo( const eq::Matrix4f& modelviewM,
                              const double sliceDistance,
-                             const eq::Range& range );
+                             const eq::Vector3f& boxMin,
+                             const eq::Vector3f& boxMax );
 
     eq::Vector3f getPosition
     (
@@ -60,6 +63,7 @@ struct SliceClipper
     int             frontIndex;
     double          sliceDistance;
     double          planeStart;
+    int             numberOfSlices;
 };
 
 }
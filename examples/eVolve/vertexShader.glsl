@@ -38,6 +38,7 @@ uniform float   H;   //scale for y
 uniform float   D;   //scale for z
 uniform float   Do;  //shift of z
 uniform float   Db;  //z offset 
+uniform vec3    brickScale; //volume to brick texture coordinates
 
 void main(void)
 {
@@ -59,6 +60,10 @@ void main(void)
     //compute texture coordinates for virtual back vertex
     gl_TexCoord[1] = 0.5 * gl_TexCoord[1] + 0.5;
 
+    //brick of the middle of the sampled segment, for empty space skipping
+    gl_TexCoord[2] = vec4( 0.5 * ( gl_TexCoord[0].xyz + gl_TexCoord[1].xyz ) *
+                           brickScale, 1.0 );
+
 
 //Scaling of texture coordinates
     gl_TexCoord[0].x  *= W;
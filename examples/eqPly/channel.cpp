@@ -61,6 +61,7 @@ namespace eqPly
 Channel::Channel( eq::Window* parent )
         : eq::Channel( parent )
         , _model(0)
+        , _drawRange( eq::Range::ALL )
         , _frameRestart( 0 )
 {
 }
@@ -125,8 +126,14 @@ void Channel::frameDraw( const eq::uint128_t& frameID )
     if( oldModel != model )
         state.setFrustumCulling( false ); // create all display lists/VBOs
 
+    Config* config = static_cast< Config* >( getConfig( ));
+    const eq::Range range = getRange();
     if( model )
+    {
+        config->loadModelRange( _modelID, range );
+        _drawRange = range;
         _updateNearFar( model->getBoundingSphere( ));
+    }
 
     eq::Channel::frameDraw( frameID ); // Setup OpenGL state
 
@@ -159,7 +166,10 @@ void Channel::frameDraw( const eq::uint128_t& frameID )
         glColor3f( .75f, .75f, .75f );
 
     if( model )
+    {
         _drawModel( model );
+        config->releaseModelRange( _modelID, range );
+    }
     else
     {
         glNormal3f( 0.f, -1.f, 0.f );
@@ -270,6 +280,13 @@ void Channel::frameStart( const eq::uint128_t& frameID,
     for( size_t i = 0; i < eq::NUM_EYES; ++i )
         _accum[ i ].stepsDone = 0;
 
+    // request the geometry of the last range while the frame starts
+    if( _model )
+    {
+        Config* config = static_cast< Config* >( getConfig( ));
+        config->prefetchModelRange( _modelID, _drawRange );
+    }
+
     eq::Channel::frameStart( frameID, frameNumber );
 }
 
@@ -598,19 +615,35 @@ void Channel::_drawModel( const Model* scene )
     state.setProjectionModelViewMatrix( projection * view * model );
     state.setRange( triply::Range( &getRange().start ));
 
+    const InitData& initData =
+        static_cast<Config*>( getConfig( ))->getInitData();
+    const eq::PixelViewport& pvp = getPixelViewport();
+    state.setViewportSize( float( pvp.w ), float( pvp.h ));
+    state.setLODThreshold( initData.getLODThreshold( ));
+
     const eq::Pipe* pipe = getPipe();
     const GLuint program = state.getProgram( pipe );
+    state.setOctNormals( program != VertexBufferState::INVALID &&
+                         scene->isCompact() &&
+                         state.getRenderMode() ==
+                             triply::RENDER_MODE_BUFFER_OBJECT );
     if( program != VertexBufferState::INVALID )
+    {
         glUseProgram( program );
+        glUniform1i( glGetUniformLocation( program, "octNormals" ),
+                     state.useOctNormals( ));
+    }
 
-    scene->cullDraw( state );
+    {
+        eq::ChannelStatistics event( eq::Statistic::CHANNEL_CULL, this );
+        scene->cull( state, _drawList );
+    }
+    scene->draw( state, _drawList );
 
     state.setChannel( 0 );
     if( program != VertexBufferState::INVALID )
         glUseProgram( 0 );
 
-    const InitData& initData =
-        static_cast<Config*>( getConfig( ))->getInitData();
     if( initData.useROI( ))
         // declare empty region in case nothing is in frustum
         declareRegion( eq::PixelViewport( ));
@@ -83,6 +83,8 @@ private:
 
     const Model* _model;
     eq::uint128_t _modelID;
+    eq::Range _drawRange; // of the last frameDraw, prefetched on frameStart
+    triply::DrawList _drawList;
     uint32_t _frameRestart;
 
     struct Accum
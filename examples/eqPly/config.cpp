@@ -55,16 +55,17 @@ Config::Config( eq::ServerPtr parent )
 
 Config::~Config()
 {
-    for( ModelsCIter i = _models.begin(); i != _models.end(); ++i )
-        delete *i;
-    _models.clear();
-
+    // distributors first, they finish pending chunk mappings into the models
     for( ModelDistsCIter i = _modelDist.begin(); i != _modelDist.end(); ++i )
     {
         LBASSERT( !(*i)->isAttached() );
         delete *i;
     }
     _modelDist.clear();
+
+    for( ModelsCIter i = _models.begin(); i != _models.end(); ++i )
+        delete *i;
+    _models.clear();
 }
 
 bool Config::init()
@@ -147,6 +148,8 @@ void Config::_loadModels()
 
             if( _initData.useInvertedFaces() )
                 model->useInvertedFaces();
+            if( _initData.useCompactLeaves( ))
+                model->useCompactLeaves();
 
             if( !model->readFromFile( filename.c_str( )))
             {
@@ -184,7 +187,8 @@ void Config::_registerModels()
         ModelDist* modelDist = 0;
         if( createDist )
         {
-            modelDist = new ModelDist( model );
+            modelDist = new ModelDist( model,
+                                       _initData.useChunkedDistribution( ));
             _modelDist.push_back( modelDist );
         }
         else
@@ -259,6 +263,44 @@ const Model* Config::getModel( const eq::uint128_t& modelID )
     return model;
 }
 
+void Config::loadModelRange( const eq::uint128_t& modelID,
+                             const eq::Range& range )
+{
+    ModelDist* modelDist = _findModelDist( modelID );
+    if( modelDist )
+        modelDist->loadRange( triply::Range( &range.start ));
+}
+
+void Config::releaseModelRange( const eq::uint128_t& modelID,
+                                const eq::Range& range )
+{
+    ModelDist* modelDist = _findModelDist( modelID );
+    if( modelDist )
+        modelDist->releaseRange( triply::Range( &range.start ));
+}
+
+void Config::prefetchModelRange( const eq::uint128_t& modelID,
+                                 const eq::Range& range )
+{
+    ModelDist* modelDist = _findModelDist( modelID );
+    if( modelDist )
+        modelDist->prefetchRange( triply::Range( &range.start ));
+}
+
+ModelDist* Config::_findModelDist( const eq::uint128_t& modelID )
+{
+    // The model dists synchronize their ranges themselves, protect only the
+    // list against getModel() of other pipe threads
+    const eq::Node* node = getNodes().front();
+    const bool needModelLock = (node->getPipes().size() > 1);
+    lunchbox::ScopedWrite _mutex( needModelLock ? &_modelLock : 0 );
+
+    for( ModelDistsCIter i = _modelDist.begin(); i != _modelDist.end(); ++i )
+        if( (*i)->getID() == modelID )
+            return *i;
+    return 0;
+}
+
 uint32_t Config::startFrame()
 {
     _updateData();
@@ -70,6 +70,19 @@ public:
     /** @return the requested, default model or 0. */
     const Model* getModel( const eq::uint128_t& id );
 
+    /**
+     * Map the geometry of a model range, if distributed in chunks.
+     *
+     * The geometry stays resident until released by releaseModelRange().
+     */
+    void loadModelRange( const eq::uint128_t& id, const eq::Range& range );
+
+    /** Release a model range loaded by loadModelRange(). */
+    void releaseModelRange( const eq::uint128_t& id, const eq::Range& range );
+
+    /** Start mapping the geometry of a model range without waiting. */
+    void prefetchModelRange( const eq::uint128_t& id, const eq::Range& range );
+
     /** @sa eq::Config::handleEvent */
     virtual bool handleEvent( const eq::ConfigEvent* event );
     virtual bool handleEvent( eq::EventICommand command );
@@ -115,6 +128,7 @@ private:
 
     void _loadModels();
     void _registerModels();
+    ModelDist* _findModelDist( const eq::uint128_t& modelID );
     void _loadPath();
     void _deregisterData();
 
@@ -58,6 +58,8 @@ InitData::InitData()
     , _invFaces( false )
     , _logo( true )
     , _roi ( true )
+    , _lodThreshold( 0.f )
+    , _compact( false )
 {}
 
 InitData::~InitData()
@@ -68,13 +70,13 @@ InitData::~InitData()
 void InitData::getInstanceData( co::DataOStream& os )
 {
     os << _frameDataID << _windowSystem << _renderMode << _useGLSL << _invFaces
-       << _logo << _roi;
+       << _logo << _roi << _lodThreshold << _compact;
 }
 
 void InitData::applyInstanceData( co::DataIStream& is )
 {
     is >> _frameDataID >> _windowSystem >> _renderMode >> _useGLSL >> _invFaces
-       >> _logo >> _roi;
+       >> _logo >> _roi >> _lodThreshold >> _compact;
     LBASSERT( _frameDataID != 0 );
 }
 
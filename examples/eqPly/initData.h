@@ -50,6 +50,8 @@ namespace eqPly
         bool               useInvertedFaces() const { return _invFaces; }
         bool               showLogo() const         { return _logo; }
         bool               useROI() const           { return _roi; }
+        float              getLODThreshold() const  { return _lodThreshold; }
+        bool               useCompactLeaves() const { return _compact; }
 
     protected:
         virtual void getInstanceData( co::DataOStream& os );
@@ -63,6 +65,8 @@ namespace eqPly
         void enableInvertedFaces() { _invFaces = true; }
         void disableLogo()         { _logo     = false; }
         void disableROI()          { _roi      = false; }
+        void setLODThreshold( const float pixels ) { _lodThreshold = pixels; }
+        void enableCompactLeaves() { _compact  = true; }
 
     private:
         eq::uint128_t      _frameDataID;
@@ -72,6 +76,8 @@ namespace eqPly
         bool               _invFaces;
         bool               _logo;
         bool               _roi;
+        float              _lodThreshold;
+        bool               _compact;
     };
 }
 
@@ -48,6 +48,7 @@ LocalInitData::LocalInitData()
     , _maxFrames( 0xffffffffu )
     , _color( true )
     , _isResident( false )
+    , _chunked( false )
 {
     _filenames.push_back( lunchbox::getRootPath() +
                           "/share/Equalizer/data" );
@@ -58,6 +59,7 @@ LocalInitData& LocalInitData::operator = ( const LocalInitData& from )
     _maxFrames   = from._maxFrames;
     _color       = from._color;
     _isResident  = from._isResident;
+    _chunked     = from._chunked;
     _filenames    = from._filenames;
     _pathFilename = from._pathFilename;
 
@@ -71,6 +73,9 @@ LocalInitData& LocalInitData::operator = ( const LocalInitData& from )
         disableLogo();
     if( !from.useROI( ))
         disableROI();
+    setLODThreshold( from.getLODThreshold( ));
+    if( from.useCompactLeaves( ))
+        enableCompactLeaves();
 
     return *this;
 }
@@ -101,6 +106,8 @@ void LocalInitData::parseArguments( const int argc, char** argv )
     bool userDefinedInvertFaces( false );
     bool userDefinedDisableLogo( false );
     bool userDefinedDisableROI( false );
+    float userDefinedLODThreshold( 0.f );
+    bool userDefinedCompactLeaves( false );
 
     const std::string& desc = EqPly::getHelp();
     po::options_description options( desc + " Version " +
@@ -136,7 +143,17 @@ void LocalInitData::parseArguments( const int argc, char** argv )
           "Disable overlay logo" )
         ( "disableROI,d",
           po::bool_switch(&userDefinedDisableROI)->default_value( false ),
-          "Disable region of interest (ROI)" );
+          "Disable region of interest (ROI)" )
+        ( "lod,l", po::value<float>( &userDefinedLODThreshold ),
+          "Draw simplified subtrees up to this error in pixels (default: 0,"
+          " always draw the full model)" )
+        ( "compact,k",
+          po::bool_switch(&userDefinedCompactLeaves)->default_value( false ),
+          "Use quantized, vertex cache optimized leaves (valid during binary"
+          " file creation)" )
+        ( "chunked", po::bool_switch(&_chunked)->default_value( false ),
+          "Distribute the model geometry in chunks, mapped by the render"
+          " clients for their range" );
 
     po::variables_map variableMap;
 
@@ -202,6 +219,12 @@ void LocalInitData::parseArguments( const int argc, char** argv )
 
     if( userDefinedDisableROI )
         disableROI();
+
+    if( variableMap.count("lod") > 0 )
+        setLODThreshold( userDefinedLODThreshold );
+
+    if( userDefinedCompactLeaves )
+        enableCompactLeaves();
 }
 
 }
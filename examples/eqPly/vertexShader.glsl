@@ -32,11 +32,26 @@
 varying vec3 normalEye;
 varying vec4 positionEye;
 
+// compact models pass octahedral encoded normals in gl_Normal.xy
+uniform bool octNormals;
+
+vec3 decodeNormal( vec2 encoded )
+{
+    vec3 normal = vec3( encoded, 1.0 - abs( encoded.x ) - abs( encoded.y ));
+    if( normal.z < 0.0 )
+        normal.xy = ( 1.0 - abs( normal.yx )) *
+                    vec2( normal.x >= 0.0 ? 1.0 : -1.0,
+                          normal.y >= 0.0 ? 1.0 : -1.0 );
+    return normal;
+}
+
 
 void main()
 {
+    vec3 normal = octNormals ? decodeNormal( gl_Normal.xy ) : gl_Normal;
+
     // transform normal to eye coordinates
-    normalEye = normalize( gl_NormalMatrix * gl_Normal );
+    normalEye = normalize( gl_NormalMatrix * normal );
     
     // transform position to eye coordinates
     positionEye = normalize( gl_ModelViewMatrix * gl_Vertex );
@@ -0,0 +1,602 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "plyReader.h"
+#include "ply.h"
+#include "vertexData.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace triply
+{
+/*  Determine whether the current architecture is little endian or not.  */
+bool isArchitectureLittleEndian();
+
+namespace
+{
+// data per ASCII parse task, large enough to amortize the line scan
+const size_t _chunkSize = 4 * 1024 * 1024;
+
+int _getType( const std::string& name )
+{
+    if( name == "char" || name == "int8" )
+        return PLY_CHAR;
+    if( name == "uchar" || name == "uint8" )
+        return PLY_UCHAR;
+    if( name == "short" || name == "int16" )
+        return PLY_SHORT;
+    if( name == "ushort" || name == "uint16" )
+        return PLY_USHORT;
+    if( name == "int" || name == "int32" )
+        return PLY_INT;
+    if( name == "uint" || name == "uint32" )
+        return PLY_UINT;
+    if( name == "float" || name == "float32" )
+        return PLY_FLOAT;
+    if( name == "double" || name == "float64" )
+        return PLY_DOUBLE;
+    return 0;
+}
+
+size_t _getSize( const int type )
+{
+    switch( type )
+    {
+    case PLY_CHAR: case PLY_UCHAR:   return 1;
+    case PLY_SHORT: case PLY_USHORT: return 2;
+    case PLY_INT: case PLY_UINT: case PLY_FLOAT: return 4;
+    case PLY_DOUBLE: return 8;
+    default: return 0;
+    }
+}
+
+template< class T > T _get( const char* data, const bool swap )
+{
+    T value;
+    if( swap )
+    {
+        char* bytes = reinterpret_cast< char* >( &value );
+        std::reverse_copy( data, data + sizeof( T ), bytes );
+    }
+    else
+        memcpy( &value, data, sizeof( T ));
+    return value;
+}
+
+double _getValue( const char* data, const int type, const bool swap )
+{
+    switch( type )
+    {
+    case PLY_CHAR:   return *reinterpret_cast< const int8_t* >( data );
+    case PLY_UCHAR:  return *reinterpret_cast< const uint8_t* >( data );
+    case PLY_SHORT:  return _get< int16_t >( data, swap );
+    case PLY_USHORT: return _get< uint16_t >( data, swap );
+    case PLY_INT:    return _get< int32_t >( data, swap );
+    case PLY_UINT:   return _get< uint32_t >( data, swap );
+    case PLY_FLOAT:  return _get< float >( data, swap );
+    case PLY_DOUBLE: return _get< double >( data, swap );
+    default:         return 0.;
+    }
+}
+
+bool _isSpace( const char c )
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/*  @return the start of the next line with data, or end.  */
+const char* _nextLine( const char* data, const char* end )
+{
+    while( data < end && *data != '\n' )
+        ++data;
+    while( data < end && _isSpace( *data ))
+        ++data;
+    return data;
+}
+
+/*  @return the number of non-empty lines starting in [begin, end).  */
+size_t _countLines( const char* begin, const char* end, const char* limit )
+{
+    size_t lines = 0;
+    for( const char* line = begin; line < end; line = _nextLine( line, limit ))
+        ++lines;
+    return lines;
+}
+
+/*  Parse the next token of a line ending before end, advances data past it.
+    The mapped file is not NUL-terminated, the token is parsed from a copy. */
+bool _parse( const char*& data, const char* const end, double& value )
+{
+    while( data < end && ( *data == ' ' || *data == '\t' ))
+        ++data;
+
+    const char* const token = data;
+    while( data < end && !_isSpace( *data ))
+        ++data;
+
+    char buffer[ 64 ];
+    const size_t length = data - token;
+    if( length == 0 || length >= sizeof( buffer )) // end of line or garbage
+        return false;
+
+    ::memcpy( buffer, token, length );
+    buffer[ length ] = 0;
+    char* next = 0;
+    value = strtod( buffer, &next );
+    return next == buffer + length;
+}
+
+/*  @return true if value is a valid index into nVertices vertices.  */
+bool _isIndex( const double value, const size_t nVertices )
+{
+    return value >= 0. && value < double( nVertices );
+}
+}
+
+PlyReader::PlyReader( const std::string& filename )
+    : _data( 0 )
+    , _size( 0 )
+    , _body( 0 )
+    , _format( FORMAT_ASCII )
+    , _supported( false )
+    , _vertexElement( 0 )
+    , _faceElement( 0 )
+{
+#ifndef _WIN32
+    const int fd = open( filename.c_str(), O_RDONLY );
+    if( fd < 0 )
+        return;
+
+    struct stat status;
+    if( fstat( fd, &status ) == 0 && status.st_size > 0 )
+    {
+        void* data = mmap( 0, status.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+        if( data != MAP_FAILED )
+        {
+            madvise( data, status.st_size, MADV_SEQUENTIAL );
+            _data = static_cast< const char* >( data );
+            _size = status.st_size;
+        }
+    }
+    close( fd );
+
+    if( _data )
+        _supported = _parseHeader();
+#else
+    (void)filename; // use the generic reader
+#endif
+}
+
+PlyReader::~PlyReader()
+{
+#ifndef _WIN32
+    if( _data )
+        munmap( const_cast< char* >( _data ), _size );
+#endif
+}
+
+/*  Parse the header, and check that the layout is one we can read.  */
+bool PlyReader::_parseHeader()
+{
+    const char* const end = _data + _size;
+    const char* line = _data;
+    bool vertex = false;
+    bool face = false;
+
+    for( bool first = true; ; first = false )
+    {
+        const char* eol = static_cast< const char* >(
+            memchr( line, '\n', end - line ));
+        if( !eol )
+            return false;
+
+        std::istringstream words( std::string( line, eol ));
+        std::string keyword;
+        words >> keyword;
+        line = eol + 1;
+
+        if( first )
+        {
+            if( keyword != "ply" )
+                return false;
+        }
+        else if( keyword == "format" )
+        {
+            std::string format;
+            words >> format;
+            if( format == "ascii" )
+                _format = FORMAT_ASCII;
+            else if( format == "binary_little_endian" )
+                _format = FORMAT_BINARY_LE;
+            else if( format == "binary_big_endian" )
+                _format = FORMAT_BINARY_BE;
+            else
+                return false;
+        }
+        else if( keyword == "element" )
+        {
+            Element element;
+            words >> element.name >> element.count;
+            if( !words )
+                return false;
+            element.size = 0;
+            if( element.name == "vertex" )
+            {
+                vertex = true;
+                _vertexElement = _elements.size();
+            }
+            else if( element.name == "face" )
+            {
+                face = true;
+                _faceElement = _elements.size();
+            }
+            _elements.push_back( element );
+        }
+        else if( keyword == "property" )
+        {
+            if( _elements.empty( ))
+                return false;
+
+            Element& element = _elements.back();
+            Property property;
+            std::string type;
+            words >> type;
+            if( type == "list" )
+            {
+                std::string countType;
+                words >> countType >> type;
+                property.countType = _getType( countType );
+                if( property.countType == 0 ||
+                    property.countType == PLY_FLOAT ||
+                    property.countType == PLY_DOUBLE )
+                {
+                    return false;
+                }
+            }
+            else
+                property.countType = 0;
+
+            words >> property.name;
+            property.type = _getType( type );
+            if( !words || property.type == 0 )
+                return false;
+            property.offset = element.size;
+            if( property.countType == 0 )
+                element.size += _getSize( property.type );
+            element.properties.push_back( property );
+        }
+        else if( keyword == "end_header" )
+            break;
+        // else comment, obj_info or unknown: ignore
+    }
+    _body = line - _data;
+
+    if( !vertex || !face )
+        return false;
+
+    // vertices need x, y and z scalars
+    const Element& vertices = _elements[ _vertexElement ];
+    size_t found = 0;
+    for( size_t i = 0; i < vertices.properties.size(); ++i )
+    {
+        const Property& property = vertices.properties[i];
+        if( property.countType != 0 )
+            return false;
+        if( property.name == "x" || property.name == "y" ||
+            property.name == "z" )
+        {
+            ++found;
+        }
+    }
+    if( found != 3 )
+        return false;
+
+    // faces need to be a single list of integer indices
+    const Element& faces = _elements[ _faceElement ];
+    if( faces.properties.size() != 1 ||
+        faces.properties[0].countType == 0 ||
+        faces.properties[0].type == PLY_FLOAT ||
+        faces.properties[0].type == PLY_DOUBLE )
+    {
+        return false;
+    }
+
+    if( _format == FORMAT_ASCII )
+    {
+        // the last number has to be terminated before the end of the mapping
+        return _isSpace( *( end - 1 ));
+    }
+
+    // binary: all other elements need a fixed size to be skipped
+    for( size_t i = 0; i < _elements.size(); ++i )
+    {
+        if( i == _faceElement )
+            continue;
+        const Element& element = _elements[i];
+        for( size_t j = 0; j < element.properties.size(); ++j )
+            if( element.properties[j].countType != 0 )
+                return false;
+    }
+    return true;
+}
+
+void PlyReader::read( VertexData& data, const bool invertFaces )
+{
+    PLYLIBASSERT( _supported );
+    data.vertices.clear();
+    data.colors.clear();
+    data.triangles.clear();
+
+    if( _format == FORMAT_ASCII )
+        _readASCII( data, invertFaces );
+    else
+        _readBinary( data, invertFaces );
+}
+
+void PlyReader::_readBinary( VertexData& data, const bool invertFaces )
+{
+    const bool swap = ( _format == FORMAT_BINARY_LE ) !=
+                      isArchitectureLittleEndian();
+
+    // triangle faces have a fixed size, which is verified while reading
+    const Property& list = _elements[ _faceElement ].properties[0];
+    const size_t faceSize = _getSize( list.countType ) +
+                            3 * _getSize( list.type );
+    _elements[ _faceElement ].size = faceSize;
+
+    size_t offset = _body;
+    size_t vertexOffset = 0;
+    size_t faceOffset = 0;
+    for( size_t i = 0; i < _elements.size(); ++i )
+    {
+        const Element& element = _elements[i];
+        if( i == _vertexElement )
+            vertexOffset = offset;
+        else if( i == _faceElement )
+            faceOffset = offset;
+
+        if( element.count > ( _size - offset ) / std::max( element.size,
+                                                            size_t( 1 )))
+        {
+            throw MeshException( "Error reading PLY file. The file is "
+                                 "truncated." );
+        }
+        offset += element.count * element.size;
+    }
+
+    // vertices, with precomputed property offsets
+    const Element& vertices = _elements[ _vertexElement ];
+    const Property* position[3] = { 0, 0, 0 };
+    const Property* color[3] = { 0, 0, 0 };
+    for( size_t i = 0; i < vertices.properties.size(); ++i )
+    {
+        const Property& property = vertices.properties[i];
+        if( property.name == "x" )          position[0] = &property;
+        else if( property.name == "y" )     position[1] = &property;
+        else if( property.name == "z" )     position[2] = &property;
+        else if( property.name == "red" )   color[0] = &property;
+        else if( property.name == "green" ) color[1] = &property;
+        else if( property.name == "blue" )  color[2] = &property;
+    }
+    const bool hasColors = color[0] && color[1] && color[2];
+
+    const int64_t nVertices = vertices.count;
+    data.vertices.resize( nVertices );
+    if( hasColors )
+        data.colors.resize( nVertices );
+
+    const char* const vertexData = _data + vertexOffset;
+#pragma omp parallel for
+    for( int64_t i = 0; i < nVertices; ++i )
+    {
+        const char* vertex = vertexData + i * vertices.size;
+        for( size_t j = 0; j < 3; ++j )
+            data.vertices[i][j] = float( _getValue( vertex +
+                                                    position[j]->offset,
+                                                    position[j]->type, swap ));
+        if( hasColors )
+            for( size_t j = 0; j < 3; ++j )
+                data.colors[i][j] = uint8_t( _getValue( vertex +
+                                                        color[j]->offset,
+                                                        color[j]->type, swap ));
+    }
+
+    // triangles
+    const int64_t nFaces = _elements[ _faceElement ].count;
+    const size_t countSize = _getSize( list.countType );
+    const size_t indexSize = _getSize( list.type );
+    const size_t first = invertFaces ? 2 : 0;
+    const size_t last = invertFaces ? 0 : 2;
+    data.triangles.resize( nFaces );
+
+    const char* const faceData = _data + faceOffset;
+    bool valid = true;
+    bool indices = true;
+#pragma omp parallel for reduction( && : valid, indices )
+    for( int64_t i = 0; i < nFaces; ++i )
+    {
+        const char* face = faceData + i * faceSize;
+        if( _getValue( face, list.countType, swap ) != 3. )
+        {
+            valid = false;
+            continue;
+        }
+        face += countSize;
+
+        const double a = _getValue( face, list.type, swap );
+        const double b = _getValue( face + indexSize, list.type, swap );
+        const double c = _getValue( face + 2 * indexSize, list.type, swap );
+        indices = _isIndex( a, size_t( nVertices )) &&
+                  _isIndex( b, size_t( nVertices )) &&
+                  _isIndex( c, size_t( nVertices )) && indices;
+
+        Triangle& triangle = data.triangles[i];
+        triangle[ first ] = Index( a );
+        triangle[1] = Index( b );
+        triangle[ last ] = Index( c );
+    }
+
+    if( !valid )
+        throw MeshException( "Error reading PLY file. Encountered a "
+                             "face which does not have three vertices." );
+    if( !indices )
+        throw MeshException( "Error reading PLY file. Encountered a "
+                             "face with an invalid vertex index." );
+}
+
+void PlyReader::_readASCII( VertexData& data, const bool invertFaces )
+{
+    const char* const end = _data + _size;
+    const char* begin = _data + _body;
+    while( begin < end && _isSpace( *begin ))
+        ++begin;
+
+    // split the body into chunks starting at line boundaries
+    std::vector< const char* > chunks( 1, begin );
+    while( size_t( end - chunks.back( )) > _chunkSize )
+        chunks.push_back( _nextLine( chunks.back() + _chunkSize, end ));
+    chunks.push_back( end );
+    const int64_t nChunks = chunks.size() - 1;
+
+    // number the lines of each chunk, the element is given by the line number
+    std::vector< size_t > firstLine( nChunks + 1, 0 );
+#pragma omp parallel for
+    for( int64_t i = 0; i < nChunks; ++i )
+        firstLine[ i + 1 ] = _countLines( chunks[i], chunks[i+1], end );
+    for( int64_t i = 0; i < nChunks; ++i )
+        firstLine[ i + 1 ] += firstLine[i];
+
+    std::vector< size_t > elementLine( _elements.size() + 1, 0 );
+    for( size_t i = 0; i < _elements.size(); ++i )
+        elementLine[ i + 1 ] = elementLine[i] + _elements[i].count;
+    if( firstLine.back() < elementLine.back( ))
+        throw MeshException( "Error reading PLY file. The file is truncated." );
+
+    const Element& vertices = _elements[ _vertexElement ];
+    const size_t vertexLine = elementLine[ _vertexElement ];
+    const size_t faceLine = elementLine[ _faceElement ];
+    const size_t nVertices = vertices.count;
+    const size_t nFaces = _elements[ _faceElement ].count;
+
+    // property index of x, y, z, red, green and blue
+    size_t index[6] = { 0, 0, 0, 0, 0, 0 };
+    bool hasColor[3] = { false, false, false };
+    for( size_t i = 0; i < vertices.properties.size(); ++i )
+    {
+        const std::string& name = vertices.properties[i].name;
+        if( name == "x" )          index[0] = i;
+        else if( name == "y" )     index[1] = i;
+        else if( name == "z" )     index[2] = i;
+        else if( name == "red" )   { index[3] = i; hasColor[0] = true; }
+        else if( name == "green" ) { index[4] = i; hasColor[1] = true; }
+        else if( name == "blue" )  { index[5] = i; hasColor[2] = true; }
+    }
+    const bool hasColors = hasColor[0] && hasColor[1] && hasColor[2];
+    const size_t nProperties = vertices.properties.size();
+    const size_t first = invertFaces ? 2 : 0;
+    const size_t last = invertFaces ? 0 : 2;
+
+    data.vertices.resize( nVertices );
+    if( hasColors )
+        data.colors.resize( nVertices );
+    data.triangles.resize( nFaces );
+
+    bool valid = true;
+    bool triangles = true;
+    bool indices = true;
+#pragma omp parallel for reduction( && : valid, triangles, indices ) \
+    schedule( dynamic )
+    for( int64_t i = 0; i < nChunks; ++i )
+    {
+        std::vector< double > values( nProperties );
+        size_t lineNumber = firstLine[i];
+        for( const char* line = chunks[i]; line < chunks[i+1];
+             line = _nextLine( line, end ), ++lineNumber )
+        {
+            if( lineNumber >= vertexLine && lineNumber < vertexLine + nVertices)
+            {
+                const char* pos = line;
+                for( size_t j = 0; j < nProperties; ++j )
+                    valid = _parse( pos, end, values[j] ) && valid;
+
+                const size_t v = lineNumber - vertexLine;
+                data.vertices[v] = Vertex( float( values[ index[0] ] ),
+                                           float( values[ index[1] ] ),
+                                           float( values[ index[2] ] ));
+                if( hasColors )
+                    data.colors[v] = Color( uint8_t( values[ index[3] ] ),
+                                            uint8_t( values[ index[4] ] ),
+                                            uint8_t( values[ index[5] ] ));
+            }
+            else if( lineNumber >= faceLine && lineNumber < faceLine + nFaces )
+            {
+                const char* pos = line;
+                double count = 0., a = 0., b = 0., c = 0.;
+                valid = _parse( pos, end, count ) && valid;
+                if( count != 3. )
+                {
+                    triangles = false;
+                    continue;
+                }
+                valid = _parse( pos, end, a ) && _parse( pos, end, b ) &&
+                        _parse( pos, end, c ) && valid;
+                indices = _isIndex( a, nVertices ) &&
+                          _isIndex( b, nVertices ) &&
+                          _isIndex( c, nVertices ) && indices;
+
+                Triangle& triangle = data.triangles[ lineNumber - faceLine ];
+                triangle[ first ] = Index( a );
+                triangle[1] = Index( b );
+                triangle[ last ] = Index( c );
+            }
+            // else other element, ignore
+        }
+    }
+
+    if( !triangles )
+        throw MeshException( "Error reading PLY file. Encountered a "
+                             "face which does not have three vertices." );
+    if( !valid )
+        throw MeshException( "Error reading PLY file. Encountered a "
+                             "malformed vertex or face." );
+    if( !indices )
+        throw MeshException( "Error reading PLY file. Encountered a "
+                             "face with an invalid vertex index." );
+}
+
+}
@@ -0,0 +1,94 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLYLIB_PLYREADER_H
+#define PLYLIB_PLYREADER_H
+
+#include "typedefs.h"
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+namespace triply
+{
+/*  Reads the common vertex and triangle layouts of binary and ASCII PLY files
+    from a memory mapped file, converting chunks of the data in parallel.  */
+class PlyReader : public boost::noncopyable
+{
+public:
+    /*  Map the file and parse its header.  */
+    explicit PlyReader( const std::string& filename );
+    ~PlyReader();
+
+    /*  @return true if the file layout can be read by this reader.  */
+    bool isSupported() const { return _supported; }
+
+    /*  Read the data, throws a MeshException on malformed files.  */
+    void read( VertexData& data, bool invertFaces );
+
+private:
+    enum Format
+    {
+        FORMAT_ASCII,
+        FORMAT_BINARY_LE,
+        FORMAT_BINARY_BE
+    };
+
+    struct Property
+    {
+        std::string name;
+        int type;      // scalar or list index type, PLY_* from ply.h
+        int countType; // list count type, or 0 for scalars
+        size_t offset; // in bytes within a binary scalar element
+    };
+
+    struct Element
+    {
+        std::string name;
+        size_t count;
+        std::vector< Property > properties;
+        size_t size; // in bytes, of one binary element with scalars only
+    };
+
+    const char* _data;
+    size_t      _size;
+    size_t      _body; // offset after the header
+    Format      _format;
+    bool        _supported;
+
+    std::vector< Element > _elements;
+    size_t _vertexElement;
+    size_t _faceElement;
+
+    bool _parseHeader();
+    void _readBinary( VertexData& data, bool invertFaces );
+    void _readASCII( VertexData& data, bool invertFaces );
+};
+}
+
+#endif // PLYLIB_PLYREADER_H
@@ -64,6 +64,7 @@
 
 #include<vmmlib/types.hpp>
 #include <boost/progress.hpp>
+#include <cmath>
 #include <exception>
 #include <iostream>
 #include <string>
@@ -86,6 +87,8 @@ using vmml::Matrix4f;
 using vmml::Vector4f;
 typedef size_t Index;
 typedef unsigned short ShortIndex;
+typedef vmml::vector< 3, int16_t > PackedVertex; // quantized in leaf bounds
+typedef vmml::vector< 2, int16_t > PackedNormal; // octahedral encoding
 
 // mesh exception
 struct MeshException : public std::exception
@@ -133,7 +136,10 @@ typedef ArrayWrapper< float, 2 >    Range;
 const Index             LEAF_SIZE( 21845 );
 
 // binary mesh file version, increment if changing the file format
-const unsigned short    FILE_VERSION( 0x0118 );
+const unsigned short    FILE_VERSION( 0x011c );
+
+// alignment of the vertex data arrays in the binary mesh file, in bytes
+const size_t            FILE_ALIGNMENT( 4096 );
 
 // enumeration for the sort axis
 enum Axis
@@ -188,6 +194,69 @@ inline void memRead( char* destination, char** source, size_t length )
     memcpy( destination, *source, length );
     *source += length;
 }
+
+// octahedral normal encoding, see "A Survey of Efficient Representations for
+// Independent Unit Vectors", Cigolle et al., JCGT 2014
+inline float signNotZero( const float value )
+{
+    return value >= 0.f ? 1.f : -1.f;
+}
+
+inline PackedNormal encodeNormal( const Normal& normal )
+{
+    const float sum = fabsf( normal[0] ) + fabsf( normal[1] ) +
+                      fabsf( normal[2] );
+    if( sum <= 0.f )
+        return PackedNormal( 0, 0 );
+
+    float x = normal[0] / sum;
+    float y = normal[1] / sum;
+    if( normal[2] < 0.f )
+    {
+        const float foldedX = ( 1.f - fabsf( y )) * signNotZero( x );
+        y = ( 1.f - fabsf( x )) * signNotZero( y );
+        x = foldedX;
+    }
+    return PackedNormal( int16_t( roundf( x * 32767.f )),
+                         int16_t( roundf( y * 32767.f )));
+}
+
+inline Normal decodeNormal( const PackedNormal& packed )
+{
+    float x = float( packed[0] ) / 32767.f;
+    float y = float( packed[1] ) / 32767.f;
+    const float z = 1.f - fabsf( x ) - fabsf( y );
+    if( z < 0.f )
+    {
+        const float unfoldedX = ( 1.f - fabsf( y )) * signNotZero( x );
+        y = ( 1.f - fabsf( x )) * signNotZero( y );
+        x = unfoldedX;
+    }
+    Normal normal( x, y, z );
+    normal.normalize();
+    return normal;
+}
+
+// position quantization of compact leaves: vertex = center + packed * scale,
+// where scale is the largest half extent of the leaf bounds / 32767
+inline int16_t quantize( const float value )
+{
+    return int16_t( fmaxf( -32767.f, fminf( 32767.f, roundf( value ))));
+}
+
+inline PackedVertex packVertex( const Vertex& vertex, const Vertex& center,
+                                const float scale )
+{
+    const Vertex local = ( vertex - center ) / scale;
+    return PackedVertex( quantize( local.x( )), quantize( local.y( )),
+                         quantize( local.z( )));
+}
+
+inline Vertex unpackVertex( const PackedVertex& packed, const Vertex& center,
+                            const float scale )
+{
+    return center + Vertex( packed.x(), packed.y(), packed.z( )) * scale;
+}
 }
 
 #ifdef EQUALIZER
@@ -64,6 +64,11 @@ public:
 
     TRIPLY_API virtual const BoundingSphere& updateBoundingSphere() = 0;
 
+    /*  @return the model space error of the simplified proxy, 0 if none.  */
+    virtual float getLODError() const { return 0.f; }
+    /*  Draw the simplified proxy instead of the full subtree.  */
+    TRIPLY_API virtual void drawLOD( VertexBufferState& ) const {}
+
 protected:
     VertexBufferBase() : _boundingSphere( 0.0f )
         {
@@ -92,6 +97,11 @@ protected:
                             VertexBufferData& globalData,
                             boost::progress_display& ) = 0;
 
+    /*  Append the leaf data to the global data, in tree order.  */
+    virtual void mergeTree( const VertexData& data,
+                            VertexBufferData& globalData, const size_t depth,
+                            boost::progress_display& ) = 0;
+
     virtual void updateRange() = 0;
 
     friend class VertexBufferDist;
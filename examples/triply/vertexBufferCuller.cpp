@@ -0,0 +1,235 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vertexBufferCuller.h"
+#include "vertexBufferBase.h"
+#include "vertexBufferState.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#if defined( _OPENMP ) && _OPENMP >= 201307 // OpenMP 4.0 simd
+#  define TRIPLY_USE_SIMD
+#endif
+
+namespace triply
+{
+namespace
+{
+const size_t _batchSize = 8; // floats per AVX register
+
+/*  @return the screen space size in pixels of the given model space error at
+    the nearest point of the bounding sphere.  */
+float _getPixelError( const Matrix4f& pmv, const BoundingSphere& sphere,
+                      const float error, const float* viewportSize )
+{
+    const Vector4f center( sphere.x(), sphere.y(), sphere.z(), 1.f );
+    const Vector4f clip = pmv * center;
+    const Vertex xRow( pmv( 0, 0 ), pmv( 0, 1 ), pmv( 0, 2 ));
+    const Vertex yRow( pmv( 1, 0 ), pmv( 1, 1 ), pmv( 1, 2 ));
+    const Vertex wRow( pmv( 3, 0 ), pmv( 3, 1 ), pmv( 3, 2 ));
+
+    const float w = clip.w() - wRow.length() * sphere.w();
+    if( w <= std::numeric_limits< float >::epsilon( )) // crosses near plane
+        return std::numeric_limits< float >::max();
+
+    return error / w * .5f * std::max( xRow.length() * viewportSize[0],
+                                       yRow.length() * viewportSize[1] );
+}
+}
+
+/*  Copy the spheres, ranges and children of all nodes in breadth-first
+    order.  */
+void VertexBufferCuller::setup( const VertexBufferBase* root )
+{
+    _x.clear();
+    _y.clear();
+    _z.clear();
+    _radius.clear();
+    _ranges.clear();
+    _lodErrors.clear();
+    _left.clear();
+    _right.clear();
+    _nodes.clear();
+    if( !root )
+        return;
+
+    _nodes.push_back( root );
+    for( size_t i = 0; i < _nodes.size(); ++i )
+    {
+        const VertexBufferBase* node = _nodes[i];
+        const BoundingSphere& sphere = node->getBoundingSphere();
+        _x.push_back( sphere.x( ));
+        _y.push_back( sphere.y( ));
+        _z.push_back( sphere.z( ));
+        _radius.push_back( sphere.w( ));
+        _ranges.push_back( Range( node->getRange( )));
+        _lodErrors.push_back( node->getLODError( ));
+
+        if( node->getLeft() && node->getRight( ))
+        {
+            _left.push_back( uint32_t( _nodes.size( )));
+            _nodes.push_back( node->getLeft( ));
+            _right.push_back( uint32_t( _nodes.size( )));
+            _nodes.push_back( node->getRight( ));
+        }
+        else
+        {
+            _left.push_back( 0 );
+            _right.push_back( 0 );
+        }
+    }
+
+    // pad with empty spheres, so that the distance loop has no remainder
+    const size_t size = ( _nodes.size() + _batchSize - 1 ) / _batchSize *
+                        _batchSize;
+    _x.resize( size, 0.f );
+    _y.resize( size, 0.f );
+    _z.resize( size, 0.f );
+    _radius.resize( size, 0.f );
+}
+
+/*  Compute the minimum signed distance of each sphere center to the six
+    frustum planes.  */
+void VertexBufferCuller::_computeDistances( const Matrix4f& pmv,
+                                            float* distances ) const
+{
+    // extract the normalized frustum planes from the matrix rows
+    float planes[6][4];
+    for( size_t i = 0; i < 3; ++i )
+    {
+        for( size_t j = 0; j < 4; ++j )
+        {
+            planes[ 2 * i ][j] = pmv( 3, j ) + pmv( i, j );
+            planes[ 2 * i + 1 ][j] = pmv( 3, j ) - pmv( i, j );
+        }
+    }
+    for( size_t i = 0; i < 6; ++i )
+    {
+        const float length = sqrtf( planes[i][0] * planes[i][0] +
+                                    planes[i][1] * planes[i][1] +
+                                    planes[i][2] * planes[i][2] );
+        for( size_t j = 0; j < 4; ++j )
+            planes[i][j] /= length;
+    }
+
+    const float* x = &_x[0];
+    const float* y = &_y[0];
+    const float* z = &_z[0];
+    const ptrdiff_t size = ptrdiff_t( _x.size( ));
+
+#ifdef TRIPLY_USE_SIMD
+#  pragma omp simd
+#endif
+    for( ptrdiff_t i = 0; i < size; ++i )
+    {
+        float distance = std::numeric_limits< float >::max();
+        for( size_t j = 0; j < 6; ++j )
+            distance = std::min( distance, planes[j][0] * x[i] +
+                                           planes[j][1] * y[i] +
+                                           planes[j][2] * z[i] + planes[j][3] );
+        distances[i] = distance;
+    }
+}
+
+/*  Traverse the flattened tree on the precomputed sphere visibilities.  */
+void VertexBufferCuller::cull( const VertexBufferState& state,
+                               DrawList& drawList ) const
+{
+    drawList.commands.clear();
+    if( _nodes.empty( ))
+        return;
+
+    const Range& range = state.getRange();
+    const Matrix4f& pmv = state.getProjectionModelViewMatrix();
+    const float lodThreshold = state.getLODThreshold();
+    const bool frustumCulling = state.useFrustumCulling();
+
+    drawList.distances.resize( _x.size( ));
+    if( frustumCulling )
+        _computeDistances( pmv, &drawList.distances[0] );
+
+    // start with root node
+    std::vector< uint32_t >& candidates = drawList.candidates;
+    candidates.clear();
+    candidates.push_back( 0 );
+
+    while( !candidates.empty( ))
+    {
+        const uint32_t i = candidates.back();
+        candidates.pop_back();
+
+        // completely out of range check
+        const Range& nodeRange = _ranges[i];
+        if( nodeRange[0] >= range[1] || nodeRange[1] < range[0] )
+            continue;
+
+        // sphere outside of one plane, or intersecting at least one plane
+        const float radius = _radius[i];
+        const float distance = frustumCulling ? drawList.distances[i] : radius;
+        if( distance < -radius )
+            continue;
+        const bool fullyVisible = distance >= radius;
+
+        // draw the proxy of subtrees fully in range if it is precise enough
+        if( lodThreshold > 0.f && _lodErrors[i] > 0.f &&
+            nodeRange[0] >= range[0] && nodeRange[1] <= range[1] &&
+            _getPixelError( pmv, BoundingSphere( _x[i], _y[i], _z[i], radius ),
+                            _lodErrors[i],
+                            state.getViewportSize( )) < lodThreshold )
+        {
+            const DrawCommand command = { _nodes[i], true };
+            drawList.commands.push_back( command );
+            continue;
+        }
+
+        // if fully visible and fully in range, render it
+        if( fullyVisible && nodeRange[0] >= range[0] &&
+            nodeRange[1] < range[1] )
+        {
+            const DrawCommand command = { _nodes[i], false };
+            drawList.commands.push_back( command );
+        }
+        else if( _left[i] == 0 ) // partial leaf
+        {
+            // else drop, to be drawn by 'previous' channel
+            if( nodeRange[0] >= range[0] )
+            {
+                const DrawCommand command = { _nodes[i], false };
+                drawList.commands.push_back( command );
+            }
+        }
+        else
+        {
+            candidates.push_back( _left[i] );
+            candidates.push_back( _right[i] );
+        }
+    }
+}
+
+}
@@ -0,0 +1,88 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLYLIB_VERTEXBUFFERCULLER_H
+#define PLYLIB_VERTEXBUFFERCULLER_H
+
+#include <triply/api.h>
+#include "typedefs.h"
+#include <vector>
+
+namespace triply
+{
+/*  A node selected by the culler, drawn with its LOD proxy or in full.  */
+struct DrawCommand
+{
+    const VertexBufferBase* node;
+    bool                    lod;
+};
+
+/*  The result of one culling pass, reusable between frames.  */
+struct DrawList
+{
+    std::vector< DrawCommand > commands;
+
+    // scratch space of the culler
+    std::vector< float >    distances;
+    std::vector< uint32_t > candidates;
+};
+
+/*  Frustum culling of a kd-tree over a flattened, breadth-first copy of its
+    bounding spheres and ranges. The spheres are stored as structure of arrays
+    and tested in one vectorized pass, before the tree is traversed on the
+    precomputed visibilities to select the nodes to draw.  */
+class VertexBufferCuller
+{
+public:
+    /*  Flatten the given tree, to be called after the tree has changed.  */
+    void setup( const VertexBufferBase* root );
+
+    /*  Select the nodes to draw for the given state.  */
+    TRIPLY_API void cull( const VertexBufferState& state,
+                          DrawList& drawList ) const;
+
+    size_t getNumberOfNodes() const { return _nodes.size(); }
+
+private:
+    // node spheres, padded to a multiple of the SIMD batch size
+    std::vector< float > _x;
+    std::vector< float > _y;
+    std::vector< float > _z;
+    std::vector< float > _radius;
+
+    std::vector< Range >    _ranges;
+    std::vector< float >    _lodErrors;
+    std::vector< uint32_t > _left; // 0 for leaves, the root is never a child
+    std::vector< uint32_t > _right;
+    std::vector< const VertexBufferBase* > _nodes;
+
+    void _computeDistances( const Matrix4f& pmv, float* distances ) const;
+};
+}
+
+#endif // PLYLIB_VERTEXBUFFERCULLER_H
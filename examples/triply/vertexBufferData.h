@@ -38,68 +38,166 @@
 
 namespace triply 
 {    
+    /** An array either owning its data or referencing a memory mapped file. */
+    template< class T > class DataArray
+    {
+    public:
+        DataArray() : _data( 0 ), _size( 0 ) {}
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        const T& operator[]( const size_t i ) const { return _data[i]; }
+        const T* getData() const { return _data; }
+
+        void clear() { _storage.clear(); _sync(); }
+        void reserve( const size_t size ) { _storage.reserve( size ); }
+        void push_back( const T& value )
+            { _storage.push_back( value ); _sync(); }
+
+        template< class I > void append( const I begin, const I end )
+            { _storage.insert( _storage.end(), begin, end ); _sync(); }
+
+        /*  Exchange the owned data with the given vector.  */
+        void swap( std::vector< T >& storage )
+            { _storage.swap( storage ); _sync(); }
+
+        /*  Reference mapped data, which has to outlive this array.  */
+        void map( const T* data, const size_t size )
+        {
+            std::vector< T >().swap( _storage );
+            _data = data;
+            _size = size;
+        }
+
+    private:
+        DataArray( const DataArray& );
+        DataArray& operator = ( const DataArray& );
+
+        std::vector< T > _storage;
+        const T*         _data;
+        size_t           _size;
+
+        void _sync()
+        {
+            _data = _storage.empty() ? 0 : &_storage[0];
+            _size = _storage.size();
+        }
+    };
+
     /** Holds the final kd-tree data, sorted and reindexed.  */
     class VertexBufferData
     {
     public:
+        VertexBufferData() : compact( false ) {}
+
         void clear()
         {
             vertices.clear();
             colors.clear();
             normals.clear();
             indices.clear();
+            packedVertices.clear();
+            packedNormals.clear();
+            lodVertices.clear();
+            lodColors.clear();
+            lodNormals.clear();
+            lodIndices.clear();
         }
         
-        /*  Write the vectors' sizes and contents to the given stream.  */
+        /*  Write the arrays' sizes and page-aligned contents to the given
+            stream.  */
         void toStream( std::ostream& os )
         {
-            writeVector( os, vertices );
-            writeVector( os, colors );
-            writeVector( os, normals );
-            writeVector( os, indices );
+            writeArray( os, vertices );
+            writeArray( os, colors );
+            writeArray( os, normals );
+            writeArray( os, indices );
+            writeArray( os, packedVertices );
+            writeArray( os, packedNormals );
+            writeArray( os, lodVertices );
+            writeArray( os, lodColors );
+            writeArray( os, lodNormals );
+            writeArray( os, lodIndices );
         }
         
-        /*  Read the vectors' sizes and contents from the given MMF address.  */
+        /*  Reference the arrays in the MMF, which has to stay mapped.  */
         void fromMemory( char** addr )
         {
             clear();
-            readVector( addr, vertices );
-            readVector( addr, colors );
-            readVector( addr, normals );
-            readVector( addr, indices );
+            mapArray( addr, vertices );
+            mapArray( addr, colors );
+            mapArray( addr, normals );
+            mapArray( addr, indices );
+            mapArray( addr, packedVertices );
+            mapArray( addr, packedNormals );
+            mapArray( addr, lodVertices );
+            mapArray( addr, lodColors );
+            mapArray( addr, lodNormals );
+            mapArray( addr, lodIndices );
+            compact = !packedVertices.empty();
         }
         
-        std::vector< Vertex >       vertices;
-        std::vector< Color >        colors;
-        std::vector< Normal >       normals;
-        std::vector< ShortIndex >   indices;
+        DataArray< Vertex >       vertices;
+        DataArray< Color >        colors;
+        DataArray< Normal >       normals;
+        DataArray< ShortIndex >   indices;
+
+        // compact leaves replace vertices and normals, see VertexBufferLeaf
+        DataArray< PackedVertex > packedVertices;
+        DataArray< PackedNormal > packedNormals;
+        bool                      compact;
+
+        // simplified proxies of the inner nodes, see VertexBufferNode
+        DataArray< Vertex >       lodVertices;
+        DataArray< Color >        lodColors;
+        DataArray< Normal >       lodNormals;
+        DataArray< ShortIndex >   lodIndices;
         
     private:
-        /*  Helper function to write a vector to output stream.  */
+        /*  Helper function to write an array to output stream.  */
         template< class T >
-        void writeVector( std::ostream& os, std::vector< T >& v )
+        void writeArray( std::ostream& os, const DataArray< T >& array )
         {
-            size_t length = v.size();
+            size_t length = array.size();
             os.write( reinterpret_cast< char* >( &length ), 
                       sizeof( size_t ) );
-            if( length > 0 )
-                os.write( reinterpret_cast< char* >( &v[0] ), 
-                          length * sizeof( T ) );
+            if( length == 0 )
+                return;
+
+            // the padding aligns to the file offset, which is unknown on
+            // non-seekable streams
+            const std::streamoff offset = os.tellp();
+            if( offset < 0 )
+            {
+                os.setstate( std::ios::failbit );
+                return;
+            }
+
+            const size_t padding = ( FILE_ALIGNMENT - size_t( offset ) %
+                                     FILE_ALIGNMENT ) % FILE_ALIGNMENT;
+            static const char zeros[ FILE_ALIGNMENT ] = { 0 };
+            os.write( zeros, padding );
+            os.write( reinterpret_cast< const char* >( array.getData( )),
+                      length * sizeof( T ) );
         }
         
-        /*  Helper function to read a vector from the MMF address.  */
+        /*  Helper function to map an array from the MMF address, which is
+            page-aligned at the start of the file.  */
         template< class T >
-        void readVector( char** addr, std::vector< T >& v )
+        void mapArray( char** addr, DataArray< T >& array )
         {
             size_t length;
             memRead( reinterpret_cast< char* >( &length ), addr, 
                      sizeof( size_t ) );
-            if( length > 0 )
-            {
-                v.resize( length );
-                memRead( reinterpret_cast< char* >( &v[0] ), addr, 
-                         length * sizeof( T ) );
-            }
+            if( length == 0 )
+                return;
+
+            const size_t misalignment =
+                reinterpret_cast< size_t >( *addr ) % FILE_ALIGNMENT;
+            if( misalignment != 0 )
+                *addr += FILE_ALIGNMENT - misalignment;
+            array.map( reinterpret_cast< const T* >( *addr ), length );
+            *addr += length * sizeof( T );
         }
     };
     
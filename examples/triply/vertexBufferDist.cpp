@@ -32,8 +32,215 @@
 #include "vertexBufferLeaf.h"
 #include "vertexBufferRoot.h"
 
+#include <lunchbox/monitor.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <algorithm>
+#include <memory>
+
 namespace triply
 {
+namespace
+{
+// same encoding as a std::vector, the data may reference the mapped model file
+template< class T >
+co::DataOStream& operator << ( co::DataOStream& os, const DataArray< T >& array )
+{
+    os << uint64_t( array.size( ));
+    if( !array.empty( ))
+        os << co::Array< const T >( array.getData(), array.size( ));
+    return os;
+}
+
+template< class T >
+co::DataIStream& operator >> ( co::DataIStream& is, DataArray< T >& array )
+{
+    std::vector< T > storage;
+    is >> storage;
+    array.swap( storage );
+    return is;
+}
+
+/*  Write elements [start, end) of the array, or nothing if it is unused. */
+template< class T >
+void _writeSlice( co::DataOStream& os, const DataArray< T >& array,
+                  const Index start, const Index end )
+{
+    if( array.empty() || end == start )
+    {
+        os << uint64_t( 0 );
+        return;
+    }
+    os << uint64_t( end - start )
+       << co::Array< const T >( &array[ start ], end - start );
+}
+
+const size_t _chunkSize = 4 * 1024 * 1024; // uncompressed bytes
+const size_t _defaultMaxResidentSize = 1024 * 1024 * 1024;
+
+template< class T > size_t _getSize( const DataArray< T >& array )
+{
+    return array.size() * sizeof( T );
+}
+
+/*  Clear the array and release its memory.  */
+template< class T > void _free( DataArray< T >& array )
+{
+    std::vector< T > storage;
+    array.swap( storage );
+}
+}
+
+/*  The geometry of a run of consecutive leaves, a slice of the master's model
+    data. Collage compresses it as any other object data.  */
+class VertexBufferChunk : public co::Object
+{
+public:
+    VertexBufferChunk( const VertexBufferData& source, const uint32_t index,
+                       const Index vertexStart, const Index vertexEnd,
+                       const Index indexStart, const Index indexEnd,
+                       const Range& range )
+        : _source( &source ), _target( 0 ), _index( index )
+        , _vertexStart( vertexStart ), _vertexEnd( vertexEnd )
+        , _indexStart( indexStart ), _indexEnd( indexEnd ), _range( range )
+        , _resident( true ), _claimed( false ), _users( 0 ), _lastUse( 0 )
+    {}
+
+    VertexBufferChunk( VertexBufferData& target, const uint32_t index,
+                       const eq::uint128_t& id, const Range& range )
+        : _source( 0 ), _target( &target ), _index( index ), _vertexStart( 0 )
+        , _vertexEnd( 0 ), _indexStart( 0 ), _indexEnd( 0 ), _range( range )
+        , _id( id ), _resident( false ), _claimed( false ), _users( 0 )
+        , _lastUse( 0 )
+    {}
+
+    virtual ~VertexBufferChunk() { finish(); }
+
+    uint32_t getIndex() const { return _index; }
+    Index getVertexStart() const { return _vertexStart; }
+    Index getIndexStart() const { return _indexStart; }
+    const Range& getRange() const { return _range; }
+
+    bool intersects( const Range& range ) const
+        { return _range[0] < range[1] && _range[1] > range[0]; }
+
+    /*  @return true if the chunk's data may be freed by evict().  */
+    bool isEvictable() const
+        { return _target && _resident.get() && !_mapping && _users == 0; }
+
+    uint64_t getLastUse() const { return _lastUse; }
+
+    /*  Pin the chunk while a draw uses it, and note the use for the LRU.  */
+    void pin( const uint64_t use ) { ++_users; _lastUse = use; }
+    void unpin() { LBASSERT( _users > 0 ); --_users; }
+
+    /*  @return the size of the resident geometry on a slave in bytes.  */
+    size_t getResidentSize() const
+    {
+        if( !_target || !_resident.get( ))
+            return 0;
+        const VertexBufferData& data = *_target;
+        return _getSize( data.vertices ) + _getSize( data.colors ) +
+               _getSize( data.normals ) + _getSize( data.packedVertices ) +
+               _getSize( data.packedNormals ) + _getSize( data.indices );
+    }
+
+    /*  Free the geometry of an unused chunk, a later map() fetches it again.
+        Leaves skip drawing while their chunk is not resident.  */
+    void evict()
+    {
+        LBASSERT( isEvictable( ));
+        getLocalNode()->unmapObject( this );
+
+        VertexBufferData& data = *_target;
+        _free( data.vertices );
+        _free( data.colors );
+        _free( data.normals );
+        _free( data.packedVertices );
+        _free( data.packedNormals );
+        _free( data.indices );
+        _resident = false;
+    }
+
+    /*  Start mapping the chunk on a slave, unless already done.  */
+    void map( co::LocalNodePtr localNode, co::NodePtr master )
+    {
+        if( _resident.get() || _mapping )
+            return;
+        _mapping.reset( new co::f_bool_t( localNode->syncObject( this, master,
+                                                                 _id )));
+    }
+
+    /*  @return the started mapping for the caller to wait on, or 0 if none
+        or if another caller already waits on it.  */
+    co::f_bool_t* claimMapping()
+    {
+        if( !_mapping || _claimed )
+            return 0;
+        _claimed = true;
+        return _mapping.get();
+    }
+
+    /*  Mark the chunk resident once the claimed mapping finished.  */
+    void publish()
+    {
+        LBASSERT( _claimed );
+        _mapping.reset();
+        _claimed = false;
+        _resident = true;
+    }
+
+    /*  Wait for the mapping claimed by another caller to be published.  */
+    void waitResident() const { _resident.waitEQ( true ); }
+
+    /*  Wait for an unclaimed mapping, e.g., of a prefetch, to finish.  */
+    void finish()
+    {
+        if( !_mapping || _claimed )
+            return;
+        LBCHECK( _mapping->wait( ));
+        _mapping.reset();
+        _resident = true;
+    }
+
+protected:
+    void getInstanceData( co::DataOStream& os ) override
+    {
+        LBASSERT( _source );
+        const VertexBufferData& data = *_source;
+        os << data.compact;
+        _writeSlice( os, data.vertices, _vertexStart, _vertexEnd );
+        _writeSlice( os, data.colors, _vertexStart, _vertexEnd );
+        _writeSlice( os, data.normals, _vertexStart, _vertexEnd );
+        _writeSlice( os, data.packedVertices, _vertexStart, _vertexEnd );
+        _writeSlice( os, data.packedNormals, _vertexStart, _vertexEnd );
+        _writeSlice( os, data.indices, _indexStart, _indexEnd );
+    }
+
+    void applyInstanceData( co::DataIStream& is ) override
+    {
+        LBASSERT( _target );
+        VertexBufferData& data = *_target;
+        is >> data.compact >> data.vertices >> data.colors >> data.normals
+           >> data.packedVertices >> data.packedNormals >> data.indices;
+    }
+
+private:
+    const VertexBufferData* _source;
+    VertexBufferData* _target;
+    const uint32_t _index;
+    const Index _vertexStart;
+    const Index _vertexEnd;
+    const Index _indexStart;
+    const Index _indexEnd;
+    const Range _range;
+    const eq::uint128_t _id;
+    lunchbox::Monitorb _resident;
+    std::unique_ptr< co::f_bool_t > _mapping;
+    bool _claimed; // a loadRange() waits on _mapping
+    size_t _users; // draws using the chunk, see VertexBufferDist::loadRange
+    uint64_t _lastUse;
+};
 
 VertexBufferDist::VertexBufferDist()
     : _root( 0 )
@@ -41,20 +248,29 @@ VertexBufferDist::VertexBufferDist()
     , _left( 0 )
     , _right( 0 )
     , _isRoot( false )
+    , _chunk( 0 )
+    , _maxResidentSize( _defaultMaxResidentSize )
+    , _useCount( 0 )
 {}
 
-VertexBufferDist::VertexBufferDist( VertexBufferRoot* root )
+VertexBufferDist::VertexBufferDist( VertexBufferRoot* root, const bool chunked )
     : _root( root )
     , _node( root )
     , _left( 0 )
     , _right( 0 )
     , _isRoot( true )
+    , _chunk( 0 )
+    , _maxResidentSize( _defaultMaxResidentSize )
+    , _useCount( 0 )
 {
     if( root->getLeft( ))
         _left = new VertexBufferDist( root, root->getLeft( ));
 
     if( root->getRight( ))
         _right = new VertexBufferDist( root, root->getRight( ));
+
+    if( chunked )
+        _setupChunks();
 }
 
 VertexBufferDist::VertexBufferDist( VertexBufferRoot* root,
@@ -64,6 +280,9 @@ VertexBufferDist::VertexBufferDist( VertexBufferRoot* root,
         , _left( 0 )
         , _right( 0 )
         , _isRoot( false )
+        , _chunk( 0 )
+        , _maxResidentSize( _defaultMaxResidentSize )
+        , _useCount( 0 )
 {
     if( !node )
         return;
@@ -77,16 +296,78 @@ VertexBufferDist::VertexBufferDist( VertexBufferRoot* root,
 
 VertexBufferDist::~VertexBufferDist()
 {
+    for( size_t i = 0; i < _chunks.size(); ++i )
+        delete _chunks[i];
+    _chunks.clear();
     delete _left;
     _left = 0;
     delete _right;
     _right = 0;
 }
 
+/*  Group the leaves in tree order, which is their order in the model data. */
+void VertexBufferDist::_setupChunks()
+{
+    std::vector< VertexBufferDist* > leaves;
+    _collectLeaves( leaves );
+
+    const VertexBufferData& data = _root->_data;
+    const size_t vertexSize = data.compact ?
+        sizeof( PackedVertex ) + sizeof( PackedNormal ) + sizeof( Color ) :
+        sizeof( Vertex ) + sizeof( Normal ) + sizeof( Color );
+
+    for( size_t begin = 0; begin < leaves.size(); )
+    {
+        size_t end = begin;
+        size_t size = 0;
+        while( end < leaves.size() && ( end == begin || size < _chunkSize ))
+        {
+            const VertexBufferLeaf* leaf =
+                static_cast< const VertexBufferLeaf* >( leaves[ end ]->_node );
+            size += leaf->_vertexLength * vertexSize +
+                    leaf->_indexLength * sizeof( ShortIndex );
+            ++end;
+        }
+
+        const VertexBufferLeaf* first =
+            static_cast< const VertexBufferLeaf* >( leaves[ begin ]->_node );
+        const VertexBufferLeaf* last =
+            static_cast< const VertexBufferLeaf* >( leaves[ end - 1 ]->_node );
+        Range range;
+        range[0] = first->getRange()[0];
+        range[1] = last->getRange()[1];
+
+        VertexBufferChunk* chunk = new VertexBufferChunk( data,
+            uint32_t( _chunks.size( )),
+            first->_vertexStart, last->_vertexStart + last->_vertexLength,
+            first->_indexStart, last->_indexStart + last->_indexLength, range );
+        _chunks.push_back( chunk );
+
+        for( ; begin < end; ++begin )
+            leaves[ begin ]->_chunk = chunk;
+    }
+}
+
+void VertexBufferDist::_collectLeaves( std::vector< VertexBufferDist* >& leaves )
+{
+    if( !_left && !_right )
+    {
+        if( _node )
+            leaves.push_back( this );
+        return;
+    }
+    if( _left )
+        _left->_collectLeaves( leaves );
+    if( _right )
+        _right->_collectLeaves( leaves );
+}
+
 void VertexBufferDist::registerTree( co::LocalNodePtr node )
 {
     LBASSERT( !isAttached() );
     LBCHECK( node->registerObject( this ));
+    for( size_t i = 0; i < _chunks.size(); ++i )
+        LBCHECK( node->registerObject( _chunks[i] ));
 
     if( _left )
         _left->registerTree( node );
@@ -100,6 +381,8 @@ void VertexBufferDist::deregisterTree()
     LBASSERT( isAttached() );
     LBASSERT( isMaster( ));
 
+    for( size_t i = 0; i < _chunks.size(); ++i )
+        getLocalNode()->deregisterObject( _chunks[i] );
     getLocalNode()->deregisterObject( this );
 
     if( _left )
@@ -108,6 +391,26 @@ void VertexBufferDist::deregisterTree()
         _right->deregisterTree();
 }
 
+void VertexBufferDist::unmapTree()
+{
+    LBASSERT( isAttached() );
+    LBASSERT( !isMaster( ));
+
+    co::LocalNodePtr localNode = getLocalNode();
+    for( size_t i = 0; i < _chunks.size(); ++i )
+    {
+        _chunks[i]->finish();
+        if( _chunks[i]->isAttached( ))
+            localNode->unmapObject( _chunks[i] );
+    }
+    localNode->unmapObject( this );
+
+    if( _left )
+        _left->unmapTree();
+    if( _right )
+        _right->unmapTree();
+}
+
 VertexBufferRoot* VertexBufferDist::loadModel( co::NodePtr master,
                                                      co::LocalNodePtr localNode,
                                                      const eq::uint128_t& modelID )
@@ -119,9 +422,133 @@ VertexBufferRoot* VertexBufferDist::loadModel( co::NodePtr master,
         LBWARN << "Mapping of model failed" << std::endl;
         return 0;
     }
+    if( !_chunks.empty( ))
+        _master = master;
     return _root;
 }
 
+void VertexBufferDist::loadRange( const Range& range )
+{
+    LBASSERT( _isRoot );
+    if( _chunks.empty() || isMaster( ))
+        return;
+
+    // Pin the chunks and start their mappings under the lock, but wait for
+    // them without it. Pinned chunks are not evicted meanwhile.
+    typedef std::pair< VertexBufferChunk*, co::f_bool_t* > Mapping;
+    std::vector< Mapping > claimed;
+    std::vector< VertexBufferChunk* > pinned;
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        _prefetchRange( range );
+
+        ++_useCount;
+        for( size_t i = 0; i < _chunks.size(); ++i )
+        {
+            VertexBufferChunk* chunk = _chunks[i];
+            if( !chunk->intersects( range ))
+                continue;
+            chunk->pin( _useCount );
+            if( co::f_bool_t* mapping = chunk->claimMapping( ))
+                claimed.push_back( Mapping( chunk, mapping ));
+            else
+                pinned.push_back( chunk );
+        }
+    }
+
+    for( size_t i = 0; i < claimed.size(); ++i )
+        LBCHECK( claimed[i].second->wait( ));
+
+    // chunks mapped by a concurrent loadRange() of the same range
+    for( size_t i = 0; i < pinned.size(); ++i )
+        pinned[i]->waitResident();
+
+    lunchbox::ScopedWrite mutex( _lock );
+    for( size_t i = 0; i < claimed.size(); ++i )
+        claimed[i].first->publish();
+    _evictChunks();
+}
+
+void VertexBufferDist::releaseRange( const Range& range )
+{
+    LBASSERT( _isRoot );
+    if( _chunks.empty() || isMaster( ))
+        return;
+
+    lunchbox::ScopedWrite mutex( _lock );
+    for( size_t i = 0; i < _chunks.size(); ++i )
+        if( _chunks[i]->intersects( range ))
+            _chunks[i]->unpin();
+}
+
+void VertexBufferDist::prefetchRange( const Range& range )
+{
+    LBASSERT( _isRoot );
+    if( _chunks.empty() || isMaster( ))
+        return;
+
+    lunchbox::ScopedWrite mutex( _lock );
+    _prefetchRange( range );
+}
+
+void VertexBufferDist::_prefetchRange( const Range& range )
+{
+    size_t first = _chunks.size();
+    size_t last = 0;
+    co::LocalNodePtr localNode = getLocalNode();
+    for( size_t i = 0; i < _chunks.size(); ++i )
+    {
+        if( !_chunks[i]->intersects( range ))
+            continue;
+        _chunks[i]->map( localNode, _master );
+        first = std::min( first, i );
+        last = i;
+    }
+    if( first > last )
+        return;
+
+    // prefetch the neighbours, which a moving range boundary will need next
+    if( first > 0 )
+        _chunks[ first - 1 ]->map( localNode, _master );
+    if( last + 1 < _chunks.size( ))
+        _chunks[ last + 1 ]->map( localNode, _master );
+}
+
+size_t VertexBufferDist::getResidentSize()
+{
+    LBASSERT( _isRoot );
+    lunchbox::ScopedWrite mutex( _lock );
+    size_t size = 0;
+    for( size_t i = 0; i < _chunks.size(); ++i )
+        size += _chunks[i]->getResidentSize();
+    return size;
+}
+
+/*  Evict the least recently used, unpinned chunks above the resident size.  */
+void VertexBufferDist::_evictChunks()
+{
+    size_t size = 0;
+    std::vector< VertexBufferChunk* > candidates;
+    for( size_t i = 0; i < _chunks.size(); ++i )
+    {
+        size += _chunks[i]->getResidentSize();
+        if( _chunks[i]->isEvictable( ))
+            candidates.push_back( _chunks[i] );
+    }
+    if( size <= _maxResidentSize )
+        return;
+
+    std::sort( candidates.begin(), candidates.end(),
+               []( const VertexBufferChunk* a, const VertexBufferChunk* b )
+                   { return a->getLastUse() < b->getLastUse(); });
+
+    for( size_t i = 0; i < candidates.size() && size > _maxResidentSize; ++i )
+    {
+        size -= candidates[i]->getResidentSize();
+        candidates[i]->evict();
+    }
+}
+
 void VertexBufferDist::getInstanceData( co::DataOStream& os )
 {
     LBASSERT( _node );
@@ -136,9 +563,27 @@ void VertexBufferDist::getInstanceData( co::DataOStream& os )
             LBASSERT( _root );
             const VertexBufferData& data = _root->_data;
 
-            os << data.vertices << data.colors << data.normals << data.indices
-               << _root->_name;
+            os << !_chunks.empty();
+            if( _chunks.empty( ))
+                os << data.vertices << data.colors << data.normals
+                   << data.indices << data.packedVertices << data.packedNormals;
+            else
+            {
+                os << !data.colors.empty() << uint64_t( _chunks.size( ));
+                for( size_t i = 0; i < _chunks.size(); ++i )
+                    os << _chunks[i]->getID() << _chunks[i]->getRange();
+            }
+            os << data.compact << data.lodVertices << data.lodColors
+               << data.lodNormals << data.lodIndices << _root->_name;
         }
+
+        LBASSERT( dynamic_cast< const VertexBufferNode* >( _node ));
+        const VertexBufferNode* node =
+            static_cast< const VertexBufferNode* >( _node );
+        os << uint64_t( node->_lodVertexStart )
+           << uint64_t( node->_lodIndexStart )
+           << uint64_t( node->_lodIndexLength ) << node->_lodVertexLength
+           << node->_lodError;
     }
     else
     {
@@ -148,9 +593,20 @@ void VertexBufferDist::getInstanceData( co::DataOStream& os )
         const VertexBufferLeaf* leaf =
             static_cast< const VertexBufferLeaf* >( _node );
 
+        // in chunked mode, the starts are relative to the chunk
+        uint64_t vertexStart = leaf->_vertexStart;
+        uint64_t indexStart = leaf->_indexStart;
+        if( _chunk )
+        {
+            vertexStart -= _chunk->getVertexStart();
+            indexStart -= _chunk->getIndexStart();
+            os << _chunk->getIndex();
+        }
+
         os << leaf->_boundingBox[0] << leaf->_boundingBox[1]
-           << uint64_t( leaf->_vertexStart ) << uint64_t( leaf->_indexStart )
-           << uint64_t( leaf->_indexLength ) << leaf->_vertexLength;
+           << vertexStart << indexStart
+           << uint64_t( leaf->_indexLength ) << leaf->_vertexLength
+           << leaf->_packCenter << leaf->_packScale;
     }
 
     os << _node->_boundingSphere << _node->_range;
@@ -173,8 +629,29 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
             VertexBufferRoot* root = new VertexBufferRoot;
             VertexBufferData& data = root->_data;
 
-            is >> data.vertices >> data.colors >> data.normals >> data.indices
-               >> root->_name;
+            bool chunked;
+            is >> chunked;
+            if( !chunked )
+                is >> data.vertices >> data.colors >> data.normals
+                   >> data.indices >> data.packedVertices
+                   >> data.packedNormals;
+            else
+            {
+                uint64_t nChunks;
+                is >> root->_chunkColors >> nChunks;
+                for( uint64_t i = 0; i < nChunks; ++i )
+                {
+                    eq::uint128_t id;
+                    Range range;
+                    is >> id >> range;
+                    root->_chunks.push_back( new VertexBufferData );
+                    _chunks.push_back(
+                        new VertexBufferChunk( *root->_chunks.back(),
+                                               uint32_t( i ), id, range ));
+                }
+            }
+            is >> data.compact >> data.lodVertices >> data.lodColors
+               >> data.lodNormals >> data.lodIndices >> root->_name;
 
             node  = root;
             _root = root;
@@ -185,6 +662,13 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
             node = new VertexBufferNode;
         }
 
+        uint64_t i1, i2, i3;
+        is >> i1 >> i2 >> i3 >> node->_lodVertexLength >> node->_lodError;
+        node->_lodVertexStart = size_t( i1 );
+        node->_lodIndexStart = size_t( i2 );
+        node->_lodIndexLength = size_t( i3 );
+        node->_globalData = &_root->_data;
+
         base   = node;
         _left  = new VertexBufferDist( _root, 0 );
         _right = new VertexBufferDist( _root, 0 );
@@ -201,12 +685,20 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
     else
     {
         LBASSERT( !_isRoot );
-        VertexBufferData& data = _root->_data;
-        VertexBufferLeaf* leaf = new VertexBufferLeaf( data );
+        VertexBufferData* data = &_root->_data;
+        if( !_root->_chunks.empty( ))
+        {
+            uint32_t chunk;
+            is >> chunk;
+            LBASSERT( chunk < _root->_chunks.size( ));
+            data = _root->_chunks[ chunk ];
+        }
+        VertexBufferLeaf* leaf = new VertexBufferLeaf( *data );
 
         uint64_t i1, i2, i3;
         is >> leaf->_boundingBox[0] >> leaf->_boundingBox[1]
-           >> i1 >> i2 >> i3 >> leaf->_vertexLength;
+           >> i1 >> i2 >> i3 >> leaf->_vertexLength
+           >> leaf->_packCenter >> leaf->_packScale;
         leaf->_vertexStart = size_t( i1 );
         leaf->_indexStart = size_t( i2 );
         leaf->_indexLength = size_t( i3 );
@@ -218,6 +710,8 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
     is >> base->_boundingSphere >> base->_range;
 
     _node = base;
+    if( _isRoot ) // all subtrees are synced
+        _root->_culler.setup( _root );
 }
 
 }
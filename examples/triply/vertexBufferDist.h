@@ -35,23 +35,66 @@
 #include "typedefs.h"
 
 #include <co/co.h>
+#include <lunchbox/lock.h>
+#include <vector>
 
 namespace triply
 {
-/** Uses co::Object to distribute a model, holds a VertexBufferBase node. */
+class VertexBufferChunk;
+
+/**
+ * Uses co::Object to distribute a model, holds a VertexBufferBase node.
+ *
+ * By default the root object carries all model data. In chunked mode it only
+ * carries the tree and the LOD proxies, and the leaf geometry is distributed in
+ * separate chunk objects, each holding a run of consecutive leaves. Slaves map
+ * the chunks on demand using loadRange().
+ */
 class VertexBufferDist : public co::Object
 {
 public:
     TRIPLY_API VertexBufferDist();
-    TRIPLY_API explicit VertexBufferDist( triply::VertexBufferRoot* root );
+    TRIPLY_API explicit VertexBufferDist( triply::VertexBufferRoot* root,
+                                          bool chunked = false );
     TRIPLY_API virtual ~VertexBufferDist();
 
     TRIPLY_API void registerTree( co::LocalNodePtr node );
     TRIPLY_API void deregisterTree();
 
+    /** Unmap a tree and its chunks loaded by loadModel(). */
+    TRIPLY_API void unmapTree();
+
     TRIPLY_API triply::VertexBufferRoot* loadModel( co::NodePtr master,
                                                     co::LocalNodePtr localNode,
                                                     const eq::uint128_t& modelID );
+
+    /**
+     * Map and pin the leaf geometry of the given model range on a chunked
+     * slave.
+     *
+     * Blocks until the chunks intersecting the range are mapped, and starts
+     * mapping their neighbours in the background. The chunks stay resident
+     * until the range is released using releaseRange(). Unpinned chunks are
+     * evicted least recently used first when the resident geometry exceeds
+     * the maximum resident size. Thread safe, concurrent calls only
+     * serialize the bookkeeping, not the waits for the mappings.
+     */
+    TRIPLY_API void loadRange( const Range& range );
+
+    /** Unpin the chunks of a range loaded by loadRange(). Thread safe. */
+    TRIPLY_API void releaseRange( const Range& range );
+
+    /**
+     * Start mapping the chunks of the given range without waiting for them,
+     * e.g., for the range expected in the next draw. Thread safe.
+     */
+    TRIPLY_API void prefetchRange( const Range& range );
+
+    /** Set the resident geometry size above which chunks are evicted. */
+    void setMaxResidentSize( const size_t bytes ) { _maxResidentSize = bytes; }
+
+    /** @return the size of the mapped leaf geometry on a chunked slave. */
+    TRIPLY_API size_t getResidentSize();
 protected:
     TRIPLY_API VertexBufferDist( VertexBufferRoot* root,
                                  VertexBufferBase* node );
@@ -65,6 +108,18 @@ private:
     VertexBufferDist* _left;
     VertexBufferDist* _right;
     bool _isRoot;
+
+    std::vector< VertexBufferChunk* > _chunks; // root in chunked mode
+    VertexBufferChunk* _chunk; // leaf in chunked mode, holding its geometry
+    co::NodePtr _master; // slave root in chunked mode
+    size_t _maxResidentSize;
+    uint64_t _useCount; // LRU clock of loadRange()
+    lunchbox::Lock _lock; // chunk state of the range functions
+
+    void _setupChunks();
+    void _prefetchRange( const Range& range );
+    void _evictChunks();
+    void _collectLeaves( std::vector< VertexBufferDist* >& leaves );
 };
 }
 
@@ -32,53 +32,339 @@
 #include "vertexBufferData.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
-#include <map>
+#include <algorithm>
+#include <cmath>
 
 namespace triply
 {
+namespace
+{
+const Index _empty = Index( -1 );
+
+/*  Open addressing hash map from model to leaf vertex indices, sized for the
+    at most 3 * length distinct vertices of one leaf.  */
+class IndexMap
+{
+public:
+    explicit IndexMap( const Index size )
+        : _mask( _getCapacity( size ) - 1 )
+        , _keys( _mask + 1, _empty )
+        , _values( _mask + 1 )
+    {}
+
+    /*  @return true if the key was inserted, value returns the stored value. */
+    bool insert( const Index key, const ShortIndex newValue, ShortIndex& value )
+    {
+        for( Index slot = _hash( key ); ; slot = ( slot + 1 ) & _mask )
+        {
+            if( _keys[ slot ] == key )
+            {
+                value = _values[ slot ];
+                return false;
+            }
+            if( _keys[ slot ] == _empty )
+            {
+                _keys[ slot ] = key;
+                _values[ slot ] = value = newValue;
+                return true;
+            }
+        }
+    }
+
+private:
+    const Index _mask;
+    std::vector< Index > _keys;
+    std::vector< ShortIndex > _values;
+
+    static Index _getCapacity( const Index size )
+    {
+        Index capacity = 16;
+        while( capacity < 2 * size ) // load factor <= .5
+            capacity <<= 1;
+        return capacity;
+    }
+
+    Index _hash( const Index key ) const
+        { return Index( key * 2654435761u ) & _mask; }
+};
+
+/*  Linear-speed vertex cache optimisation, see Tom Forsyth,
+    https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html  */
+const size_t _cacheSize = 32;
+
+float _getVertexScore( const int cachePosition, const uint32_t remaining )
+{
+    if( remaining == 0 ) // no triangle needs this vertex
+        return -1.f;
+
+    float score = 0.f;
+    if( cachePosition >= 3 )
+        score = powf( 1.f - float( cachePosition - 3 ) /
+                            float( _cacheSize - 3 ), 1.5f );
+    else if( cachePosition >= 0 ) // used by the last triangle
+        score = .75f;
+
+    // boost vertices with few remaining triangles, to finish them off
+    return score + 2.f / sqrtf( float( remaining ));
+}
+
+/*  Reorder the triangles of the given indices for post-transform cache
+    locality.  */
+void _optimizeVertexCache( std::vector< ShortIndex >& indices,
+                           const size_t nVertices )
+{
+    const size_t nTriangles = indices.size() / 3;
+    if( nTriangles == 0 )
+        return;
+
+    // triangles adjacent to each vertex, remaining ones first
+    std::vector< uint32_t > remaining( nVertices, 0 );
+    for( size_t i = 0; i < indices.size(); ++i )
+        ++remaining[ indices[i] ];
+
+    std::vector< uint32_t > offsets( nVertices + 1, 0 );
+    for( size_t v = 0; v < nVertices; ++v )
+        offsets[ v + 1 ] = offsets[ v ] + remaining[ v ];
+
+    std::vector< uint32_t > adjacency( indices.size( ));
+    std::vector< uint32_t > fill( offsets.begin(), offsets.end() - 1 );
+    for( size_t i = 0; i < indices.size(); ++i )
+        adjacency[ fill[ indices[i] ]++ ] = uint32_t( i / 3 );
+
+    std::vector< int > cachePositions( nVertices, -1 );
+    std::vector< float > vertexScores( nVertices );
+    for( size_t v = 0; v < nVertices; ++v )
+        vertexScores[v] = _getVertexScore( -1, remaining[v] );
+
+    std::vector< float > triangleScores( nTriangles );
+    std::vector< bool > emitted( nTriangles, false );
+    for( size_t t = 0; t < nTriangles; ++t )
+        triangleScores[t] = vertexScores[ indices[ 3 * t ]] +
+                            vertexScores[ indices[ 3 * t + 1 ]] +
+                            vertexScores[ indices[ 3 * t + 2 ]];
+
+    std::vector< ShortIndex > result;
+    result.reserve( indices.size( ));
+    std::vector< ShortIndex > cache, newCache;
+    cache.reserve( _cacheSize + 3 );
+    newCache.reserve( _cacheSize + 3 );
+
+    size_t best = 0;
+    for( size_t t = 1; t < nTriangles; ++t )
+        if( triangleScores[t] > triangleScores[ best ] )
+            best = t;
+
+    size_t scan = 0; // all triangles before are emitted
+    for( size_t n = 0; n < nTriangles; ++n )
+    {
+        if( best == nTriangles ) // nothing in cache, pick the best remaining
+        {
+            while( emitted[ scan ] )
+                ++scan;
+            best = scan;
+            for( size_t t = scan + 1; t < nTriangles; ++t )
+                if( !emitted[t] && triangleScores[t] > triangleScores[ best ])
+                    best = t;
+        }
+
+        emitted[ best ] = true;
+        newCache.clear();
+        for( size_t i = 0; i < 3; ++i )
+        {
+            const ShortIndex v = indices[ 3 * best + i ];
+            result.push_back( v );
+            newCache.push_back( v );
+
+            // remove the triangle from the vertex' remaining adjacency
+            uint32_t* begin = &adjacency[ offsets[v] ];
+            uint32_t* end = begin + remaining[v];
+            *std::find( begin, end, uint32_t( best )) = *( end - 1 );
+            --remaining[v];
+        }
+        for( size_t i = 0; i < cache.size(); ++i )
+            if( std::find( newCache.begin(), newCache.begin() + 3, cache[i] ) ==
+                newCache.begin() + 3 )
+            {
+                newCache.push_back( cache[i] );
+            }
+        cache.swap( newCache );
+
+        // update scores of all touched vertices and their triangles
+        for( size_t i = 0; i < cache.size(); ++i )
+        {
+            const ShortIndex v = cache[i];
+            cachePositions[v] = i < _cacheSize ? int( i ) : -1;
+            vertexScores[v] = _getVertexScore( cachePositions[v],
+                                               remaining[v] );
+        }
+
+        best = nTriangles;
+        float bestScore = -1.f;
+        for( size_t i = 0; i < cache.size(); ++i )
+        {
+            const ShortIndex v = cache[i];
+            for( uint32_t j = offsets[v]; j < offsets[v] + remaining[v]; ++j )
+            {
+                const uint32_t t = adjacency[j];
+                const float score = vertexScores[ indices[ 3 * t ]] +
+                                    vertexScores[ indices[ 3 * t + 1 ]] +
+                                    vertexScores[ indices[ 3 * t + 2 ]];
+                triangleScores[t] = score;
+                if( score > bestScore )
+                {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+        if( cache.size() > _cacheSize )
+            cache.resize( _cacheSize );
+    }
+    indices.swap( result );
+}
+}
 
-/*  Finish partial setup - sort, reindex and merge into global data.  */
+/*  Finish partial setup - sort and reindex the leaf triangles.  */
 void VertexBufferLeaf::setupTree( VertexData& data, const Index start,
                                   const Index length, const Axis axis,
-                                  const size_t depth,
+                                  const size_t,
                                   VertexBufferData& globalData,
-                                  boost::progress_display& progress )
+                                  boost::progress_display& )
 {
     data.sort( start, length, axis );
-    _vertexStart = globalData.vertices.size();
-    _vertexLength = 0;
-    _indexStart = globalData.indices.size();
-    _indexLength = 0;
 
-    const bool hasColors = !data.colors.empty();
-
-    // stores the new indices (relative to _start)
-    std::map< Index, ShortIndex > newIndex;
+    // stores the new indices (relative to _vertexStart) in first use order
+    IndexMap newIndex( 3 * length );
+    _setupVertices.clear();
+    _setupIndices.resize( 3 * length );
 
     for( Index t = 0; t < length; ++t )
     {
         for( Index v = 0; v < 3; ++v )
         {
-            Index i = data.triangles[start + t][v];
-            if( newIndex.find( i ) == newIndex.end() )
+            const Index i = data.triangles[start + t][v];
+            ShortIndex& index = _setupIndices[ 3 * t + v ];
+            if( newIndex.insert( i, ShortIndex( _setupVertices.size( )),
+                                 index ))
             {
-                newIndex[i] = _vertexLength++;
+                _setupVertices.push_back( i );
                 // assert number of vertices does not exceed SmallIndex range
-                PLYLIBASSERT( _vertexLength );
-                globalData.vertices.push_back( data.vertices[i] );
-                if( hasColors )
-                    globalData.colors.push_back( data.colors[i] );
-                globalData.normals.push_back( data.normals[i] );
+                PLYLIBASSERT( ShortIndex( _setupVertices.size( )));
             }
-            globalData.indices.push_back( newIndex[i] );
-            ++_indexLength;
         }
     }
+
+    if( !globalData.compact )
+        return;
+
+    // reorder triangles for the vertex cache, then renumber the vertices in
+    // the new first use order for sequential vertex fetches
+    _optimizeVertexCache( _setupIndices, _setupVertices.size( ));
+
+    const ShortIndex unused = ShortIndex( -1 );
+    std::vector< ShortIndex > renumber( _setupVertices.size(), unused );
+    std::vector< Index > vertices;
+    vertices.reserve( _setupVertices.size( ));
+    for( size_t i = 0; i < _setupIndices.size(); ++i )
+    {
+        ShortIndex& index = _setupIndices[i];
+        if( renumber[ index ] == unused )
+        {
+            renumber[ index ] = ShortIndex( vertices.size( ));
+            vertices.push_back( _setupVertices[ index ] );
+        }
+        index = renumber[ index ];
+    }
+    _setupVertices.swap( vertices );
+}
+
+
+/*  Merge the reindexed leaf data into the global data.  */
+void VertexBufferLeaf::mergeTree( const VertexData& data,
+                                  VertexBufferData& globalData,
+                                  const size_t depth,
+                                  boost::progress_display& progress )
+{
+    _vertexStart = globalData.compact ? globalData.packedVertices.size() :
+                                        globalData.vertices.size();
+    _vertexLength = ShortIndex( _setupVertices.size( ));
+    _indexStart = globalData.indices.size();
+    _indexLength = Index( _setupIndices.size( ));
+
+    const bool hasColors = !data.colors.empty();
+    if( globalData.compact )
+        _pack( data );
+    for( std::vector< Index >::const_iterator i = _setupVertices.begin();
+         i != _setupVertices.end(); ++i )
+    {
+        if( hasColors )
+            globalData.colors.push_back( data.colors[*i] );
+        if( globalData.compact )
+            continue;
+        globalData.vertices.push_back( data.vertices[*i] );
+        globalData.normals.push_back( data.normals[*i] );
+    }
+    globalData.indices.append( _setupIndices.begin(), _setupIndices.end( ));
+
+    std::vector< Index >().swap( _setupVertices );
+    std::vector< ShortIndex >().swap( _setupIndices );
     if( depth == 3 )
         ++progress;
 }
 
 
+/*  Quantize the leaf vertices to its bounding box and encode the normals.  */
+void VertexBufferLeaf::_pack( const VertexData& data )
+{
+    Vertex min = data.vertices[ _setupVertices.front() ];
+    Vertex max = min;
+    for( std::vector< Index >::const_iterator i = _setupVertices.begin();
+         i != _setupVertices.end(); ++i )
+    {
+        const Vertex& vertex = data.vertices[*i];
+        for( size_t j = 0; j < 3; ++j )
+        {
+            min[j] = std::min( min[j], vertex[j] );
+            max[j] = std::max( max[j], vertex[j] );
+        }
+    }
+
+    // uniform scale, so that normals stay correct under the leaf transform
+    const Vertex halfExtent = ( max - min ) * .5f;
+    const float extent = std::max( halfExtent.x(),
+                                   std::max( halfExtent.y(), halfExtent.z( )));
+    _packCenter = ( min + max ) * .5f;
+    _packScale = extent > 0.f ? extent / 32767.f : 1.f;
+
+    for( std::vector< Index >::const_iterator i = _setupVertices.begin();
+         i != _setupVertices.end(); ++i )
+    {
+        _globalData.packedVertices.push_back(
+            packVertex( data.vertices[*i], _packCenter, _packScale ));
+        _globalData.packedNormals.push_back( encodeNormal( data.normals[*i] ));
+    }
+}
+
+
+/*  @return the model space position of the given vertex.  */
+inline Vertex VertexBufferLeaf::_getVertex( const Index i ) const
+{
+    if( !_globalData.compact )
+        return _globalData.vertices[i];
+
+    return unpackVertex( _globalData.packedVertices[i], _packCenter,
+                         _packScale );
+}
+
+
+/*  @return the unit normal of the given vertex.  */
+inline Normal VertexBufferLeaf::_getNormal( const Index i ) const
+{
+    return _globalData.compact ? decodeNormal( _globalData.packedNormals[i] ) :
+                                 _globalData.normals[i];
+}
+
+
 /*  Compute the bounding sphere of the leaf's indexed vertices.  */
 const BoundingSphere& VertexBufferLeaf::updateBoundingSphere()
 {
@@ -90,15 +376,14 @@ const BoundingSphere& VertexBufferLeaf::updateBoundingSphere()
 
 
     // 1a) initialize and compute a bounding box
-    _boundingBox[0] = _globalData.vertices[ _vertexStart +
-                                            _globalData.indices[_indexStart] ];
-    _boundingBox[1] = _globalData.vertices[ _vertexStart +
-                                            _globalData.indices[_indexStart] ];
+    _boundingBox[0] = _getVertex( _vertexStart +
+                                  _globalData.indices[_indexStart] );
+    _boundingBox[1] = _boundingBox[0];
 
     for( Index i = 1 + _indexStart; i < _indexStart + _indexLength; ++i )
     {
-        const Vertex& vertex = _globalData.vertices[ _vertexStart +
-                                                     _globalData.indices[ i ] ];
+        const Vertex vertex = _getVertex( _vertexStart +
+                                          _globalData.indices[ i ] );
         _boundingBox[0][0] = std::min( _boundingBox[0][0], vertex[0] );
         _boundingBox[1][0] = std::max( _boundingBox[1][0], vertex[0] );
         _boundingBox[0][1] = std::min( _boundingBox[0][1], vertex[1] );
@@ -125,9 +410,9 @@ const BoundingSphere& VertexBufferLeaf::updateBoundingSphere()
     // 2) test all points to be in the estimated bounding sphere
     for( Index offset = 0; offset < _indexLength; ++offset )
     {
-        const Vertex& vertex =
-            _globalData.vertices[ _vertexStart +
-                                  _globalData.indices[_indexStart + offset] ];
+        const Vertex vertex =
+            _getVertex( _vertexStart +
+                        _globalData.indices[_indexStart + offset] );
 
         const Vertex centerToPoint   = vertex - center;
         const float  distanceSquared = centerToPoint.squared_length();
@@ -154,9 +439,9 @@ const BoundingSphere& VertexBufferLeaf::updateBoundingSphere()
     // 2a) re-test all points to be in the estimated bounding sphere
     for( Index offset = 0; offset < _indexLength; ++offset )
     {
-        const Vertex& vertex =
-            _globalData.vertices[ _vertexStart +
-                                  _globalData.indices[_indexStart + offset] ];
+        const Vertex vertex =
+            _getVertex( _vertexStart +
+                        _globalData.indices[_indexStart + offset] );
 
         const Vertex centerToPoint   = vertex - center;
         const float  distanceSquared = centerToPoint.squared_length();
@@ -201,14 +486,43 @@ void VertexBufferLeaf::setupRendering( VertexBufferState& state,
         if( data[VERTEX_OBJECT] == state.INVALID )
             data[VERTEX_OBJECT] = state.newBufferObject( charThis + 0 );
         glBindBuffer( GL_ARRAY_BUFFER, data[VERTEX_OBJECT] );
-        glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Vertex ),
-                        &_globalData.vertices[_vertexStart], GL_STATIC_DRAW );
+        if( _globalData.compact )
+            glBufferData( GL_ARRAY_BUFFER,
+                          _vertexLength * sizeof( PackedVertex ),
+                          &_globalData.packedVertices[_vertexStart],
+                          GL_STATIC_DRAW );
+        else
+            glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Vertex ),
+                          &_globalData.vertices[_vertexStart], GL_STATIC_DRAW );
 
         if( data[NORMAL_OBJECT] == state.INVALID )
-            data[NORMAL_OBJECT] = state.newBufferObject( charThis + 1 );
+            data[NORMAL_OBJECT] = state.newBufferObject( _getNormalKey( state ));
         glBindBuffer( GL_ARRAY_BUFFER, data[NORMAL_OBJECT] );
-        glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Normal ),
-                        &_globalData.normals[_vertexStart], GL_STATIC_DRAW );
+        if( !_globalData.compact )
+            glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Normal ),
+                          &_globalData.normals[_vertexStart], GL_STATIC_DRAW );
+        else if( state.useOctNormals( ))
+        {
+            // the shader decodes x, y of a normalized short normal array
+            std::vector< int16_t > normals( 3 * _vertexLength, 0 );
+            for( ShortIndex i = 0; i < _vertexLength; ++i )
+            {
+                const PackedNormal& normal =
+                    _globalData.packedNormals[ _vertexStart + i ];
+                normals[ 3 * i ] = normal.x();
+                normals[ 3 * i + 1 ] = normal.y();
+            }
+            glBufferData( GL_ARRAY_BUFFER, normals.size() * sizeof( int16_t ),
+                          &normals[0], GL_STATIC_DRAW );
+        }
+        else
+        {
+            std::vector< Normal > normals( _vertexLength );
+            for( ShortIndex i = 0; i < _vertexLength; ++i )
+                normals[i] = _getNormal( _vertexStart + i );
+            glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Normal ),
+                          &normals[0], GL_STATIC_DRAW );
+        }
 
         if( data[COLOR_OBJECT] == state.INVALID )
             data[COLOR_OBJECT] = state.newBufferObject( charThis + 2 );
@@ -251,6 +565,8 @@ void VertexBufferLeaf::draw( VertexBufferState& state ) const
 {
     if( state.stopRendering( ))
         return;
+    if( _globalData.indices.empty( )) // chunk not mapped by VertexBufferDist
+        return;
 
     state.updateRegion( _boundingBox );
     switch( state.getRenderMode() )
@@ -275,6 +591,7 @@ void VertexBufferLeaf::renderBufferObject( VertexBufferState& state ) const
     for( int i = 0; i < 4; ++i )
         buffers[i] =
             state.getBufferObject( reinterpret_cast< const char* >(this) + i );
+    buffers[NORMAL_OBJECT] = state.getBufferObject( _getNormalKey( state ));
     if( buffers[VERTEX_OBJECT] == state.INVALID ||
         buffers[NORMAL_OBJECT] == state.INVALID ||
         buffers[COLOR_OBJECT] == state.INVALID ||
@@ -287,12 +604,38 @@ void VertexBufferLeaf::renderBufferObject( VertexBufferState& state ) const
         glBindBuffer( GL_ARRAY_BUFFER, buffers[COLOR_OBJECT] );
         glColorPointer( 3, GL_UNSIGNED_BYTE, 0, 0 );
     }
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffers[INDEX_OBJECT] );
     glBindBuffer( GL_ARRAY_BUFFER, buffers[NORMAL_OBJECT] );
-    glNormalPointer( GL_FLOAT, 0, 0 );
+    if( !_globalData.compact )
+    {
+        glNormalPointer( GL_FLOAT, 0, 0 );
+        glBindBuffer( GL_ARRAY_BUFFER, buffers[VERTEX_OBJECT] );
+        glVertexPointer( 3, GL_FLOAT, 0, 0 );
+        glDrawElements( GL_TRIANGLES, GLsizei(_indexLength),
+                        GL_UNSIGNED_SHORT, 0 );
+        return;
+    }
+
+    glNormalPointer( state.useOctNormals() ? GL_SHORT : GL_FLOAT, 0, 0 );
     glBindBuffer( GL_ARRAY_BUFFER, buffers[VERTEX_OBJECT] );
-    glVertexPointer( 3, GL_FLOAT, 0, 0 );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffers[INDEX_OBJECT] );
+    glVertexPointer( 3, GL_SHORT, 0, 0 );
+
+    // dequantize positions, GL_NORMALIZE is enabled by the root
+    glPushMatrix();
+    glTranslatef( _packCenter.x(), _packCenter.y(), _packCenter.z( ));
+    glScalef( _packScale, _packScale, _packScale );
     glDrawElements( GL_TRIANGLES, GLsizei(_indexLength), GL_UNSIGNED_SHORT, 0 );
+    glPopMatrix();
+}
+
+
+/*  @return the buffer object key of the normals, which depend on whether
+    compact normals are decoded by the shader.  */
+const void* VertexBufferLeaf::_getNormalKey( const VertexBufferState& state )
+    const
+{
+    const char* charThis = reinterpret_cast< const char* >( this );
+    return charThis + ( state.useOctNormals() && _globalData.compact ? 4 : 1 );
 }
 
 
@@ -323,6 +666,12 @@ void VertexBufferLeaf::renderImmediate( VertexBufferState& state ) const
         const Index i =_vertexStart + _globalData.indices[_indexStart + offset];
         if( state.useColors() )
             glColor3ubv( &_globalData.colors[i][0] );
+        if( _globalData.compact )
+        {
+            glNormal3fv( _getNormal( i ).array );
+            glVertex3fv( _getVertex( i ).array );
+            continue;
+        }
         glNormal3fv( &_globalData.normals[i][0] );
         glVertex3fv( &_globalData.vertices[i][0] );
     }
@@ -349,6 +698,10 @@ void VertexBufferLeaf::fromMemory( char** addr, VertexBufferData& globalData )
              sizeof( Index ) );
     memRead( reinterpret_cast< char* >( &_indexLength ), addr,
              sizeof( Index ) );
+    memRead( reinterpret_cast< char* >( &_packCenter ), addr,
+             sizeof( Vertex ) );
+    memRead( reinterpret_cast< char* >( &_packScale ), addr,
+             sizeof( float ) );
 }
 
 
@@ -363,6 +716,8 @@ void VertexBufferLeaf::toStream( std::ostream& os )
     os.write( reinterpret_cast< char* >( &_vertexLength ),sizeof( ShortIndex ));
     os.write( reinterpret_cast< char* >( &_indexStart ), sizeof( Index ));
     os.write( reinterpret_cast< char* >( &_indexLength ), sizeof( Index ));
+    os.write( reinterpret_cast< char* >( &_packCenter ), sizeof( Vertex ));
+    os.write( reinterpret_cast< char* >( &_packScale ), sizeof( float ));
 }
 
 }
@@ -31,6 +31,7 @@
 #define PLYLIB_VERTEXBUFFERLEAF_H
 
 #include "vertexBufferBase.h"
+#include <vector>
 
 namespace triply
 {
@@ -40,12 +41,18 @@ class VertexBufferLeaf : public VertexBufferBase
 public:
     explicit VertexBufferLeaf( VertexBufferData& data )
         : _globalData( data ), _vertexStart( 0 ), _indexStart( 0 )
-        , _indexLength( 0 ), _vertexLength( 0 ) {}
+        , _indexLength( 0 ), _vertexLength( 0 ), _packCenter( 0.f )
+        , _packScale( 1.f ) {}
     virtual ~VertexBufferLeaf() {}
 
     virtual void draw( VertexBufferState& state ) const;
     virtual Index getNumberOfVertices() const { return _indexLength; }
 
+    Index getVertexStart() const { return _vertexStart; }
+    ShortIndex getVertexLength() const { return _vertexLength; }
+    Index getIndexStart() const { return _indexStart; }
+    Index getIndexLength() const { return _indexLength; }
+
 protected:
     virtual void toStream( std::ostream& os );
     virtual void fromMemory( char** addr, VertexBufferData& globalData );
@@ -55,6 +62,9 @@ protected:
                             const size_t depth,
                             VertexBufferData& globalData,
                             boost::progress_display& );
+    virtual void mergeTree( const VertexData& data,
+                            VertexBufferData& globalData, const size_t depth,
+                            boost::progress_display& );
     virtual const BoundingSphere& updateBoundingSphere();
     virtual void updateRange();
 
@@ -64,6 +74,11 @@ private:
     void renderDisplayList( VertexBufferState& state ) const;
     void renderBufferObject( VertexBufferState& state ) const;
 
+    const void* _getNormalKey( const VertexBufferState& state ) const;
+    Vertex _getVertex( Index i ) const;
+    Normal _getNormal( Index i ) const;
+    void _pack( const VertexData& data );
+
     friend class VertexBufferDist;
     VertexBufferData&   _globalData;
     BoundingBox         _boundingBox;
@@ -71,6 +86,14 @@ private:
     Index               _indexStart;
     Index               _indexLength;
     ShortIndex          _vertexLength;
+
+    // dequantization of compact leaves: vertex = center + packed * scale
+    Vertex              _packCenter;
+    float               _packScale;
+
+    // leaf data between setupTree() and mergeTree()
+    std::vector< Index >      _setupVertices; // model index per leaf vertex
+    std::vector< ShortIndex > _setupIndices;
 };
 }
 
@@ -29,21 +29,51 @@
 
 
 #include "vertexBufferNode.h"
+#include "vertexBufferData.h"
 #include "vertexBufferLeaf.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
+#include <algorithm>
+#include <cmath>
 #include <set>
 
+#if defined( _OPENMP ) && _OPENMP >= 200805 // OpenMP 3.0 tasks
+#  define TRIPLY_USE_TASKS
+#endif
+
 namespace triply
 {
+namespace
+{
+// subtrees below this size are not worth a task of their own
+const Index _minTaskLength = 8 * LEAF_SIZE;
+
+// LOD proxies cluster vertices in a grid of this many cells along the longest
+// axis, which keeps their vertex count in ShortIndex range
+const size_t _lodGridSize = 32;
+// subtrees up to this size are drawn from their leaves
+const Index _minLODLength = 2 * LEAF_SIZE;
+
+/*  @return a key for the triangle, equal for all rotations of its indices. */
+uint64_t _getTriangleKey( const uint64_t a, const uint64_t b, const uint64_t c )
+{
+    if( a <= b && a <= c )
+        return ( a << 32 ) | ( b << 16 ) | c;
+    if( b <= a && b <= c )
+        return ( b << 32 ) | ( c << 16 ) | a;
+    return ( c << 32 ) | ( a << 16 ) | b;
+}
+}
 
 /*  Destructor, clears up children as well.  */
 VertexBufferNode::~VertexBufferNode()
 {
     delete _left;
     delete _right;
+    delete _lodSetup;
     _left = 0;
     _right = 0;
+    _lodSetup = 0;
 }
 
 inline static bool _subdivide( const Index length, const size_t depth )
@@ -51,14 +81,20 @@ inline static bool _subdivide( const Index length, const size_t depth )
     return ( length / 2 > LEAF_SIZE ) || ( depth < 3 && length > 1 );
 }
 
-/*  Continue kd-tree setup, create intermediary or leaf nodes as required.  */
+/*  Continue kd-tree setup, create intermediary or leaf nodes as required.
+    Sibling subtrees are built concurrently, their leaves are merged into the
+    global data in tree order by mergeTree(). */
 void VertexBufferNode::setupTree( VertexData& data, const Index start,
                                   const Index length, const Axis axis,
                                   const size_t depth,
                                   VertexBufferData& globalData,
                                   boost::progress_display& progress )
 {
-    data.sort( start, length, axis );
+    _globalData = &globalData;
+
+    // the children sort or partition their halves again, only the median
+    // split of the sorted order matters here
+    data.partition( start, length, axis );
     const Index median = start + ( length / 2 );
 
     // left child will include elements smaller than the median
@@ -86,12 +122,180 @@ void VertexBufferNode::setupTree( VertexData& data, const Index start,
     const Axis newAxisRight = subdivideRight ?
                         data.getLongestAxis( median, rightLength ) : AXIS_X;
 
+#ifdef TRIPLY_USE_TASKS
+    const bool spawn = leftLength >= _minTaskLength;
+#  pragma omp task if( spawn ) default( shared )
+#endif
     static_cast< VertexBufferNode* >
             ( _left )->setupTree( data, start, leftLength, newAxisLeft, depth+1,
                                   globalData, progress );
     static_cast< VertexBufferNode* >
         ( _right )->setupTree( data, median, rightLength, newAxisRight, depth+1,
                                globalData, progress );
+#ifdef TRIPLY_USE_TASKS
+#  pragma omp taskwait
+#endif
+
+    if( length > _minLODLength )
+        _setupLOD( data, start, length );
+}
+
+
+/*  Build the vertex-clustered proxy of the subtree's triangles.  */
+void VertexBufferNode::_setupLOD( const VertexData& data, const Index start,
+                                  const Index length )
+{
+    // bounding box of the subtree
+    Vertex min = data.vertices[ data.triangles[start][0] ];
+    Vertex max = min;
+    for( Index t = start; t < start + length; ++t )
+    {
+        for( Index v = 0; v < 3; ++v )
+        {
+            const Vertex& vertex = data.vertices[ data.triangles[t][v] ];
+            for( size_t i = 0; i < 3; ++i )
+            {
+                min[i] = std::min( min[i], vertex[i] );
+                max[i] = std::max( max[i], vertex[i] );
+            }
+        }
+    }
+
+    const Vertex extent = max - min;
+    const float longest = std::max( std::max( extent[0], extent[1] ),
+                                    extent[2] );
+    if( longest <= 0.f )
+        return;
+
+    const float cellSize = longest / float( _lodGridSize );
+    size_t dims[3];
+    for( size_t i = 0; i < 3; ++i )
+        dims[i] = std::min( size_t( extent[i] / cellSize ) + 1, _lodGridSize );
+
+    // cluster the triangle corners, averaging their attributes per cell
+    const bool hasColors = !data.colors.empty();
+    std::vector< int32_t > cells( dims[0] * dims[1] * dims[2], -1 );
+    std::vector< Vertex > positions;
+    std::vector< Normal > normals;
+    std::vector< uint32_t > colors;
+    std::vector< uint32_t > counts;
+    std::vector< uint64_t > keys;
+    keys.reserve( length );
+
+    for( Index t = start; t < start + length; ++t )
+    {
+        uint64_t corners[3];
+        for( Index v = 0; v < 3; ++v )
+        {
+            const Index i = data.triangles[t][v];
+            const Vertex& vertex = data.vertices[i];
+            size_t cell = 0;
+            for( size_t j = 3; j > 0; --j )
+            {
+                const size_t pos = std::min( size_t(( vertex[j-1] - min[j-1] ) /
+                                                    cellSize ), dims[j-1] - 1 );
+                cell = cell * dims[j-1] + pos;
+            }
+
+            int32_t& index = cells[ cell ];
+            if( index < 0 )
+            {
+                index = int32_t( counts.size( ));
+                positions.push_back( Vertex( 0.f ));
+                normals.push_back( Normal( 0.f ));
+                colors.resize( colors.size() + 3, 0 );
+                counts.push_back( 0 );
+            }
+
+            positions[ index ] += vertex;
+            normals[ index ] += data.normals[i];
+            if( hasColors )
+                for( size_t j = 0; j < 3; ++j )
+                    colors[ 3 * index + j ] += data.colors[i][j];
+            ++counts[ index ];
+            corners[v] = index;
+        }
+
+        // triangles collapsed by the clustering are dropped
+        if( corners[0] != corners[1] && corners[1] != corners[2] &&
+            corners[0] != corners[2] )
+        {
+            keys.push_back( _getTriangleKey( corners[0], corners[1],
+                                             corners[2] ));
+        }
+    }
+
+    std::sort( keys.begin(), keys.end( ));
+    keys.erase( std::unique( keys.begin(), keys.end( )), keys.end( ));
+
+    // not worth it, draw the children instead
+    if( keys.empty() || keys.size() * 4 > length )
+        return;
+
+    _lodSetup = new VertexBufferData;
+    for( size_t i = 0; i < counts.size(); ++i )
+    {
+        const float count = float( counts[i] );
+        _lodSetup->vertices.push_back( positions[i] / count );
+
+        Normal normal = normals[i];
+        if( normal.squared_length() > 0.f )
+            normal.normalize();
+        _lodSetup->normals.push_back( normal );
+
+        if( hasColors )
+            _lodSetup->colors.push_back(
+                Color( uint8_t( colors[ 3 * i ] / counts[i] ),
+                       uint8_t( colors[ 3 * i + 1 ] / counts[i] ),
+                       uint8_t( colors[ 3 * i + 2 ] / counts[i] )));
+    }
+
+    for( std::vector< uint64_t >::const_iterator i = keys.begin();
+         i != keys.end(); ++i )
+    {
+        _lodSetup->indices.push_back( ShortIndex( *i >> 32 ));
+        _lodSetup->indices.push_back( ShortIndex( *i >> 16 ));
+        _lodSetup->indices.push_back( ShortIndex( *i ));
+    }
+    _lodError = cellSize * std::sqrt( 3.f );
+}
+
+
+/*  Merge the children's leaf data into the global data, left to right.  */
+void VertexBufferNode::mergeTree( const VertexData& data,
+                                  VertexBufferData& globalData,
+                                  const size_t depth,
+                                  boost::progress_display& progress )
+{
+    static_cast< VertexBufferNode* >
+            ( _left )->mergeTree( data, globalData, depth+1, progress );
+    static_cast< VertexBufferNode* >
+            ( _right )->mergeTree( data, globalData, depth+1, progress );
+
+    if( _lodSetup )
+    {
+        const VertexBufferData& lod = *_lodSetup;
+        _lodVertexStart = globalData.lodVertices.size();
+        _lodVertexLength = ShortIndex( lod.vertices.size( ));
+        _lodIndexStart = globalData.lodIndices.size();
+        _lodIndexLength = lod.indices.size();
+
+        const Vertex* vertices = lod.vertices.getData();
+        const Normal* normals = lod.normals.getData();
+        globalData.lodVertices.append( vertices, vertices + _lodVertexLength );
+        globalData.lodNormals.append( normals, normals + _lodVertexLength );
+        if( !lod.colors.empty( ))
+        {
+            const Color* colors = lod.colors.getData();
+            globalData.lodColors.append( colors, colors + _lodVertexLength );
+        }
+        const ShortIndex* indices = lod.indices.getData();
+        globalData.lodIndices.append( indices, indices + _lodIndexLength );
+
+        delete _lodSetup;
+        _lodSetup = 0;
+    }
+
     if( depth == 3 )
         ++progress;
 }
@@ -146,6 +350,139 @@ void VertexBufferNode::draw( VertexBufferState& state ) const
 }
 
 
+#define glewGetContext state.glewGetContext
+
+/*  Draw the simplified proxy of the subtree.  */
+void VertexBufferNode::drawLOD( VertexBufferState& state ) const
+{
+    if( state.stopRendering( ))
+        return;
+
+    BoundingBox box;
+    const Vertex center( _boundingSphere.array );
+    box[0] = center - Vertex( _boundingSphere.w( ));
+    box[1] = center + Vertex( _boundingSphere.w( ));
+    state.updateRegion( box );
+
+    const char* charThis = reinterpret_cast< const char* >( this );
+    switch( state.getRenderMode() )
+    {
+    case RENDER_MODE_IMMEDIATE:
+        _renderLODImmediate( state );
+        return;
+
+    case RENDER_MODE_BUFFER_OBJECT:
+    {
+        GLuint buffers[4];
+        for( int i = 0; i < 4; ++i )
+            buffers[i] = state.getBufferObject( charThis + i );
+        if( buffers[VERTEX_OBJECT] == state.INVALID ||
+            buffers[NORMAL_OBJECT] == state.INVALID ||
+            buffers[COLOR_OBJECT] == state.INVALID ||
+            buffers[INDEX_OBJECT] == state.INVALID )
+        {
+            _setupLODRendering( state, buffers );
+        }
+
+        if( state.useColors() )
+        {
+            glBindBuffer( GL_ARRAY_BUFFER, buffers[COLOR_OBJECT] );
+            glColorPointer( 3, GL_UNSIGNED_BYTE, 0, 0 );
+        }
+        glBindBuffer( GL_ARRAY_BUFFER, buffers[NORMAL_OBJECT] );
+        glNormalPointer( GL_FLOAT, 0, 0 );
+        glBindBuffer( GL_ARRAY_BUFFER, buffers[VERTEX_OBJECT] );
+        glVertexPointer( 3, GL_FLOAT, 0, 0 );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffers[INDEX_OBJECT] );
+        glDrawElements( GL_TRIANGLES, GLsizei( _lodIndexLength ),
+                        GL_UNSIGNED_SHORT, 0 );
+        return;
+    }
+
+    case RENDER_MODE_DISPLAY_LIST:
+    default:
+    {
+        const char* key = charThis;
+        if( state.useColors( ))
+            ++key;
+
+        GLuint displayList = state.getDisplayList( key );
+        if( displayList == state.INVALID )
+            _setupLODRendering( state, &displayList );
+        glCallList( displayList );
+        return;
+    }
+    }
+}
+
+
+/*  Set up the buffer objects or display list of the proxy.  */
+void VertexBufferNode::_setupLODRendering( VertexBufferState& state,
+                                           GLuint* data ) const
+{
+    const char* charThis = reinterpret_cast< const char* >( this );
+    const VertexBufferData& global = *_globalData;
+
+    if( state.getRenderMode() == RENDER_MODE_BUFFER_OBJECT )
+    {
+        if( data[VERTEX_OBJECT] == state.INVALID )
+            data[VERTEX_OBJECT] = state.newBufferObject( charThis + 0 );
+        glBindBuffer( GL_ARRAY_BUFFER, data[VERTEX_OBJECT] );
+        glBufferData( GL_ARRAY_BUFFER, _lodVertexLength * sizeof( Vertex ),
+                      &global.lodVertices[_lodVertexStart], GL_STATIC_DRAW );
+
+        if( data[NORMAL_OBJECT] == state.INVALID )
+            data[NORMAL_OBJECT] = state.newBufferObject( charThis + 1 );
+        glBindBuffer( GL_ARRAY_BUFFER, data[NORMAL_OBJECT] );
+        glBufferData( GL_ARRAY_BUFFER, _lodVertexLength * sizeof( Normal ),
+                      &global.lodNormals[_lodVertexStart], GL_STATIC_DRAW );
+
+        if( data[COLOR_OBJECT] == state.INVALID )
+            data[COLOR_OBJECT] = state.newBufferObject( charThis + 2 );
+        if( state.useColors() )
+        {
+            glBindBuffer( GL_ARRAY_BUFFER, data[COLOR_OBJECT] );
+            glBufferData( GL_ARRAY_BUFFER, _lodVertexLength * sizeof( Color ),
+                          &global.lodColors[_lodVertexStart], GL_STATIC_DRAW );
+        }
+
+        if( data[INDEX_OBJECT] == state.INVALID )
+            data[INDEX_OBJECT] = state.newBufferObject( charThis + 3 );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, data[INDEX_OBJECT] );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER,
+                      _lodIndexLength * sizeof( ShortIndex ),
+                      &global.lodIndices[_lodIndexStart], GL_STATIC_DRAW );
+        return;
+    }
+
+    const char* key = charThis;
+    if( state.useColors( ))
+        ++key;
+    data[0] = state.newDisplayList( key );
+    glNewList( data[0], GL_COMPILE );
+    _renderLODImmediate( state );
+    glEndList();
+}
+
+
+/*  Render the proxy with immediate mode primitives.  */
+void VertexBufferNode::_renderLODImmediate( VertexBufferState& state ) const
+{
+    const VertexBufferData& global = *_globalData;
+    glBegin( GL_TRIANGLES );
+    for( Index offset = 0; offset < _lodIndexLength; ++offset )
+    {
+        const Index i = _lodVertexStart +
+                        global.lodIndices[_lodIndexStart + offset];
+        if( state.useColors() )
+            glColor3ubv( &global.lodColors[i][0] );
+        glNormal3fv( &global.lodNormals[i][0] );
+        glVertex3fv( &global.lodVertices[i][0] );
+    }
+    glEnd();
+}
+
+
 /*  Read node from memory and continue with remaining nodes.  */
 void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
 {
@@ -156,6 +493,16 @@ void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
         throw MeshException( "Error reading binary file. Expected a regular "
                              "node, but found something else instead." );
     VertexBufferBase::fromMemory( addr, globalData );
+    memRead( reinterpret_cast< char* >( &_lodVertexStart ), addr,
+             sizeof( Index ) );
+    memRead( reinterpret_cast< char* >( &_lodVertexLength ), addr,
+             sizeof( ShortIndex ) );
+    memRead( reinterpret_cast< char* >( &_lodIndexStart ), addr,
+             sizeof( Index ) );
+    memRead( reinterpret_cast< char* >( &_lodIndexLength ), addr,
+             sizeof( Index ) );
+    memRead( reinterpret_cast< char* >( &_lodError ), addr, sizeof( float ));
+    _globalData = &globalData;
 
     // read left child (peek ahead)
     memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
@@ -189,6 +536,12 @@ void VertexBufferNode::toStream( std::ostream& os )
     size_t nodeType = NODE_TYPE;
     os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ) );
     VertexBufferBase::toStream( os );
+    os.write( reinterpret_cast< char* >( &_lodVertexStart ), sizeof( Index ));
+    os.write( reinterpret_cast< char* >( &_lodVertexLength ),
+              sizeof( ShortIndex ));
+    os.write( reinterpret_cast< char* >( &_lodIndexStart ), sizeof( Index ));
+    os.write( reinterpret_cast< char* >( &_lodIndexLength ), sizeof( Index ));
+    os.write( reinterpret_cast< char* >( &_lodError ), sizeof( float ));
     static_cast< VertexBufferNode* >( _left )->toStream( os );
     static_cast< VertexBufferNode* >( _right )->toStream( os );
 }
@@ -39,10 +39,15 @@ namespace triply
 class VertexBufferNode : public VertexBufferBase
 {
 public:
-    VertexBufferNode() : _left( 0 ), _right( 0 ) {}
+    VertexBufferNode()
+        : _left( 0 ), _right( 0 ), _globalData( 0 ), _lodSetup( 0 )
+        , _lodVertexStart( 0 ), _lodIndexStart( 0 ), _lodIndexLength( 0 )
+        , _lodVertexLength( 0 ), _lodError( 0.f ) {}
     TRIPLY_API virtual ~VertexBufferNode();
 
     TRIPLY_API void draw( VertexBufferState& state ) const override;
+    float getLODError() const override { return _lodError; }
+    TRIPLY_API void drawLOD( VertexBufferState& state ) const override;
     Index getNumberOfVertices() const override
         { return _left->getNumberOfVertices()+_right->getNumberOfVertices(); }
 
@@ -61,6 +66,10 @@ protected:
                                const size_t depth,
                                VertexBufferData& globalData,
                                boost::progress_display& ) override;
+    TRIPLY_API void mergeTree( const VertexData& data,
+                               VertexBufferData& globalData,
+                               const size_t depth,
+                               boost::progress_display& ) override;
     TRIPLY_API const BoundingSphere& updateBoundingSphere() override;
     TRIPLY_API void updateRange() override;
 
@@ -68,6 +77,19 @@ private:
     friend class VertexBufferDist;
     VertexBufferBase*   _left;
     VertexBufferBase*   _right;
+
+    // vertex-clustered proxy of the subtree, in the global lod* arrays
+    const VertexBufferData* _globalData;
+    VertexBufferData*   _lodSetup; // between setupTree() and mergeTree()
+    Index               _lodVertexStart;
+    Index               _lodIndexStart;
+    Index               _lodIndexLength;
+    ShortIndex          _lodVertexLength;
+    float               _lodError; // cluster diagonal, 0 if no proxy
+
+    void _setupLOD( const VertexData& data, Index start, Index length );
+    void _setupLODRendering( VertexBufferState& state, GLuint* data ) const;
+    void _renderLODImmediate( VertexBufferState& state ) const;
 };
 }
 #endif // PLYLIB_VERTEXBUFFERNODE_H
@@ -31,7 +31,7 @@
 #include "vertexBufferRoot.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
-#include <vmmlib/frustumCuller.hpp>
+#include <cstring>
 #include <string>
 #include <sstream>
 #include <fcntl.h>
@@ -44,124 +44,97 @@
 namespace triply
 {
 
-using vmml::FrustumCullerf;
+namespace
+{
+const size_t ARCHITECTURE_TAG_SIZE = 8;
+}
 
 /*  Determine number of bits used by the current architecture.  */
 size_t getArchitectureBits();
 /*  Determine whether the current architecture is little endian or not.  */
 bool isArchitectureLittleEndian();
+/*  Construct architecture tag, e.g., 'le64'.  */
+std::string getArchitectureTag();
 /*  Construct architecture dependent file name.  */
 std::string getArchitectureFilename( const std::string& filename );
 
+VertexBufferRoot::~VertexBufferRoot()
+{
+    _data.clear();
+    _unmap();
+    for( size_t i = 0; i < _chunks.size(); ++i )
+        delete _chunks[i];
+}
+
 /*  Begin kd-tree setup, go through full range starting with x axis.  */
 void VertexBufferRoot::setupTree( VertexData& data,
                                   boost::progress_display& progress )
 {
     // data is VertexData, _data is VertexBufferData
     _data.clear();
+    _unmap();
+    _data.compact = _compact;
 
     const Axis axis = data.getLongestAxis( 0, data.triangles.size() );
 
+    // build the subtrees in parallel, then merge the leaves in tree order
+#pragma omp parallel
+#pragma omp single
     VertexBufferNode::setupTree( data, 0, data.triangles.size(),
                                  axis, 0, _data, progress );
+
+    _data.indices.reserve( 3 * data.triangles.size( ));
+    VertexBufferNode::mergeTree( data, _data, 0, progress );
     VertexBufferNode::updateBoundingSphere();
     VertexBufferNode::updateRange();
+    _culler.setup( this );
 }
 
-// #define LOGCULL
+/*  Cull and draw the model in one pass.  */
 void VertexBufferRoot::cullDraw( VertexBufferState& state ) const
+{
+    DrawList drawList;
+    cull( state, drawList );
+    draw( state, drawList );
+}
+
+
+// #define LOGCULL
+/*  Draw the nodes selected by cull().  */
+void VertexBufferRoot::draw( VertexBufferState& state,
+                             const DrawList& drawList ) const
 {
     _beginRendering( state );
 
 #ifdef LOGCULL
     size_t verticesRendered = 0;
-    size_t verticesOverlap  = 0;
 #endif
 
-    const Range& range = state.getRange();
-    const FrustumCullerf culler( state.getProjectionModelViewMatrix( ));
-
-    // start with root node
-    std::vector< const triply::VertexBufferBase* > candidates;
-    candidates.push_back( this );
-
-    while( !candidates.empty() )
+    for( std::vector< DrawCommand >::const_iterator i =
+             drawList.commands.begin(); i != drawList.commands.end(); ++i )
     {
         if( state.stopRendering( ))
-            return;
-
-        const triply::VertexBufferBase* treeNode = candidates.back();
-        candidates.pop_back();
+            break;
 
-        // completely out of range check
-        if( treeNode->getRange()[0] >= range[1] ||
-            treeNode->getRange()[1] < range[0] )
+        if( i->lod )
+            i->node->drawLOD( state );
+        else
         {
-            continue;
-        }
-
-        // bounding sphere view frustum culling
-        const vmml::Visibility visibility = state.useFrustumCulling() ?
-                            culler.test( treeNode->getBoundingSphere( )) :
-                            vmml::VISIBILITY_FULL;
-        switch( visibility )
-        {
-            case vmml::VISIBILITY_FULL:
-                // if fully visible and fully in range, render it
-                if( treeNode->getRange()[0] >= range[0] &&
-                    treeNode->getRange()[1] <  range[1] )
-                {
-                    treeNode->draw( state );
-                    //treeNode->drawBoundingSphere( state );
-#ifdef LOGCULL
-                    verticesRendered += treeNode->getNumberOfVertices();
-#endif
-                    break;
-                }
-                // partial range, fall through to partial visibility
-
-            case vmml::VISIBILITY_PARTIAL:
-            {
-                const triply::VertexBufferBase* left  = treeNode->getLeft();
-                const triply::VertexBufferBase* right = treeNode->getRight();
-
-                if( !left && !right )
-                {
-                    if( treeNode->getRange()[0] >= range[0] )
-                    {
-                        treeNode->draw( state );
-                        //treeNode->drawBoundingSphere( state );
+            i->node->draw( state );
 #ifdef LOGCULL
-                        verticesRendered += treeNode->getNumberOfVertices();
-                        if( visibility == vmml::VISIBILITY_PARTIAL )
-                            verticesOverlap  += treeNode->getNumberOfVertices();
+            verticesRendered += i->node->getNumberOfVertices();
 #endif
-                    }
-                    // else drop, to be drawn by 'previous' channel
-                }
-                else
-                {
-                    if( left )
-                        candidates.push_back( left );
-                    if( right )
-                        candidates.push_back( right );
-                }
-                break;
-            }
-            case vmml::VISIBILITY_NONE:
-                // do nothing
-                break;
         }
     }
 
     _endRendering( state );
 
 #ifdef LOGCULL
-    const size_t verticesTotal = model->getNumberOfVertices();
+    const size_t verticesTotal = getNumberOfVertices();
     PLYLIBINFO
         << getName() << " rendered " << verticesRendered * 100 / verticesTotal
-        << "% of model, overlap <= " << verticesOverlap * 100 / verticesTotal
-        << "%" << std::endl;
+        << "% of model in " << drawList.commands.size() << " draws"
+        << std::endl;
 #endif
 }
 
@@ -179,6 +152,11 @@ void VertexBufferRoot::_beginRendering( VertexBufferState& state ) const
         glEnableClientState( GL_NORMAL_ARRAY );
         if( state.useColors() )
             glEnableClientState( GL_COLOR_ARRAY );
+        if( _data.compact ) // normals are scaled by the leaf transformation
+        {
+            glPushAttrib( GL_ENABLE_BIT );
+            glEnable( GL_NORMALIZE );
+        }
 #endif
     case RENDER_MODE_DISPLAY_LIST:
     case RENDER_MODE_IMMEDIATE:
@@ -208,6 +186,8 @@ void VertexBufferRoot::_endRendering( VertexBufferState& state ) const
         glBindBuffer( GL_ARRAY_BUFFER_ARB, 0);
         glBindBuffer( GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
         glPopClientAttrib();
+        if( _data.compact )
+            glPopAttrib();
     }
 #endif
     case RENDER_MODE_DISPLAY_LIST:
@@ -234,16 +214,32 @@ bool isArchitectureLittleEndian()
 }
 
 
-/*  Construct architecture dependent file name.  */
-std::string getArchitectureFilename( const std::string& filename )
+/*  Construct architecture tag, e.g., 'le64'.  */
+std::string getArchitectureTag()
 {
     std::ostringstream oss;
-    oss << filename << ( isArchitectureLittleEndian() ? ".le" : ".be" );
-    oss << getArchitectureBits() << ".bin";
+    oss << ( isArchitectureLittleEndian() ? "le" : "be" )
+        << getArchitectureBits();
     return oss.str();
 }
 
 
+/*  Construct architecture dependent file name.  */
+std::string getArchitectureFilename( const std::string& filename )
+{
+    return filename + '.' + getArchitectureTag() + ".bin";
+}
+
+
+/*  Construct the binary file name of this tree's layout.  */
+std::string VertexBufferRoot::_getCacheFilename( const std::string& filename )
+    const
+{
+    return getArchitectureFilename( _compact ? filename + ".compact" :
+                                               filename );
+}
+
+
 /*  Functions extracted out of readFromFile to enhance readability.  */
 bool VertexBufferRoot::_constructFromPly( const std::string& filename )
 {
@@ -275,6 +271,8 @@ bool VertexBufferRoot::_constructFromPly( const std::string& filename )
 
 bool VertexBufferRoot::_readBinary( std::string filename )
 {
+    _data.clear();
+    _unmap();
 #ifdef WIN32
 
     // replace dir delimiters since '\' is often used as escape char
@@ -318,17 +316,24 @@ bool VertexBufferRoot::_readBinary( std::string filename )
             PLYLIBERROR << "Unable to read binary file, an exception occured:  "
                       << e.what() << std::endl;
         }
-        UnmapViewOfFile( addr );
     }
     else
     {
         PLYLIBERROR << "Unable to read binary file, memory mapping failed."
                   << std::endl;
+        CloseHandle( map );
         return false;
     }
 
     CloseHandle( map );
-    return result;
+    if( result ) // the vertex data references the mapping
+    {
+        _mapping = addr;
+        return true;
+    }
+    _data.clear();
+    UnmapViewOfFile( addr );
+    return false;
 
 #else
     // try to open binary file
@@ -344,8 +349,11 @@ bool VertexBufferRoot::_readBinary( std::string filename )
     char* addr   = static_cast< char* >( mmap( 0, status.st_size, PROT_READ,
                                                MAP_SHARED, fd, 0 ) );
     bool  result = false;
+    close( fd );
     if( addr != MAP_FAILED )
     {
+        // only the data ranges drawn by this process are paged in
+        madvise( addr, status.st_size, MADV_RANDOM );
         try
         {
             fromMemory( addr );
@@ -356,23 +364,44 @@ bool VertexBufferRoot::_readBinary( std::string filename )
             PLYLIBERROR << "Unable to read binary file, an exception occured:  "
                       << e.what() << std::endl;
         }
-        munmap( addr, status.st_size );
+
+        if( result ) // the vertex data references the mapping
+        {
+            _mapping = addr;
+            _mappingSize = status.st_size;
+        }
+        else
+        {
+            _data.clear();
+            munmap( addr, status.st_size );
+        }
     }
     else
     {
         PLYLIBERROR << "Unable to read binary file, memory mapping failed."
                   << std::endl;
     }
-
-    close( fd );
     return result;
 #endif
 }
 
+void VertexBufferRoot::_unmap()
+{
+    if( !_mapping )
+        return;
+#ifdef WIN32
+    UnmapViewOfFile( _mapping );
+#else
+    munmap( _mapping, _mappingSize );
+#endif
+    _mapping = 0;
+    _mappingSize = 0;
+}
+
 /*  Read binary kd-tree representation, construct from ply if unavailable.  */
 bool VertexBufferRoot::readFromFile( const std::string& filename )
 {
-    if( _readBinary( getArchitectureFilename( filename )))
+    if( _readBinary( _getCacheFilename( filename )))
     {
         _name = filename;
         return true;
@@ -390,7 +419,7 @@ bool VertexBufferRoot::writeToFile( const std::string& filename )
 {
     bool result = false;
 
-    std::ofstream output( getArchitectureFilename( filename ).c_str(),
+    std::ofstream output( _getCacheFilename( filename ).c_str(),
                           std::ios::out | std::ios::binary );
     if( output )
     {
@@ -426,6 +455,12 @@ void VertexBufferRoot::fromMemory( char* start )
     if( version != FILE_VERSION )
         throw MeshException( "Error reading binary file. Version in file "
                              "does not match the expected version." );
+    char tag[ ARCHITECTURE_TAG_SIZE ];
+    memRead( tag, addr, ARCHITECTURE_TAG_SIZE );
+    if( std::string( tag, strnlen( tag, ARCHITECTURE_TAG_SIZE )) !=
+        getArchitectureTag( ))
+        throw MeshException( "Error reading binary file. Architecture in file "
+                             "does not match the current architecture." );
     size_t nodeType;
     memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
     if( nodeType != ROOT_TYPE )
@@ -433,6 +468,7 @@ void VertexBufferRoot::fromMemory( char* start )
                              "node, but found something else instead." );
     _data.fromMemory( addr );
     VertexBufferNode::fromMemory( addr, _data );
+    _culler.setup( this );
 }
 
 
@@ -441,6 +477,9 @@ void VertexBufferRoot::toStream( std:: ostream& os )
 {
     size_t version = FILE_VERSION;
     os.write( reinterpret_cast< char* >( &version ), sizeof( size_t ) );
+    char tag[ ARCHITECTURE_TAG_SIZE ] = { 0 };
+    getArchitectureTag().copy( tag, ARCHITECTURE_TAG_SIZE );
+    os.write( tag, ARCHITECTURE_TAG_SIZE );
     size_t nodeType = ROOT_TYPE;
     os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ) );
     _data.toStream( os );
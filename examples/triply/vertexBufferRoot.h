@@ -32,6 +32,7 @@
 #define PLYLIB_VERTEXBUFFERROOT_H
 
 #include <triply/api.h>
+#include "vertexBufferCuller.h"
 #include "vertexBufferData.h"
 #include "vertexBufferNode.h"
 
@@ -41,18 +42,34 @@ namespace triply
 class VertexBufferRoot : public VertexBufferNode
 {
 public:
-    TRIPLY_API VertexBufferRoot() : VertexBufferNode(), _invertFaces(false) {}
+    TRIPLY_API VertexBufferRoot()
+        : VertexBufferNode(), _invertFaces( false ), _compact( false )
+        , _mapping( 0 ), _mappingSize( 0 ), _chunkColors( false ) {}
+    TRIPLY_API virtual ~VertexBufferRoot();
 
     TRIPLY_API virtual void cullDraw( VertexBufferState& state ) const;
     TRIPLY_API virtual void draw( VertexBufferState& state ) const;
 
+    /*  Select the nodes to draw, to be drawn later with draw( drawList ).  */
+    void cull( const VertexBufferState& state, DrawList& drawList ) const
+        { _culler.cull( state, drawList ); }
+    TRIPLY_API void draw( VertexBufferState& state,
+                          const DrawList& drawList ) const;
+
     TRIPLY_API void setupTree( VertexData& data, boost::progress_display&  );
     TRIPLY_API bool writeToFile( const std::string& filename );
     TRIPLY_API bool readFromFile( const std::string& filename );
-    bool hasColors() const { return !_data.colors.empty(); }
+    bool hasColors() const
+        { return _chunks.empty() ? !_data.colors.empty() : _chunkColors; }
 
     void useInvertedFaces() { _invertFaces = true; }
 
+    /*  Build quantized, vertex cache optimized leaves, cached separately.  */
+    void useCompactLeaves() { _compact = true; }
+    bool isCompact() const { return _data.compact; }
+
+    const VertexBufferData& getData() const { return _data; }
+
     const std::string& getName() const { return _name; }
 
 protected:
@@ -62,14 +79,24 @@ protected:
 private:
     bool _constructFromPly( const std::string& filename );
     bool _readBinary( std::string filename );
+    void _unmap();
+    std::string _getCacheFilename( const std::string& filename ) const;
 
     void _beginRendering( VertexBufferState& state ) const;
     void _endRendering( VertexBufferState& state ) const;
 
     friend class VertexBufferDist;
     VertexBufferData _data;
+    VertexBufferCuller _culler;
     bool             _invertFaces;
+    bool             _compact;
     std::string      _name;
+    void*            _mapping; // binary file referenced by _data
+    size_t           _mappingSize;
+
+    // leaf geometry of a model distributed in chunks, see VertexBufferDist
+    std::vector< VertexBufferData* > _chunks;
+    bool             _chunkColors;
 };
 }
 
@@ -32,13 +32,17 @@
 namespace triply
 {
 VertexBufferState::VertexBufferState( const GLEWContext* glewContext )
-        : _glewContext( glewContext )
+        : _lodThreshold( 0.f )
+        , _glewContext( glewContext )
         , _renderMode( RENDER_MODE_DISPLAY_LIST )
         , _useColors( false )
         , _useFrustumCulling( true )
+        , _useOctNormals( false )
 {
     _range[0] = 0.f;
     _range[1] = 1.f;
+    _viewportSize[0] = 0.f;
+    _viewportSize[1] = 0.f;
     resetRegion();
     PLYLIBASSERT( glewContext );
 }
@@ -63,6 +63,21 @@ public:
     TRIPLY_API void setRange( const Range& range ) { _range = range; }
     TRIPLY_API const Range& getRange() const { return _range; }
 
+    /** Set the size of the rendered viewport, used for LOD selection. */
+    TRIPLY_API void setViewportSize( const float width, const float height )
+        { _viewportSize[0] = width; _viewportSize[1] = height; }
+    TRIPLY_API const float* getViewportSize() const { return _viewportSize; }
+
+    /** Set the LOD error threshold in pixels, 0 to disable LOD proxies. */
+    TRIPLY_API void setLODThreshold( const float pixels )
+        { _lodThreshold = pixels; }
+    TRIPLY_API float getLODThreshold() const { return _lodThreshold; }
+
+    /** Pass compact normals undecoded, for shaders handling octNormals. */
+    TRIPLY_API void setOctNormals( const bool enable )
+        { _useOctNormals = enable; }
+    TRIPLY_API bool useOctNormals() const { return _useOctNormals; }
+
     TRIPLY_API void resetRegion();
     TRIPLY_API void updateRegion( const BoundingBox& box );
     TRIPLY_API virtual void declareRegion( const Vector4f& ) {}
@@ -83,11 +98,14 @@ protected:
 
     Matrix4f      _pmvMatrix; //!< projection * modelView matrix
     Range         _range; //!< normalized [0,1] part of the model to draw
+    float         _viewportSize[2]; //!< width, height in pixels
+    float         _lodThreshold; //!< max projected LOD error in pixels
     const GLEWContext* const _glewContext;
     RenderMode    _renderMode;
     Vector4f      _region; //!< normalized x1 y1 x2 y2 region from cullDraw
     bool          _useColors;
     bool          _useFrustumCulling;
+    bool          _useOctNormals;
 
 private:
 };
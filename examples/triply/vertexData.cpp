@@ -29,6 +29,7 @@
 
 #include "vertexData.h"
 #include "ply.h"
+#include "plyReader.h"
 
 #include <cstdlib>
 #include <algorithm>
@@ -36,8 +37,10 @@
 #if (( __GNUC__ > 4 ) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 4)) )
 #  include <parallel/algorithm>
 using __gnu_parallel::sort;
+using __gnu_parallel::nth_element;
 #else
 using std::sort;
+using std::nth_element;
 #endif
 
 using namespace triply;
@@ -45,6 +48,8 @@ using namespace triply;
 /*  Contructor.  */
 VertexData::VertexData()
     : _invertFaces( false )
+    , _fullSort( false )
+    , _genericReader( false )
 {
     _boundingBox[0] = Vertex( 0.0f );
     _boundingBox[1] = Vertex( 0.0f );
@@ -135,12 +140,17 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
             throw MeshException( "Error reading PLY file. Encountered a "
                                  "face which does not have three vertices." );
         }
-        triangles.push_back( Triangle( face.vertices[ind1],
-                                       face.vertices[1],
-                                       face.vertices[ind3] ) );
+        const Triangle triangle( face.vertices[ind1], face.vertices[1],
+                                 face.vertices[ind3] );
 
         // free the memory that was allocated by ply_get_element
         free( face.vertices );
+
+        for( size_t j = 0; j < 3; ++j )
+            if( triangle[j] >= vertices.size( ))
+                throw MeshException( "Error reading PLY file. Encountered a "
+                                     "face with an invalid vertex index." );
+        triangles.push_back( triangle );
     }
 }
 
@@ -148,6 +158,26 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
 /*  Open a PLY file and read vertex, color and index data.  */
 bool VertexData::readPlyFile( const std::string& filename )
 {
+    if( !_genericReader )
+    {
+        PlyReader reader( filename );
+        if( reader.isSupported( ))
+        {
+            try
+            {
+                reader.read( *this, _invertFaces );
+                return true;
+            }
+            catch( const std::exception& e )
+            {
+                PLYLIBERROR << "Unable to read PLY file, an exception "
+                            << "occured:  " << e.what() << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // other layouts: generic, element by element reader
     int     nPlyElems;
     char**  elemNames;
     int     fileType;
@@ -391,6 +421,10 @@ struct _TriangleSort
         }
         while( axis != _axis );
 
+        // break ties by vertex indices for a strict, deterministic order
+        for( size_t i = 0; i < 3; ++i )
+            if( t1[i] != t2[i] )
+                return t1[i] < t2[i];
         return false;
     }
 
@@ -408,3 +442,25 @@ void VertexData::sort( const Index start, const Index length, const Axis axis )
     ::sort( triangles.begin() + start, triangles.begin() + start + length,
             _TriangleSort( *this, axis ) );
 }
+
+
+/*  Split the index data from start to start + length at its median along the
+    given axis. The lower half holds the same triangles as after sort(), since
+    the order is strict. */
+void VertexData::partition( const Index start, const Index length,
+                            const Axis axis )
+{
+    PLYLIBASSERT( length > 0 );
+    PLYLIBASSERT( start + length <= triangles.size() );
+
+    if( _fullSort )
+    {
+        sort( start, length, axis );
+        return;
+    }
+
+    ::nth_element( triangles.begin() + start,
+                   triangles.begin() + start + length / 2,
+                   triangles.begin() + start + length,
+                   _TriangleSort( *this, axis ) );
+}
@@ -49,6 +49,8 @@ namespace triply
 
         TRIPLY_API bool readPlyFile( const std::string& file );
         TRIPLY_API void sort( const Index start, const Index length, const Axis axis );
+        TRIPLY_API void partition( const Index start, const Index length,
+                                   const Axis axis );
         TRIPLY_API void scale( const float baseSize = 2.0f );
         TRIPLY_API void calculateNormals();
         TRIPLY_API void calculateBoundingBox();
@@ -57,6 +59,12 @@ namespace triply
 
         void useInvertedFaces() { _invertFaces = true; }
 
+        /*  Fully sort in partition(), as before the parallel tree setup.  */
+        void useFullSort() { _fullSort = true; }
+
+        /*  Read PLY files element by element, as before the parallel reader. */
+        void useGenericReader() { _genericReader = true; }
+
         std::vector< Vertex >   vertices;
         std::vector< Color >    colors;
         std::vector< Normal >   normals;
@@ -69,6 +77,8 @@ namespace triply
 
         BoundingBox _boundingBox;
         bool        _invertFaces;
+        bool        _fullSort;
+        bool        _genericReader;
     };
 }
 
@@ -63,7 +63,8 @@ public:
      * beginning of each frame. The instance passed to the render callbacks is
      * automatically synchronized to the version belonging to the frame
      * rendered. The object may be 0, if the application does not want to use a
-     * per-frame object.
+     * per-frame object. Large frame data may use an eq::ChunkedObject, whose
+     * chunks are committed in parallel without blocking the frame start.
      *
      * @return true on success, false otherwise.
      * @param frameData a distributed object holding frame-specific data.
@@ -0,0 +1,215 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the block-sparse transport of images: only the occupied or changed
+// blocks are packed, and the receiving image restores the full pixel data.
+// Also tests cropping images to their regions of interest.
+
+#include <lunchbox/test.h>
+
+#include <eq/image.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <eq/fabric/pixelViewport.h>
+#include <lunchbox/rng.h>
+#include <pression/plugins/compressor.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const uint32_t blockSize = 32;
+const eq::PixelViewport pvp( 0, 0, 1000, 600 );
+
+void _setPixels( eq::Image& image, const eq::Frame::Buffer buffer,
+                 const uint32_t internalFormat, const uint32_t externalFormat,
+                 std::vector< uint32_t >& pixels )
+{
+    eq::PixelData data;
+    data.internalFormat = internalFormat;
+    data.externalFormat = externalFormat;
+    data.pixelSize = 4;
+    data.pvp = pvp;
+    data.pixels = pixels.data();
+    image.setPixelData( buffer, data );
+    image.useCompressor( buffer, EQ_COMPRESSOR_AUTO );
+}
+
+void _testRoundTrip( eq::Image& source, const bool compress,
+                     const eq::Image* reference = 0 )
+{
+    eq::Image destination;
+    destination.setPixelViewport( pvp );
+
+    const eq::Frame::Buffer buffers[] = { eq::Frame::BUFFER_COLOR,
+                                          eq::Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const eq::Frame::Buffer buffer = buffers[i];
+        const eq::PixelData& blocks = source.getBlockData( buffer, compress );
+        TEST( blocks.pvp.w == int32_t( blockSize ));
+        TEST( blocks.pvp.h % blockSize == 0 );
+
+        if( reference )
+            destination.setBlockData( buffer, blocks, blockSize,
+                                      source.getBlockMask(), *reference );
+        else
+            destination.setBlockData( buffer, blocks, blockSize,
+                                      source.getBlockMask(),
+                                      source.getBlockBackground( buffer ));
+        TEST( destination.hasPixelData( buffer ));
+        TEST( destination.getPixelDataSize( buffer ) ==
+              source.getPixelDataSize( buffer ));
+        TESTINFO( ::memcmp( destination.getPixelPointer( buffer ),
+                            source.getPixelPointer( buffer ),
+                            source.getPixelDataSize( buffer )) == 0,
+                  "buffer " << buffer << " compressed " << compress );
+    }
+}
+
+void _testCrop( const eq::Image& image, const eq::PixelViewport& region,
+                const eq::Frame::Buffer buffer,
+                const std::vector< uint32_t >& pixels )
+{
+    TEST( image.getPixelViewport() == region );
+    TEST( image.getPixelDataSize( buffer ) == region.getArea() * 4 );
+
+    const uint32_t* data = reinterpret_cast< const uint32_t* >(
+        image.getPixelPointer( buffer ));
+    for( int32_t y = 0; y < region.h; ++y )
+        for( int32_t x = 0; x < region.w; ++x )
+            TESTINFO( data[ y * region.w + x ] ==
+                      pixels[ ( region.y + y ) * pvp.w + region.x + x ],
+                      region << " " << x << ", " << y );
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    // background with a few rectangles of geometry, like a DB source
+    const size_t nPixels = pvp.getArea();
+    std::vector< uint32_t > color( nPixels, 0u );
+    std::vector< uint32_t > depth( nPixels, 0xffffffffu );
+    lunchbox::RNG rng;
+    const int32_t rects[][4] = {{ 100, 50, 300, 200 }, { 500, 300, 250, 150 },
+                                { 37, 411, 61, 5 }};
+    for( size_t i = 0; i < 3; ++i )
+        for( int32_t y = rects[i][1]; y < rects[i][1] + rects[i][3]; ++y )
+            for( int32_t x = rects[i][0]; x < rects[i][0] + rects[i][2]; ++x )
+            {
+                color[ y * pvp.w + x ] = rng.get< uint32_t >() | 0xff000000u;
+                depth[ y * pvp.w + x ] = rng.get< uint32_t >() >> 8;
+            }
+
+    eq::Image source;
+    source.setPixelViewport( pvp );
+    _setPixels( source, eq::Frame::BUFFER_COLOR, EQ_COMPRESSOR_DATATYPE_RGBA,
+                EQ_COMPRESSOR_DATATYPE_BGRA, color );
+    _setPixels( source, eq::Frame::BUFFER_DEPTH, EQ_COMPRESSOR_DATATYPE_DEPTH,
+                EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT, depth );
+
+    const float occupancy = source.findBlocks( blockSize );
+    TESTINFO( occupancy > 0.1f && occupancy < 0.3f, occupancy );
+    _testRoundTrip( source, false );
+    _testRoundTrip( source, true );
+
+    // regions of interest, into another image and in place
+    const eq::PixelViewport region( 96, 48, 304, 208 );
+    eq::Image cropped;
+    cropped.crop( source, region );
+    _testCrop( cropped, region, eq::Frame::BUFFER_COLOR, color );
+    _testCrop( cropped, region, eq::Frame::BUFFER_DEPTH, depth );
+
+    const eq::PixelViewport inner( 112, 64, 64, 32 );
+    cropped.crop( cropped, inner );
+    _testCrop( cropped, inner, eq::Frame::BUFFER_COLOR, color );
+    _testCrop( cropped, inner, eq::Frame::BUFFER_DEPTH, depth );
+    cropped.flush();
+
+    // delta to the previous frame
+    eq::Image reference;
+    reference.copyBlocks( eq::Frame::BUFFER_COLOR, source );
+    reference.copyBlocks( eq::Frame::BUFFER_DEPTH, source );
+    TEST( source.findChangedBlocks( reference, blockSize ) == 0.f );
+    _testRoundTrip( source, true, &reference );
+
+    for( int32_t y = 200; y < 240; ++y )
+        for( int32_t x = 600; x < 640; ++x )
+        {
+            color[ y * pvp.w + x ] = rng.get< uint32_t >();
+            depth[ y * pvp.w + x ] = rng.get< uint32_t >();
+        }
+    _setPixels( source, eq::Frame::BUFFER_COLOR, EQ_COMPRESSOR_DATATYPE_RGBA,
+                EQ_COMPRESSOR_DATATYPE_BGRA, color );
+    _setPixels( source, eq::Frame::BUFFER_DEPTH, EQ_COMPRESSOR_DATATYPE_DEPTH,
+                EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT, depth );
+
+    const float changed = source.findChangedBlocks( reference, blockSize );
+    TESTINFO( changed > 0.f && changed < 0.02f, changed );
+    _testRoundTrip( source, false, &reference );
+    _testRoundTrip( source, true, &reference );
+
+    reference.copyBlocks( eq::Frame::BUFFER_COLOR, source );
+    reference.copyBlocks( eq::Frame::BUFFER_DEPTH, source );
+    TEST( source.findChangedBlocks( reference, blockSize ) == 0.f );
+
+    // only background
+    std::fill( color.begin(), color.end(), 0u );
+    std::fill( depth.begin(), depth.end(), 0xffffffffu );
+    _setPixels( source, eq::Frame::BUFFER_COLOR, EQ_COMPRESSOR_DATATYPE_RGBA,
+                EQ_COMPRESSOR_DATATYPE_BGRA, color );
+    _setPixels( source, eq::Frame::BUFFER_DEPTH, EQ_COMPRESSOR_DATATYPE_DEPTH,
+                EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT, depth );
+    TEST( source.findBlocks( blockSize ) == 0.f );
+    _testRoundTrip( source, true );
+
+    // background of the clear color, not of the occupied first pixel
+    source.setClearValues( eq::Vector4f( .5f, .25f, 1.f, 1.f ), 1.f );
+    std::vector< uint8_t > background;
+    TEST( source.getBackground( eq::Frame::BUFFER_COLOR, background ));
+    TEST( background.size() == 4 );
+    uint32_t clearColor = 0;
+    ::memcpy( &clearColor, background.data(), background.size( ));
+    TESTINFO( clearColor == 0xff8040ffu, std::hex << clearColor );
+    TEST( source.getBackground( eq::Frame::BUFFER_DEPTH, background ));
+    TEST( background == std::vector< uint8_t >( 4, 0xff ));
+
+    std::fill( color.begin(), color.end(), clearColor );
+    color[0] = 0u;
+    depth[0] = 0u;
+    _setPixels( source, eq::Frame::BUFFER_COLOR, EQ_COMPRESSOR_DATATYPE_RGBA,
+                EQ_COMPRESSOR_DATATYPE_BGRA, color );
+    _setPixels( source, eq::Frame::BUFFER_DEPTH, EQ_COMPRESSOR_DATATYPE_DEPTH,
+                EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT, depth );
+    const size_t nBlocks = (( pvp.w + blockSize - 1 ) / blockSize ) *
+                           (( pvp.h + blockSize - 1 ) / blockSize );
+    TESTINFO( source.findBlocks( blockSize ) == 1.f / float( nBlocks ),
+              source.findBlocks( blockSize ));
+    TEST( ::memcmp( source.getBlockBackground( eq::Frame::BUFFER_COLOR ),
+                    &clearColor, 4 ) == 0 );
+    _testRoundTrip( source, false );
+    _testRoundTrip( source, true );
+
+    source.flush();
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Maps a chunked object on another node while the master keeps committing
+// frames. The chunk versions announced by a commit may still be in flight on
+// the commit threads when the slave maps the object.
+
+#include <lunchbox/test.h>
+
+#include <eq/chunkedObject.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/localNode.h>
+
+#include <mutex>
+#include <thread>
+
+namespace
+{
+typedef std::vector< uint32_t > Words;
+
+const size_t nChunks = 16;
+const size_t chunkSize = 16 * 1024; // words, 64 KB
+const size_t nFrames = 50;
+
+co::LocalNodePtr _listen()
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "localhost" );
+
+    co::LocalNodePtr node = new co::LocalNode;
+    node->addConnectionDescription( desc );
+    TEST( node->listen( ));
+    return node;
+}
+
+Words _words( const size_t frame, const size_t chunk )
+{
+    Words words( chunkSize );
+    for( size_t i = 0; i < chunkSize; ++i )
+        words[i] = uint32_t( frame * nChunks * chunkSize + chunk * chunkSize +
+                             i );
+    return words;
+}
+
+class Chunked : public eq::ChunkedObject
+{
+public:
+    Chunked() : eq::ChunkedObject( nChunks, 4 ), data( nChunks ) {}
+
+    void update( const size_t frame )
+    {
+        for( size_t i = 0; i < nChunks; ++i )
+        {
+            setChunkDirty( i );
+            data[i] = _words( frame, i );
+        }
+    }
+
+    bool isFrame( const size_t frame ) const
+    {
+        for( size_t i = 0; i < nChunks; ++i )
+            if( data[i] != _words( frame, i ))
+                return false;
+        return true;
+    }
+
+    std::vector< Words > data;
+
+protected:
+    void serializeChunk( co::DataOStream& os, const size_t chunk ) override
+        { os << data[ chunk ]; }
+    void deserializeChunk( co::DataIStream& is, const size_t chunk ) override
+        { is >> data[ chunk ]; }
+};
+
+typedef std::pair< co::uint128_t, size_t > FrameVersion;
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    co::LocalNodePtr server = _listen();
+    co::LocalNodePtr client = _listen();
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription(
+        server->getConnectionDescriptions().front( ));
+    TEST( client->connect( serverProxy ));
+
+    Chunked master;
+    master.update( 0 );
+    TEST( server->registerObject( &master ));
+    master.setAutoObsolete( nFrames + 1 );
+
+    std::mutex mutex;
+    FrameVersion latest( master.commit(), 0 );
+    master.waitCommitted();
+
+    // commit frames without waiting for the chunks to be sent
+    std::thread committer( [&]
+    {
+        for( size_t frame = 1; frame <= nFrames; ++frame )
+        {
+            master.update( frame );
+            const co::uint128_t version = master.commit();
+            std::lock_guard< std::mutex > lock( mutex );
+            latest = FrameVersion( version, frame );
+        }
+    });
+
+    size_t nMapped = 0;
+    for( bool done = false; !done; ++nMapped )
+    {
+        FrameVersion current;
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            current = latest;
+        }
+        done = current.second == nFrames;
+
+        Chunked slave;
+        TEST( client->mapObject( &slave,
+                                 co::ObjectVersion( master.getID(),
+                                                    current.first )));
+        TESTINFO( slave.isFrame( current.second ),
+                  "slave mapped at frame " << current.second
+                  << " has different data" );
+        client->unmapObject( &slave );
+    }
+    committer.join();
+    master.waitCommitted();
+    TEST( nMapped > 0 );
+
+    server->deregisterObject( &master );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+    serverProxy = 0;
+    client = 0;
+    server = 0;
+
+    eq::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,318 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Writes a frame capture in the .eqs format and replays it with
+// eq::FrameReplay: a depth-composited frame of two full images, followed by a
+// frame of one block-sparse image.
+
+#include <lunchbox/test.h>
+
+#include <eq/frameData.h>
+#include <eq/frameReplay.h>
+#include <eq/image.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/pixelData.h>
+#include <eq/fabric/pixelViewport.h>
+#include <eq/fabric/renderContext.h>
+#include <eq/fabric/zoom.h>
+#include <co/objectVersion.h>
+#include <pression/plugins/compressor.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+// The file format of eq::detail::FrameCapture, version 2
+const uint64_t magic = 0x3170436d72467145ull;
+const uint32_t version = 2;
+const uint32_t recordImage = 1;
+const uint32_t recordAssembly = 2;
+
+struct ImageRecord
+{
+    co::ObjectVersion frameData;
+    eq::RenderContext context;
+    eq::PixelViewport pvp;
+    eq::Zoom zoom;
+    eq::uint128_t stream;
+    uint32_t frameNumber;
+    uint32_t buffers;
+    uint32_t useAlpha;
+    uint32_t sequence;
+    uint64_t size;
+};
+
+struct AssemblyRecord
+{
+    uint32_t frameNumber;
+    uint32_t nFrames;
+};
+
+struct FrameRecord
+{
+    co::ObjectVersion frameData;
+    eq::Vector2i offset;
+    eq::Zoom zoom;
+    uint32_t buffers;
+    uint32_t zoomFilter;
+};
+
+const std::string filename( "frameReplay.eqs" );
+const eq::PixelViewport pvp( 0, 0, 64, 32 );
+const uint32_t buffers = eq::Frame::BUFFER_COLOR | eq::Frame::BUFFER_DEPTH;
+const uint32_t farDepth = 0xffffffffu;
+const eq::uint128_t idA( 1, 1 );
+const eq::uint128_t idB( 1, 2 );
+
+struct Pixels
+{
+    Pixels() : color( pvp.getArea( )), depth( pvp.getArea( )) {}
+
+    std::vector< uint32_t > color;
+    std::vector< uint32_t > depth;
+};
+
+template< class T > void _write( std::ostream& file, const T& value )
+{
+    file.write( reinterpret_cast< const char* >( &value ), sizeof( T ));
+}
+
+void _write( std::ostream& file, const std::vector< uint8_t >& data )
+{
+    file.write( reinterpret_cast< const char* >( data.data( )), data.size( ));
+}
+
+template< class T > void _append( std::vector< uint8_t >& payload,
+                                  const T* data, const size_t size )
+{
+    const uint8_t* bytes = reinterpret_cast< const uint8_t* >( data );
+    payload.insert( payload.end(), bytes, bytes + size );
+}
+
+eq::FrameData::ImageHeader _makeHeader( const eq::Frame::Buffer buffer,
+                                        const eq::PixelViewport& blocksPVP,
+                                        const uint32_t blockSize )
+{
+    const bool color = buffer == eq::Frame::BUFFER_COLOR;
+    const eq::FrameData::ImageHeader header =
+        { color ? EQ_COMPRESSOR_DATATYPE_RGBA : EQ_COMPRESSOR_DATATYPE_DEPTH,
+          color ? EQ_COMPRESSOR_DATATYPE_BGRA :
+                  EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT,
+          4, blocksPVP, EQ_COMPRESSOR_NONE, 0, 1, 1.f, blockSize, 0 };
+    return header;
+}
+
+/** @return the uncompressed payload of an image, as transmitted. */
+std::vector< uint8_t > _pack( const Pixels& pixels )
+{
+    std::vector< uint8_t > payload;
+    const uint64_t size = pvp.getArea() * 4;
+    for( eq::Frame::Buffer buffer : { eq::Frame::BUFFER_COLOR,
+                                      eq::Frame::BUFFER_DEPTH })
+    {
+        const eq::FrameData::ImageHeader header = _makeHeader( buffer, pvp, 0 );
+        _append( payload, &header, sizeof( header ));
+        _append( payload, &size, sizeof( size ));
+        _append( payload, buffer == eq::Frame::BUFFER_COLOR ?
+                          pixels.color.data() : pixels.depth.data(), size );
+    }
+    return payload;
+}
+
+/** @return the block-sparse payload of an image, as transmitted. */
+std::vector< uint8_t > _packBlocks( Pixels& pixels, const uint32_t blockSize )
+{
+    eq::Image image;
+    image.setPixelViewport( pvp );
+    for( eq::Frame::Buffer buffer : { eq::Frame::BUFFER_COLOR,
+                                      eq::Frame::BUFFER_DEPTH })
+    {
+        const eq::FrameData::ImageHeader header = _makeHeader( buffer, pvp, 0 );
+        eq::PixelData data;
+        data.internalFormat = header.internalFormat;
+        data.externalFormat = header.externalFormat;
+        data.pixelSize = header.pixelSize;
+        data.pvp = pvp;
+        data.pixels = buffer == eq::Frame::BUFFER_COLOR ?
+                      pixels.color.data() : pixels.depth.data();
+        image.setPixelData( buffer, data );
+    }
+    TEST( image.findBlocks( blockSize ) < 1.f );
+
+    std::vector< uint8_t > payload;
+    for( eq::Frame::Buffer buffer : { eq::Frame::BUFFER_COLOR,
+                                      eq::Frame::BUFFER_DEPTH })
+    {
+        const eq::PixelData& blocks = image.getBlockData( buffer, false );
+        const uint64_t size = blocks.pvp.getArea() * blocks.pixelSize;
+        const eq::FrameData::ImageHeader header =
+            _makeHeader( buffer, blocks.pvp, blockSize );
+        _append( payload, &header, sizeof( header ));
+        _append( payload, image.getBlockMask(), image.getBlockMaskSize( ));
+        _append( payload, static_cast< const uint8_t* >(
+                     image.getBlockBackground( buffer )), blocks.pixelSize );
+        _append( payload, &size, sizeof( size ));
+        _append( payload, blocks.pixels, size );
+    }
+    image.flush();
+    return payload;
+}
+
+void _writeImage( std::ofstream& file, const eq::uint128_t& id,
+                  const uint64_t frameDataVersion, const uint32_t frameNumber,
+                  const std::vector< uint8_t >& payload )
+{
+    ImageRecord record;
+    record.frameData = co::ObjectVersion( id, frameDataVersion );
+    record.context = eq::RenderContext();
+    record.pvp = pvp;
+    record.zoom = eq::Zoom::NONE;
+    record.stream = eq::uint128_t();
+    record.frameNumber = frameNumber;
+    record.buffers = buffers;
+    record.useAlpha = 0;
+    record.sequence = 0;
+    record.size = payload.size();
+
+    _write( file, recordImage );
+    _write( file, record );
+    _write( file, payload );
+}
+
+void _writeAssembly( std::ofstream& file, const uint32_t frameNumber,
+                     const std::vector< co::ObjectVersion >& frameDatas )
+{
+    const AssemblyRecord assembly = { frameNumber,
+                                      uint32_t( frameDatas.size( )) };
+    _write( file, recordAssembly );
+    _write( file, assembly );
+    for( const co::ObjectVersion& frameData : frameDatas )
+    {
+        FrameRecord frame;
+        frame.frameData = frameData;
+        frame.offset = eq::Vector2i::ZERO;
+        frame.zoom = eq::Zoom::NONE;
+        frame.buffers = buffers;
+        frame.zoomFilter = eq::FILTER_NEAREST;
+        _write( file, frame );
+    }
+}
+
+void _testResult( const eq::Image* result, const Pixels& expected )
+{
+    TEST( result );
+    TEST( result->getPixelViewport() == pvp );
+    const uint32_t* color = reinterpret_cast< const uint32_t* >(
+        result->getPixelPointer( eq::Frame::BUFFER_COLOR ));
+    const uint32_t* depth = reinterpret_cast< const uint32_t* >(
+        result->getPixelPointer( eq::Frame::BUFFER_DEPTH ));
+
+    for( size_t i = 0; i < pvp.getArea(); ++i )
+    {
+        TESTINFO( depth[i] == expected.depth[i], i << ": " << depth[i] );
+        // pixels on the far plane keep the clear color of the result
+        if( expected.depth[i] != farDepth )
+            TESTINFO( color[i] == expected.color[i], i << ": " << color[i] );
+    }
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    // A is in front on the left half, B on the right half
+    Pixels a, b, merged, sparse;
+    for( int32_t y = 0; y < pvp.h; ++y )
+        for( int32_t x = 0; x < pvp.w; ++x )
+        {
+            const size_t i = y * pvp.w + x;
+            const bool left = x < pvp.w / 2;
+            a.color[i] = 0xff0000ffu;
+            a.depth[i] = left ? 0x10u : 0x30u;
+            b.color[i] = 0xff00ff00u;
+            b.depth[i] = 0x20u;
+            merged.color[i] = left ? a.color[i] : b.color[i];
+            merged.depth[i] = left ? a.depth[i] : b.depth[i];
+            sparse.color[i] = left ? a.color[i] : 0u;
+            sparse.depth[i] = left ? a.depth[i] : farDepth;
+        }
+
+    const std::vector< uint8_t > payloadA = _pack( a );
+    const std::vector< uint8_t > payloadB = _pack( b );
+    const std::vector< uint8_t > payloadSparse = _packBlocks( sparse, 16 );
+    TEST( payloadSparse.size() < payloadA.size( ));
+    {
+        std::ofstream file( filename.c_str(),
+                            std::ios::out | std::ios::binary );
+        TEST( file.is_open( ));
+        _write( file, magic );
+        _write( file, version );
+        _write( file, uint32_t( sizeof( eq::FrameData::ImageHeader )));
+
+        _writeImage( file, idA, 1, 1, payloadA );
+        _writeImage( file, idB, 1, 1, payloadB );
+        _writeAssembly( file, 1, { co::ObjectVersion( idA, 1ull ),
+                                   co::ObjectVersion( idB, 1ull ) });
+
+        _writeImage( file, idA, 2, 2, payloadSparse );
+        _writeAssembly( file, 2, { co::ObjectVersion( idA, 2ull ) });
+        TEST( file.good( ));
+    }
+
+    eq::FrameReplay replay( filename );
+    TEST( replay.isGood( ));
+    for( size_t pass = 0; pass < 2; ++pass )
+    {
+        TEST( replay.next( ));
+        TEST( replay.getTimes().frameNumber == 1 );
+        TEST( replay.getTimes().nImages == 2 );
+        TEST( replay.getTimes().size == payloadA.size() + payloadB.size( ));
+        TEST( replay.getImages().size() == 2 );
+        _testResult( replay.getResult(), merged );
+
+        TEST( replay.next( ));
+        TEST( replay.getTimes().frameNumber == 2 );
+        TEST( replay.getTimes().nImages == 1 );
+        TEST( replay.getTimes().size == payloadSparse.size( ));
+        TEST( replay.getImages().size() == 1 );
+        _testResult( replay.getResult(), sparse );
+
+        TEST( !replay.next( ));
+        replay.rewind();
+        TEST( replay.isGood( ));
+    }
+
+    // captures of another format version are rejected
+    {
+        std::fstream file( filename.c_str(), std::ios::in | std::ios::out |
+                                             std::ios::binary );
+        file.seekp( sizeof( magic ));
+        _write( file, version + 1 );
+    }
+    eq::FrameReplay invalid( filename );
+    TEST( !invalid.isGood( ));
+    TEST( !invalid.next( ));
+
+    ::remove( filename.c_str( ));
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
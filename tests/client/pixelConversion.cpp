@@ -0,0 +1,241 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the SIMD pixel conversions are exact, i.e., bit-identical to the
+// scalar code paths and to the reference values.
+
+#include <lunchbox/test.h>
+
+#include <eq/util/pixelConversion.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace pixel = eq::util::pixel;
+
+namespace
+{
+uint32_t _bits( const float value )
+{
+    uint32_t bits;
+    ::memcpy( &bits, &value, sizeof( bits ));
+    return bits;
+}
+
+float _float( const uint32_t bits )
+{
+    float value;
+    ::memcpy( &value, &bits, sizeof( value ));
+    return value;
+}
+
+/** Run a conversion with and without SIMD and compare the results. */
+template< class In, class Out, class Func >
+void _testSIMD( const std::vector< In >& in, Func func )
+{
+    std::vector< Out > simd( in.size( ));
+    std::vector< Out > scalar( in.size( ));
+
+    pixel::setSIMDEnabled( true );
+    func( in.data(), simd.data(), in.size( ));
+    pixel::setSIMDEnabled( false );
+    func( in.data(), scalar.data(), in.size( ));
+    pixel::setSIMDEnabled( true );
+
+    TEST( ::memcmp( simd.data(), scalar.data(),
+                    in.size() * sizeof( Out )) == 0 );
+}
+
+void _testHalf()
+{
+    std::vector< uint16_t > halfs( 65536 );
+    for( size_t i = 0; i < halfs.size(); ++i )
+        halfs[i] = uint16_t( i );
+    _testSIMD< uint16_t, float >( halfs, pixel::halfToFloat );
+    _testSIMD< uint16_t, uint8_t >( halfs, pixel::halfToUnorm8 );
+
+    std::vector< float > floats( halfs.size( ));
+    pixel::halfToFloat( halfs.data(), floats.data(), halfs.size( ));
+    TEST( floats[ 0x3c00 ] == 1.f );
+    TEST( floats[ 0xc000 ] == -2.f );
+    TEST( floats[ 0x7bff ] == 65504.f );
+    TEST( floats[ 0x0001 ] == std::ldexp( 1.f, -24 ));
+    TEST( floats[ 0x7c00 ] == std::numeric_limits< float >::infinity( ));
+    TEST( _bits( floats[ 0x8000 ] ) == 0x80000000u );
+    TEST( _bits( floats[ 0x7c01 ] ) == 0x7fc02000u ); // quieted signaling NaN
+
+    // all non-NaN values survive the round trip
+    std::vector< uint16_t > back( halfs.size( ));
+    pixel::floatToHalf( floats.data(), back.data(), floats.size( ));
+    for( size_t i = 0; i < halfs.size(); ++i )
+        if(( halfs[i] & 0x7fff ) <= 0x7c00 )
+            TESTINFO( back[i] == halfs[i], i << " -> " << back[i] );
+
+    // every 251th float covers all exponents and many mantissas
+    std::vector< float > values;
+    values.reserve( ( uint64_t( 1 ) << 32 ) / 251 + 1 );
+    for( uint64_t i = 0; i < ( uint64_t( 1 ) << 32 ); i += 251 )
+        values.push_back( _float( uint32_t( i )));
+    _testSIMD< float, uint16_t >( values, pixel::floatToHalf );
+    _testSIMD< float, uint8_t >( values, pixel::floatToUnorm8 );
+
+    // round to nearest even
+    const float ties[] = { 1.f + std::ldexp( 1.f, -11 ),
+                           1.f + 3.f * std::ldexp( 1.f, -11 ),
+                           65519.f, 65520.f, std::ldexp( 1.f, -25 ),
+                           std::ldexp( 3.f, -25 ) };
+    const uint16_t expected[] = { 0x3c00, 0x3c02, 0x7bff, 0x7c00, 0x0000,
+                                  0x0002 };
+    uint16_t rounded[ 6 ];
+    pixel::floatToHalf( ties, rounded, 6 );
+    for( size_t i = 0; i < 6; ++i )
+        TESTINFO( rounded[i] == expected[i], i << ": " << rounded[i] );
+}
+
+void _testUnorm8()
+{
+    const float in[] = { -1.f, 0.f, 0.5f, 1.f, 2.f,
+                         std::numeric_limits< float >::quiet_NaN(),
+                         std::numeric_limits< float >::infinity(),
+                         -std::numeric_limits< float >::infinity(),
+                         0.999f, 1.f / 255.f };
+    const uint8_t expected[] = { 0, 0, 127, 255, 255, 0, 255, 0, 254, 1 };
+    const size_t n = sizeof( in ) / sizeof( float );
+
+    // repeat the values to cover the SIMD and the scalar code paths
+    std::vector< float > values;
+    for( size_t i = 0; i < 7; ++i )
+        values.insert( values.end(), in, in + n );
+    std::vector< uint8_t > out( values.size( ));
+    pixel::floatToUnorm8( values.data(), out.data(), values.size( ));
+    for( size_t i = 0; i < values.size(); ++i )
+        TESTINFO( out[i] == expected[ i % n ], i << ": " << int( out[i] ));
+}
+
+void _testInterleave()
+{
+    const size_t sizes[] = { 1, 2, 4 };
+    const size_t counts[] = { 0, 1, 15, 16, 17, 1000 };
+    for( size_t s = 0; s < 3; ++s )
+    for( size_t nChannels = 1; nChannels <= 4; ++nChannels )
+    for( size_t c = 0; c < 6; ++c )
+    {
+        const size_t size = sizes[s];
+        const size_t nPixels = counts[c];
+        std::vector< uint8_t > in( nPixels * nChannels * size + 1 );
+        for( size_t i = 0; i < in.size(); ++i )
+            in[i] = uint8_t( i * 7 + i / 256 );
+
+        std::vector< uint8_t > planes( nPixels * nChannels * size + 1 );
+        void* pointers[ 4 ];
+        for( size_t i = 0; i < nChannels; ++i )
+            pointers[i] = &planes[ i * nPixels * size ];
+
+        pixel::deinterleave( in.data(), nPixels, nChannels, size, pointers );
+        for( size_t i = 0; i < nChannels; ++i )
+            for( size_t j = 0; j < nPixels; ++j )
+                TESTINFO( ::memcmp( &planes[ ( i * nPixels + j ) * size ],
+                                    &in[ ( j * nChannels + i ) * size ],
+                                    size ) == 0,
+                          size << "x" << nChannels << " pixel " << j );
+
+        std::vector< uint8_t > out( in.size(), in.back( ));
+        pixel::interleave( pointers, nPixels, nChannels, size, out.data( ));
+        TESTINFO( out == in, size << "x" << nChannels << " " << nPixels );
+    }
+}
+
+void _testUnpremultiply()
+{
+    std::vector< uint8_t > color( 65536 + 5 );
+    std::vector< uint8_t > alpha( color.size( ));
+    for( size_t i = 0; i < color.size(); ++i )
+    {
+        color[i] = uint8_t( i );
+        alpha[i] = uint8_t( i >> 8 );
+    }
+
+    std::vector< uint8_t > result = color;
+    pixel::unpremultiply( result.data(), alpha.data(), result.size( ));
+    for( size_t i = 0; i < color.size(); ++i )
+    {
+        const uint32_t expected = alpha[i] == 0 ? color[i] :
+                         std::min( 255u, 255u * color[i] / alpha[i] );
+        TESTINFO( result[i] == expected, int( color[i] ) << "/" <<
+                  int( alpha[i] ) << " = " << int( result[i] ));
+    }
+}
+
+void _testDiffers()
+{
+    const uint8_t rgbMask[] = { 0xff, 0xff, 0xff, 0 };
+    const uint8_t black[] = { 0, 0, 0, 0xff };
+    const size_t sizes[] = { 1, 4, 8, 12, 16 };
+    for( const size_t size : sizes )
+    {
+        std::vector< uint8_t > mask( size, 0xff );
+        std::vector< uint8_t > background( size, 0x80 );
+        if( size == 4 )
+        {
+            mask.assign( rgbMask, rgbMask + 4 );
+            background.assign( black, black + 4 );
+        }
+
+        for( size_t nPixels = 0; nPixels < 70; ++nPixels )
+        {
+            std::vector< uint8_t > pixels;
+            for( size_t i = 0; i < nPixels; ++i )
+                pixels.insert( pixels.end(), background.begin(),
+                               background.end( ));
+            if( size == 4 && nPixels > 0 )
+                pixels[ nPixels * 4 - 1 ] = 0x7f; // masked alpha is ignored
+            TESTINFO( !pixel::differs( pixels.data(), nPixels, size,
+                                       mask.data(), background.data( )),
+                      size << "x" << nPixels );
+
+            for( size_t i = 0; i < nPixels * size; ++i )
+            {
+                if( !mask[ i % size ] )
+                    continue;
+                pixels[i] ^= 0x01;
+                TESTINFO( pixel::differs( pixels.data(), nPixels, size,
+                                          mask.data(), background.data( )),
+                          size << "x" << nPixels << " @" << i );
+                pixels[i] ^= 0x01;
+            }
+        }
+    }
+}
+}
+
+int main( int, char** )
+{
+    std::cout << "Using " << pixel::getSIMDInstructions() << std::endl;
+    _testHalf();
+    _testUnorm8();
+    _testUnpremultiply();
+
+    _testInterleave();
+    _testDiffers();
+    pixel::setSIMDEnabled( false );
+    _testInterleave();
+    _testUnpremultiply();
+    _testDiffers();
+    return EXIT_SUCCESS;
+}
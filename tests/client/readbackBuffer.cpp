@@ -0,0 +1,200 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Starts asynchronous framebuffer readbacks in the window context and finishes
+// them from a second thread in a shared context without a drawable, as done by
+// the channel's transfer thread. With GL_ARB_buffer_storage and GL_ARB_sync,
+// the readback goes through a persistently mapped pixel pack buffer.
+
+#include <lunchbox/test.h>
+#include <eq/eq.h>
+#include <eq/fabric/channel.h>
+
+#include <thread>
+
+#ifdef _WIN32
+#  define setenv( name, value, overwrite ) \
+    _putenv_s( name, value )
+#endif
+
+#ifdef EQUALIZER_USE_HWSD
+namespace
+{
+const eq::PixelViewport pvp( 0, 0, 200, 100 );
+
+class TestChannel : public eq::Channel
+{
+public:
+    explicit TestChannel( eq::Window* parent ) : eq::Channel( parent ) {}
+
+protected:
+    void frameDraw( const eq::uint128_t& ) override
+    {
+        if( !GLEW_ARB_pixel_buffer_object || !GLEW_ARB_buffer_storage ||
+            !GLEW_ARB_sync )
+        {
+            std::cerr << "Persistently mapped buffers not supported, skipping"
+                      << std::endl;
+            return;
+        }
+
+        eq::SystemWindow* transfer = _createTransferWindow();
+        TEST( transfer );
+
+        eq::Image image;
+        image.setAlphaUsage( true );
+        TEST( image.allocDownloader( eq::Frame::BUFFER_COLOR,
+                                     EQ_COMPRESSOR_TRANSFER_RGBA_TO_BGRA,
+                                     glewGetContext( )));
+
+        // the readbacks alternate between two mapped buffers, the third one
+        // reuses the buffer of the first one
+        _readback( image, *transfer, eq::Vector4f( 1.f, .5f, .25f, 1.f ),
+                   0xffff8040u );
+        _readback( image, *transfer, eq::Vector4f( 0.f, 1.f, 0.f, 1.f ),
+                   0xff00ff00u );
+        _readback( image, *transfer, eq::Vector4f( 0.f, 0.f, 1.f, 1.f ),
+                   0xff0000ffu );
+
+        image.resetPlugins();
+        transfer->configExit();
+        delete transfer;
+        getWindow()->makeCurrent( false );
+    }
+
+private:
+    /** @return a drawable-less window sharing the context of our window. */
+    eq::SystemWindow* _createTransferWindow()
+    {
+        eq::Window* window = getWindow();
+        eq::WindowSettings settings = window->getSettings();
+        settings.setIAttribute( eq::WindowSettings::IATTR_HINT_DRAWABLE,
+                                eq::OFF );
+        settings.setSharedContextWindow( window->getSystemWindow( ));
+
+        eq::SystemWindow* transfer =
+            getPipe()->getWindowSystem().createWindow( window, settings );
+        if( !transfer )
+            return 0;
+        if( !transfer->configInit( ))
+        {
+            delete transfer;
+            return 0;
+        }
+        transfer->makeCurrent();
+        transfer->doneCurrent();
+        window->makeCurrent( false );
+        return transfer;
+    }
+
+    void _readback( eq::Image& image, const eq::SystemWindow& transfer,
+                    const eq::Vector4f& color, const uint32_t expected )
+    {
+        EQ_GL_CALL( glClearColor( color[0], color[1], color[2], color[3] ));
+        EQ_GL_CALL( glClear( GL_COLOR_BUFFER_BIT ));
+
+        const eq::PixelViewport& channelPVP = getPixelViewport();
+        TEST( image.startReadback( eq::Frame::BUFFER_COLOR, channelPVP,
+                                   getContext(), eq::Zoom::NONE,
+                                   getObjectManager( )));
+
+        std::thread thread( [ &image, &transfer ]
+        {
+            transfer.makeCurrent();
+            image.finishReadback( transfer.glewGetContext( ));
+            transfer.doneCurrent();
+        });
+        thread.join();
+
+        TEST( image.hasPixelData( eq::Frame::BUFFER_COLOR ));
+        TEST( image.getPixelViewport() == eq::PixelViewport(
+                  0, 0, channelPVP.w, channelPVP.h ));
+        const uint32_t* pixels = reinterpret_cast< const uint32_t* >(
+            image.getPixelPointer( eq::Frame::BUFFER_COLOR ));
+        for( uint32_t i = 0; i < channelPVP.getArea(); ++i )
+            TESTINFO( pixels[i] == expected, i << ": " << std::hex
+                      << pixels[i] << " != " << expected );
+    }
+};
+
+class TestWindow : public eq::Window
+{
+public:
+    explicit TestWindow( eq::Pipe* parent ) : eq::Window( parent ) {}
+
+    bool configInit( const eq::uint128_t& initID ) override
+    {
+        setPixelViewport( pvp );
+        return eq::Window::configInit( initID );
+    }
+};
+
+class TestNodeFactory : public eq::NodeFactory
+{
+public:
+    eq::Window* createWindow( eq::Pipe* parent ) override
+        { return new TestWindow( parent ); }
+    eq::Channel* createChannel( eq::Window* parent ) override
+        { return new TestChannel( parent ); }
+};
+}
+
+int main( const int argc, char** argv )
+{
+#ifndef Darwin
+    ::setenv( "EQ_WINDOW_IATTR_HINT_DRAWABLE", "-12" /*FBO*/, 1 /*overwrite*/ );
+#endif
+
+    TestNodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    eq::ClientPtr client = new eq::Client;
+    TEST( client->initLocal( argc, argv ));
+
+    eq::ServerPtr server = new eq::Server;
+    TEST( client->connectServer( server ));
+
+    eq::fabric::ConfigParams configParams;
+    eq::Config* config = server->chooseConfig( configParams );
+
+    if( !config ) // Most probably no GPUs present, tests in meaningless
+    {
+        client->disconnectServer( server );
+        client->exitLocal();
+        eq::exit();
+        return EXIT_SUCCESS;
+    }
+    TEST( config->init( co::uint128_t( )));
+
+    config->startFrame( co::uint128_t( ));
+    config->finishFrame();
+
+    config->exit();
+    server->releaseConfig( config );
+    client->disconnectServer( server );
+    client->exitLocal();
+    eq::exit();
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main( const int, char** )
+{
+    return EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,96 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <eVolve/brickGrid.h>
+
+// Classifies the bricks of a volume with a small opaque cube for different
+// transfer functions. A new transfer function only reclassifies the brick
+// min/max grid, the volume data is not read again.
+
+namespace
+{
+const uint32_t size = 32; // voxels along each axis, 4x4x4 bricks
+const uint8_t cube = 200; // value inside [8, 16)^3, zero elsewhere
+
+std::vector< uint8_t > _transferFunction( const uint8_t opaqueValue )
+{
+    std::vector< uint8_t > TF( 256 * 4, 0 );
+    TF[ opaqueValue * 4 + 3 ] = 255;
+    return TF;
+}
+
+uint32_t _countVisible( const eVolve::BrickGrid& grid )
+{
+    uint32_t nVisible = 0;
+    for( uint32_t bz = 0; bz < grid.getDepth(); ++bz )
+        nVisible += grid.getLayer( bz ).nVisible;
+    return nVisible;
+}
+}
+
+int main( int, char** )
+{
+    // RGBA voxels as in raw+der volumes, the scalar is the fourth byte
+    std::vector< uint8_t > volume( size * size * size * 4, 0 );
+    for( uint32_t z = 8; z < 16; ++z )
+        for( uint32_t y = 8; y < 16; ++y )
+            for( uint32_t x = 8; x < 16; ++x )
+                volume[ (( z * size + y ) * size + x ) * 4 + 3 ] = cube;
+
+    eVolve::BrickGrid grid;
+    TEST( grid.isEmpty( ));
+    grid.compute( &volume[3], size, size, size, 4 );
+    TEST( !grid.isEmpty( ));
+    TEST( grid.getWidth() == 4 );
+    TEST( grid.getHeight() == 4 );
+    TEST( grid.getDepth() == 4 );
+
+    // reclassification must not touch the volume anymore
+    std::fill( volume.begin(), volume.end(), 0 );
+
+    // only the cube is opaque: its brick and the neighbours sampling its
+    // voxels in their apron are visible
+    std::vector< uint8_t > visibility;
+    grid.classify( _transferFunction( cube ), visibility, 4, 4, 4 );
+    TEST( visibility.size() == 64 );
+    TESTINFO( _countVisible( grid ) == 27, _countVisible( grid ));
+    TEST( visibility[ ( 1 * 4 + 1 ) * 4 + 1 ] == 255 );
+    TEST( visibility[ ( 3 * 4 + 3 ) * 4 + 3 ] == 0 );
+    const eVolve::BrickGrid::Layer& layer = grid.getLayer( 1 );
+    TEST( layer.x0 == 0 && layer.x1 == 2 && layer.y0 == 0 && layer.y1 == 2 );
+    TEST( grid.getLayer( 3 ).nVisible == 0 );
+    TEST( grid.getLayer( 3 ).x0 > grid.getLayer( 3 ).x1 );
+
+    // only the empty space is opaque: all bricks are visible, the apron of
+    // the cube's brick reaches into the empty space
+    grid.classify( _transferFunction( 0 ), visibility, 8, 8, 8 );
+    TEST( visibility.size() == 512 );
+    TESTINFO( _countVisible( grid ) == 64, _countVisible( grid ));
+    TEST( visibility[ ( 1 * 8 + 1 ) * 8 + 1 ] == 255 );
+    TEST( visibility[ ( 3 * 8 + 3 ) * 8 + 3 ] == 255 );
+    TEST( visibility[ ( 3 * 8 + 3 ) * 8 + 4 ] == 0 ); // padding
+
+    // values next to an opaque one are visible due to linear filtering
+    grid.classify( _transferFunction( cube + 1 ), visibility, 4, 4, 4 );
+    TESTINFO( _countVisible( grid ) == 27, _countVisible( grid ));
+
+    // a transparent transfer function hides everything
+    grid.classify( std::vector< uint8_t >( 256 * 4, 0 ), visibility, 4, 4, 4 );
+    TEST( _countVisible( grid ) == 0 );
+    return EXIT_SUCCESS;
+}
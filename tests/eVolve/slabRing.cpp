@@ -0,0 +1,71 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <eVolve/slabRing.h>
+
+// Two channels with different DB ranges share the slab ring of one model and
+// must not evict each other's slabs.
+
+int main( int, char** )
+{
+    eVolve::SlabRing ring;
+    ring.setNSlabs( 64 );
+
+    // first range allocates the ring
+    TEST( ring.update( 0, 5 ));
+    TEST( ring.getUploads().size() == 6 );
+
+    // second, disjoint range grows the ring to the union of both
+    TEST( ring.update( 40, 45 ));
+    TEST( ring.getUploads().size() == 6 );
+    TESTINFO( ring.getNSlots() >= 46, ring.getNSlots( ));
+    TEST( ring.getNSlots() <= 64 );
+
+    // the first range lost its slabs in the reallocation
+    TEST( !ring.update( 0, 5 ));
+    TEST( ring.getUploads().size() == 6 );
+
+    // alternating between the two ranges does not upload anything anymore
+    for( size_t i = 0; i < 20; ++i )
+    {
+        TEST( !ring.update( 40, 45 ));
+        TESTINFO( ring.getUploads().empty(), ring.getUploads().size( ));
+        TEST( !ring.update( 0, 5 ));
+        TESTINFO( ring.getUploads().empty(), ring.getUploads().size( ));
+    }
+
+    // a slowly moving range only uploads the new slab
+    TEST( !ring.update( 1, 6 ));
+    TEST( ring.getUploads().size() == 1 );
+    TEST( ring.getUploads().front() == 6 );
+
+    // slots of resident slabs are distinct over the whole union
+    for( uint32_t i = 0; i <= 45; ++i )
+        for( uint32_t j = i + 1; j <= 45; ++j )
+            TEST( ring.getSlot( i ) != ring.getSlot( j ));
+
+    // a small volume never gets more slots than slabs, rounded up
+    eVolve::SlabRing small;
+    small.setNSlabs( 3 );
+    TEST( small.update( 0, 0 ));
+    TEST( small.getNSlots() == 4 );
+    TEST( !small.update( 2, 2 ));
+    TEST( !small.update( 0, 2 ));
+    TEST( small.getUploads().size() == 1 );
+    return EXIT_SUCCESS;
+}
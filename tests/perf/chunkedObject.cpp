@@ -0,0 +1,176 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <eq/chunkedObject.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/localNode.h>
+#include <lunchbox/clock.h>
+
+// Measures how long the application thread is blocked by committing a 16 MB
+// per-frame delta, as chunks committed by threads or as one object, and the
+// time until the delta is synced on another node.
+
+namespace
+{
+typedef std::vector< uint32_t > Words;
+
+const size_t nChunks = 64;
+const size_t chunkSize = 64 * 1024; // words, 256 KB
+const size_t nFrames = 20;
+
+co::LocalNodePtr _listen()
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "localhost" );
+
+    co::LocalNodePtr node = new co::LocalNode;
+    node->addConnectionDescription( desc );
+    TEST( node->listen( ));
+    return node;
+}
+
+// half random, half constant words per cache line, changing every frame
+void _fill( Words& words, const size_t frame, const size_t chunk )
+{
+    uint32_t state = uint32_t( frame * nChunks + chunk + 1 ) * 2654435761u;
+    for( size_t i = 0; i < words.size(); ++i )
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        words[i] = ( i % 16 ) < 8 ? state : uint32_t( frame );
+    }
+}
+
+class Chunked : public eq::ChunkedObject
+{
+public:
+    Chunked() : eq::ChunkedObject( nChunks ), data( nChunks ) {}
+
+    void update( const size_t frame )
+    {
+        for( size_t i = 0; i < nChunks; ++i )
+        {
+            setChunkDirty( i );
+            data[i].resize( chunkSize );
+            _fill( data[i], frame, i );
+        }
+    }
+
+    std::vector< Words > data;
+
+protected:
+    void serializeChunk( co::DataOStream& os, const size_t chunk ) override
+        { os << data[ chunk ]; }
+    void deserializeChunk( co::DataIStream& is, const size_t chunk ) override
+        { is >> data[ chunk ]; }
+};
+
+class Single : public co::Object
+{
+public:
+    Single() : data( nChunks ) {}
+
+    void update( const size_t frame )
+    {
+        for( size_t i = 0; i < nChunks; ++i )
+        {
+            data[i].resize( chunkSize );
+            _fill( data[i], frame, i );
+        }
+    }
+
+    std::vector< Words > data;
+
+protected:
+    ChangeType getChangeType() const override { return INSTANCE; }
+    void getInstanceData( co::DataOStream& os ) override { os << data; }
+    void applyInstanceData( co::DataIStream& is ) override { is >> data; }
+};
+
+template< class T >
+void _measure( const std::string& name, co::LocalNodePtr server,
+               co::LocalNodePtr client )
+{
+    T master;
+    T slave;
+    master.update( 0 );
+    TEST( server->registerObject( &master ));
+    master.setAutoObsolete( 1 );
+    TEST( client->mapObject( &slave, co::ObjectVersion( &master )));
+
+    slave.sync( master.commit( )); // first commit registers the chunks
+    TEST( slave.data == master.data );
+
+    float commitTime = 0.f;
+    lunchbox::Clock clock;
+    for( size_t frame = 1; frame <= nFrames; ++frame )
+    {
+        master.update( frame );
+
+        const lunchbox::Clock commitClock;
+        const co::uint128_t version = master.commit();
+        commitTime += commitClock.getTimef();
+
+        slave.sync( version );
+        TEST( slave.data == master.data );
+    }
+    const float time = clock.getTimef();
+
+    std::cout << name << ": " << commitTime / float( nFrames )
+              << " ms blocked in commit, " << time / float( nFrames )
+              << " ms/frame for " << ( nChunks * chunkSize * 4 >> 20 )
+              << " MB" << std::endl;
+
+    client->unmapObject( &slave );
+    server->deregisterObject( &master );
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    co::LocalNodePtr server = _listen();
+    co::LocalNodePtr client = _listen();
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription(
+        server->getConnectionDescriptions().front( ));
+    TEST( client->connect( serverProxy ));
+
+    _measure< Single >( "one object", server, client );
+    _measure< Chunked >( "64 chunks", server, client );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+    serverProxy = 0;
+    client = 0;
+    server = 0;
+
+    eq::exit();
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,5 @@
 
-/* Copyright (c) 2006-2014, Stefan Eilemann <eile@equalizergraphics.com>
+/* Copyright (c) 2006-2016, Stefan Eilemann <eile@equalizergraphics.com>
  *
  * This library is free software; you can redistribute it and/or modify it under
  * the terms of the GNU Lesser General Public License version 2.1 as published
@@ -19,30 +19,44 @@
 #include <lunchbox/test.h>
 
 #include <eq/frame.h>    // enum Eye
+#include <eq/frameReplay.h>
 #include <eq/image.h>
 #include <eq/init.h>
 #include <eq/nodeFactory.h>
 #include <eq/pixelData.h>
+#include <eq/util/pixelConversion.h>
 
 #include <co/global.h>
 
 #include <lunchbox/clock.h>
 #include <lunchbox/file.h>
+#include <pression/compressor.h>
+#include <pression/decompressor.h>
 #include <pression/plugin.h>
 #include <pression/pluginRegistry.h>
 #include <pression/pluginVisitor.h>
 #include <pression/plugins/compressor.h>
 
-#include <numeric>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <atomic>
 #include <fstream>
-
-// Tests the functionality and speed of the image compression.
-//#define WRITE_DECOMPRESSED
-//#define WRITE_COMPRESSED
-
-#ifndef NDEBUG
-#  define COMPARE_RESULT
-#endif
+#include <map>
+#include <thread>
+
+// Benchmarks the image compression plugins on a corpus of images: the stored
+// test images by default, or the given rgb files, directories and frame
+// captures. Each image is compressed in horizontal chunks, each by its own
+// compressor instance, distributed over a number of threads, like images are
+// compressed for transmission. Compression and decompression throughput, the
+// compression ratio and the error of the decompressed pixels are measured
+// separately for each combination. By default, each image is compressed once
+// as one chunk on one thread; --sweep measures chunk and thread counts. The
+// results are written as JSON with --output, and two runs can be compared for
+// regressions.
+
+namespace po = boost::program_options;
 
 namespace
 {
@@ -53,283 +67,637 @@ public:
                                            const EqCompressorInfo& info )
     {
         if( !(info.capabilities & EQ_COMPRESSOR_TRANSFER) )
-            names.push_back( info.name );
+            infos.push_back( info );
         return lunchbox::TRAVERSE_CONTINUE;
     }
 
-    std::vector< uint32_t > names;
+    std::vector< EqCompressorInfo > infos;
+};
+
+/** An image buffer of the corpus. */
+struct Input
+{
+    std::string name;
+    eq::Frame::Buffer buffer;
+    uint32_t format; // external format, the token type of the compressors
+    uint32_t pixelSize;
+    eq::PixelViewport pvp;
+    bool hasAlpha;
+    std::vector< uint8_t > pixels;
+};
+typedef std::vector< Input > Inputs;
+
+/** The measurements of one compressor, image and configuration. */
+struct Result
+{
+    Result() : compressor( 0 ), alpha( true ), chunks( 0 ), threads( 0 )
+             , size( 0 ), compressedSize( 0 ), compressTime( 0.f )
+             , decompressTime( 0.f ), meanError( -1. ), maxError( -1. ) {}
+
+    std::string image;
+    std::string buffer;
+    uint32_t compressor;
+    bool alpha;
+    uint32_t chunks;
+    uint32_t threads;
+    uint64_t size;
+    uint64_t compressedSize;
+    float compressTime;   // ms, best of all loops
+    float decompressTime; // ms, best of all loops
+    double meanError;     // -1 if not comparable
+    double maxError;
+
+    std::string getKey() const
+    {
+        std::ostringstream os;
+        os << image << '|' << buffer << '|' << compressor << '|' << alpha
+           << '|' << chunks << '|' << threads;
+        return os.str();
+    }
+
+    float getRatio() const
+        { return size ? float( compressedSize ) / float( size ) : 1.f; }
+    float getCompressThroughput() const
+        { return _getThroughput( compressTime ); }
+    float getDecompressThroughput() const
+        { return _getThroughput( decompressTime ); }
+
+private:
+    float _getThroughput( const float time ) const // MB/s
+    {
+        return float( size ) / 1024.f / 1024.f /
+               ( std::max( time, 0.001f ) / 1000.f );
+    }
+};
+typedef std::vector< Result > Results;
+
+enum ChannelType
+{
+    CHANNEL_NONE,
+    CHANNEL_UNORM8,
+    CHANNEL_HALF,
+    CHANNEL_FLOAT,
+    CHANNEL_UINT
 };
 
-template< typename T >
-static void _compare( const void* data, const void* destData,
-                      const eq::Frame::Buffer buffer, const bool useAlpha,
-                      const int64_t nElem, const float quality )
+ChannelType _getChannelType( const uint32_t format )
 {
-    const T* destValue = reinterpret_cast< const T* >( destData );
-    const T* value = reinterpret_cast< const T* >( data );
-    double error = 0.;
+    switch( format )
+    {
+    case EQ_COMPRESSOR_DATATYPE_RGBA:
+    case EQ_COMPRESSOR_DATATYPE_BGRA:
+    case EQ_COMPRESSOR_DATATYPE_RGB:
+    case EQ_COMPRESSOR_DATATYPE_BGR:
+        return CHANNEL_UNORM8;
+    case EQ_COMPRESSOR_DATATYPE_RGB16F:
+    case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+    case EQ_COMPRESSOR_DATATYPE_BGR16F:
+    case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+        return CHANNEL_HALF;
+    case EQ_COMPRESSOR_DATATYPE_BGRA32F:
+    case EQ_COMPRESSOR_DATATYPE_BGR32F:
+    case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+    case EQ_COMPRESSOR_DATATYPE_RGB32F:
+        return CHANNEL_FLOAT;
+    case EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT:
+        return CHANNEL_UINT;
+    default: // packed formats, e.g., RGB10_A2
+        return CHANNEL_NONE;
+    }
+}
 
-#pragma omp parallel for reduction(+ : error)
-    for( int64_t k = 0; k < nElem; ++k )
+/** Accumulate the absolute differences of n values as doubles. */
+template< typename T, typename F >
+void _addError( const T* a, const T* b, const size_t n, const size_t skip,
+                F normalize, double& sum, double& max, size_t& count )
+{
+    for( size_t i = 0; i < n; ++i )
+    {
+        if( skip && i % skip == skip - 1 )
+            continue;
+
+        const double error = ::fabs( normalize( a[i] ) - normalize( b[i] ));
+        if( error != error ) // NaN
+            continue;
+        sum += error;
+        max = std::max( max, error );
+        ++count;
+    }
+}
+
+/** Compute the error of the decompressed pixels, normalized for unorms. */
+void _measureError( const Input& input, const uint8_t* result,
+                    const bool alpha, Result& out )
+{
+    const ChannelType type = _getChannelType( input.format );
+    const size_t channelSize = type == CHANNEL_UNORM8 ? 1 :
+                               type == CHANNEL_HALF ? 2 : 4;
+    const size_t n = input.pixels.size() / channelSize;
+    // Don't test alpha if alpha is ignored
+    const size_t skip = alpha || !input.hasAlpha ? 0 : 4;
+
+    double sum = 0.;
+    double max = 0.;
+    size_t count = 0;
+    switch( type )
     {
-        if( !useAlpha && buffer == eq::Frame::BUFFER_COLOR )
+    case CHANNEL_UNORM8:
+        _addError( input.pixels.data(), result, n, skip,
+                   []( uint8_t v ) { return double( v ) / 255.; },
+                   sum, max, count );
+        break;
+
+    case CHANNEL_HALF:
+    {
+        std::vector< float > a( n );
+        std::vector< float > b( n );
+        eq::util::pixel::halfToFloat(
+            reinterpret_cast< const uint16_t* >( input.pixels.data( )),
+            a.data(), n );
+        eq::util::pixel::halfToFloat(
+            reinterpret_cast< const uint16_t* >( result ), b.data(), n );
+        _addError( a.data(), b.data(), n, skip,
+                   []( float v ) { return double( v ); }, sum, max, count );
+        break;
+    }
+
+    case CHANNEL_FLOAT:
+        _addError( reinterpret_cast< const float* >( input.pixels.data( )),
+                   reinterpret_cast< const float* >( result ), n, skip,
+                   []( float v ) { return double( v ); }, sum, max, count );
+        break;
+
+    case CHANNEL_UINT:
+        _addError( reinterpret_cast< const uint32_t* >( input.pixels.data( )),
+                   reinterpret_cast< const uint32_t* >( result ), n, skip,
+                   []( uint32_t v ) { return double( v ) / 4294967295.; },
+                   sum, max, count );
+        break;
+
+    case CHANNEL_NONE:
+        return;
+    }
+
+    out.meanError = count ? sum / double( count ) : 0.;
+    out.maxError = max;
+}
+
+/** Run the n tasks on the given number of threads. */
+template< typename F > void _parallel( const size_t nThreads, const size_t n,
+                                       const F& task )
+{
+    std::atomic< size_t > next( 0 );
+    auto worker = [&]
+    {
+        for( size_t i = next++; i < n; i = next++ )
+            task( i );
+    };
+
+    std::vector< std::thread > threads;
+    for( size_t i = 1; i < nThreads; ++i )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+Result _benchmark( const Input& input, const EqCompressorInfo& info,
+                   const bool alpha, const uint32_t nChunks,
+                   const uint32_t nThreads, const size_t nLoops )
+{
+    pression::PluginRegistry& registry = co::Global::getPluginRegistry();
+    const uint32_t chunks = std::min( nChunks, uint32_t( input.pvp.h ));
+    const size_t rowSize = input.pvp.w * input.pixelSize;
+    const size_t outRowSize = input.pvp.w * info.outputTokenSize;
+    const uint64_t flags = EQ_COMPRESSOR_DATA_2D |
+                           ( alpha ? 0 : EQ_COMPRESSOR_IGNORE_ALPHA );
+
+    std::vector< pression::Compressor > compressors( chunks );
+    std::vector< pression::Decompressor > decompressors( chunks );
+    std::vector< eq::PixelViewport > pvps( chunks );
+    std::vector< uint8_t > output( input.pvp.getArea() *
+                                   info.outputTokenSize );
+    for( uint32_t i = 0; i < chunks; ++i )
+    {
+        const int32_t y = input.pvp.h * i / chunks;
+        pvps[i] = eq::PixelViewport( 0, y, input.pvp.w,
+                                     input.pvp.h * ( i + 1 ) / chunks - y );
+        TEST( compressors[i].setup( registry, info.name ));
+        TEST( decompressors[i].setup( registry, info.name ));
+    }
+
+    Result result;
+    result.image = input.name;
+    result.buffer = input.buffer == eq::Frame::BUFFER_COLOR ? "color" :
+                                                              "depth";
+    result.compressor = info.name;
+    result.alpha = alpha;
+    result.chunks = chunks;
+    result.threads = nThreads;
+    result.size = input.pixels.size();
+    result.compressTime = std::numeric_limits< float >::max();
+    result.decompressTime = std::numeric_limits< float >::max();
+
+    for( size_t loop = 0; loop < nLoops; ++loop )
+    {
+        lunchbox::Clock clock;
+        _parallel( nThreads, chunks, [&]( const size_t i )
         {
-            // Don't test alpha if alpha is ignored
-            if( k % 4 == 3 )
-                continue;
+            uint64_t dims[4];
+            const eq::PixelViewport pvp( 0, 0, pvps[i].w, pvps[i].h );
+            pvp.convertToPlugin( dims );
+            compressors[i].compress( &input.pixels[ pvps[i].y * rowSize ],
+                                     dims, flags );
+        });
+        result.compressTime = std::min( result.compressTime,
+                                        clock.getTimef( ));
+
+        clock.reset();
+        _parallel( nThreads, chunks, [&]( const size_t i )
+        {
+            uint64_t dims[4];
+            const eq::PixelViewport pvp( 0, 0, pvps[i].w, pvps[i].h );
+            pvp.convertToPlugin( dims );
+            decompressors[i].decompress( compressors[i].getResult(),
+                                         &output[ pvps[i].y * outRowSize ],
+                                         dims, flags );
+        });
+        result.decompressTime = std::min( result.decompressTime,
+                                          clock.getTimef( ));
+    }
+
+    for( const pression::Compressor& compressor : compressors )
+        result.compressedSize += compressor.getResult().getSize();
+
+    if( info.outputTokenType == input.format )
+    {
+        _measureError( input, output.data(), alpha, result );
+        if( result.meanError >= 0. && info.quality >= 1.f )
+            TESTINFO( result.maxError == 0., "lossless compressor 0x"
+                      << std::hex << info.name << std::dec << " error "
+                      << result.maxError << " on " << input.name );
+        else if( result.meanError >= 0. &&
+                 _getChannelType( input.format ) == CHANNEL_UNORM8 )
+            TESTINFO( result.meanError <= 1. - info.quality,
+                      "Comparison of initial data and decompressed data "
+                      "failed, compressor 0x" << std::hex << info.name
+                      << std::dec << " error " << result.meanError );
+    }
+    return result;
+}
+
+void _add( eq::Image& image, const std::string& name,
+           const eq::Frame::Buffer buffer, Inputs& inputs )
+{
+    if( !image.hasPixelData( buffer ))
+        return;
+
+    const eq::PixelData& data = image.getPixelData( buffer );
+    const uint8_t* pixels = reinterpret_cast< const uint8_t* >( data.pixels );
+    Input input;
+    input.name = name;
+    input.buffer = buffer;
+    input.format = data.externalFormat;
+    input.pixelSize = data.pixelSize;
+    input.pvp = data.pvp;
+    input.hasAlpha = buffer == eq::Frame::BUFFER_COLOR && image.hasAlpha();
+    input.pixels.assign( pixels, pixels + data.pvp.getArea()*data.pixelSize );
+    inputs.push_back( input );
+}
+
+void _addImageFile( const std::string& filename, Inputs& inputs )
+{
+    const eq::Frame::Buffer buffer =
+        filename.find( "depth" ) == std::string::npos ?
+            eq::Frame::BUFFER_COLOR : eq::Frame::BUFFER_DEPTH;
+    eq::Image image;
+    TESTINFO( image.readImage( filename, buffer ), filename );
+    _add( image, filename, buffer, inputs );
+}
+
+void _addDirectory( const std::string& directory, Inputs& inputs )
+{
+    eq::Strings candidates = lunchbox::searchDirectory( directory,
+                                                        ".*\\.rgb" );
+    stde::usort( candidates ); // have a predictable order
+    for( const std::string& filename : candidates )
+        if( filename.find( "out_" ) == std::string::npos )
+            _addImageFile( directory + "/" + filename, inputs );
+}
+
+/** Add the input images of the first assemblies of a frame capture. */
+void _addCapture( const std::string& filename, const size_t nFrames,
+                  Inputs& inputs )
+{
+    eq::FrameReplay replay( filename );
+    TESTINFO( replay.isGood(), filename );
+
+    for( size_t i = 0; i < nFrames && replay.next(); ++i )
+    {
+        size_t j = 0;
+        for( eq::Image* image : replay.getImages( ))
+        {
+            std::ostringstream name;
+            name << filename << ":" << replay.getTimes().frameNumber << ":"
+                 << j++;
+            _add( *image, name.str(), eq::Frame::BUFFER_COLOR, inputs );
+            _add( *image, name.str(), eq::Frame::BUFFER_DEPTH, inputs );
         }
+    }
+}
 
-        error += ::fabs( double( value[k] ) - double( destValue[k] ));
+std::string _escape( const std::string& string )
+{
+    std::string escaped;
+    for( const char c : string )
+    {
+        if( c == '"' || c == '\\' )
+            escaped += '\\';
+        escaped += c;
     }
+    return escaped;
+}
 
-    const double max = ( 1.f - quality ) * std::numeric_limits< T >::max() *
-                       double( nElem );
-    TESTINFO( error <= max,
-              "Comparison of initial data and decompressed data failed" <<
-              ", error " << error << " max " << max );
+bool _write( const std::string& filename, const Results& results )
+{
+    std::ofstream file( filename.c_str( ));
+    if( !file.is_open( ))
+        return false;
+
+    file << "{" << std::endl << "  \"results\": [" << std::endl;
+    for( size_t i = 0; i < results.size(); ++i )
+    {
+        const Result& result = results[i];
+        file << "    { \"image\": \"" << _escape( result.image ) << "\", "
+             << "\"buffer\": \"" << result.buffer << "\", "
+             << "\"compressor\": " << result.compressor << ", "
+             << "\"alpha\": " << ( result.alpha ? "true" : "false" ) << ", "
+             << "\"chunks\": " << result.chunks << ", "
+             << "\"threads\": " << result.threads << ", "
+             << "\"size\": " << result.size << ", "
+             << "\"compressedSize\": " << result.compressedSize << ", "
+             << "\"ratio\": " << result.getRatio() << ", "
+             << "\"compressTime\": " << result.compressTime << ", "
+             << "\"decompressTime\": " << result.decompressTime << ", "
+             << "\"compressThroughput\": " << result.getCompressThroughput()
+             << ", \"decompressThroughput\": "
+             << result.getDecompressThroughput() << ", "
+             << "\"meanError\": " << result.meanError << ", "
+             << "\"maxError\": " << result.maxError << " }"
+             << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+    }
+    file << "  ]" << std::endl << "}" << std::endl;
+    return !file.fail();
+}
+
+Results _read( const std::string& filename )
+{
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json( filename, tree );
+
+    Results results;
+    for( const auto& child : tree.get_child( "results" ))
+    {
+        const boost::property_tree::ptree& node = child.second;
+        Result result;
+        result.image = node.get< std::string >( "image" );
+        result.buffer = node.get< std::string >( "buffer" );
+        result.compressor = node.get< uint32_t >( "compressor" );
+        result.alpha = node.get< bool >( "alpha" );
+        result.chunks = node.get< uint32_t >( "chunks" );
+        result.threads = node.get< uint32_t >( "threads" );
+        result.size = node.get< uint64_t >( "size" );
+        result.compressedSize = node.get< uint64_t >( "compressedSize" );
+        result.compressTime = node.get< float >( "compressTime" );
+        result.decompressTime = node.get< float >( "decompressTime" );
+        result.meanError = node.get< double >( "meanError" );
+        result.maxError = node.get< double >( "maxError" );
+        results.push_back( result );
+    }
+    return results;
+}
+
+/** @return the number of regressions of current over baseline. */
+size_t _compare( const Results& baseline, const Results& current,
+                 const float tolerance )
+{
+    std::map< std::string, const Result* > base;
+    for( const Result& result : baseline )
+        base[ result.getKey() ] = &result;
+
+    size_t nCompared = 0;
+    size_t nRegressions = 0;
+    for( const Result& result : current )
+    {
+        const auto i = base.find( result.getKey( ));
+        if( i == base.end( ))
+            continue;
+
+        const Result& old = *i->second;
+        ++nCompared;
+
+        std::ostringstream regressions;
+        if( result.getCompressThroughput() <
+            old.getCompressThroughput() * ( 1.f - tolerance ))
+        {
+            regressions << " compress " << old.getCompressThroughput()
+                        << " -> " << result.getCompressThroughput() << " MB/s";
+        }
+        if( result.getDecompressThroughput() <
+            old.getDecompressThroughput() * ( 1.f - tolerance ))
+        {
+            regressions << " decompress " << old.getDecompressThroughput()
+                        << " -> " << result.getDecompressThroughput()
+                        << " MB/s";
+        }
+        if( result.getRatio() > old.getRatio() * ( 1.f + tolerance ))
+            regressions << " ratio " << old.getRatio() << " -> "
+                        << result.getRatio();
+        if( result.meanError > old.meanError * ( 1. + tolerance ) + 1e-6 )
+            regressions << " error " << old.meanError << " -> "
+                        << result.meanError;
+
+        if( regressions.str().empty( ))
+            continue;
+
+        ++nRegressions;
+        std::cout << "Regression 0x" << std::hex << result.compressor
+                  << std::dec << " " << result.image << " " << result.buffer
+                  << " alpha " << result.alpha << " chunks " << result.chunks
+                  << " threads " << result.threads << ":"
+                  << regressions.str() << std::endl;
+    }
+
+    std::cout << nRegressions << " regressions in " << nCompared
+              << " comparisons, tolerance " << tolerance << std::endl;
+    return nRegressions;
+}
+
+std::vector< uint32_t > _parseList( const std::string& list )
+{
+    std::vector< uint32_t > values;
+    std::istringstream is( list );
+    std::string value;
+    while( std::getline( is, value, ',' ))
+        values.push_back( std::max( std::stoi( value ), 1 ));
+    return values;
 }
 }
 
 int main( int argc, char **argv )
 {
+    std::vector< std::string > corpus;
+    std::vector< std::string > compare;
+    std::string baseline;
+    std::string json;
+    std::string chunkList = "1";
+    std::string threadList = "1";
+    size_t nLoops = 1;
+    size_t nFrames = 10;
+    float tolerance = 0.1f;
+
+    po::options_description options( "Compressor benchmark" );
+    options.add_options()
+        ( "images,i", po::value< std::vector< std::string > >( &corpus ),
+          "rgb images, directories of rgb images or frame captures" )
+        ( "chunks,c", po::value< std::string >( &chunkList ),
+          "comma-separated list of chunk counts" )
+        ( "threads,t", po::value< std::string >( &threadList ),
+          "comma-separated list of thread counts" )
+        ( "loops,l", po::value< size_t >( &nLoops ),
+          "repetitions of each measurement, the best is reported" )
+        ( "frames,f", po::value< size_t >( &nFrames ),
+          "maximum number of assemblies used from each frame capture" )
+        ( "sweep,s", "measure 1 and 8 chunks on 1 and all cores, best of 3 "
+          "loops, unless given explicitly" )
+        ( "output,o", po::value< std::string >( &json ),
+          "file name for the JSON results" )
+        ( "baseline,b", po::value< std::string >( &baseline ),
+          "JSON results to compare this run against" )
+        ( "compare", po::value< std::vector< std::string > >( &compare )
+                         ->multitoken(),
+          "compare two JSON results without running the benchmark" )
+        ( "tolerance", po::value< float >( &tolerance ),
+          "relative change reported as a regression" );
+
+    po::variables_map variables;
+    po::store( po::command_line_parser( argc, argv ).options( options )
+                   .allow_unregistered().run(), variables );
+    po::notify( variables );
+    if( variables.count( "sweep" ))
+    {
+        if( !variables.count( "chunks" ))
+            chunkList = "1,8";
+        if( !variables.count( "threads" ))
+            threadList = "1," + std::to_string(
+                std::max( std::thread::hardware_concurrency(), 1u ));
+        if( !variables.count( "loops" ))
+            nLoops = 3;
+    }
+    nLoops = std::max( nLoops, size_t( 1 ));
+
+    if( !compare.empty( ))
+    {
+        TESTINFO( compare.size() == 2, "--compare needs two result files" );
+        const size_t nRegressions = _compare( _read( compare[0] ),
+                                              _read( compare[1] ), tolerance );
+        return nRegressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     eq::NodeFactory nodeFactory;
     TEST( eq::init( argc, argv, &nodeFactory ));
 
-    eq::Strings images;
-    eq::Strings candidates = lunchbox::searchDirectory( "images", ".*\\.rgb");
-    stde::usort( candidates ); // have a predictable order
-    for( eq::StringsCIter i = candidates.begin(); i != candidates.end(); ++i )
+    Inputs inputs;
+    if( corpus.empty( ))
     {
-        const std::string& filename = *i;
-        const size_t decompPos = filename.find( "out_" );
-        if( decompPos == std::string::npos )
-            images.push_back( "images/" + filename );
+        _addDirectory( "images", inputs );
+        eq::Strings candidates = lunchbox::searchDirectory( ".",
+                                                            "Result.*\\.rgb" );
+        stde::usort( candidates ); // have a predictable order
+        for( const std::string& filename : candidates )
+            if( filename.find( "out_" ) == std::string::npos )
+                _addImageFile( filename, inputs );
     }
-
-    candidates = lunchbox::searchDirectory( ".", "Result.*\\.rgb" );
-    stde::usort( candidates ); // have a predictable order
-    for( eq::Strings::const_iterator i = candidates.begin();
-        i != candidates.end(); ++i )
+    for( const std::string& entry : corpus )
     {
-        const std::string& filename = *i;
-        const size_t decompPos = filename.find( "out_" );
-        if( decompPos == std::string::npos )
-            images.push_back( filename );
+        if( entry.size() > 4 && entry.substr( entry.size() - 4 ) == ".rgb" )
+            _addImageFile( entry, inputs );
+        else if( boost::filesystem::is_directory( entry ))
+            _addDirectory( entry, inputs );
+        else
+            _addCapture( entry, nFrames, inputs );
     }
-    TEST( !images.empty( ));
-
-    lunchbox::Clock clock;
-    eq::Image image;
-    eq::Image destImage;
+    TEST( !inputs.empty( ));
 
-    // For each compressor...
     const pression::PluginRegistry& registry = co::Global::getPluginRegistry();
     Finder finder;
     registry.accept( finder );
-    std::vector< uint32_t >& names = finder.names;
-    std::cout << images.size() << " test images X " << names.size()
-              << " plugins" << std::endl;
-    TESTINFO( names.size() > 23, names.size( ));
+    TESTINFO( finder.infos.size() > 23, finder.infos.size( ));
+
+    const std::vector< uint32_t > chunks = _parseList( chunkList );
+    const std::vector< uint32_t > threads = _parseList( threadList );
+    std::cout << inputs.size() << " images X " << finder.infos.size()
+              << " plugins X " << chunks.size() << " chunk counts X "
+              << threads.size() << " thread counts" << std::endl;
 
     std::cout.setf( std::ios::right, std::ios::adjustfield );
     std::cout.precision( 5 );
-    std::cout << "COMPRESSOR,                            IMAGE,       SIZE, A,"
-              << " COMPRESSED,     t_comp,   t_decomp" << std::endl;
+    std::cout << "COMPRESSOR,                            IMAGE, A, CHUNKS, "
+              << "THREADS,  RATIO,  COMP MB/s, DECOMP MB/s,      ERROR"
+              << std::endl;
 
-    for( std::vector< uint32_t >::const_iterator i = names.begin();
-         i != names.end(); ++i )
+    Results results;
+    for( const EqCompressorInfo& info : finder.infos )
     {
-        const uint32_t name = *i;
-
-        // For alpha, ignore alpha...
-        image.setAlphaUsage( true );
-        destImage.setAlphaUsage( true );
-        while( true )
+        for( const Input& input : inputs )
         {
-            uint64_t totalSize( 0 );
-            uint64_t totalCompressedSize( 0 );
-            float totalCompressTime( 0.f );
-            float totalDecompressTime( 0.f );
+            if( info.tokenType != input.format )
+                continue; // Compressor not suitable for current image
 
-            // For each image
-            for( eq::StringsCIter j = images.begin(); j != images.end(); ++j )
+            for( size_t i = 0; i < 2; ++i )
             {
-                const std::string& filename = *j;
-                const size_t depthPos = filename.find( "depth" );
-                const eq::Frame::Buffer buffer = (depthPos==std::string::npos) ?
-                    eq::Frame::BUFFER_COLOR : eq::Frame::BUFFER_DEPTH;
-
-                TEST( image.readImage( filename, buffer ));
-
-                if( !image.getAlphaUsage() &&
-                    ( buffer != eq::Frame::BUFFER_COLOR || !image.hasAlpha( )))
-                {
+                // For alpha, ignore alpha...
+                const bool alpha = i == 0;
+                if( !alpha && !input.hasAlpha )
                     continue; // Ignoring alpha doesn't make sense
-                }
-
-                const std::vector<uint32_t> compressors(
-                    image.findCompressors( buffer ));
 
-                if( std::find( compressors.begin(), compressors.end(), name ) ==
-                    compressors.end( ))
+                for( const uint32_t nChunks : chunks )
                 {
-                    continue; // Compressor not suitable for current image
-                }
-
-                image.allocCompressor( buffer, name );
-                destImage.setPixelViewport( image.getPixelViewport( ));
-
-                const uint32_t size = image.getPixelDataSize( buffer );
-
-#ifndef NDEBUG
-                // touch memory once
-                destImage.setPixelData( buffer,
-                                        image.compressPixelData( buffer ));
-                // force recompression
-                image.setAlphaUsage( !image.getAlphaUsage( ));
-                image.setAlphaUsage( !image.getAlphaUsage( ));
-#endif
-
-                // Compress
-                clock.reset();
-                const eq::PixelData& pixels = image.compressPixelData( buffer );
-                const float compressTime = clock.getTimef();
-
-                TEST( pixels.compressedData.compressor == name );
-                TESTINFO( name == pixels.compressedData.compressor,
-                          name << " != " << pixels.compressedData.compressor );
-
-                uint32_t compressedSize = 0;
-                if( pixels.compressedData.compressor == EQ_COMPRESSOR_NONE )
-                    compressedSize = size;
-                else
-                {
-                    compressedSize = pixels.compressedData.getSize();
-
-#ifdef WRITE_COMPRESSED
-                    std::ofstream comp( std::string( filename+".comp" ).c_str(),
-                                        std::ios::out | std::ios::binary );
-                    TEST( comp.is_open( ));
-
-                    BOOST_FOREACH( const pression::CompressorChunk& chunk,
-                                   pixels.compressedData.chunks )
+                    for( const uint32_t nThreads : threads )
                     {
-                        comp.write( reinterpret_cast<const char*>( chunk.data ),
-                                    chunk.getNumBytes( ));
+                        const Result& result = _benchmark( input, info, alpha,
+                                                           nChunks, nThreads,
+                                                           nLoops );
+                        std::cout
+                            << "0x" << std::setw(3) << std::setfill( '0' )
+                            << std::hex << info.name << std::dec
+                            << std::setfill(' ') << ", " << std::setw(32)
+                            << input.name << ", " << alpha << ", "
+                            << std::setw(6) << result.chunks << ", "
+                            << std::setw(7) << nThreads << ", "
+                            << std::setw(6) << result.getRatio() << ", "
+                            << std::setw(10) << result.getCompressThroughput()
+                            << ", " << std::setw(11)
+                            << result.getDecompressThroughput() << ", "
+                            << std::setw(10) << result.meanError << std::endl;
+                        results.push_back( result );
                     }
-                    comp.close();
-#endif
-                }
-
-                // Decompress
-                clock.reset();
-                destImage.setPixelData( buffer, pixels );
-                const float decompressTime = clock.getTimef();
-
-                std::cout  << "0x" << std::setw(3) << std::setfill( '0' )
-                           << std::hex << name << std::dec << std::setfill(' ')
-                           << ", " << std::setw(37) << filename
-                           << ", " << std::setw(10) << size << ", "
-                           << image.getAlphaUsage() << ", " << std::setw(10)
-                           << compressedSize << ", " << std::setw(10)
-                           << compressTime << ", " << std::setw(10)
-                           << decompressTime << std::endl;
-
-                totalSize += size;
-                totalCompressedSize += compressedSize;
-                totalCompressTime   += compressTime;
-                totalDecompressTime += decompressTime;
-
-#ifdef WRITE_DECOMPRESSED
-                destImage.writeImage( lunchbox::getDirname( filename ) +
-                                      "/out_" +
-                                      lunchbox::getFilename( filename ),
-                                      buffer );
-#endif
-
-#ifdef COMPARE_RESULT
-                const uint8_t* data = image.getPixelPointer( buffer );
-                const uint8_t* destData = destImage.getPixelPointer( buffer );
-                const float quality =
-                    registry.findPlugin( name )->findInfo( name ).quality;
-                uint8_t channelSize = 0;
-                switch( image.getExternalFormat( buffer ))
-                {
-                    case EQ_COMPRESSOR_DATATYPE_RGBA:
-                    case EQ_COMPRESSOR_DATATYPE_BGRA:
-                    case EQ_COMPRESSOR_DATATYPE_RGB:
-                    case EQ_COMPRESSOR_DATATYPE_BGR:
-                    case EQ_COMPRESSOR_DATATYPE_RGB10_A2 :
-                    case EQ_COMPRESSOR_DATATYPE_BGR10_A2 :
-                        channelSize = 1;
-                        break;
-                    case EQ_COMPRESSOR_DATATYPE_BGRA32F:
-                    case EQ_COMPRESSOR_DATATYPE_BGR32F:
-                    case EQ_COMPRESSOR_DATATYPE_RGBA32F:
-                    case EQ_COMPRESSOR_DATATYPE_RGB32F:
-                    case EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT:
-                        channelSize = 4;
-                        break;
-                    case EQ_COMPRESSOR_DATATYPE_RGB16F:
-                    case EQ_COMPRESSOR_DATATYPE_RGBA16F:
-                    case EQ_COMPRESSOR_DATATYPE_BGR16F:
-                    case EQ_COMPRESSOR_DATATYPE_BGRA16F:
-                        channelSize = 2;
-                        break;
-                    default:
-                        LBERROR << "Unknown image pixel data type" << std::endl;
-                        channelSize = 0;
-                }
-                if( channelSize == 0 )
-                    continue;
-
-                const int64_t nElem = size / channelSize;
-
-                switch( channelSize )
-                {
-                    case 1:
-                        _compare< uint8_t >( data, destData, buffer,
-                                             image.getAlphaUsage(), nElem,
-                                             quality );
-                        break;
-                    case 2:
-                        if( quality == 1.f )
-                            _compare< uint16_t >( data, destData, buffer,
-                                              image.getAlphaUsage(), nElem,
-                                              quality );
-                        break;
-                    case 4:
-                        _compare< float >( data, destData, buffer,
-                                           image.getAlphaUsage(), nElem,
-                                           quality );
-                        break;
-                    default:
-                        break;
                 }
-#endif
             }
-
-            if( totalSize > 0 )
-                std::cout
-                    << "0x" << std::setw(3) << std::setfill( '0' ) << std::hex
-                    << name << std::dec << std::setfill(' ')
-                    << ",                                 Total, "
-                    << std::setw(10) << totalSize << ", "
-                    << image.getAlphaUsage() << ", " << std::setw(10)
-                    << totalCompressedSize << ", " << std::setw(10)
-                    << totalCompressTime << ", " << std::setw(10)
-                    << totalDecompressTime << std::endl << std::endl;
-
-            image.setAlphaUsage( !image.getAlphaUsage( ));
-            destImage.setAlphaUsage( image.getAlphaUsage( ));
-            if( image.getAlphaUsage( ))
-                break;
         }
     }
 
-    image.flush();
-    destImage.flush();
-    eq::exit();
+    if( !json.empty( ))
+    {
+        TESTINFO( _write( json, results ), json );
+        std::cout << "Wrote " << results.size() << " results to " << json
+                  << std::endl;
+    }
 
-    return EXIT_SUCCESS;
+    size_t nRegressions = 0;
+    if( !baseline.empty( ))
+        nRegressions = _compare( _read( baseline ), results, tolerance );
+
+    eq::exit();
+    return nRegressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,148 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/server/channel.h>
+#include <eq/server/config.h>
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/observer.h>
+#include <eq/server/server.h>
+
+#include <co/connectionDescription.h>
+#include <lunchbox/clock.h>
+
+#include <sstream>
+
+// Measures the per-frame cost of the config commit done by startFrame on a
+// generated 300-channel config, with and without changes in the hierarchy.
+
+namespace
+{
+const size_t nPipes = 10;
+const size_t nWindows = 5; // per pipe
+const size_t nChannels = 6; // per window
+const size_t nSegments = nPipes * nWindows * nChannels;
+const size_t nFrames = 1000;
+
+std::string _generateConfig()
+{
+    std::ostringstream os;
+    os << "server { config { appNode {";
+    for( size_t i = 0; i < nPipes; ++i )
+    {
+        os << " pipe {";
+        for( size_t j = 0; j < nWindows; ++j )
+        {
+            os << " window {";
+            for( size_t k = 0; k < nChannels; ++k )
+                os << " channel { name \"channel"
+                   << ( i * nWindows + j ) * nChannels + k << "\" }";
+            os << " }";
+        }
+        os << " }";
+    }
+    os << " } observer {} layout { view { observer 0 }}"
+       << " canvas { layout 0 wall {}";
+
+    const size_t columns = 20;
+    const size_t rows = nSegments / columns;
+    for( size_t i = 0; i < nSegments; ++i )
+        os << " segment { channel \"channel" << i << "\" viewport [ "
+           << float( i % columns ) / float( columns ) << " "
+           << float( i / columns ) / float( rows ) << " "
+           << 1.f / float( columns ) << " " << 1.f / float( rows ) << " ] }";
+    os << " }}}";
+    return os.str();
+}
+
+template< class F >
+void _measure( const std::string& name, eq::server::Config* config,
+               const F& change )
+{
+    config->commit();
+    TEST( !config->isDirty( ));
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < nFrames; ++i )
+    {
+        change( i );
+        config->commit();
+    }
+    const float time = clock.getTimef();
+
+    TEST( !config->isDirty( ));
+    std::cout << nSegments << " channels, " << name << ": "
+              << time * 1000.f / float( nFrames ) << " us/frame" << std::endl;
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    eq::server::Loader loader;
+    eq::server::ServerPtr server =
+        loader.parseServer( _generateConfig().c_str( ));
+    TEST( server.isValid( ));
+    TEST( server->getConfigs().size() == 1 );
+
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "localhost" );
+    server->addConnectionDescription( desc );
+    TEST( server->listen( ));
+    server->init(); // registers all config objects
+
+    eq::server::Config* config = server->getConfigs().front();
+    eq::server::Observer* observer = config->getObservers().front();
+    std::ostringstream name;
+    name << "channel" << nSegments / 2;
+    eq::server::Channel* channel =
+        config->find< eq::server::Channel >( name.str( ));
+    TEST( observer );
+    TEST( channel );
+
+    _measure( "unchanged", config, []( const size_t ) {} );
+    _measure( "head tracking", config, [observer]( const size_t i )
+    {
+        eq::Matrix4f head;
+        head.array[12] = float( i ) / float( nFrames );
+        observer->setHeadMatrix( head );
+    });
+    _measure( "one channel", config, [channel]( const size_t i )
+    {
+        channel->setName( i % 2 ? "odd" : "even" );
+    });
+
+    // the changes reached the leaves through the dirty parents
+    TEST( !observer->isDirty( ));
+    TEST( !channel->isDirty( ));
+
+    server->exit();
+    TEST( server->close( ));
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    server = 0;
+
+    eq::exit();
+    return EXIT_SUCCESS;
+}
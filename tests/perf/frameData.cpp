@@ -0,0 +1,161 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <eq/frameData.h>
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/server/frameData.h>
+
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/localNode.h>
+#include <lunchbox/clock.h>
+
+// Measures the per-frame cost of committing and syncing the recycled output
+// frame datas of a 64-source DB compound, against the full instance data
+// distribution used before the delta encoding. Both nodes are in-process and
+// connected through a pipe.
+
+namespace
+{
+const size_t nSources = 64;
+const uint32_t latency = 1;
+const size_t nDatas = nSources * ( latency + 1 ); // steady-state ring
+const uint32_t nFrames = 1000;
+
+/** Baseline: sends all parameters on each commit. */
+class InstanceMaster : public eq::server::FrameData
+{
+protected:
+    ChangeType getChangeType() const override { return INSTANCE; }
+};
+
+class InstanceSlave : public eq::FrameData
+{
+protected:
+    ChangeType getChangeType() const override { return INSTANCE; }
+    void unpack( co::DataIStream& is ) override { applyInstanceData( is ); }
+};
+
+class Node : public co::LocalNode
+{
+public:
+    /** Connect to a process-local node through a pipe connection. */
+    bool connectLocal( co::LocalNodePtr server, co::NodePtr serverProxy )
+    {
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->type = co::CONNECTIONTYPE_PIPE;
+        co::ConnectionPtr connection = co::Connection::create( desc );
+        if( !connection->connect( ))
+            return false;
+
+        server->addConnection( connection->acceptSync( ));
+        return connect( serverProxy, connection );
+    }
+};
+
+template< class M, class S >
+float _measure( co::LocalNodePtr server, co::LocalNodePtr client )
+{
+    std::vector< M* > masters( nDatas );
+    std::vector< S* > slaves( nDatas );
+    const eq::PixelViewport pvp( 0, 0, 1920, 1200 );
+
+    for( size_t i = 0; i < nDatas; ++i )
+    {
+        masters[i] = new M;
+        masters[i]->setPixelViewport( pvp );
+        masters[i]->setBuffers( eq::Frame::BUFFER_COLOR |
+                                eq::Frame::BUFFER_DEPTH );
+        TEST( server->registerObject( masters[i] ));
+        masters[i]->setAutoObsolete( 1 );
+
+        slaves[i] = new S;
+        TEST( client->mapObject( slaves[i], co::ObjectVersion( masters[i] )));
+    }
+
+    eq::fabric::RenderContext context;
+    lunchbox::Clock clock;
+    for( uint32_t frame = 1; frame <= nFrames; ++frame )
+    {
+        const size_t base = ( frame % ( latency + 1 )) * nSources;
+        context.frameID = eq::uint128_t( frame );
+
+        for( size_t i = 0; i < nSources; ++i )
+        {
+            M* data = masters[ base + i ];
+            context.range = eq::Range( float( i ) / float( nSources ),
+                                       float( i + 1 ) / float( nSources ));
+            data->setFrameNumber( frame );
+            data->setContext( context );
+            data->commit();
+        }
+
+        for( size_t i = 0; i < nSources; ++i )
+        {
+            S* data = slaves[ base + i ];
+            data->sync( masters[ base + i ]->getVersion( ));
+            TEST( data->getContext().frameID == eq::uint128_t( frame ));
+            TEST( data->getPixelViewport() == pvp );
+        }
+    }
+    const float time = clock.getTimef();
+
+    for( size_t i = 0; i < nDatas; ++i )
+    {
+        client->unmapObject( slaves[i] );
+        server->deregisterObject( masters[i] );
+        delete slaves[i];
+        delete masters[i];
+    }
+    return time * 1000.f / float( nFrames );
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    co::LocalNodePtr server = new co::LocalNode;
+    lunchbox::RefPtr< Node > client = new Node;
+    TEST( server->listen( ));
+    TEST( client->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    TEST( client->connectLocal( server, serverProxy ));
+
+    const float instance = _measure< InstanceMaster, InstanceSlave >( server,
+                                                                      client );
+    const float delta = _measure< eq::server::FrameData, eq::FrameData >(
+        server, client );
+
+    std::cout << nSources << " sources, latency " << latency << ": "
+              << instance << " us/frame instance, " << delta
+              << " us/frame delta" << std::endl;
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+    serverProxy = 0;
+    client = 0;
+    server = 0;
+
+    eq::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/thread.h>
+
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <vector>
+
+// Measures the memory bandwidth of copying a 4K RGBA image, as done when
+// compressing or transmitting it, from a thread on the socket holding the
+// pixel memory and from a thread on another socket. The pixels are written by
+// a thread bound to socket 0, like the readback of a pipe thread. Skipped on
+// machines with one NUMA node.
+
+namespace
+{
+const size_t imageSize = 3840 * 2160 * 4; // bytes
+const size_t nLoops = 20;
+
+/** @return the number of NUMA nodes, or 0 if unknown. */
+size_t _getNumNodes()
+{
+    namespace fs = boost::filesystem;
+    const fs::path path( "/sys/devices/system/node" );
+    boost::system::error_code error;
+    if( !fs::is_directory( path, error ))
+        return 0;
+
+    size_t nNodes = 0;
+    for( fs::directory_iterator i( path, error ); !error &&
+             i != fs::directory_iterator(); i.increment( error ))
+    {
+        const std::string name = i->path().filename().string();
+        if( name.size() > 4 && name.compare( 0, 4, "node" ) == 0 &&
+            ::isdigit( name[4] ))
+        {
+            ++nNodes;
+        }
+    }
+    return nNodes;
+}
+
+class Allocator : public lunchbox::Thread
+{
+public:
+    explicit Allocator( std::vector< uint8_t >& pixels ) : _pixels( pixels ) {}
+
+protected:
+    void run() override
+    {
+        lunchbox::Thread::setAffinity( lunchbox::Thread::SOCKET );
+
+        // first touch places the pages on the socket of this thread
+        _pixels.resize( imageSize );
+        for( size_t i = 0; i < imageSize; ++i )
+            _pixels[i] = uint8_t( i / 64 );
+    }
+
+private:
+    std::vector< uint8_t >& _pixels;
+};
+
+class Reader : public lunchbox::Thread
+{
+public:
+    Reader( const std::vector< uint8_t >& pixels, const int32_t socket )
+        : time( 0.f )
+        , _pixels( pixels )
+        , _socket( socket )
+    {}
+
+    float time; // ms per image
+
+protected:
+    void run() override
+    {
+        lunchbox::Thread::setAffinity( lunchbox::Thread::SOCKET + _socket );
+
+        std::vector< uint8_t > copy( imageSize );
+        ::memcpy( copy.data(), _pixels.data(), imageSize ); // first touch
+
+        lunchbox::Clock clock;
+        for( size_t i = 0; i < nLoops; ++i )
+            ::memcpy( copy.data(), _pixels.data(), imageSize );
+        time = clock.getTimef() / float( nLoops );
+        TEST( copy == _pixels );
+    }
+
+private:
+    const std::vector< uint8_t >& _pixels;
+    const int32_t _socket;
+};
+
+float _read( const std::vector< uint8_t >& pixels, const int32_t socket )
+{
+    Reader reader( pixels, socket );
+    TEST( reader.start( ));
+    TEST( reader.join( ));
+    return reader.time;
+}
+
+void _report( const std::string& name, const float time )
+{
+    std::cout << "Copy 4K RGBA on " << name << " socket: " << time << " ms, "
+              << float( imageSize ) / time / 1e6f << " GB/s" << std::endl;
+}
+}
+
+int main( int, char** )
+{
+    const size_t nNodes = _getNumNodes();
+    if( nNodes < 2 )
+    {
+        std::cout << "Skipping NUMA test, " << nNodes << " NUMA node(s)"
+                  << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    std::vector< uint8_t > pixels;
+    Allocator allocator( pixels );
+    TEST( allocator.start( ));
+    TEST( allocator.join( ));
+
+    _read( pixels, 0 ); // warm up
+    _report( "local ", _read( pixels, 0 ));
+    _report( "remote", _read( pixels, 1 ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <eq/util/pixelConversion.h>
+#include <lunchbox/clock.h>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+// Measures the throughput of the pixel conversions on a 720p image, with and
+// without the SIMD code paths. Pass --4k to measure a 4K image, which needs
+// about 500 MB of memory.
+
+namespace pixel = eq::util::pixel;
+
+namespace
+{
+const size_t nLoops = 10;
+
+template< class Func >
+void _measure( const std::string& name, const size_t nBytes, Func func )
+{
+    float time[ 2 ];
+    for( size_t i = 0; i < 2; ++i )
+    {
+        pixel::setSIMDEnabled( i == 0 );
+        func(); // warm up
+        lunchbox::Clock clock;
+        for( size_t j = 0; j < nLoops; ++j )
+            func();
+        time[i] = clock.getTimef();
+    }
+    pixel::setSIMDEnabled( true );
+
+    const float megabytes = float( nBytes * nLoops ) / 1024.f / 1024.f;
+    std::cout << std::setw( 20 ) << name << ", "
+              << std::setw( 10 ) << megabytes / time[0] * 1000.f << ", "
+              << std::setw( 10 ) << megabytes / time[1] * 1000.f << std::endl;
+}
+}
+
+int main( int argc, char** argv )
+{
+    bool use4K = false;
+    for( int i = 1; i < argc; ++i )
+        if( std::string( argv[i] ) == "--4k" )
+            use4K = true;
+
+    const size_t nPixels = use4K ? 3840 * 2160 : 1280 * 720;
+    const size_t nValues = nPixels * 4; // RGBA
+
+    std::vector< uint16_t > halfs( nValues );
+    std::vector< float > floats( nValues );
+    std::vector< uint8_t > bytes( nValues );
+    std::vector< uint8_t > planes( nValues * 4 );
+    for( size_t i = 0; i < nValues; ++i )
+    {
+        floats[i] = float( i % 1000 ) / 999.f;
+        bytes[i] = uint8_t( i * 7 );
+    }
+    pixel::floatToHalf( floats.data(), halfs.data(), nValues );
+
+    std::vector< uint8_t > out( nValues * 4 );
+    float* outFloats = reinterpret_cast< float* >( out.data( ));
+    uint16_t* outHalfs = reinterpret_cast< uint16_t* >( out.data( ));
+
+    std::cout << "Using " << pixel::getSIMDInstructions() << ", "
+              << nPixels << " pixels" << std::endl
+              << std::setw( 20 ) << "Conversion, " << std::setw( 10 )
+              << "SIMD MB/s, " << std::setw( 10 ) << "Scalar MB/s" << std::endl;
+
+    _measure( "halfToFloat", nValues * 2, [&] {
+        pixel::halfToFloat( halfs.data(), outFloats, nValues ); });
+    _measure( "floatToHalf", nValues * 4, [&] {
+        pixel::floatToHalf( floats.data(), outHalfs, nValues ); });
+    _measure( "floatToUnorm8", nValues * 4, [&] {
+        pixel::floatToUnorm8( floats.data(), out.data(), nValues ); });
+    _measure( "halfToUnorm8", nValues * 2, [&] {
+        pixel::halfToUnorm8( halfs.data(), out.data(), nValues ); });
+
+    const size_t sizes[] = { 1, 2, 4 };
+    for( size_t s = 0; s < 3; ++s )
+    {
+        for( size_t nChannels = 3; nChannels <= 4; ++nChannels )
+        {
+            const size_t size = sizes[s];
+            void* pointers[ 4 ];
+            for( size_t i = 0; i < nChannels; ++i )
+                pointers[i] = &planes[ i * nPixels * size ];
+            const void* input = size == 1 ? (const void*)bytes.data() :
+                                size == 2 ? (const void*)halfs.data() :
+                                            (const void*)floats.data();
+
+            std::ostringstream name;
+            name << size << "x" << nChannels;
+            _measure( "deinterleave " + name.str(), nPixels * nChannels * size,
+                      [&] { pixel::deinterleave( input, nPixels, nChannels,
+                                                 size, pointers ); });
+            _measure( "interleave " + name.str(), nPixels * nChannels * size,
+                      [&] { pixel::interleave( pointers, nPixels, nChannels,
+                                               size, out.data( )); });
+        }
+    }
+
+    _measure( "unpremultiply", nPixels, [&] {
+        pixel::unpremultiply( out.data(), bytes.data(), nPixels ); });
+    return EXIT_SUCCESS;
+}
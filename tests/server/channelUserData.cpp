@@ -0,0 +1,168 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Changes the user data of a channel in a config without other changes. The
+// config commit has to reach the channel through its clean parents, commit the
+// user data and redistribute the new channel version.
+
+#include <lunchbox/test.h>
+
+#include <eq/init.h>
+#include <eq/nodeFactory.h>
+#include <eq/server/channel.h>
+#include <eq/server/config.h>
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/node.h>
+#include <eq/server/pipe.h>
+#include <eq/server/server.h>
+#include <eq/server/window.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/serializable.h>
+
+namespace
+{
+class UserData : public co::Serializable
+{
+public:
+    UserData() : _value( 0 ) {}
+
+    void setValue( const uint32_t value )
+        { _value = value; setDirty( DIRTY_VALUE ); }
+
+protected:
+    void serialize( co::DataOStream& os, const uint64_t dirtyBits ) override
+    {
+        co::Serializable::serialize( os, dirtyBits );
+        if( dirtyBits & DIRTY_VALUE )
+            os << _value;
+    }
+
+    void deserialize( co::DataIStream& is, const uint64_t dirtyBits ) override
+    {
+        co::Serializable::deserialize( is, dirtyBits );
+        if( dirtyBits & DIRTY_VALUE )
+            is >> _value;
+    }
+
+private:
+    enum DirtyBits
+    {
+        DIRTY_VALUE = co::Serializable::DIRTY_CUSTOM << 0
+    };
+
+    uint32_t _value;
+};
+
+/** A channel holding the master instance of its user data. */
+class Channel : public eq::server::Channel
+{
+public:
+    explicit Channel( eq::server::Window* parent )
+        : eq::server::Channel( parent ) {}
+
+protected:
+    bool hasMasterUserData() override { return true; }
+};
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer(
+        "server { config { appNode { pipe { window { channel {}}}"
+        " pipe { window { channel {}}}} observer {}}}" );
+    TEST( server.isValid( ));
+    TEST( server->getConfigs().size() == 1 );
+
+    eq::server::Config* config = server->getConfigs().front();
+    const eq::server::Pipes& pipes = config->getNodes().front()->getPipes();
+    TEST( pipes.size() == 2 );
+    eq::server::Window* window = pipes.front()->getWindows().front();
+    Channel* channel = new Channel( window );
+    UserData userData;
+    channel->setUserData( &userData );
+
+    // unchanged user data in another subtree is not committed
+    eq::server::Window* cleanWindow = pipes.back()->getWindows().front();
+    Channel* cleanChannel = new Channel( cleanWindow );
+    UserData cleanData;
+    cleanChannel->setUserData( &cleanData );
+
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "localhost" );
+    server->addConnectionDescription( desc );
+    TEST( server->listen( ));
+    server->init(); // registers all config objects
+
+    config->commit();
+    TEST( userData.isAttached( ));
+    TEST( userData.isMaster( ));
+    TEST( !config->isDirty( ));
+    TEST( !window->isDirty( ));
+    TEST( !channel->isDirty( ));
+    TEST( cleanData.isAttached( ));
+
+    const eq::uint128_t cleanVersion = cleanChannel->getVersion();
+    const eq::uint128_t cleanWindowVersion = cleanWindow->getVersion();
+    for( uint32_t i = 1; i < 10; ++i )
+    {
+        const eq::uint128_t version = userData.getVersion();
+        const eq::uint128_t channelVersion = channel->getVersion();
+        const eq::uint128_t windowVersion = window->getVersion();
+
+        userData.setValue( i );
+        TEST( channel->isDirty( ));
+        config->commit();
+
+        TEST( !userData.isDirty( ));
+        TESTINFO( userData.getVersion() > version,
+                  userData.getVersion() << " <= " << version );
+        // the new user data version reaches the slaves through the parents
+        TEST( channel->getVersion() > channelVersion );
+        TEST( window->getVersion() > windowVersion );
+        TEST( !channel->isDirty( ));
+        TEST( !window->isDirty( ));
+
+        TEST( cleanChannel->getVersion() == cleanVersion );
+        TEST( cleanWindow->getVersion() == cleanWindowVersion );
+    }
+
+    // a commit without changes leaves the hierarchy untouched
+    const eq::uint128_t channelVersion = channel->getVersion();
+    config->commit();
+    TEST( channel->getVersion() == channelVersion );
+
+    channel->setUserData( 0 );
+    cleanChannel->setUserData( 0 );
+    TEST( !userData.isAttached( ));
+
+    server->exit();
+    TEST( server->close( ));
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    server = 0;
+
+    eq::exit();
+    return EXIT_SUCCESS;
+}
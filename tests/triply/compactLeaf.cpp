@@ -0,0 +1,181 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <triply/typedefs.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+// Checks the octahedral normal encoding and the position quantization of
+// compact leaves, which define the layout of the compact cache files.
+
+namespace
+{
+const double maxAngle = .005;   // degrees, ~.0036 for 2 x 16 bit
+const size_t nDirections = 200000;
+const size_t nPositions = 100000;
+
+/** @return the angle between two normals in degrees. */
+double _getAngle( const triply::Normal& a, const triply::Normal& b )
+{
+    const double cx = double( a[1] ) * b[2] - double( a[2] ) * b[1];
+    const double cy = double( a[2] ) * b[0] - double( a[0] ) * b[2];
+    const double cz = double( a[0] ) * b[1] - double( a[1] ) * b[0];
+    const double dot = double( a[0] ) * b[0] + double( a[1] ) * b[1] +
+                       double( a[2] ) * b[2];
+    return std::atan2( std::sqrt( cx * cx + cy * cy + cz * cz ), dot ) *
+           180. / M_PI;
+}
+
+double _testNormal( const triply::Normal& normal )
+{
+    const triply::Normal decoded =
+        triply::decodeNormal( triply::encodeNormal( normal ));
+    TESTINFO( std::abs( decoded.length() - 1.f ) < 1e-5f, decoded );
+
+    triply::Normal unit = normal;
+    unit.normalize();
+    const double angle = _getAngle( unit, decoded );
+    TESTINFO( angle <= maxAngle, normal << " decoded as " << decoded << ": "
+              << angle << " degrees" );
+    return angle;
+}
+
+void _testNormals()
+{
+    // evenly distributed directions on a Fibonacci sphere
+    double worst = 0.;
+    const float goldenAngle = float( M_PI * ( 3. - std::sqrt( 5. )));
+    for( size_t i = 0; i < nDirections; ++i )
+    {
+        const float z = 1.f - 2.f * ( float( i ) + .5f ) / float( nDirections );
+        const float r = std::sqrt( 1.f - z * z );
+        const float phi = goldenAngle * float( i );
+        worst = std::max( worst, _testNormal(
+                              triply::Normal( r * std::cos( phi ),
+                                              r * std::sin( phi ), z )));
+    }
+
+    // axes, diagonals and the fold of the lower hemisphere at z = 0
+    for( int x = -1; x <= 1; ++x )
+        for( int y = -1; y <= 1; ++y )
+            for( int z = -1; z <= 1; ++z )
+                if( x != 0 || y != 0 || z != 0 )
+                    worst = std::max( worst, _testNormal( triply::Normal(
+                                          float( x ), float( y ), float( z ))));
+    const float foldZ[] = { -1e-6f, 0.f, 1e-6f };
+    for( int i = 0; i < 360; ++i )
+    {
+        const float phi = float( i ) * float( M_PI ) / 180.f;
+        for( size_t j = 0; j < 3; ++j )
+            worst = std::max( worst, _testNormal(
+                                  triply::Normal( std::cos( phi ),
+                                                  std::sin( phi ), foldZ[j] )));
+    }
+    std::cout << "Max normal error " << worst << " degrees" << std::endl;
+
+    // the length of the normal does not matter
+    const triply::Normal normal( .3f, -.4f, -.5f );
+    TEST( triply::encodeNormal( normal ) ==
+          triply::encodeNormal( normal * 1000.f ));
+    TEST( triply::encodeNormal( normal ) ==
+          triply::encodeNormal( normal * 1e-20f ));
+
+    // degenerate normals decode to a unit normal
+    const triply::PackedNormal zero =
+        triply::encodeNormal( triply::Normal( 0.f ));
+    TEST( zero == triply::PackedNormal( 0, 0 ));
+    TEST( triply::decodeNormal( zero ) == triply::Normal( 0.f, 0.f, 1.f ));
+    TEST( triply::decodeNormal( triply::encodeNormal(
+              triply::Normal( 0.f, 0.f, -1e-30f ))) ==
+          triply::Normal( 0.f, 0.f, -1.f ));
+}
+
+/** Quantize random positions in a leaf with the given bounds. */
+void _testPositions( const triply::Vertex& min, const triply::Vertex& max,
+                     std::mt19937& rng )
+{
+    // center and scale as computed by the compact leaves
+    const triply::Vertex center = ( min + max ) * .5f;
+    const triply::Vertex halfExtent = ( max - min ) * .5f;
+    const float extent = std::max( halfExtent.x(),
+                                   std::max( halfExtent.y(), halfExtent.z( )));
+    const float scale = extent > 0.f ? extent / 32767.f : 1.f;
+
+    // half a quantization step, plus the float precision of the positions
+    float maxValue = 0.f;
+    for( size_t i = 0; i < 3; ++i )
+        maxValue = std::max( maxValue, std::max( std::abs( min[i] ),
+                                                 std::abs( max[i] )));
+    const double maxError = .5 * scale + 4. *
+        std::numeric_limits< float >::epsilon() * maxValue;
+
+    double worst = 0.;
+    for( size_t i = 0; i < nPositions; ++i )
+    {
+        triply::Vertex vertex;
+        for( size_t j = 0; j < 3; ++j )
+        {
+            if( i < 8 ) // corners first
+                vertex[j] = ( i >> j ) & 1 ? max[j] : min[j];
+            else
+            {
+                std::uniform_real_distribution< float > random( min[j],
+                                                                max[j] );
+                vertex[j] = random( rng );
+            }
+        }
+
+        const triply::Vertex decoded = triply::unpackVertex(
+            triply::packVertex( vertex, center, scale ), center, scale );
+        for( size_t j = 0; j < 3; ++j )
+        {
+            const double error = std::abs( double( decoded[j] ) - vertex[j] );
+            worst = std::max( worst, error );
+            TESTINFO( error <= maxError, vertex << " decoded as " << decoded
+                      << ", error " << error << " > " << maxError );
+        }
+    }
+    std::cout << "Max position error " << worst << " for a leaf of "
+              << max - min << std::endl;
+}
+}
+
+int main( int, char** )
+{
+    // the compact cache file layout depends on these sizes
+    TEST( sizeof( triply::PackedNormal ) == 4 );
+    TEST( sizeof( triply::PackedVertex ) == 6 );
+
+    _testNormals();
+
+    std::mt19937 rng( 42 );
+    _testPositions( triply::Vertex( -1.f ), triply::Vertex( 1.f ), rng );
+    _testPositions( triply::Vertex( 0.f ), triply::Vertex( 120.f, 119.f, 1.f ),
+                    rng );
+    _testPositions( triply::Vertex( 1000.f, -2000.f, 5.f ),
+                    triply::Vertex( 1000.5f, -1999.75f, 5.f ), rng );
+    _testPositions( triply::Vertex( -1e-3f, 0.f, 0.f ),
+                    triply::Vertex( 1e-3f, 2e-3f, 0.f ), rng );
+
+    // a leaf with a single position
+    const triply::Vertex point( 3.f, 4.f, 5.f );
+    _testPositions( point, point, rng );
+    return EXIT_SUCCESS;
+}
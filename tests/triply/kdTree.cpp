@@ -0,0 +1,137 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <triply/vertexBufferLeaf.h>
+#include <triply/vertexBufferRoot.h>
+#include <triply/vertexData.h>
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+// Builds the kd-tree of a small model with the parallel median split and with
+// the full sort used before, and checks that both trees have the same nodes
+// and leaves. The flat grid has many triangles with equal medians, which are
+// ordered by the tie-break of the triangle sort.
+
+namespace
+{
+const size_t gridSize = 120; // vertices per side
+
+typedef std::array< float, 9 > TriangleKey;
+typedef std::vector< TriangleKey > TriangleKeys;
+
+void _createGrid( triply::VertexData& data )
+{
+    for( size_t y = 0; y < gridSize; ++y )
+        for( size_t x = 0; x < gridSize; ++x )
+            data.vertices.push_back( triply::Vertex( float( x ), float( y ),
+                                                     float(( x / 8 ) % 2 )));
+
+    for( size_t y = 0; y + 1 < gridSize; ++y )
+    {
+        for( size_t x = 0; x + 1 < gridSize; ++x )
+        {
+            const size_t i = y * gridSize + x;
+            data.triangles.push_back( triply::Triangle( i, i + 1,
+                                                        i + gridSize ));
+            data.triangles.push_back( triply::Triangle( i + 1,
+                                                        i + gridSize + 1,
+                                                        i + gridSize ));
+        }
+    }
+    data.calculateNormals();
+    data.scale( 2.0f );
+}
+
+void _setupTree( triply::VertexBufferRoot& root, const bool fullSort )
+{
+    triply::VertexData data;
+    _createGrid( data );
+    if( fullSort )
+        data.useFullSort();
+
+    std::ostringstream progressSink;
+    boost::progress_display progress( data.triangles.size(), progressSink );
+    root.setupTree( data, progress );
+}
+
+/** @return the triangles of a leaf as vertex positions, in a fixed order. */
+TriangleKeys _getTriangles( const triply::VertexBufferData& data,
+                            const triply::VertexBufferLeaf& leaf )
+{
+    TriangleKeys triangles;
+    for( triply::Index i = 0; i < leaf.getIndexLength(); i += 3 )
+    {
+        std::array< std::array< float, 3 >, 3 > corners;
+        for( size_t j = 0; j < 3; ++j )
+        {
+            const triply::Vertex& vertex = data.vertices[
+                leaf.getVertexStart() +
+                data.indices[ leaf.getIndexStart() + i + j ]];
+            corners[j] = {{ vertex[0], vertex[1], vertex[2] }};
+        }
+        std::sort( corners.begin(), corners.end( ));
+
+        TriangleKey key;
+        for( size_t j = 0; j < 9; ++j )
+            key[j] = corners[ j / 3 ][ j % 3 ];
+        triangles.push_back( key );
+    }
+    std::sort( triangles.begin(), triangles.end( ));
+    return triangles;
+}
+
+size_t _compare( const triply::VertexBufferData& data1,
+                 const triply::VertexBufferBase& node1,
+                 const triply::VertexBufferData& data2,
+                 const triply::VertexBufferBase& node2 )
+{
+    TEST( node1.getRange()[0] == node2.getRange()[0] );
+    TEST( node1.getRange()[1] == node2.getRange()[1] );
+    TEST( node1.getNumberOfVertices() == node2.getNumberOfVertices( ));
+
+    const triply::VertexBufferBase* left = node1.getLeft();
+    TEST( !left == !node2.getLeft( ));
+    if( !left )
+    {
+        const TriangleKeys& triangles1 = _getTriangles( data1,
+            static_cast< const triply::VertexBufferLeaf& >( node1 ));
+        const TriangleKeys& triangles2 = _getTriangles( data2,
+            static_cast< const triply::VertexBufferLeaf& >( node2 ));
+        TEST( triangles1 == triangles2 );
+        return 1;
+    }
+
+    return _compare( data1, *left, data2, *node2.getLeft( )) +
+           _compare( data1, *node1.getRight(), data2, *node2.getRight( ));
+}
+}
+
+int main( int, char** )
+{
+    triply::VertexBufferRoot parallel;
+    triply::VertexBufferRoot serial;
+    _setupTree( parallel, false );
+    _setupTree( serial, true );
+
+    const size_t nLeaves = _compare( parallel.getData(), parallel,
+                                     serial.getData(), serial );
+    TESTINFO( nLeaves > 1, nLeaves );
+    return EXIT_SUCCESS;
+}
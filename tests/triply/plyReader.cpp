@@ -0,0 +1,167 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <triply/vertexData.h>
+
+#include <cstdio>
+#include <fstream>
+
+// Writes a small model as ASCII, binary little endian and binary big endian
+// PLY file, and checks that the parallel reader and the generic ply.c reader
+// return the same data. Faces with an invalid vertex index are rejected by
+// both readers.
+
+namespace
+{
+const std::string filename = "triply_plyReader.ply";
+
+const size_t nVertices = 4;
+const float positions[ nVertices ][3] = {
+    { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 1.f, 1.f, 0.f },
+    { -.5f, 1.25f, 2.f }};
+const uint8_t colors[ nVertices ][3] = {
+    { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 10, 20, 30 }};
+
+const size_t nFaces = 2;
+const int faces[ nFaces ][3] = {{ 0, 1, 2 }, { 0, 2, 3 }};
+const int badFaces[ nFaces ][3] = {{ 0, 1, 2 }, { 0, 2, 7 }};
+
+enum Format
+{
+    FORMAT_ASCII,
+    FORMAT_BINARY_LE,
+    FORMAT_BINARY_BE
+};
+
+const char* const formatNames[] = { "ascii", "binary_little_endian",
+                                    "binary_big_endian" };
+
+void _putBytes( std::ostream& os, const void* value, const size_t size,
+                const bool bigEndian )
+{
+    uint16_t one = 1;
+    const bool swap = ( *reinterpret_cast< uint8_t* >( &one ) == 1 ) ==
+                      bigEndian;
+    const char* bytes = static_cast< const char* >( value );
+    for( size_t i = 0; i < size; ++i )
+        os.put( bytes[ swap ? size - 1 - i : i ] );
+}
+
+void _write( const Format format, const int indices[ nFaces ][3] )
+{
+    std::ofstream os( filename.c_str(), std::ios::binary );
+    os << "ply\n"
+       << "format " << formatNames[ format ] << " 1.0\n"
+       << "comment triply test model\n"
+       << "element vertex " << nVertices << "\n"
+       << "property float x\n"
+       << "property float y\n"
+       << "property float z\n"
+       << "property uchar red\n"
+       << "property uchar green\n"
+       << "property uchar blue\n"
+       << "element face " << nFaces << "\n"
+       << "property list uchar int vertex_indices\n"
+       << "end_header\n";
+
+    if( format == FORMAT_ASCII )
+    {
+        for( size_t i = 0; i < nVertices; ++i )
+            os << positions[i][0] << " " << positions[i][1] << " "
+               << positions[i][2] << " " << int( colors[i][0] ) << " "
+               << int( colors[i][1] ) << " " << int( colors[i][2] ) << "\n";
+        for( size_t i = 0; i < nFaces; ++i )
+            os << "3 " << indices[i][0] << " " << indices[i][1] << " "
+               << indices[i][2] << "\n";
+        return;
+    }
+
+    const bool bigEndian = format == FORMAT_BINARY_BE;
+    for( size_t i = 0; i < nVertices; ++i )
+    {
+        for( size_t j = 0; j < 3; ++j )
+            _putBytes( os, &positions[i][j], sizeof( float ), bigEndian );
+        for( size_t j = 0; j < 3; ++j )
+            os.put( char( colors[i][j] ));
+    }
+    for( size_t i = 0; i < nFaces; ++i )
+    {
+        os.put( 3 );
+        for( size_t j = 0; j < 3; ++j )
+            _putBytes( os, &indices[i][j], sizeof( int ), bigEndian );
+    }
+}
+
+bool _read( triply::VertexData& data, const bool generic )
+{
+    if( generic )
+        data.useGenericReader();
+    return data.readPlyFile( filename );
+}
+
+void _testFormat( const Format format )
+{
+    const char* const name = formatNames[ format ];
+    _write( format, faces );
+
+    triply::VertexData parallel;
+    triply::VertexData generic;
+    TESTINFO( _read( parallel, false ), name );
+    TESTINFO( _read( generic, true ), name );
+
+    TESTINFO( parallel.vertices.size() == nVertices, name );
+    TESTINFO( parallel.colors.size() == nVertices, name );
+    TESTINFO( parallel.triangles.size() == nFaces, name );
+    for( size_t i = 0; i < nVertices; ++i )
+    {
+        const triply::Vertex vertex( positions[i][0], positions[i][1],
+                                     positions[i][2] );
+        const triply::Color color( colors[i][0], colors[i][1], colors[i][2] );
+        TESTINFO( parallel.vertices[i] == vertex,
+                  name << " " << i << ": " << parallel.vertices[i] );
+        TESTINFO( parallel.colors[i] == color, name << " " << i );
+    }
+    for( size_t i = 0; i < nFaces; ++i )
+    {
+        const triply::Triangle triangle( faces[i][0], faces[i][1],
+                                         faces[i][2] );
+        TESTINFO( parallel.triangles[i] == triangle,
+                  name << " " << i << ": " << parallel.triangles[i] );
+    }
+
+    TESTINFO( parallel.vertices == generic.vertices, name );
+    TESTINFO( parallel.colors == generic.colors, name );
+    TESTINFO( parallel.triangles == generic.triangles, name );
+
+    _write( format, badFaces );
+    triply::VertexData badParallel;
+    triply::VertexData badGeneric;
+    TESTINFO( !_read( badParallel, false ), name );
+    TESTINFO( !_read( badGeneric, true ), name );
+}
+}
+
+int main( int, char** )
+{
+    _testFormat( FORMAT_ASCII );
+    _testFormat( FORMAT_BINARY_LE );
+    _testFormat( FORMAT_BINARY_BE );
+
+    ::remove( filename.c_str( ));
+    return EXIT_SUCCESS;
+}
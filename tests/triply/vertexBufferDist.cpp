@@ -0,0 +1,159 @@
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <lunchbox/test.h>
+
+#include <triply/vertexBufferDist.h>
+#include <triply/vertexBufferRoot.h>
+#include <triply/vertexData.h>
+
+#include <co/connectionDescription.h>
+#include <co/init.h>
+#include <co/localNode.h>
+
+#include <cmath>
+#include <sstream>
+#include <thread>
+
+// Maps the leaf geometry of a chunked model on demand, evicts unused chunks
+// and loads the same range from two threads, as concurrent pipes do.
+
+namespace
+{
+const size_t gridSize = 600; // vertices per side, several 4 MB chunks
+
+co::LocalNodePtr _listen()
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "localhost" );
+
+    co::LocalNodePtr node = new co::LocalNode;
+    node->addConnectionDescription( desc );
+    TEST( node->listen( ));
+    return node;
+}
+
+void _createGrid( triply::VertexData& data )
+{
+    for( size_t y = 0; y < gridSize; ++y )
+        for( size_t x = 0; x < gridSize; ++x )
+            data.vertices.push_back( triply::Vertex( float( x ), float( y ),
+                                         std::sin( float( x + y ) * .1f )));
+
+    for( size_t y = 0; y + 1 < gridSize; ++y )
+    {
+        for( size_t x = 0; x + 1 < gridSize; ++x )
+        {
+            const size_t i = y * gridSize + x;
+            data.triangles.push_back( triply::Triangle( i, i + 1,
+                                                        i + gridSize ));
+            data.triangles.push_back( triply::Triangle( i + 1,
+                                                        i + gridSize + 1,
+                                                        i + gridSize ));
+        }
+    }
+    data.calculateNormals();
+    data.scale( 2.0f );
+}
+
+triply::Range _range( const float start, const float end )
+{
+    triply::Range range;
+    range[0] = start;
+    range[1] = end;
+    return range;
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    co::LocalNodePtr server = _listen();
+    co::LocalNodePtr client = _listen();
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription(
+        server->getConnectionDescriptions().front( ));
+    TEST( client->connect( serverProxy ));
+
+    triply::VertexData data;
+    _createGrid( data );
+    std::ostringstream progressSink;
+    boost::progress_display progress( 12, progressSink );
+    triply::VertexBufferRoot root;
+    root.setupTree( data, progress );
+
+    triply::VertexBufferDist master( &root, true /* chunked */ );
+    master.registerTree( server );
+
+    triply::VertexBufferDist slave;
+    TEST( slave.loadModel( serverProxy, client, master.getID( )));
+    TEST( slave.getResidentSize() == 0 );
+
+    const triply::Range all = _range( 0.f, 1.f );
+    const triply::Range first = _range( 0.f, .05f );
+    const triply::Range last = _range( .95f, 1.f );
+
+    // prefetched chunks become resident once a draw loads them
+    slave.prefetchRange( first );
+    slave.loadRange( first );
+    const size_t firstSize = slave.getResidentSize();
+    TEST( firstSize > 0 );
+
+    slave.loadRange( all );
+    const size_t allSize = slave.getResidentSize();
+    TESTINFO( allSize > firstSize, allSize << " <= " << firstSize );
+    slave.releaseRange( all );
+    slave.releaseRange( first );
+
+    // only the pinned chunks survive eviction
+    slave.setMaxResidentSize( 0 );
+    slave.loadRange( last );
+    const size_t lastSize = slave.getResidentSize();
+    TEST( lastSize > 0 );
+    TESTINFO( lastSize < allSize, lastSize << " >= " << allSize );
+    slave.releaseRange( last );
+
+    // evicted chunks are mapped again
+    slave.loadRange( first );
+    TESTINFO( slave.getResidentSize() == firstSize,
+              slave.getResidentSize() << " != " << firstSize );
+    slave.releaseRange( first );
+
+    // concurrent draws of the same range wait for each other's mappings
+    slave.setMaxResidentSize( allSize );
+    std::thread other( [&slave, &all] { slave.loadRange( all ); } );
+    slave.loadRange( all );
+    other.join();
+    TESTINFO( slave.getResidentSize() == allSize,
+              slave.getResidentSize() << " != " << allSize );
+    slave.releaseRange( all );
+    slave.releaseRange( all );
+
+    slave.unmapTree();
+    master.deregisterTree();
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+    serverProxy = 0;
+    client = 0;
+    server = 0;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
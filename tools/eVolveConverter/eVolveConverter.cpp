@@ -27,6 +27,11 @@
 #ifndef _MSC_VER
 #  include <stdint.h>
 #endif
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <thread>
 
 #define EQ_MIN(a,b) ((a)<(b)?(a):(b))
 #ifndef MIN
@@ -48,6 +53,7 @@ namespace eVolve
 using namespace std;
 using hlpFuncs::clip;
 using hlpFuncs::min;
+using hlpFuncs::max;
 using hlpFuncs::hFile;
 
 static int lFailed( const char* msg, int result=1 )
@@ -189,8 +195,98 @@ static void getPredefinedHeaderParameters
 static void CreateTransferFunc( int t, unsigned char *transfer );
 
 
+/** Reads z-slices of a volume from a file or from memory, slices outside of
+    the volume or beyond the end of the file read as zero.
+*/
+class SliceReader
+{
+public:
+    SliceReader( const string& filename, const size_t sliceSize,
+                 const unsigned d )
+        : _file( filename.c_str(), ifstream::in | ifstream::binary )
+        , _data( 0 )
+        , _sliceSize( sliceSize )
+        , _d( d )
+    {}
+
+    SliceReader( const unsigned char* data, const size_t sliceSize,
+                 const unsigned d )
+        : _data( data )
+        , _sliceSize( sliceSize )
+        , _d( d )
+    {}
+
+    bool isOpen() const { return _data || _file.is_open(); }
+
+    /** Reads slices [z, z+n) to dst */
+    void read( const int z, const unsigned n, unsigned char* dst )
+    {
+        const int first = clip<int>( z, 0, _d );
+        const int last  = clip<int>( z + n, 0, _d );
+
+        memset( dst, 0, n * _sliceSize );
+        if( first >= last )
+            return;
+
+        unsigned char* out = dst + ( first - z ) * _sliceSize;
+        const size_t size = ( last - first ) * _sliceSize;
+        if( _data )
+        {
+            memcpy( out, _data + first * _sliceSize, size );
+            return;
+        }
+
+        _file.clear();
+        _file.seekg( first * _sliceSize, ios::beg );
+        _file.read( (char*)out, size );
+    }
+
+private:
+    ifstream             _file;
+    const unsigned char* _data;
+    const size_t         _sliceSize;
+    const int            _d;
+};
+
+/** Memory used for the slabs of a streaming conversion */
+static const size_t slabMemory = 256*1024*1024;
+
+/** Calls func( i ) for i in [begin, end) on all cores */
+static void parallelFor( const unsigned begin, const unsigned end,
+                         const std::function< void( unsigned ) >& func )
+{
+    const unsigned nThreads =
+        min( max( std::thread::hardware_concurrency(), 1u ), end - begin );
+    if( nThreads <= 1 )
+    {
+        for( unsigned i = begin; i < end; ++i )
+            func( i );
+        return;
+    }
+
+    vector< std::thread > threads;
+    for( unsigned t = 0; t < nThreads; ++t )
+        threads.push_back( std::thread( [&, t]
+        {
+            for( unsigned i = begin + t; i < end; i += nThreads )
+                func( i );
+        }));
+    for( unsigned t = 0; t < nThreads; ++t )
+        threads[t].join();
+}
+
+static void printThroughput( const size_t nVoxels,
+                    const std::chrono::high_resolution_clock::time_point start )
+{
+    const double seconds = std::chrono::duration< double >(
+                  std::chrono::high_resolution_clock::now() - start ).count();
+    std::cout << nVoxels << " voxels in " << seconds << " s, "
+              << nVoxels / seconds << " voxels/s" << endl;
+}
+
 static int calculateAndSaveDerivatives( const string& dst,
-                                        unsigned char *volume,
+                                        SliceReader&  src,
+                                        const unsigned stride,
                                         const unsigned w,
                                         const unsigned h,
                                         const unsigned d  );
@@ -477,30 +573,13 @@ int RawConverter::RawToRawPlusDerivativesConverter( const string& src,
     std::cout << "Creating derivatives for raw model: "
            << src << " " << w << " x " << h << " x " << d << endl;
 
-//read model
-    vector<unsigned char> volume( w*h*d, 0 );
-
-    std::cout << "Reading model" << endl;
+//calculate and save derivatives, streaming the model
     {
-        ifstream file( src.c_str(),
-                       ifstream::in | ifstream::binary | ifstream::ate );
-
-        if( !file.is_open() )
+        SliceReader volume( src, w*h, d );
+        if( !volume.isOpen() )
             return lFailed( "Can't open volume file" );
 
-        ifstream::pos_type size;
-
-        size = min( (int)file.tellg(), (int)volume.size() );
-
-        file.seekg( 0, ios::beg );
-        file.read( (char*)( &volume[0] ), size );
-
-        file.close();
-    }
-
-//calculate and save derivatives
-    {
-        int result = calculateAndSaveDerivatives( dst, &volume[0], w,  h, d );
+        int result = calculateAndSaveDerivatives( dst, volume, 1, w, h, d );
 
         if( result ) return result;
     }
@@ -526,42 +605,13 @@ int RawConverter::RecalculateDerivatives( const string& src,
     std::cout << "Creating derivatives for raw model: "
            << src << " " << w << " x " << h << " x " << d << endl;
 
-//read model
-    vector<unsigned char> volume( w*h*d*4, 0 );
-
-    std::cout << "Reading model" << endl;
+//calculate and save derivatives from the values, streaming the model
     {
-        ifstream file( src.c_str(),
-                       ifstream::in | ifstream::binary | ifstream::ate );
-
-        if( !file.is_open() )
+        SliceReader volume( src, w*h*4, d );
+        if( !volume.isOpen() )
             return lFailed( "Can't open volume file" );
 
-        ifstream::pos_type size;
-
-        size = min( (int)file.tellg(), (int)volume.size() );
-
-        file.seekg( 0, ios::beg );
-        file.read( (char*)( &volume[0] ), size );
-
-        file.close();
-    }
-//remove derivatives
-    {
-        unsigned char* sr = &volume[3];
-        unsigned char* ds = &volume[0];
-        for( unsigned i = 3; i < w*h*d*4; i+=4 )
-        {
-            *ds = *sr;
-            sr += 4;
-            ++ds;
-        }
-        volume.resize( w*h*d );
-    }
-
-//calculate and save derivatives
-    {
-        int result = calculateAndSaveDerivatives( dst, &volume[0], w, h, d );
+        int result = calculateAndSaveDerivatives( dst, volume, 4, w, h, d );
 
         if( result ) return result;
     }
@@ -770,8 +820,9 @@ int RawConverter::PvmSavToRawDerVhfConverter(     const string& src,
             << endl;
 
     // calculating derivatives
+    SliceReader slices( volume, width*height, depth );
     int result =
-        calculateAndSaveDerivatives( dst, volume, width,  height, depth );
+        calculateAndSaveDerivatives( dst, slices, 1, width, height, depth );
 
     free( volume );
     if( result ) return result;
@@ -833,202 +884,287 @@ int RawConverter::ScaleRawDerFile(                  const string& src,
     std::cout << "old dimensions: " << wS << " x " << hS << " x " << dS << endl;
     std::cout << "new dimensions: " << wD << " x " << hD << " x " << dD << endl;
 
-    //read volume
-    vector<unsigned char> sVol( wS*hS*dS*4, 0 );
+    //scale volume in slabs of destination slices
+    SliceReader source( src, size_t( wS )*hS*4, dS );
+    if( !source.isOpen() )
+        return lFailed( "Can't open volume file" );
 
-    std::cout << "Reading model" << endl;
-    {
-        ifstream file( src.c_str(),
-                       ifstream::in | ifstream::binary | ifstream::ate );
+    ofstream file ( dst.c_str(),
+                    ifstream::out | ifstream::binary | ifstream::trunc );
+    if( !file.is_open() )
+        return lFailed( "Can't open destination volume file" );
 
-        if( !file.is_open() )
-            return lFailed( "Can't open volume file" );
+    std::cout << "Scaling model" << endl;
+    const std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+    {
+        const size_t wD4   = wD*4;
+        const size_t wDhD4 = wD4*hD;
+        const size_t wS4   = wS*4;
+        const size_t wShS4 = wS4*hS;
+
+        const unsigned scaleIx = static_cast<unsigned>( scaleX );
+        const unsigned scaleIy = static_cast<unsigned>( scaleY );
+        const unsigned scaleIz = static_cast<unsigned>( scaleZ );
+        const unsigned endX = wD > scaleIx ? wD-scaleIx : 0;
+        const unsigned endY = hD > scaleIy ? hD-scaleIy : 0;
+        const unsigned endZ = dD > scaleIz ? dD-scaleIz : 0;
+
+        // source coordinates of destination rows and columns
+        vector<double> cxs( endX ), cys( endY );
+        vector<int>    nxs( endX ), nys( endY );
+        for( unsigned x=0; x<endX; x++ )
+        {
+            const double cx = x/scaleX;
+            nxs[x] = static_cast<int>( cx );
+            cxs[x] = cx - nxs[x];
+        }
+        for( unsigned y=0; y<endY; y++ )
+        {
+            const double cy = y/scaleY;
+            nys[y] = static_cast<int>( cy );
+            cys[y] = cy - nys[y];
+        }
 
-        ifstream::pos_type size;
+        const size_t perSlice = wDhD4 + size_t( wShS4 / scaleZ ) + wShS4;
+        const unsigned slab = clip<size_t>( slabMemory / perSlice, 1, dD );
+        vector<unsigned char> dVol( slab * wDhD4 );
+        vector<unsigned char> sVol;
 
-        size = min( (int)file.tellg(), (int)sVol.size() );
+        for( unsigned z0 = 0; z0 < dD; z0 += slab )
+        {
+            std::cout << ".";
+            std::cout.flush();
 
-        file.seekg( 0, ios::beg );
-        file.read( (char*)( &sVol[0] ), size );
+            const unsigned z1 = min( z0 + slab, dD );
+            memset( &dVol[0], 0, ( z1-z0 ) * wDhD4 );
 
-        file.close();
-    }
-    std::cout << "Scaling model" << endl;
-    //scale volume
-    vector<unsigned char> dVol( wD*hD*dD*4, 0 );
-    {
-        int wD4   = wD*4;
-        int wDhD4 = wD*hD*4;
-        int wS4   = wS*4;
-        int wShS4 = wS*hS*4;
-
-        int scaleIx  = static_cast<int>( scaleX );
-        int scaleIy  = static_cast<int>( scaleY );
-        int scaleIz  = static_cast<int>( scaleZ );
-        int tenPerc  = (dD-scaleIz-1) / 10;
-        int tenPercI = 0;
-        for( unsigned z=0; z<dD-scaleIz; z++ )
-        {
-            if( ++tenPercI >= tenPerc )
+            if( z0 < endZ )
             {
-                std::cout << ".";
-                std::cout.flush();
-                tenPercI = 0;
-            }
-            for( unsigned y=0; y<hD-scaleIy; y++ )
-                for( unsigned x=0; x<wD-scaleIx; x++ )
+                // source slices used by the destination slices [z0, zEnd)
+                const unsigned zEnd = min( z1, endZ );
+                const int first = static_cast<int>( z0/scaleZ );
+                const int last  = static_cast<int>( (zEnd-1)/scaleZ ) + 1;
+                sVol.resize(( last-first+1 ) * wShS4 );
+                source.read( first, last-first+1, &sVol[0] );
+
+                parallelFor( z0, zEnd, [&]( const unsigned z )
                 {
-                    double cx = x/scaleX;
-                    double cy = y/scaleY;
                     double cz = z/scaleZ;
+                    const int nz = static_cast<int>( cz ) - first;
+                    const int fz = nz+1;
+                    cz -= static_cast<int>( cz );
 
-                    int nx = static_cast<int>( cx );
-                    int ny = static_cast<int>( cy );
-                    int nz = static_cast<int>( cz );
-
-                    int fx = nx+1;
-                    int fy = ny+1;
-                    int fz = nz+1;
-
-                    cx -= nx;
-                    cy -= ny;
-                    cz -= nz;
-
-                    double v1 = (1-cx)*(1-cy)*(1-cz);
-                    double v2 =    cx *(1-cy)*(1-cz);
-                    double v3 = (1-cx)*(1-cy)*   cz;
-                    double v4 =    cx *(1-cy)*   cz;
-                    double v5 = (1-cx)*   cy *(1-cz);
-                    double v6 =    cx *   cy *(1-cz);
-                    double v7 = (1-cx)*   cy *   cz ;
-                    double v8 =    cx *   cy *   cz ;
-
-                    int p1 = nx*4 + ny*wS4 + nz*wShS4;
-                    int p2 = fx*4 + ny*wS4 + nz*wShS4;
-                    int p3 = nx*4 + ny*wS4 + fz*wShS4;
-                    int p4 = fx*4 + ny*wS4 + fz*wShS4;
-                    int p5 = nx*4 + fy*wS4 + nz*wShS4;
-                    int p6 = fx*4 + fy*wS4 + nz*wShS4;
-                    int p7 = nx*4 + fy*wS4 + fz*wShS4;
-                    int p8 = fx*4 + fy*wS4 + fz*wShS4;
-
-                    int pD =  x*4 +  y*wD4 +  z*wDhD4;
-
-                    for( int d = 0; d<4; d++)
+                    for( unsigned y=0; y<endY; y++ )
                     {
-                        double res = v1*sVol[p1+d] + v2*sVol[p2+d] +
-                                     v3*sVol[p3+d] + v4*sVol[p4+d] +
-                                     v5*sVol[p5+d] + v6*sVol[p6+d] +
-                                     v7*sVol[p7+d] + v8*sVol[p8+d];
-
-                        dVol[pD+d] = min<int>( static_cast<int>( res ), 255 );
+                        const double cy = cys[y];
+                        const int    ny = nys[y];
+                        const int    fy = ny+1;
+
+                        // source rows at ( ny | fy, nz | fz )
+                        const unsigned char* nn = &sVol[ ny*wS4 + nz*wShS4 ];
+                        const unsigned char* fn = &sVol[ fy*wS4 + nz*wShS4 ];
+                        const unsigned char* nf = &sVol[ ny*wS4 + fz*wShS4 ];
+                        const unsigned char* ff = &sVol[ fy*wS4 + fz*wShS4 ];
+                        unsigned char* dRow = &dVol[ y*wD4 + (z-z0)*wDhD4 ];
+
+                        for( unsigned x=0; x<endX; x++ )
+                        {
+                            const double cx = cxs[x];
+                            const int    nx = nxs[x]*4;
+                            const int    fx = nx+4;
+
+                            double v1 = (1-cx)*(1-cy)*(1-cz);
+                            double v2 =    cx *(1-cy)*(1-cz);
+                            double v3 = (1-cx)*(1-cy)*   cz;
+                            double v4 =    cx *(1-cy)*   cz;
+                            double v5 = (1-cx)*   cy *(1-cz);
+                            double v6 =    cx *   cy *(1-cz);
+                            double v7 = (1-cx)*   cy *   cz ;
+                            double v8 =    cx *   cy *   cz ;
+
+                            for( int d = 0; d<4; d++)
+                            {
+                                double res =
+                                    v1*nn[nx+d] + v2*nn[fx+d] +
+                                    v3*nf[nx+d] + v4*nf[fx+d] +
+                                    v5*fn[nx+d] + v6*fn[fx+d] +
+                                    v7*ff[nx+d] + v8*ff[fx+d];
+
+                                dRow[x*4+d] =
+                                    min<int>( static_cast<int>( res ), 255 );
+                            }
+                        }
                     }
-                }
+                });
+            }
+
+            file.write( (char*)( &dVol[0] ), ( z1-z0 ) * wDhD4 );
         }
         std::cout << endl;
     }
+    file.close();
+    printThroughput( size_t( wD )*hD*dD, start );
+
+    std::cout << "Done" << endl;
+    return 0;
+}
+
 
-    //write new volume
-    std::cout << "Writing model" << endl;
+/** Computes the derivatives of the inner voxels [1, w-1) of one row, cur
+    points to the row, prv and nxt to the same row in the previous and next
+    slice. The gradients are computed in chunks into local arrays, which the
+    compiler can vectorize since they don't alias the volume data.
+*/
+static void calculateRowDerivatives( const unsigned char* prvP,
+                                     const unsigned char* curP,
+                                     const unsigned char* nxtP,
+                                     const int w, const int ws,
+                                     unsigned char* dst )
+{
+    const int chunk = 64;
+    int gxs[ chunk ];
+    int gys[ chunk ];
+    int gzs[ chunk ];
+
+    for( int x0 = 1; x0 < w-1; x0 += chunk )
     {
-        ofstream file ( dst.c_str(),
-                        ifstream::out | ifstream::binary | ifstream::trunc );
+        const int n = min( chunk, w-1-x0 );
+        const unsigned char* c = curP + x0;
+        const unsigned char* p = prvP + x0;
+        const unsigned char* q = nxtP + x0;
 
-        if( !file.is_open() )
-            return lFailed( "Can't open destination volume file" );
+        for( int i = 0; i < n; ++i )
+        {
+            gxs[i] =  q[ i+ws+1 ]+ 3*c[ i+ws+1 ]+   p[ i+ws+1 ]+
+                    3*q[ i   +1 ]+ 6*c[ i   +1 ]+ 3*p[ i   +1 ]+
+                      q[ i-ws+1 ]+ 3*c[ i-ws+1 ]+   p[ i-ws+1 ]-
 
-        file.write( (char*)( &dVol[0] ), dVol.size() );
-        file.close();
-    }
+                      q[ i+ws-1 ]- 3*c[ i+ws-1 ]-   p[ i+ws-1 ]-
+                    3*q[ i   -1 ]- 6*c[ i   -1 ]- 3*p[ i   -1 ]-
+                      q[ i-ws-1 ]- 3*c[ i-ws-1 ]-   p[ i-ws-1 ];
 
-    std::cout << "Done" << endl;
-    return 0;
+            gys[i] =  q[ i+ws+1 ]+ 3*c[ i+ws+1 ]+   p[ i+ws+1 ]+
+                    3*q[ i+ws   ]+ 6*c[ i+ws   ]+ 3*p[ i+ws   ]+
+                      q[ i+ws-1 ]+ 3*c[ i+ws-1 ]+   p[ i+ws-1 ]-
+
+                      q[ i-ws+1 ]- 3*c[ i-ws+1 ]-   p[ i-ws+1 ]-
+                    3*q[ i-ws   ]- 6*c[ i-ws   ]- 3*p[ i-ws   ]-
+                      q[ i-ws-1 ]- 3*c[ i-ws-1 ]-   p[ i-ws-1 ];
+
+            gzs[i] =  q[ i+ws+1 ]+ 3*q[ i   +1 ]+   q[ i-ws+1 ]+
+                    3*q[ i+ws   ]+ 6*q[ i      ]+ 3*q[ i-ws   ]+
+                      q[ i+ws-1 ]+ 3*q[ i   -1 ]+   q[ i-ws-1 ]-
+
+                      p[ i+ws+1 ]- 3*p[ i   +1 ]-   p[ i-ws+1 ]-
+                    3*p[ i+ws   ]- 6*p[ i      ]- 3*p[ i-ws   ]-
+                      p[ i+ws-1 ]- 3*p[ i   -1 ]-   p[ i-ws-1 ];
+        }
+
+        unsigned char* out = dst + x0*4;
+        for( int i = 0; i < n; ++i )
+        {
+            const int gx = gxs[i];
+            const int gy = gys[i];
+            const int gz = gzs[i];
+            const int length =
+                static_cast<int>( sqrt( double( gx*gx + gy*gy + gz*gz ) + 1 ));
+
+            out[i*4   ] = static_cast<unsigned char>(( gx*255/length+255 )/2 );
+            out[i*4 +1] = static_cast<unsigned char>(( gy*255/length+255 )/2 );
+            out[i*4 +2] = static_cast<unsigned char>(( gz*255/length+255 )/2 );
+            out[i*4 +3] = c[i];
+        }
+    }
 }
 
 
+/** Computes the derivatives in slabs of z-slices with a halo of one slice on
+    each side, using all cores. The next slab is read while the current one is
+    computed. The voxels on the border of the volume are zero.
+
+    @param stride bytes per voxel of the source, the value is the last byte
+*/
 static int calculateAndSaveDerivatives( const string& dst,
-                                        unsigned char *volume,
+                                        SliceReader&  src,
+                                        const unsigned stride,
                                         const unsigned w,
                                         const unsigned h,
                                         const unsigned d  )
 {
     std::cout << "Calculating derivatives" << endl;
+    const std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+
     ofstream file ( dst.c_str(),
                     ifstream::out | ifstream::binary | ifstream::trunc );
 
     if( !file.is_open() )
         return lFailed( "Can't open destination volume file" );
 
-    const int wh = w*h;
+    const size_t wh = size_t( w )*h;
+    const unsigned slab =
+        clip<size_t>( slabMemory / ( wh * ( stride*2 + 4 )), 1, d );
 
-    const int ws = static_cast<int>( w );
+    vector<unsigned char> slices[2];
+    slices[0].resize(( slab+2 ) * wh * stride );
+    slices[1].resize(( slab+2 ) * wh * stride );
+    vector<unsigned char> values( stride == 1 ? 0 : ( slab+2 ) * wh );
+    vector<unsigned char> GxGyGzA( slab * wh * 4 );
 
-    vector<unsigned char> GxGyGzA( wh*d*4, 0 );
+    std::cout << "Writing derivatives: " << dst.c_str() << " "
+              << wh*d*4 << " bytes in slabs of " << slab << " slices" << endl;
 
-    for( unsigned z=1; z<d-1; z++ )
+    std::future< void > reading = std::async( std::launch::async,
+                         [&]{ src.read( -1, slab+2, &slices[0][0] ); });
+
+    for( unsigned z0 = 0; z0 < d; z0 += slab )
     {
-        const int zwh = z*wh;
+        const unsigned nSlices = min( slab, d - z0 );
+        const unsigned current = ( z0 / slab ) % 2;
 
-        const unsigned char *curPz = &volume[0] + zwh;
+        reading.get();
+        if( z0 + slab < d )
+        {
+            unsigned char* next = &slices[ 1 - current ][0];
+            reading = std::async( std::launch::async,
+                     [&, next, z0]{ src.read( z0+slab-1, slab+2, next ); });
+        }
 
-        for( unsigned y=1; y<h-1; y++ )
+        // slice i of the slab is at z0-1+i
+        const unsigned char* volume = &slices[ current ][0];
+        if( stride != 1 )
         {
-            const int zwh_y = zwh + y*w;
-            const unsigned char * curPy = curPz + y*w;
-            for( unsigned x=1; x<w-1; x++ )
-            {
-                const unsigned char * curP = curPy +  x;
-                const unsigned char * prvP = curP  - wh;
-                const unsigned char * nxtP = curP  + wh;
-                int gx =
-                      nxtP[  ws+1 ]+ 3*curP[  ws+1 ]+   prvP[  ws+1 ]+
-                    3*nxtP[     1 ]+ 6*curP[     1 ]+ 3*prvP[     1 ]+
-                      nxtP[ -ws+1 ]+ 3*curP[ -ws+1 ]+   prvP[ -ws+1 ]-
-
-                      nxtP[  ws-1 ]- 3*curP[  ws-1 ]-   prvP[  ws-1 ]-
-                    3*nxtP[    -1 ]- 6*curP[    -1 ]- 3*prvP[    -1 ]-
-                      nxtP[ -ws-1 ]- 3*curP[ -ws-1 ]-   prvP[ -ws-1 ];
-
-                int gy =
-                      nxtP[  ws+1 ]+ 3*curP[  ws+1 ]+   prvP[  ws+1 ]+
-                    3*nxtP[  ws   ]+ 6*curP[  ws   ]+ 3*prvP[  ws   ]+
-                      nxtP[  ws-1 ]+ 3*curP[  ws-1 ]+   prvP[  ws-1 ]-
-
-                      nxtP[ -ws+1 ]- 3*curP[ -ws+1 ]-   prvP[ -ws+1 ]-
-                    3*nxtP[ -ws   ]- 6*curP[ -ws   ]- 3*prvP[ -ws   ]-
-                      nxtP[ -ws-1 ]- 3*curP[ -ws-1 ]-   prvP[ -ws-1 ];
-
-                int gz =
-                      nxtP[  ws+1 ]+ 3*nxtP[    1 ]+   nxtP[ -ws+1 ]+
-                    3*nxtP[  ws   ]+ 6*nxtP[    0 ]+ 3*nxtP[ -ws   ]+
-                      nxtP[  ws-1 ]+ 3*nxtP[   -1 ]+   nxtP[ -ws-1 ]-
-
-                      prvP[  ws+1 ]- 3*prvP[    1 ]-   prvP[ -ws+1 ]-
-                    3*prvP[  ws   ]- 6*prvP[    0 ]- 3*prvP[ -ws   ]-
-                      prvP[  ws-1 ]- 3*prvP[   -1 ]-   prvP[ -ws-1 ];
-
-                int length = static_cast<int>(
-                                        sqrt(double((gx*gx+gy*gy+gz*gz))+1));
-
-                gx = ( gx*255/length + 255 )/2;
-                gy = ( gy*255/length + 255 )/2;
-                gz = ( gz*255/length + 255 )/2;
-
-                GxGyGzA[(zwh_y + x)*4   ] = static_cast<unsigned char>( gx );
-                GxGyGzA[(zwh_y + x)*4 +1] = static_cast<unsigned char>( gy );
-                GxGyGzA[(zwh_y + x)*4 +2] = static_cast<unsigned char>( gz );
-                GxGyGzA[(zwh_y + x)*4 +3] = curP[0];
-            }
+            for( size_t i = 0; i < ( nSlices+2 ) * wh; ++i )
+                values[i] = volume[ i*stride + stride-1 ];
+            volume = &values[0];
         }
-    }
 
-    std::cout << "Writing derivatives: "
-           << dst.c_str() << " " << GxGyGzA.size() << " bytes" <<endl;
+        memset( &GxGyGzA[0], 0, nSlices * wh * 4 );
+        parallelFor( 0, nSlices, [&]( const unsigned i )
+        {
+            const unsigned z = z0 + i;
+            if( z == 0 || z >= d-1 || h < 3 || w < 3 )
+                return;
 
-    file.write( (char*)( &GxGyGzA[0] ), GxGyGzA.size() );
+            const unsigned char* curPz = volume + ( i+1 )*wh;
+            unsigned char* dstPz = &GxGyGzA[ i*wh*4 ];
 
-    file.close();
+            for( unsigned y = 1; y < h-1; ++y )
+            {
+                const unsigned char* curPy = curPz + y*w;
+                unsigned char* dstPy = dstPz + y*w*4;
+
+                calculateRowDerivatives( curPy - wh, curPy, curPy + wh, w, w,
+                                         dstPy );
+            }
+        });
+
+        file.write( (char*)( &GxGyGzA[0] ), nSlices * wh * 4 );
+    }
 
+    file.close();
+    printThroughput( wh*d, start );
     return 0;
 }
 
@@ -27,7 +27,14 @@
  */
 
 #include <eq/eq.h>
+#include <triply/vertexBufferLeaf.h>
 #include <triply/vertexBufferRoot.h>
+#include <triply/vertexData.h>
+#include <lunchbox/clock.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <sstream>
 
 namespace
 {
@@ -44,22 +51,163 @@ static bool _isPlyfile( const std::string& filename )
     }
     return true;
 }
+
+template< class T > size_t _getSize( const triply::DataArray< T >& array )
+{
+    return array.size() * sizeof( T );
+}
+
+/*  @return the vertex data size of the given kd-tree in bytes. */
+static size_t _getMemorySize( const triply::VertexBufferData& data )
+{
+    return _getSize( data.vertices ) + _getSize( data.colors ) +
+           _getSize( data.normals ) + _getSize( data.indices ) +
+           _getSize( data.packedVertices ) + _getSize( data.packedNormals );
+}
+
+/*  Simulate a FIFO post-transform cache over the leaves of the given subtree.
+    @return the number of cache misses. */
+static size_t _simulateVertexCache( const triply::VertexBufferBase* node,
+                                    const triply::VertexBufferData& data )
+{
+    if( !node )
+        return 0;
+
+    if( node->getLeft( ))
+        return _simulateVertexCache( node->getLeft(), data ) +
+               _simulateVertexCache( node->getRight(), data );
+
+    const triply::VertexBufferLeaf* leaf =
+        static_cast< const triply::VertexBufferLeaf* >( node );
+
+    const size_t cacheSize = 32;
+    std::deque< triply::ShortIndex > cache;
+    size_t misses = 0;
+    for( triply::Index i = leaf->getIndexStart();
+         i < leaf->getIndexStart() + leaf->getIndexLength(); ++i )
+    {
+        const triply::ShortIndex index = data.indices[i];
+        if( std::find( cache.begin(), cache.end(), index ) != cache.end( ))
+            continue;
+
+        ++misses;
+        cache.push_back( index );
+        if( cache.size() > cacheSize )
+            cache.pop_front();
+    }
+    return misses;
+}
+
+/*  Time the kd-tree construction of the given model in both leaf layouts,
+    without caching it, and compare their size and vertex cache efficiency. */
+template< class T > bool _equals( const triply::DataArray< T >& a,
+                                  const triply::DataArray< T >& b )
+{
+    return a.size() == b.size() &&
+           ( a.empty() || ::memcmp( a.getData(), b.getData(),
+                                    _getSize( a )) == 0 );
+}
+
+/*  @return true if both kd-trees hold byte-identical vertex data. */
+static bool _equals( const triply::VertexBufferData& a,
+                     const triply::VertexBufferData& b )
+{
+    return _equals( a.vertices, b.vertices ) &&
+           _equals( a.colors, b.colors ) &&
+           _equals( a.normals, b.normals ) &&
+           _equals( a.indices, b.indices ) &&
+           _equals( a.lodVertices, b.lodVertices ) &&
+           _equals( a.lodColors, b.lodColors ) &&
+           _equals( a.lodNormals, b.lodNormals ) &&
+           _equals( a.lodIndices, b.lodIndices );
+}
+
+static bool _benchmark( const std::string& filename )
+{
+    triply::VertexData data;
+    if( !data.readPlyFile( filename ))
+        return false;
+    data.calculateNormals();
+    data.scale( 2.0f );
+
+    // reference tree, fully sorted at each split like the serial setup
+    triply::VertexData sorted( data );
+    sorted.useFullSort();
+    std::ostringstream devNull;
+    boost::progress_display sortedProgress( 12, devNull );
+    triply::VertexBufferRoot reference;
+
+    lunchbox::Clock clock;
+    reference.setupTree( sorted, sortedProgress );
+    std::cout << filename << " sorted:  " << sorted.triangles.size()
+              << " triangles, " << clock.getTimef() << " ms kd-tree setup"
+              << std::endl;
+
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const bool compact = i == 1;
+        boost::progress_display progress( 12, devNull );
+        triply::VertexBufferRoot model;
+        if( compact )
+            model.useCompactLeaves();
+
+        clock.reset();
+        model.setupTree( data, progress );
+        const float time = clock.getTimef();
+
+        if( !compact && !_equals( model.getData(), reference.getData( )))
+        {
+            LBERROR << filename << ": kd-tree differs from the sorted setup"
+                    << std::endl;
+            return false;
+        }
+
+        const size_t nTriangles = data.triangles.size();
+        const size_t misses = _simulateVertexCache( &model, model.getData( ));
+        std::cout << filename << ( compact ? " compact: " : " full:    " )
+                  << nTriangles << " triangles, " << time
+                  << " ms kd-tree setup, "
+                  << _getMemorySize( model.getData( )) / 1024 << " KB, ACMR "
+                  << float( misses ) / float( nTriangles ) << std::endl;
+    }
+    return true;
+}
 }
 
 int main( const int argc, char** argv )
 {
+    bool benchmark = false;
+    bool compact = false;
+    int result = EXIT_SUCCESS;
     eq::Strings filenames;
     for( int i=1; i < argc; ++i )
-        filenames.push_back( argv[i] );
+    {
+        if( std::string( argv[i] ) == "--benchmark" )
+            benchmark = true;
+        else if( std::string( argv[i] ) == "--compact" )
+            compact = true;
+        else
+            filenames.push_back( argv[i] );
+    }
 
     while( !filenames.empty( ))
     {
         const std::string filename = filenames.back();
         filenames.pop_back();
 
-        if( _isPlyfile( filename ))
+        if( _isPlyfile( filename ) && benchmark )
+        {
+            if( !_benchmark( filename ))
+            {
+                LBWARN << "Benchmark failed: " << filename << std::endl;
+                result = EXIT_FAILURE;
+            }
+        }
+        else if( _isPlyfile( filename ))
         {
             triply::VertexBufferRoot* model = new triply::VertexBufferRoot;
+            if( compact )
+                model->useCompactLeaves();
             if( !model->readFromFile( filename.c_str( )))
                 LBWARN << "Can't load model: " << filename << std::endl;
 
@@ -79,5 +227,5 @@ int main( const int argc, char** argv )
                 filenames.push_back( filename + '/' + *i );
         }
     }
-    return EXIT_SUCCESS;
+    return result;
 }
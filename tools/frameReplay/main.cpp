@@ -0,0 +1,147 @@
+
+/* Copyright (c) 2016, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <eq/eq.h>
+
+// Replays a frame capture, written by a node with a channel using the
+// capture_frames attribute, and reports the time spent decompressing and
+// merging the images of each frame assembly.
+
+namespace
+{
+struct Totals
+{
+    Totals() : nAssemblies( 0 ), nImages( 0 ), size( 0 ), decode( 0.f )
+             , merge( 0.f ) {}
+
+    void add( const eq::FrameReplay::Times& times )
+    {
+        ++nAssemblies;
+        nImages += times.nImages;
+        size += times.size;
+        decode += times.decode;
+        merge += times.merge;
+    }
+
+    void add( const Totals& totals )
+    {
+        nAssemblies += totals.nAssemblies;
+        nImages += totals.nImages;
+        size += totals.size;
+        decode += totals.decode;
+        merge += totals.merge;
+    }
+
+    size_t nAssemblies;
+    size_t nImages;
+    uint64_t size;
+    float decode;
+    float merge;
+};
+
+std::ostream& operator << ( std::ostream& os, const Totals& totals )
+{
+    const float n = float( std::max( totals.nAssemblies, size_t( 1 )));
+    return os << totals.nAssemblies << " assemblies, " << totals.nImages
+              << " images, " << float( totals.size ) / 1024.f / 1024.f
+              << " MB, " << totals.decode / n << " ms decode, "
+              << totals.merge / n << " ms merge per assembly, "
+              << float( totals.size ) / 1024.f / 1024.f /
+                 ( std::max( totals.decode, 1.f ) / 1000.f )
+              << " MB/s decode";
+}
+}
+
+int main( int argc, char** argv )
+{
+    bool blend = false;
+    bool verbose = false;
+    size_t loops = 1;
+    std::string filename;
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg( argv[i] );
+        if( arg == "--blend" )
+            blend = true;
+        else if( arg == "--verbose" )
+            verbose = true;
+        else if( arg == "--loops" && i + 1 < argc )
+            loops = std::max( atoi( argv[++i] ), 1 );
+        else if( arg.compare( 0, 2, "--" ) != 0 )
+            filename = arg;
+    }
+
+    if( filename.empty( ))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--blend] [--verbose] [--loops n] capture" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    eq::NodeFactory nodeFactory;
+    if( !eq::init( argc, argv, &nodeFactory ))
+    {
+        LBERROR << "Equalizer init failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    {
+        eq::FrameReplay replay( filename );
+        Totals all;
+        for( size_t i = 0; i < loops && replay.isGood(); ++i )
+        {
+            if( i > 0 )
+                replay.rewind();
+
+            Totals loop;
+            while( replay.next( blend ))
+            {
+                const eq::FrameReplay::Times& times = replay.getTimes();
+                loop.add( times );
+                if( verbose )
+                    std::cout << "frame " << times.frameNumber << ": "
+                              << times.nImages << " images, " << times.size
+                              << " bytes, " << times.decode << " ms decode, "
+                              << times.merge << " ms merge"
+                              << ( replay.getResult() ? "" : ", not merged" )
+                              << std::endl;
+            }
+            std::cout << "Loop " << i << ": " << loop << std::endl;
+            all.add( loop );
+        }
+
+        if( !replay.isGood( ))
+            result = EXIT_FAILURE;
+        else if( loops > 1 )
+            std::cout << "Total:  " << all << std::endl;
+    }
+
+    eq::exit();
+    return result;
+}